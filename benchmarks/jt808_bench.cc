@@ -0,0 +1,818 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  jt808_bench.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 11:20:36
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "jt808/basic_data_flow.h"
+#include "jt808/bcd.h"
+#include "jt808/geofence.h"
+#include "jt808/location_columns.h"
+#include "jt808/message_view.h"
+#include "jt808/metrics.h"
+#include "jt808/packager.h"
+#include "jt808/parser.h"
+#include "jt808/point_in_polygon.h"
+#include "jt808/util.h"
+
+namespace libjt808 {
+
+namespace {
+
+// Buffer sizes of the escape and checksum benchmarks, 1023 is the largest message body.
+constexpr int64_t kBufferSizes[] = {64, 256, 1023, 4096};
+
+// Percentage of 0x7E/0x7D bytes.
+constexpr int64_t kEscapeDensities[] = {0, 1, 10, 50};
+
+// Size of the variable part of the message body: small, typical and close to a full fragment.
+constexpr int64_t kPayloadSizes[] = {16, 256, 900};
+
+// Escape densities of the message benchmarks.
+constexpr int64_t kMessageEscapeDensities[] = {0, 1, 10};
+
+constexpr char kPhoneNumber[] = "13523339527";
+
+// Deterministic bytes, density percent of them are 0x7E or 0x7D.
+std::vector<uint8_t> MakePayload(size_t const& size, int64_t const& density) {
+    std::vector<uint8_t> out(size);
+    uint32_t             seed = 0x12345678;
+    for (size_t i = 0; i < size; ++i) {
+        seed = seed * 1103515245 + 12345;
+        if (static_cast<int64_t>((seed >> 16) % 100) < density) {
+            out[i] = (seed & 0x1) ? PROTOCOL_SIGN : PROTOCOL_ESCAPE;
+        }
+        else {
+            uint8_t uch = static_cast<uint8_t>(seed >> 8);
+            if (uch == PROTOCOL_SIGN || uch == PROTOCOL_ESCAPE)
+                uch = 0x55;
+            out[i] = uch;
+        }
+    }
+    return out;
+}
+
+// Numeric field value, escaped on every byte when density is not 0.
+uint16_t Word(int64_t const& density) {
+    return density > 0 ? 0x7E7D : 0x1234;
+}
+
+uint32_t DoubleWord(int64_t const& density) {
+    return density > 0 ? 0x7E7D7E7D : 0x12345678;
+}
+
+void FillLocation(int64_t const& payload, int64_t const& density, ProtocolParameter* para) {
+    auto& info                  = para->location_info;
+    info.alarm.value            = 0;
+    info.status.value           = 0;
+    info.status.bit.gps_en      = 1;
+    info.status.bit.positioning = 1;
+    info.latitude               = density > 0 ? 0x017E7D60 : 22570336;
+    info.longitude              = 113937577;
+    info.altitude               = 54;
+    info.speed                  = density > 0 ? 0x7E : 80;
+    info.bearing                = 90;
+    info.time.Assign("200702145429");
+    auto& extension = para->location_extension;
+    extension.clear();
+    // Common standard items.
+    extension.Set(kMileage, {0x00, 0x01, 0x86, 0xA0});
+    extension.Set(kOilMass, {0x01, 0xF4});
+    extension.Set(kTachographSpeed, {0x00, 0x50});
+    extension.Set(kVehicleSignalStatus, {0x00, 0x00, 0x00, 0x03});
+    extension.Set(kPositioningStatus, {0x00, 0x00});
+    extension.Set(kNetworkQuantity, {0x1F});
+    extension.Set(kGnssSatellites, {0x0B});
+    // Custom items carry the rest of the payload, at most 255 bytes each.
+    auto const data = MakePayload(static_cast<size_t>(payload), density);
+    uint8_t    id   = kCustomInformationLength + 1;
+    for (size_t i = 0; i < data.size() && id != 0; i += 255, ++id) {
+        size_t len = data.size() - i;
+        if (len > 255)
+            len = 255;
+        extension.Set(id, data.data() + i, len);
+    }
+}
+
+// Populate every field the message packager reads, payload bytes go to the variable part of the body.
+void FillParameter(uint16_t const& msg_id, int64_t const& payload, int64_t const& density, ProtocolParameter* para) {
+    auto const data                    = MakePayload(static_cast<size_t>(payload), density);
+    para->msg_head.msg_id              = msg_id;
+    para->msg_head.phone_num           = kPhoneNumber;
+    para->msg_head.msg_flow_num        = Word(density);
+    para->msg_head.msgbody_attr.u16val = 0;
+    para->msg_head.total_packet        = 0;
+    para->msg_head.packet_seq          = 0;
+    para->respone_result               = kSuccess;
+    para->parse.msg_head.msg_id        = kLocationReport;
+    para->parse.msg_head.msg_flow_num  = Word(density);
+    switch (msg_id) {
+        case kFillPacketRequest: {
+            para->fill_packet.first_packet_msg_flow_num = Word(density);
+            para->fill_packet.packet_id.clear();
+            for (size_t i = 0; i + 1 < data.size() && para->fill_packet.packet_id.size() < 255; i += 2)
+                para->fill_packet.packet_id.push_back(static_cast<uint16_t>(data[i] << 8 | data[i + 1]));
+            break;
+        }
+        case kTerminalRegister: {
+            auto const fixed = MakePayload(32, density);
+            auto&      info  = para->register_info;
+            info.province_id = Word(density);
+            info.city_id     = Word(density);
+            info.manufacturer_id.assign(fixed.begin(), fixed.begin() + 5);
+            info.terminal_model.assign(fixed.begin() + 5, fixed.begin() + 25);
+            info.terminal_id.assign(fixed.begin() + 25, fixed.begin() + 32);
+            info.car_plate_color = kBlue;
+            info.car_plate_num   = "粤B99999";
+            break;
+        }
+        case kTerminalRegisterResponse:
+            para->authentication_code = data;
+            break;
+        case kTerminalAuthentication:
+            para->parse.authentication_code = data;
+            break;
+        case kSetTerminalParameters:
+        case kGetTerminalParametersResponse: {
+            // DWORD parameter items, 9 bytes each.
+            para->terminal_parameters.clear();
+            para->terminal_parameter_ids.clear();
+            for (size_t i = 0; i + 4 <= data.size() && para->terminal_parameters.size() < 100; i += 9)
+                para->terminal_parameters[0x0001 + i / 9].assign(data.begin() + i, data.begin() + i + 4);
+            if (para->terminal_parameters.empty())
+                para->terminal_parameters[kTerminalHeartBeatInterval] = {0x00, 0x00, 0x00, 0x3C};
+            break;
+        }
+        case kGetSpecificTerminalParameters: {
+            para->terminal_parameter_ids.clear();
+            for (size_t i = 0; i + 4 <= data.size() && para->terminal_parameter_ids.size() < 255; i += 4)
+                para->terminal_parameter_ids.push_back(static_cast<uint32_t>(data[i] << 24 | data[i + 1] << 16 |
+                                                                             data[i + 2] << 8 | data[i + 3]));
+            if (para->terminal_parameter_ids.empty())
+                para->terminal_parameter_ids.push_back(kTerminalHeartBeatInterval);
+            break;
+        }
+        case kTerminalUpgrade: {
+            auto& info        = para->upgrade_info;
+            info.upgrade_type = kTerminal;
+            info.manufacturer_id.assign({'S', 'K', 'O', 'E', 'M'});
+            info.version_id             = "1.0.0";
+            info.upgrade_data_total_len = DoubleWord(density);
+            info.upgrade_data           = data;
+            break;
+        }
+        case kTerminalUpgradeResultReport:
+            para->upgrade_info.upgrade_type   = kTerminal;
+            para->upgrade_info.upgrade_result = kTerminalUpgradeSuccess;
+            break;
+        case kLocationReport:
+        case kGetLocationInformationResponse:
+            FillLocation(payload, density, para);
+            break;
+        case kBatchLocationReport: {
+            // Location reports with the common standard items, about 60 bytes each.
+            FillLocation(0, density, para);
+            auto& batch_loc     = para->batch_loc;
+            batch_loc.data_type = 0;
+            batch_loc.loc_info.assign(payload / 64 + 1, para->location_info);
+            batch_loc.loc_ext.assign(payload / 64 + 1, para->location_extension);
+            batch_loc.nbr_of_dat = static_cast<uint16_t>(batch_loc.loc_info.size());
+            break;
+        }
+        case kLocationTrackingControl:
+            para->location_tracking_control.interval      = Word(density);
+            para->location_tracking_control.tracking_time = DoubleWord(density);
+            break;
+        case kSetPolygonArea: {
+            auto& area                          = para->polygon_area;
+            area.area_id                        = DoubleWord(density);
+            area.area_attribute.value           = 0;
+            area.area_attribute.bit.speed_limit = 1;
+            area.max_speed                      = 60;
+            area.overspeed_time                 = 10;
+            area.vertices.clear();
+            for (size_t i = 0; i + 8 <= data.size() && area.vertices.size() < 125; i += 8) {
+                LocationPoint point;
+                point.latitude  = (data[i] << 16 | data[i + 1] << 8 | data[i + 2]) / 1e6 + 22.0;
+                point.longitude = (data[i + 4] << 16 | data[i + 5] << 8 | data[i + 6]) / 1e6 + 113.0;
+                point.altitude  = 0;
+                area.vertices.push_back(point);
+            }
+            while (area.vertices.size() < 3)
+                area.vertices.push_back(LocationPoint {113.9 + area.vertices.size() * 0.01, 22.5, 0});
+            break;
+        }
+        case kDeletePolygonArea: {
+            para->polygon_area_id.clear();
+            for (size_t i = 0; i + 4 <= data.size() && para->polygon_area_id.size() < 125; i += 4)
+                para->polygon_area_id.push_back(static_cast<uint32_t>(data[i] << 24 | data[i + 1] << 16 |
+                                                                      data[i + 2] << 8 | data[i + 3]));
+            if (para->polygon_area_id.empty())
+                para->polygon_area_id.push_back(DoubleWord(density));
+            break;
+        }
+        case kMultimediaDataUpload: {
+            auto& upload                = para->multimedia_upload;
+            upload.media_id             = DoubleWord(density);
+            upload.media_type           = 0;
+            upload.media_format         = 0;
+            upload.media_event          = 1;
+            upload.channel_id           = 1;
+            upload.loaction_report_body = MakePayload(28, density);
+            upload.media_data           = data;
+            break;
+        }
+        case kMultimediaDataUploadResponse: {
+            auto& response    = para->multimedia_upload_response;
+            response.media_id = Word(density);
+            response.reload_packet_ids.clear();
+            for (size_t i = 0; i + 1 < data.size() && response.reload_packet_ids.size() < 125; i += 2)
+                response.reload_packet_ids.push_back(static_cast<uint16_t>(data[i] << 8 | data[i + 1]));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Messages whose body does not depend on the payload size.
+bool IsFixedSize(uint16_t const& msg_id) {
+    switch (msg_id) {
+        case kFillPacketRequest:
+        case kTerminalRegisterResponse:
+        case kTerminalAuthentication:
+        case kSetTerminalParameters:
+        case kGetSpecificTerminalParameters:
+        case kGetTerminalParametersResponse:
+        case kTerminalUpgrade:
+        case kLocationReport:
+        case kGetLocationInformationResponse:
+        case kBatchLocationReport:
+        case kSetPolygonArea:
+        case kDeletePolygonArea:
+        case kMultimediaDataUpload:
+        case kMultimediaDataUploadResponse:
+            return false;
+        default:
+            return true;
+    }
+}
+
+Packager const& GetPackager(void) {
+    static Packager packager;
+    if (packager.empty())
+        JT808FramePackagerInit(&packager);
+    return packager;
+}
+
+Parser const& GetParser(void) {
+    static Parser parser;
+    if (parser.empty())
+        JT808FrameParserInit(&parser);
+    return parser;
+}
+
+void BM_Package(benchmark::State& state, uint16_t msg_id) {
+    ProtocolParameter para {};
+    FillParameter(msg_id, state.range(0), state.range(1), &para);
+    auto const&          packager = GetPackager();
+    std::vector<uint8_t> out;
+    size_t               bytes = 0;
+    for (auto _ : state) {
+        out.clear();
+        if (JT808FramePackage(packager, para, &out) != 0) {
+            state.SkipWithError("package failed");
+            break;
+        }
+        bytes += out.size();
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetItemsProcessed(state.iterations());
+    state.counters["frame_bytes"] = static_cast<double>(out.size());
+}
+
+void BM_Parse(benchmark::State& state, uint16_t msg_id) {
+    ProtocolParameter para {};
+    FillParameter(msg_id, state.range(0), state.range(1), &para);
+    Packager packager;
+    JT808FramePackagerInit(&packager);
+    std::vector<uint8_t> frame;
+    if (packager.find(msg_id) == packager.end()) {
+        // Only a parser is registered, use an empty body.
+        JT808FramePackagerAppend(&packager, msg_id, [](ProtocolParameter const&, std::vector<uint8_t>*) { return 0; });
+    }
+    if (JT808FramePackage(packager, para, &frame) != 0) {
+        state.SkipWithError("package failed");
+        return;
+    }
+    auto const&       parser = GetParser();
+    ProtocolParameter parsed {};
+    for (auto _ : state) {
+        if (JT808FrameParse(parser, frame, &parsed) != 0) {
+            state.SkipWithError("parse failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * frame.size()));
+    state.SetItemsProcessed(state.iterations());
+    state.counters["frame_bytes"] = static_cast<double>(frame.size());
+}
+
+// Decode a 0x0200 frame and read it through LocationReportView, the path of the typed server callbacks.
+void BM_LocationReportView(benchmark::State& state) {
+    ProtocolParameter para {};
+    FillParameter(kLocationReport, state.range(0), state.range(1), &para);
+    std::vector<uint8_t> frame;
+    if (JT808FramePackage(GetPackager(), para, &frame) != 0) {
+        state.SkipWithError("package failed");
+        return;
+    }
+    std::vector<uint8_t> decoded;
+    MsgHead              msg_head;
+    for (auto _ : state) {
+        if (JT808FrameDecode(frame, &decoded, &msg_head) != 0) {
+            state.SkipWithError("decode failed");
+            break;
+        }
+        LocationReportView const view(
+            ByteSpan(decoded.data() + MSGBODY_NOPACKET_POS, msg_head.msgbody_attr.bit.msglen));
+        uint32_t sum = view.latitude() + view.longitude() + view.speed() + view.alarm().value;
+        auto     cursor = view.extensions();
+        uint8_t  id;
+        ByteSpan value;
+        while (cursor.Next(&id, &value))
+            sum += id + static_cast<uint32_t>(value.size);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * frame.size()));
+    state.SetItemsProcessed(state.iterations());
+    state.counters["frame_bytes"] = static_cast<double>(frame.size());
+}
+
+// Decode a 0x0704 frame into reused LocationColumns, compare with Parse/0x0704.
+void BM_BatchLocationColumns(benchmark::State& state) {
+    ProtocolParameter para {};
+    FillParameter(kBatchLocationReport, state.range(0), state.range(1), &para);
+    std::vector<uint8_t> frame;
+    if (JT808FramePackage(GetPackager(), para, &frame) != 0) {
+        state.SkipWithError("package failed");
+        return;
+    }
+    std::vector<uint8_t> decoded;
+    MsgHead              msg_head;
+    LocationColumns      columns;
+    for (auto _ : state) {
+        if (JT808FrameDecode(frame, &decoded, &msg_head) != 0) {
+            state.SkipWithError("decode failed");
+            break;
+        }
+        columns.clear();
+        if (JT808BatchLocationDecode(ByteSpan(decoded.data() + MSGBODY_NOPACKET_POS, msg_head.msgbody_attr.bit.msglen),
+                                     &columns) != 0) {
+            state.SkipWithError("columnar decode failed");
+            break;
+        }
+        benchmark::DoNotOptimize(columns.latitude.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * frame.size()));
+    state.SetItemsProcessed(state.iterations());
+    state.counters["frame_bytes"] = static_cast<double>(frame.size());
+    state.counters["points"]      = static_cast<double>(columns.size());
+}
+
+// Decode the 0xEA basic data flow item of every point of columnar 0x0704 results.
+void BM_BasicDataFlowColumns(benchmark::State& state) {
+    // Location basic information, mileage and a basic data flow item with 12 sub-items.
+    std::vector<uint8_t> body(28, 0);
+    body.insert(body.end(), {kMileage, 4, 0x00, 0x01, 0x86, 0xA0, kBasicDataFlow, 0});
+    size_t const flow_pos = body.size();
+    for (uint16_t id : {kTotalMileage, kTotalFuelConsumption, kTotalEngineRunningTime, kTotalIdleTime}) {
+        body.insert(body.end(), {0x00, static_cast<uint8_t>(id), 4, 0x00, 0x12, 0x34, 0x56});
+    }
+    for (uint16_t id : {kExternalVoltage, kBuildInBattVoltage, kGPSLocationAccuracy}) {
+        body.insert(body.end(), {0x00, static_cast<uint8_t>(id), 2, 0x00, 0x7B});
+    }
+    for (uint16_t id : {kCSQ, kGPSSatelliteNumber, kGPSAvgSNR, kIgnitionType}) {
+        body.insert(body.end(), {0x00, static_cast<uint8_t>(id), 1, 0x1F});
+    }
+    body.insert(body.end(), {0x00, kAccelerometerData, 6, 0x00, 0x10, 0xFF, 0xF0, 0x03, 0xE8});
+    body[flow_pos - 1] = static_cast<uint8_t>(body.size() - flow_pos);
+    LocationColumns columns;
+    for (int64_t i = 0; i < state.range(0); ++i)
+        JT808LocationColumnsAppend(LocationReportView(ByteSpan(body.data(), body.size())), &columns);
+    std::vector<BasicDataFlow> flows;
+    for (auto _ : state) {
+        if (JT808BasicDataFlowDecodeColumns(columns, &flows) != state.range(0)) {
+            state.SkipWithError("basic data flow decode failed");
+            break;
+        }
+        benchmark::DoNotOptimize(flows.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Find the polygon areas containing random points among range(0) small polygons spread over China.
+void BM_GeofenceQuery(benchmark::State& state) {
+    std::mt19937                           random(808);
+    std::uniform_real_distribution<double> latitude(18.0, 53.0);
+    std::uniform_real_distribution<double> longitude(73.0, 135.0);
+    std::uniform_real_distribution<double> radius(0.005, 0.05);
+    GeofenceAreas                          areas;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        PolygonArea area;
+        area.area_id              = static_cast<uint32_t>(i + 1);
+        area.area_attribute.value = 0;
+        double const lat          = latitude(random);
+        double const lon          = longitude(random);
+        double const r            = radius(random);
+        for (int v = 0; v < 6; ++v)
+            area.vertices.push_back(LocationPoint {lon + r * cos(v * 1.0472), lat + r * sin(v * 1.0472), 0.0f});
+        areas.Insert(area);
+    }
+    // Half of the points at the center of an area, half anywhere.
+    std::vector<std::pair<int32_t, int32_t>> points;
+    for (uint32_t i = 0; i < 4096; ++i) {
+        if (i % 2 == 0) {
+            auto const& box = areas.area(static_cast<uint32_t>(random() % areas.slot_count())).box;
+            points.emplace_back((box.min_lat + box.max_lat) / 2, (box.min_lon + box.max_lon) / 2);
+        }
+        else {
+            points.emplace_back(static_cast<int32_t>(latitude(random) * 1e6),
+                                static_cast<int32_t>(longitude(random) * 1e6));
+        }
+    }
+    std::vector<GeofenceAreas::Hit> hits;
+    size_t                          found = 0;
+    size_t                          next  = 0;
+    for (auto _ : state) {
+        auto const& point = points[next++ & 4095];
+        hits.clear();
+        found += areas.Query(point.first, point.second, &hits);
+        benchmark::DoNotOptimize(hits.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hit_rate"] = static_cast<double>(found) / static_cast<double>(state.iterations());
+}
+
+// Evaluate one report per vehicle and second for range(0) vehicles sharing 10000 circular areas with speed limits.
+// Each vehicle drives round a circle crossing the border of one area, so the reports mix enter, exit and overspeed
+// events. items_per_second is the number of vehicles reporting at 1 Hz one core keeps up with.
+void BM_GeofenceEvaluate(benchmark::State& state) {
+    constexpr int                          kSteps = 16; // Reports of a round.
+    std::mt19937                           random(808);
+    std::uniform_real_distribution<double> latitude(18.0, 53.0);
+    std::uniform_real_distribution<double> longitude(73.0, 135.0);
+    std::uniform_real_distribution<double> radius(500.0, 2000.0);
+    auto                                   areas = std::make_shared<GeofenceAreas>();
+    for (uint32_t i = 0; i < 10000; ++i) {
+        CircularArea area;
+        area.area_id                        = i + 1;
+        area.area_attribute.value           = 0;
+        area.area_attribute.bit.speed_limit = 1;
+        area.center                         = LocationPoint {longitude(random), latitude(random), 0.0f};
+        area.radius                         = static_cast<uint32_t>(radius(random));
+        area.max_speed                      = 60;
+        area.overspeed_time                 = 3;
+        areas->Insert(area);
+    }
+    GeofenceEngine                           engine;
+    size_t const                             vehicles = static_cast<size_t>(state.range(0));
+    std::vector<std::string>                 phones(vehicles);
+    std::vector<std::pair<int32_t, int32_t>> track(vehicles * kSteps);
+    for (size_t i = 0; i < vehicles; ++i) {
+        phones[i] = std::to_string(13500000000ULL + i);
+        engine.SetAreas(phones[i], areas);
+        auto const& area = areas->area(static_cast<uint32_t>(random() % areas->slot_count()));
+        // A round as large as the area, centered on its border.
+        double const lat_radius = area.radius / 111195.08;
+        double const lon_radius = lat_radius / cos(area.center_lat * 1e-6 * 3.14159265358979323846 / 180.0);
+        for (int step = 0; step < kSteps; ++step) {
+            double const angle = step * 2.0 * 3.14159265358979323846 / kSteps;
+            track[i * kSteps + step] =
+                std::make_pair(static_cast<int32_t>(area.center_lat + lat_radius * 1e6 * sin(angle)),
+                               static_cast<int32_t>(area.center_lon + lon_radius * 1e6 * (1.0 + cos(angle))));
+        }
+    }
+    uint8_t    body[28] = {0};
+    auto const store    = [&body](size_t const& pos, uint32_t const& value, size_t const& len) {
+        for (size_t i = 0; i < len; ++i)
+            body[pos + i] = static_cast<uint8_t>(value >> (8 * (len - 1 - i)));
+    };
+    StatusBit status;
+    status.value           = 0;
+    status.bit.positioning = 1;
+    store(4, status.value, 4);
+    BcdTimestamp time;
+    int64_t      now = 1792368000; // 2026-10-19.
+    std::vector<GeofenceEvent> events;
+    size_t                     event_count = 0;
+    size_t                     vehicle     = 0;
+    size_t                     step        = 0;
+    for (auto _ : state) {
+        if (vehicle == 0) {
+            time.FromEpoch(++now);
+            memcpy(body + 22, time.bcd, sizeof(time.bcd));
+        }
+        auto const& point = track[vehicle * kSteps + step];
+        store(8, static_cast<uint32_t>(point.first), 4);
+        store(12, static_cast<uint32_t>(point.second), 4);
+        store(18, step < kSteps / 2 ? 400 : 800, 2);
+        events.clear();
+        event_count += engine.Evaluate(phones[vehicle], LocationReportView(ByteSpan(body, sizeof(body))), &events);
+        if (++vehicle == vehicles) {
+            vehicle = 0;
+            step    = (step + 1) % kSteps;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["events"] = static_cast<double>(event_count) / static_cast<double>(state.iterations());
+}
+
+// A circle-like polygon with range(0) vertices and points spread over twice its bounding box.
+void MakePolygonPoints(int64_t const& vertices, PolygonEdges* edges, std::vector<int32_t>* lat,
+                       std::vector<int32_t>* lon) {
+    std::vector<int32_t> vertex_lat;
+    std::vector<int32_t> vertex_lon;
+    for (int64_t i = 0; i < vertices; ++i) {
+        // A wavy outline so the points are near many edges.
+        double const angle  = 6.283185307 * static_cast<double>(i) / static_cast<double>(vertices);
+        double const radius = 0.5 + 0.05 * sin(angle * 37.0);
+        vertex_lat.push_back(static_cast<int32_t>((30.0 + radius * sin(angle)) * 1e6));
+        vertex_lon.push_back(static_cast<int32_t>((114.0 + radius * cos(angle)) * 1e6));
+    }
+    PolygonEdgesBuild(vertex_lat.data(), vertex_lon.data(), vertex_lat.size(), edges);
+    std::mt19937                       random(808);
+    std::uniform_int_distribution<int> offset(-1100000, 1100000);
+    for (int i = 0; i < 4096; ++i) {
+        lat->push_back(30000000 + offset(random));
+        lon->push_back(114000000 + offset(random));
+    }
+}
+
+// Test points one by one against one polygon.
+void BM_PointInPolygon(benchmark::State& state, PolygonKernel kernel) {
+    PolygonKernel const previous = GetPolygonKernel();
+    if (SetPolygonKernel(kernel) != 0) {
+        state.SkipWithError("kernel not supported");
+        return;
+    }
+    PolygonEdges         edges;
+    std::vector<int32_t> lat;
+    std::vector<int32_t> lon;
+    MakePolygonPoints(state.range(0), &edges, &lat, &lon);
+    size_t next = 0;
+    for (auto _ : state) {
+        size_t const i = next++ & 4095;
+        benchmark::DoNotOptimize(PolygonEdgesContains(edges, lat[i], lon[i]));
+    }
+    SetPolygonKernel(previous);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Test 4096 points at once against one polygon.
+void BM_PointInPolygonBatch(benchmark::State& state, PolygonKernel kernel) {
+    PolygonKernel const previous = GetPolygonKernel();
+    if (SetPolygonKernel(kernel) != 0) {
+        state.SkipWithError("kernel not supported");
+        return;
+    }
+    PolygonEdges         edges;
+    std::vector<int32_t> lat;
+    std::vector<int32_t> lon;
+    MakePolygonPoints(state.range(0), &edges, &lat, &lon);
+    std::vector<uint8_t> inside(lat.size());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PolygonEdgesContainsBatch(edges, lat.data(), lon.data(), lat.size(), inside.data()));
+    }
+    SetPolygonKernel(previous);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lat.size()));
+}
+
+void BM_Escape(benchmark::State& state) {
+    auto const           in = MakePayload(static_cast<size_t>(state.range(0)), state.range(1));
+    std::vector<uint8_t> out;
+    for (auto _ : state) {
+        out.clear();
+        Escape(in, &out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * in.size()));
+}
+
+void BM_ReverseEscape(benchmark::State& state) {
+    std::vector<uint8_t> in;
+    Escape(MakePayload(static_cast<size_t>(state.range(0)), state.range(1)), &in);
+    std::vector<uint8_t> out;
+    for (auto _ : state) {
+        out.clear();
+        ReverseEscape(in, &out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * in.size()));
+}
+
+void BM_BccCheckSum(benchmark::State& state) {
+    auto const in = MakePayload(static_cast<size_t>(state.range(0)), state.range(1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(BccCheckSum(in.data(), in.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * in.size()));
+}
+
+void BM_StringToBcd(benchmark::State& state, std::string const& in) {
+    std::vector<uint8_t> out;
+    for (auto _ : state) {
+        out.clear();
+        StringToBcd(in, &out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * in.size()));
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_BcdToString(benchmark::State& state, std::string const& in) {
+    std::vector<uint8_t> bcd;
+    StringToBcd(in, &bcd);
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        BcdToString(bcd, &out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bcd.size()));
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_FrameExtract(benchmark::State& state) {
+    // A stream of location reports split into 1460 byte TCP segments.
+    ProtocolParameter para {};
+    FillParameter(kLocationReport, state.range(0), state.range(1), &para);
+    std::vector<uint8_t> frame;
+    JT808FramePackage(GetPackager(), para, &frame);
+    std::vector<uint8_t> stream;
+    while (stream.size() < 64 * 1024)
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    std::vector<uint8_t>              buffer;
+    std::vector<std::vector<uint8_t>> frames;
+    size_t                            count = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < stream.size(); i += 1460) {
+            size_t len = stream.size() - i;
+            if (len > 1460)
+                len = 1460;
+            buffer.insert(buffer.end(), stream.begin() + i, stream.begin() + i + len);
+            frames.clear();
+            JT808FrameExtract(&buffer, &frames);
+            count += frames.size();
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stream.size()));
+    state.SetItemsProcessed(static_cast<int64_t>(count));
+}
+
+// Metrics updates done by the server for every received frame, run multi-threaded to show the sharding.
+void BM_MetricsFrameReceived(benchmark::State& state) {
+    static JT808Metrics metrics;
+    for (auto _ : state) {
+        metrics.OnBytesReceived(64);
+        metrics.OnFrameReceived(kLocationReport);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MetricsHistogramRecord(benchmark::State& state) {
+    static MetricHistogram histogram;
+    uint64_t               value = 0;
+    for (auto _ : state)
+        histogram.Record(value++ & 0xFFFFF);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void ApplyBufferArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"bytes", "escape_pct"});
+    for (auto const& size : kBufferSizes) {
+        for (auto const& density : kEscapeDensities)
+            bench->Args({size, density});
+    }
+}
+
+void ApplyMessageArgs(benchmark::internal::Benchmark* bench, uint16_t const& msg_id) {
+    bench->ArgNames({"payload", "escape_pct"});
+    for (auto const& size : kPayloadSizes) {
+        for (auto const& density : kMessageEscapeDensities)
+            bench->Args({size, density});
+        if (IsFixedSize(msg_id))
+            break;
+    }
+}
+
+std::string MessageName(char const* prefix, uint16_t const& msg_id) {
+    char name[32] = {0};
+    snprintf(name, sizeof(name), "%s/0x%04X", prefix, msg_id);
+    return name;
+}
+
+void RegisterBenchmarks(void) {
+    ApplyBufferArgs(benchmark::RegisterBenchmark("Escape", BM_Escape));
+    ApplyBufferArgs(benchmark::RegisterBenchmark("ReverseEscape", BM_ReverseEscape));
+    ApplyBufferArgs(benchmark::RegisterBenchmark("BccCheckSum", BM_BccCheckSum));
+    benchmark::RegisterBenchmark("StringToBcd/phone", BM_StringToBcd, std::string(kPhoneNumber));
+    benchmark::RegisterBenchmark("StringToBcd/time", BM_StringToBcd, std::string("200702145429"));
+    benchmark::RegisterBenchmark("BcdToString/phone", BM_BcdToString, std::string(kPhoneNumber));
+    benchmark::RegisterBenchmark("BcdToString/time", BM_BcdToString, std::string("200702145429"));
+    benchmark::RegisterBenchmark("FrameExtract/0x0200", BM_FrameExtract)
+        ->ArgNames({"payload", "escape_pct"})
+        ->Args({16, 0})
+        ->Args({256, 10});
+    benchmark::RegisterBenchmark("Metrics/FrameReceived", BM_MetricsFrameReceived)->ThreadRange(1, 8);
+    benchmark::RegisterBenchmark("Metrics/HistogramRecord", BM_MetricsHistogramRecord)->ThreadRange(1, 8);
+    // Every registered message, so newly added commands are measured too.
+    for (auto const& item : GetPackager()) {
+        ApplyMessageArgs(benchmark::RegisterBenchmark(MessageName("Package", item.first).c_str(), BM_Package,
+                                                      item.first),
+                         item.first);
+    }
+    ApplyMessageArgs(benchmark::RegisterBenchmark("View/0x0200", BM_LocationReportView), kLocationReport);
+    ApplyMessageArgs(benchmark::RegisterBenchmark("Columnar/0x0704", BM_BatchLocationColumns), kBatchLocationReport);
+    benchmark::RegisterBenchmark("BasicDataFlow/columns", BM_BasicDataFlowColumns)
+        ->ArgName("points")
+        ->Arg(1)
+        ->Arg(16)
+        ->Arg(256);
+    benchmark::RegisterBenchmark("Geofence/Query", BM_GeofenceQuery)
+        ->ArgName("polygons")
+        ->Arg(1000)
+        ->Arg(100000);
+    benchmark::RegisterBenchmark("Geofence/Evaluate", BM_GeofenceEvaluate)
+        ->ArgName("vehicles")
+        ->Arg(10000)
+        ->Arg(100000);
+    std::pair<char const*, PolygonKernel> const kernels[] = {
+        {"scalar", kPolygonKernelScalar}, {"sse4.2", kPolygonKernelSse42}, {"avx2", kPolygonKernelAvx2}};
+    for (auto const& kernel : kernels) {
+        benchmark::RegisterBenchmark((std::string("PointInPolygon/") + kernel.first).c_str(), BM_PointInPolygon,
+                                     kernel.second)
+            ->ArgName("vertices")
+            ->Arg(16)
+            ->Arg(1024)
+            ->Arg(4096);
+        benchmark::RegisterBenchmark((std::string("PointInPolygonBatch/") + kernel.first).c_str(),
+                                     BM_PointInPolygonBatch, kernel.second)
+            ->ArgName("vertices")
+            ->Arg(16)
+            ->Arg(1024);
+    }
+    for (auto const& item : GetParser()) {
+        ApplyMessageArgs(benchmark::RegisterBenchmark(MessageName("Parse", item.first).c_str(), BM_Parse, item.first),
+                         item.first);
+    }
+}
+
+} // namespace
+
+} // namespace libjt808
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    libjt808::RegisterBenchmarks();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
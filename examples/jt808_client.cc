@@ -35,7 +35,7 @@
 #include "jt808/client.h"
 
 
-using LocationExtensions = std::map<uint8_t, std::vector<uint8_t>>;
+using LocationExtensions = libjt808::LocationExtensions;
 
 namespace {
 
@@ -43,33 +43,16 @@ constexpr uint8_t kPositioningFixStatus = 0xEE;
 
 int UpdateGNSSSatelliteNumber( uint8_t const& num, LocationExtensions* items) {
   if (items == nullptr) return -1;
-  auto const& it = items->find(libjt808::kGnssSatellites);
-  if (it != items->end()) {
-    it->second.clear();
-    it->second.push_back(num);
-  } else {
-   items->insert(
-      std::make_pair(libjt808::kGnssSatellites, std::vector<uint8_t>{num}));
-  }
+  items->Set(libjt808::kGnssSatellites, {num});
   return 0;
 }
 
 void UpdateGNSSPositioningSolutionStatus(
     uint8_t const& fix, LocationExtensions* items) {
-  auto const& it = items->find(kPositioningFixStatus);
-  if (it != items->end()) {
-    it->second.clear();
-    it->second.push_back(fix);
-  } else {
-    items->insert(
-        std::make_pair(kPositioningFixStatus, std::vector<uint8_t>{fix}));
-  }
+  items->Set(kPositioningFixStatus, {fix});
   // 检查后续自定义信息长度项是否存在.
-  auto const& iter =
-      items->find(libjt808::kCustomInformationLength);
-  if (iter == items->end()) {
-   items->insert(
-      std::make_pair(libjt808::kCustomInformationLength, std::vector<uint8_t>{0}));
+  if (items->count(libjt808::kCustomInformationLength) == 0) {
+    items->Set(libjt808::kCustomInformationLength, {0});
   }
 }
 
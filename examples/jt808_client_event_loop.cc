@@ -0,0 +1,311 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// @File    :  jt808_client_event_loop.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 21:14:37
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+// Many JT808Client terminals on one thread.
+// Every client runs in the event driven mode on a single epoll loop: connect, register, authenticate, then 1Hz
+// location reports and heartbeats, with the platform commands handled as by JT808Client::Run(). Clients whose
+// connection fails are reconnected after 5 seconds. Prints the number of authenticated clients every second.
+//
+// Usage:
+//     jt808_client_event_loop [-a ip] [-p port] [-n clients] [-t seconds] [-s]
+//     -s starts a JT808Server in the same process.
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jt808/client.h"
+#include "jt808/server.h"
+
+namespace libjt808 {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+volatile sig_atomic_t g_stop = 0;
+
+// Counted by the in-process server.
+std::atomic<uint64_t> g_location_reports(0);
+
+void SignalHandler(int) {
+    g_stop = 1;
+}
+
+struct Config {
+    std::string ip                = "127.0.0.1";
+    int         port              = 8888;
+    int         clients           = 1000;
+    int         duration          = 60; // Seconds.
+    bool        in_process_server = false;
+};
+
+struct Terminal {
+    std::unique_ptr<JT808Client> client;
+    Clock::time_point            next;    // Next HandleTimer(), or reconnection.
+    bool                         watched;       // Registered in epoll.
+    bool                         writing;       // Watched for writing.
+    bool                         authenticated; // As of the last Handle call.
+};
+
+class EventLoop {
+public:
+    explicit EventLoop(Config const& config) : config_(config), epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+    }
+
+    ~EventLoop() {
+        for (auto& terminal : terminals_)
+            Disconnect(&terminal);
+        close(epoll_fd_);
+    }
+
+    void Run(void) {
+        terminals_.resize(static_cast<size_t>(config_.clients));
+        auto const start = Clock::now();
+        for (size_t i = 0; i < terminals_.size(); ++i) {
+            auto& terminal = terminals_[i];
+            terminal.client.reset(new JT808Client());
+            terminal.client->Init();
+            terminal.client->SetRemoteAccessPoint(config_.ip, config_.port);
+            terminal.client->SetTerminalPhoneNumber(std::to_string(13900000000ULL + i));
+            terminal.client->set_location_report_inteval(1);
+            terminal.client->SetTerminalHeartbeatInterval(30);
+            terminal.watched       = false;
+            terminal.writing       = false;
+            terminal.authenticated = false;
+            // Spread the connections over the first second.
+            Schedule(i, start + std::chrono::microseconds(1000000 * i / terminals_.size()));
+        }
+        auto                     report = start + std::chrono::seconds(1);
+        auto const               stop   = start + std::chrono::seconds(config_.duration);
+        std::vector<epoll_event> events(1024);
+        while (!g_stop && Clock::now() < stop) {
+            int const timeout = timers_.empty() ? 1000 : MillisecondsUntil(timers_.top().first);
+            int const count   = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout);
+            for (int i = 0; i < count; ++i) {
+                size_t const index    = events[i].data.u32;
+                auto&        terminal = terminals_[index];
+                int          ret      = 0;
+                if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+                    ret = terminal.client->HandleWritable();
+                if (ret == 0 && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+                    ret = terminal.client->HandleReadable();
+                Update(index, ret, false);
+            }
+            auto const now = Clock::now();
+            while (!timers_.empty() && timers_.top().first <= now) {
+                auto const   timer    = timers_.top();
+                size_t const index    = timer.second;
+                auto&        terminal = terminals_[index];
+                timers_.pop();
+                if (timer.first != terminal.next)
+                    continue; // Rescheduled.
+                if (!terminal.watched) {
+                    Connect(index);
+                    continue;
+                }
+                UpdateLocation(terminal.client.get());
+                Update(index, terminal.client->HandleTimer(), true);
+            }
+            if (now >= report) {
+                report += std::chrono::seconds(1);
+                size_t authenticated = 0;
+                for (auto const& terminal : terminals_)
+                    authenticated += terminal.client->is_authenticated() ? 1 : 0;
+                printf("%zu/%zu clients authenticated, %zu reconnections\n", authenticated, terminals_.size(),
+                       reconnections_);
+            }
+        }
+    }
+
+private:
+    int MillisecondsUntil(Clock::time_point const& tp) const {
+        auto const ms = std::chrono::duration_cast<std::chrono::milliseconds>(tp - Clock::now()).count();
+        return ms < 0 ? 0 : static_cast<int>(ms < 1000 ? ms + 1 : 1000);
+    }
+
+    void Schedule(size_t const& index, Clock::time_point const& tp) {
+        terminals_[index].next = tp;
+        timers_.push(std::make_pair(tp, index));
+    }
+
+    void Connect(size_t const& index) {
+        auto& terminal = terminals_[index];
+        if (terminal.client->ConnectRemoteNonBlocking() != 0) {
+            Schedule(index, Clock::now() + std::chrono::seconds(5));
+            ++reconnections_;
+            return;
+        }
+        epoll_event event;
+        event.events   = EPOLLIN | EPOLLOUT;
+        event.data.u64 = 0;
+        event.data.u32 = static_cast<uint32_t>(index);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, terminal.client->socket_fd(), &event);
+        terminal.watched = true;
+        terminal.writing = true;
+        Update(index, terminal.client->HandleTimer(), true);
+    }
+
+    void Disconnect(Terminal* terminal) {
+        if (terminal->watched)
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, terminal->client->socket_fd(), nullptr);
+        terminal->watched       = false;
+        terminal->writing       = false;
+        terminal->authenticated = false;
+        if (terminal->client != nullptr)
+            terminal->client->Stop();
+    }
+
+    // Follow a client after one of its Handle calls returned ret, timer if it was HandleTimer().
+    void Update(size_t const& index, int const& ret, bool const& timer) {
+        auto& terminal = terminals_[index];
+        if (!terminal.watched)
+            return;
+        if (ret < 0) {
+            Disconnect(&terminal);
+            Schedule(index, Clock::now() + std::chrono::seconds(5));
+            ++reconnections_;
+            return;
+        }
+        bool const writing = terminal.client->want_write();
+        if (writing != terminal.writing) {
+            epoll_event event;
+            event.events   = EPOLLIN | (writing ? EPOLLOUT : 0);
+            event.data.u64 = 0;
+            event.data.u32 = static_cast<uint32_t>(index);
+            epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, terminal.client->socket_fd(), &event);
+            terminal.writing = writing;
+        }
+        // HandleTimer() returns the delay, the reports start once authenticated.
+        bool const authenticated = terminal.client->is_authenticated();
+        if (timer)
+            Schedule(index, Clock::now() + std::chrono::milliseconds(ret));
+        else if (authenticated != terminal.authenticated)
+            Schedule(index, Clock::now());
+        terminal.authenticated = authenticated;
+    }
+
+    // A fixed position with the current time.
+    static void UpdateLocation(JT808Client* client) {
+        LocationBasicInformation info;
+        info.alarm.value            = 0;
+        info.status.value           = 0;
+        info.status.bit.positioning = 1;
+        info.latitude               = 22543096;
+        info.longitude              = 114057865;
+        info.altitude               = 10;
+        info.speed                  = 0;
+        info.bearing                = 0;
+        info.time.FromEpoch(static_cast<int64_t>(time(nullptr)));
+        client->UpdateLocation(info);
+    }
+
+    using Timer = std::pair<Clock::time_point, size_t>;
+
+    Config                                                              config_;
+    int                                                                 epoll_fd_;
+    std::vector<Terminal>                                               terminals_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    size_t                                                              reconnections_ = 0;
+};
+
+void Usage(char const* name) {
+    printf("Usage: %s [-a ip] [-p port] [-n clients] [-t seconds] [-s]\n", name);
+}
+
+} // namespace
+
+} // namespace libjt808
+
+int main(int argc, char** argv) {
+    libjt808::Config config;
+    int              opt = 0;
+    while ((opt = getopt(argc, argv, "a:p:n:t:sh")) != -1) {
+        switch (opt) {
+            case 'a': config.ip = optarg; break;
+            case 'p': config.port = atoi(optarg); break;
+            case 'n': config.clients = atoi(optarg); break;
+            case 't': config.duration = atoi(optarg); break;
+            case 's': config.in_process_server = true; break;
+            default: libjt808::Usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (config.clients <= 0) {
+        libjt808::Usage(argv[0]);
+        return 1;
+    }
+    signal(SIGINT, libjt808::SignalHandler);
+    signal(SIGPIPE, SIG_IGN);
+    // Every client needs a descriptor, twice as many with the in-process server.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    std::unique_ptr<libjt808::JT808Server> server;
+    if (config.in_process_server) {
+        server.reset(new libjt808::JT808Server());
+        server->Init();
+        server->SetServerAccessPoint(config.ip, config.port);
+        server->set_max_connection_num(config.clients);
+        server->OnLocationReport([](libjt808::MsgHead const&, libjt808::LocationReportView const&) {
+            libjt808::g_location_reports.fetch_add(1, std::memory_order_relaxed);
+        });
+        if (server->InitServer() != 0) {
+            printf("Start server failed!!!\n");
+            return 1;
+        }
+        server->Run();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    {
+        libjt808::EventLoop loop(config);
+        loop.Run();
+    }
+    if (server != nullptr) {
+        printf("%lu location reports received\n", static_cast<unsigned long>(libjt808::g_location_reports.load()));
+        // Deliberately leaked, not stopped: JT808Server::Stop() races with the Stop() its own detached service
+        // thread makes, and that thread may still use the server after Stop() returns. The process exits next.
+        server.release();
+    }
+    return 0;
+}
@@ -274,8 +274,8 @@ int main(int argc, char **argv) {
           if (libjt808::SetAccessAreaAlarmBody(
             libjt808::kAccessAreaAlarmPolygonArea, area.first,
             libjt808::kAccessAreaAlarmInArea, &item_value) == 0) {
-            cli_para.location_extension.insert(
-                std::make_pair(libjt808::kAccessAreaAlarm, item_value));
+            cli_para.location_extension.Set(libjt808::kAccessAreaAlarm,
+                                            item_value);
           }
           ++in_out_area_flag;
           break;
@@ -292,8 +292,8 @@ int main(int argc, char **argv) {
           if (libjt808::SetAccessAreaAlarmBody(
             libjt808::kAccessAreaAlarmPolygonArea, last_in_out_area_id,
             libjt808::kAccessAreaAlarmOutArea, &item_value) == 0) {
-            cli_para.location_extension.insert(
-                std::make_pair(libjt808::kAccessAreaAlarm, item_value));
+            cli_para.location_extension.Set(libjt808::kAccessAreaAlarm,
+                                            item_value);
           }
         }
         ++in_out_area_flag;
@@ -314,33 +314,23 @@ int main(int argc, char **argv) {
           static_cast<uint16_t>(location.altitude);
       cli_para.location_info.speed = static_cast<uint16_t>(location.speed/10);
       cli_para.location_info.bearing = static_cast<uint16_t>(location.bearing);
-      cli_para.location_info.time.clear();
-      cli_para.location_info.time.assign(location.utc_time,
-                                         location.utc_time+12);
+      cli_para.location_info.time.Assign(
+          std::string(location.utc_time, location.utc_time+12));
       uint8_t temp = static_cast<uint8_t>(location.satellites_used);
-      cli_para.location_extension.insert(std::make_pair(
-          libjt808::kGnssSatellites, std::vector<uint8_t>{temp}));
-      cli_para.location_extension.insert(std::make_pair(
-          libjt808::kCustomInformationLength, std::vector<uint8_t>{1}));
+      cli_para.location_extension.Set(libjt808::kGnssSatellites, {temp});
+      cli_para.location_extension.Set(libjt808::kCustomInformationLength, {1});
       temp = static_cast<uint8_t>(location.position);
-      cli_para.location_extension.insert(std::make_pair(
-          libjt808::kPositioningStatus, std::vector<uint8_t>{temp}));
+      cli_para.location_extension.Set(libjt808::kPositioningStatus, {temp});
       cli_para.msg_head.msg_id = libjt808::kLocationReport;
       if (libjt808::JT808FramePackage(jt808_packager, cli_para, &out) < 0) {
         printf("Generate message failed\n");
         return;
       }
-      for (auto& item : cli_para.location_extension) {
-        item.second.clear();
-      }
       cli_para.location_extension.clear();
       ++cli_para.msg_head.msg_flow_num;
       //
       // 解析消息.
       //
-      for (auto& item : svr_para.parse.location_extension) {
-        item.second.clear();
-      }
       svr_para.parse.location_extension.clear();
       if (libjt808::JT808FrameParse(jt808_parser, out, &svr_para) == 0) {
         auto const& basic_info = svr_para.parse.location_info;
@@ -352,7 +342,7 @@ int main(int argc, char **argv) {
         printf("atitude: %d\n", basic_info.altitude);
         printf("speed: %d\n", basic_info.speed*10);
         printf("bearing: %d\n", basic_info.bearing);
-        printf("time: %s\n", basic_info.time.c_str());
+        printf("time: %s\n", basic_info.time.ToString().c_str());
         auto it = extension_info.find(libjt808::kGnssSatellites);
         if (it != extension_info.end())
           printf("satellites number: %d\n", it->second[0]);
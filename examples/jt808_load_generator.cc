@@ -0,0 +1,898 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  jt808_load_generator.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 12:05:52
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+// Fleet load generator.
+// Emulates N terminals on a single epoll loop: register, authenticate, 1Hz location reports with extensions,
+// heartbeats, periodic 0x0704 batch reports and occasional fragmented 0x0801 uploads. Prints the achieved throughput
+// every second and the latency histograms of every request/response pair at the end.
+//
+// Usage:
+//     jt808_load_generator [-a ip] [-p port] [-n terminals] [-t seconds] [-r connects per second]
+//                          [-l location interval ms] [-b heartbeat s] [-B batch s] [-m multimedia s]
+//                          [-M multimedia bytes] [-s] [-w capture file] [-e metrics port]
+//     -s starts a JT808Server in the same process, -w records its traffic for jt808_replay and -e serves its metrics
+//     in the Prometheus text format. The in-process server checks the size of every multimedia upload it receives.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jt808/packager.h"
+#include "jt808/parser.h"
+#include "jt808/server.h"
+#include "jt808/util.h"
+
+namespace libjt808 {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint8_t kManufacturerId[] = {'S', 'K', 'O', 'E', 'M'};
+
+constexpr uint8_t kTerminalModel[] = {'S', 'K', '9', '1', '5', '1'};
+
+// Fragment size of the multimedia upload.
+constexpr size_t kMediaFragmentLength = 1000;
+
+// Multimedia ID, type, format, event, channel and location report, repeated in every fragment like JT808Client.
+constexpr size_t kMediaHeaderLength = 36;
+
+// Requests without a response after this long are counted as timed out.
+constexpr int kResponseTimeoutSeconds = 30;
+
+volatile sig_atomic_t g_stop = 0;
+
+void SignalHandler(int) {
+    g_stop = 1;
+}
+
+struct Config {
+    std::string ip                  = "127.0.0.1";
+    int         port                = 8888;
+    int         terminals           = 1000;
+    int         duration            = 60;   // Seconds.
+    int         connect_rate        = 500;  // Connections started per second.
+    int         location_interval   = 1000; // Milliseconds.
+    int         heartbeat_interval  = 30;   // Seconds.
+    int         batch_interval      = 60;   // Seconds, 0 disables 0x0704.
+    int         batch_size          = 10;   // Locations per 0x0704.
+    int         multimedia_interval = 300;  // Seconds, 0 disables 0x0801.
+    int         multimedia_size     = 4096; // Bytes.
+    bool        in_process_server   = false;
+    std::string capture_path;
+    int         metrics_port        = 0;
+};
+
+// Log-linear latency histogram of microseconds, 16 sub-buckets per power of two (relative error < 6.25%).
+class LatencyHistogram {
+public:
+    LatencyHistogram() : buckets_(kBucketCount, 0), count_(0), sum_(0), min_(UINT64_MAX), max_(0) {
+    }
+
+    void Record(int64_t const& value) {
+        uint64_t const us = value < 0 ? 0 : static_cast<uint64_t>(value);
+        ++buckets_[Index(us)];
+        ++count_;
+        sum_ += us;
+        if (us < min_)
+            min_ = us;
+        if (us > max_)
+            max_ = us;
+    }
+
+    uint64_t count(void) const {
+        return count_;
+    }
+
+    // Upper bound of the bucket holding the percentile.
+    uint64_t Percentile(double const& percent) const {
+        if (count_ == 0)
+            return 0;
+        uint64_t const rank = static_cast<uint64_t>(count_ * percent / 100.0 + 0.5);
+        uint64_t       seen = 0;
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            seen += buckets_[i];
+            if (seen >= rank && seen > 0)
+                return std::min(UpperBound(i), max_);
+        }
+        return max_;
+    }
+
+    void Print(FILE* out, char const* name) const {
+        if (count_ == 0) {
+            fprintf(out, "  %-22s no samples\n", name);
+            return;
+        }
+        fprintf(out,
+                "  %-22s n=%-9llu min=%-8.2f avg=%-8.2f p50=%-8.2f p90=%-8.2f p99=%-8.2f p99.9=%-8.2f max=%.2f ms\n",
+                name, static_cast<unsigned long long>(count_), min_ / 1000.0, sum_ / 1000.0 / count_,
+                Percentile(50) / 1000.0, Percentile(90) / 1000.0, Percentile(99) / 1000.0, Percentile(99.9) / 1000.0,
+                max_ / 1000.0);
+    }
+
+private:
+    static constexpr size_t kBucketCount = 64 * 16;
+
+    static size_t Index(uint64_t const& value) {
+        if (value < 16)
+            return static_cast<size_t>(value);
+        int const shift = 63 - __builtin_clzll(value) - 4;
+        return static_cast<size_t>((shift + 1) * 16 + ((value >> shift) & 0xF));
+    }
+
+    static uint64_t UpperBound(size_t const& index) {
+        if (index < 16)
+            return index;
+        size_t const shift = index / 16 - 1;
+        return ((16 + index % 16) << shift) + (1ULL << shift) - 1;
+    }
+
+    std::vector<uint64_t> buckets_;
+    uint64_t              count_;
+    uint64_t              sum_;
+    uint64_t              min_;
+    uint64_t              max_;
+};
+
+enum TerminalState {
+    kDisconnected = 0x0,
+    kConnecting,
+    kRegistering,
+    kAuthenticating,
+    kOnline,
+};
+
+enum TimerType {
+    kTimerConnect = 0x0,
+    kTimerLocation,
+    kTimerHeartbeat,
+    kTimerBatch,
+    kTimerMultimedia,
+};
+
+struct TimerEvent {
+    Clock::time_point when;
+    uint32_t          index;
+    TimerType         type;
+
+    bool operator>(TimerEvent const& other) const {
+        return when > other.when;
+    }
+};
+
+// Request waiting for the platform general response.
+struct PendingRequest {
+    uint16_t          msg_id;
+    Clock::time_point sent;
+};
+
+struct Terminal {
+    int                                   fd              = -1;
+    TerminalState                         state           = kDisconnected;
+    uint16_t                              flow_num        = 0;
+    std::string                           phone;
+    Clock::time_point                     connect_start;
+    std::vector<uint8_t>                  rx;
+    std::vector<uint8_t>                  tx;
+    std::map<uint16_t, PendingRequest>    pending; // key: flow number.
+    std::vector<LocationBasicInformation> history; // Locations of the next 0x0704.
+    uint32_t                              step            = 0;
+    uint32_t                              media_id        = 0;
+    bool                                  media_in_flight = false;
+    Clock::time_point                     media_start;
+};
+
+struct Counters {
+    uint64_t sent_frames      = 0;
+    uint64_t sent_bytes       = 0;
+    uint64_t recv_frames      = 0;
+    uint64_t recv_bytes       = 0;
+    uint64_t parse_failures   = 0;
+    uint64_t nacks            = 0; // General responses with a result other than success.
+    uint64_t timeouts         = 0;
+    uint64_t connect_failures = 0;
+    uint64_t disconnects      = 0;
+};
+
+class LoadGenerator {
+public:
+    explicit LoadGenerator(Config const& config, FILE* report)
+        : config_(config), report_(report), epoll_fd_(-1), online_(0) {
+        JT808FramePackagerInit(&packager_);
+        JT808FrameParserInit(&parser_);
+    }
+
+    ~LoadGenerator() {
+        for (auto& terminal : terminals_) {
+            if (terminal.fd >= 0)
+                close(terminal.fd);
+        }
+        if (epoll_fd_ >= 0)
+            close(epoll_fd_);
+    }
+
+    int Run(void);
+
+private:
+    void Schedule(uint32_t const& index, TimerType const& type, Clock::time_point const& when) {
+        timers_.push(TimerEvent {when, index, type});
+    }
+
+    void Connect(uint32_t const& index);
+    void Disconnect(Terminal* terminal);
+    void OnConnected(uint32_t const& index);
+    void OnReadable(uint32_t const& index);
+    void OnWritable(uint32_t const& index);
+    void OnFrame(uint32_t const& index, std::vector<uint8_t> const& frame);
+    void OnOnline(uint32_t const& index);
+    void OnTimer(TimerEvent const& event);
+
+    // Package and send a message, tracked messages are matched with the platform general response.
+    int SendMessage(Terminal* terminal, uint16_t const& msg_id, bool const& track);
+    int SendMultimedia(Terminal* terminal);
+    int Write(Terminal* terminal, std::vector<uint8_t> const& frame);
+    void UpdateLocation(uint32_t const& index, Terminal* terminal);
+    void ExpireRequests(Clock::time_point const& now);
+    void PrintProgress(Clock::time_point const& now);
+    void PrintSummary(void);
+
+    Config                                                                   config_;
+    FILE*                                                                    report_;
+    int                                                                      epoll_fd_;
+    size_t                                                                   online_;
+    Packager                                                                 packager_;
+    Parser                                                                   parser_;
+    ProtocolParameter                                                        tx_para_ {};
+    ProtocolParameter                                                        rx_para_ {};
+    std::vector<Terminal>                                                    terminals_;
+    std::priority_queue<TimerEvent, std::vector<TimerEvent>, std::greater<TimerEvent>> timers_;
+    std::vector<std::vector<uint8_t>>                                        frames_;
+    std::vector<uint8_t>                                                     frame_;
+    BcdTimestamp                                                             time_bcd_ {};
+    Counters                                                                 counters_;
+    Counters                                                                 last_counters_;
+    std::map<uint16_t, uint64_t>                                             sent_by_id_;
+    LatencyHistogram                                                         handshake_latency_;
+    std::map<uint16_t, LatencyHistogram>                                     response_latency_;
+    Clock::time_point                                                        start_;
+    Clock::time_point                                                        last_report_;
+};
+
+int LoadGenerator::Run(void) {
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ < 0) {
+        printf("%s[%d]: Create epoll failed!!!\n", __FUNCTION__, __LINE__);
+        return -1;
+    }
+    terminals_.resize(config_.terminals);
+    start_       = Clock::now();
+    last_report_ = start_;
+    // Ramp up connections at the configured rate.
+    for (int i = 0; i < config_.terminals; ++i) {
+        char phone[16] = {0};
+        snprintf(phone, sizeof(phone), "13%09d", i);
+        terminals_[i].phone = phone;
+        Schedule(i, kTimerConnect, start_ + std::chrono::microseconds(1000000LL * i / config_.connect_rate));
+    }
+    auto const                      end = start_ + std::chrono::seconds(config_.duration);
+    std::vector<struct epoll_event> events(1024);
+    while (!g_stop) {
+        auto now = Clock::now();
+        if (now >= end)
+            break;
+        int timeout = 100;
+        if (!timers_.empty()) {
+            auto const wait = std::chrono::duration_cast<std::chrono::milliseconds>(timers_.top().when - now).count();
+            timeout         = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(wait, timeout)));
+        }
+        int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout);
+        if (n < 0 && errno != EINTR)
+            break;
+        for (int i = 0; i < n; ++i) {
+            uint32_t const index = events[i].data.u32;
+            if (terminals_[index].state == kConnecting) {
+                OnConnected(index);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                OnReadable(index);
+            if ((events[i].events & EPOLLOUT) && terminals_[index].fd >= 0)
+                OnWritable(index);
+        }
+        // Location time of this round.
+        time_bcd_.FromEpoch(time(nullptr));
+        now = Clock::now();
+        while (!timers_.empty() && timers_.top().when <= now) {
+            auto const event = timers_.top();
+            timers_.pop();
+            OnTimer(event);
+        }
+        if (now - last_report_ >= std::chrono::seconds(1)) {
+            ExpireRequests(now);
+            PrintProgress(now);
+        }
+    }
+    PrintSummary();
+    return 0;
+}
+
+void LoadGenerator::Connect(uint32_t const& index) {
+    auto& terminal = terminals_[index];
+    int   fd       = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        ++counters_.connect_failures;
+        return;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family        = AF_INET;
+    addr.sin_port          = htons(static_cast<uint16_t>(config_.port));
+    addr.sin_addr.s_addr   = inet_addr(config_.ip.c_str());
+    terminal.connect_start = Clock::now();
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        ++counters_.connect_failures;
+        return;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN | EPOLLOUT;
+    event.data.u32 = index;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        close(fd);
+        ++counters_.connect_failures;
+        return;
+    }
+    terminal.fd    = fd;
+    terminal.state = kConnecting;
+}
+
+void LoadGenerator::Disconnect(Terminal* terminal) {
+    if (terminal->fd < 0)
+        return;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, terminal->fd, nullptr);
+    close(terminal->fd);
+    if (terminal->state == kOnline) {
+        --online_;
+        ++counters_.disconnects;
+    }
+    else {
+        ++counters_.connect_failures;
+    }
+    terminal->fd    = -1;
+    terminal->state = kDisconnected;
+    terminal->rx.clear();
+    terminal->tx.clear();
+    terminal->pending.clear();
+}
+
+void LoadGenerator::OnConnected(uint32_t const& index) {
+    auto&     terminal = terminals_[index];
+    int       error    = 0;
+    socklen_t len      = sizeof(error);
+    if (getsockopt(terminal.fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+        Disconnect(&terminal);
+        return;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.u32 = index;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, terminal.fd, &event);
+    terminal.state   = kRegistering;
+    auto& info       = tx_para_.register_info;
+    info.province_id = 0x002c;
+    info.city_id     = 0x012c;
+    info.manufacturer_id.assign(kManufacturerId, kManufacturerId + sizeof(kManufacturerId));
+    info.terminal_model.assign(kTerminalModel, kTerminalModel + sizeof(kTerminalModel));
+    info.terminal_id.assign(terminal.phone.end() - 7, terminal.phone.end());
+    info.car_plate_color = kVin;
+    info.car_plate_num.clear();
+    SendMessage(&terminal, kTerminalRegister, false);
+}
+
+void LoadGenerator::OnReadable(uint32_t const& index) {
+    auto&   terminal = terminals_[index];
+    uint8_t buffer[4096];
+    while (terminal.fd >= 0) {
+        ssize_t ret = recv(terminal.fd, buffer, sizeof(buffer), 0);
+        if (ret > 0) {
+            counters_.recv_bytes += ret;
+            terminal.rx.insert(terminal.rx.end(), buffer, buffer + ret);
+            frames_.clear();
+            JT808FrameExtract(&terminal.rx, &frames_);
+            for (auto const& frame : frames_) {
+                OnFrame(index, frame);
+                if (terminal.fd < 0)
+                    return;
+            }
+            continue;
+        }
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (ret < 0 && errno == EINTR)
+            continue;
+        Disconnect(&terminal);
+        return;
+    }
+}
+
+void LoadGenerator::OnWritable(uint32_t const& index) {
+    auto& terminal = terminals_[index];
+    while (!terminal.tx.empty()) {
+        ssize_t ret = send(terminal.fd, terminal.tx.data(), terminal.tx.size(), MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            if (errno == EINTR)
+                continue;
+            Disconnect(&terminal);
+            return;
+        }
+        terminal.tx.erase(terminal.tx.begin(), terminal.tx.begin() + ret);
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.u32 = index;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, terminal.fd, &event);
+}
+
+void LoadGenerator::OnFrame(uint32_t const& index, std::vector<uint8_t> const& frame) {
+    auto& terminal = terminals_[index];
+    ++counters_.recv_frames;
+    if (JT808FrameParse(parser_, frame, &rx_para_) != 0) {
+        ++counters_.parse_failures;
+        return;
+    }
+    auto const now = Clock::now();
+    switch (rx_para_.parse.msg_head.msg_id) {
+        case kTerminalRegisterResponse:
+            if (terminal.state != kRegistering)
+                break;
+            if (rx_para_.parse.respone_result != kRegisterSuccess) {
+                Disconnect(&terminal);
+                break;
+            }
+            terminal.state                     = kAuthenticating;
+            tx_para_.parse.authentication_code = rx_para_.parse.authentication_code;
+            SendMessage(&terminal, kTerminalAuthentication, false);
+            break;
+        case kPlatformGeneralResponse: {
+            auto const& result = rx_para_.parse.respone_result;
+            if (terminal.state == kAuthenticating && rx_para_.parse.respone_msg_id == kTerminalAuthentication) {
+                if (result != kSuccess) {
+                    Disconnect(&terminal);
+                    break;
+                }
+                handshake_latency_.Record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - terminal.connect_start).count());
+                OnOnline(index);
+                break;
+            }
+            if (result != kSuccess)
+                ++counters_.nacks;
+            auto it = terminal.pending.find(rx_para_.parse.respone_flow_num);
+            if (it == terminal.pending.end() || it->second.msg_id != rx_para_.parse.respone_msg_id)
+                break;
+            response_latency_[it->second.msg_id].Record(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - it->second.sent).count());
+            terminal.pending.erase(it);
+            break;
+        }
+        case kMultimediaDataUploadResponse:
+            if (!terminal.media_in_flight)
+                break;
+            terminal.media_in_flight = false;
+            response_latency_[kMultimediaDataUpload].Record(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - terminal.media_start).count());
+            break;
+        default:
+            break;
+    }
+}
+
+void LoadGenerator::OnOnline(uint32_t const& index) {
+    auto& terminal = terminals_[index];
+    terminal.state = kOnline;
+    ++online_;
+    // Spread the periodic messages of the fleet over their intervals.
+    auto const now = Clock::now();
+    auto       phase = [index](int const& interval_ms) {
+        return std::chrono::milliseconds(interval_ms > 0 ? (index * 7919LL) % interval_ms : 0);
+    };
+    Schedule(index, kTimerLocation, now + phase(config_.location_interval));
+    Schedule(index, kTimerHeartbeat, now + phase(config_.heartbeat_interval * 1000));
+    if (config_.batch_interval > 0)
+        Schedule(index, kTimerBatch, now + phase(config_.batch_interval * 1000));
+    if (config_.multimedia_interval > 0)
+        Schedule(index, kTimerMultimedia, now + phase(config_.multimedia_interval * 1000));
+}
+
+void LoadGenerator::OnTimer(TimerEvent const& event) {
+    auto& terminal = terminals_[event.index];
+    if (event.type == kTimerConnect) {
+        Connect(event.index);
+        return;
+    }
+    // Timers of terminals that went offline are dropped.
+    if (terminal.state != kOnline)
+        return;
+    switch (event.type) {
+        case kTimerLocation:
+            UpdateLocation(event.index, &terminal);
+            SendMessage(&terminal, kLocationReport, true);
+            Schedule(event.index, kTimerLocation, event.when + std::chrono::milliseconds(config_.location_interval));
+            break;
+        case kTimerHeartbeat:
+            SendMessage(&terminal, kTerminalHeartBeat, true);
+            Schedule(event.index, kTimerHeartbeat, event.when + std::chrono::seconds(config_.heartbeat_interval));
+            break;
+        case kTimerBatch:
+            if (!terminal.history.empty()) {
+                auto& batch_loc      = tx_para_.batch_loc;
+                batch_loc.data_type  = 1;
+                batch_loc.nbr_of_dat = static_cast<uint16_t>(terminal.history.size());
+                batch_loc.loc_info.swap(terminal.history);
+                batch_loc.loc_ext.assign(batch_loc.loc_info.size(), tx_para_.location_extension);
+                SendMessage(&terminal, kBatchLocationReport, true);
+                batch_loc.loc_info.swap(terminal.history);
+                terminal.history.clear();
+            }
+            Schedule(event.index, kTimerBatch, event.when + std::chrono::seconds(config_.batch_interval));
+            break;
+        case kTimerMultimedia:
+            if (!terminal.media_in_flight)
+                SendMultimedia(&terminal);
+            Schedule(event.index, kTimerMultimedia, event.when + std::chrono::seconds(config_.multimedia_interval));
+            break;
+        default:
+            break;
+    }
+}
+
+// Vehicles drive north-east from their own starting point at about 40km/h.
+void LoadGenerator::UpdateLocation(uint32_t const& index, Terminal* terminal) {
+    ++terminal->step;
+    auto& info                  = tx_para_.location_info;
+    info.alarm.value            = 0;
+    info.status.value           = 0;
+    info.status.bit.acc         = 1;
+    info.status.bit.positioning = 1;
+    info.status.bit.gps_en      = 1;
+    info.status.bit.beidou_en   = 1;
+    info.latitude               = 22500000 + (index % 1000) * 100 + terminal->step * 70;
+    info.longitude              = 113900000 + (index / 1000) * 100 + terminal->step * 70;
+    info.altitude               = 54;
+    info.speed                  = 400;
+    info.bearing                = 45;
+    info.time                   = time_bcd_;
+    uint32_t const mileage      = terminal->step * 11;
+    auto&          extension    = tx_para_.location_extension;
+    extension.Set(kMileage, {static_cast<uint8_t>(mileage >> 24), static_cast<uint8_t>(mileage >> 16),
+                             static_cast<uint8_t>(mileage >> 8), static_cast<uint8_t>(mileage)});
+    extension.Set(kOilMass, {0x01, 0xF4});
+    extension.Set(kNetworkQuantity, {0x1F});
+    extension.Set(kGnssSatellites, {0x0B});
+    extension.Set(kPositioningStatus, {0x02});
+    if (config_.batch_interval > 0 && terminal->history.size() < static_cast<size_t>(config_.batch_size))
+        terminal->history.push_back(info);
+}
+
+int LoadGenerator::SendMessage(Terminal* terminal, uint16_t const& msg_id, bool const& track) {
+    auto& head               = tx_para_.msg_head;
+    head.msg_id              = msg_id;
+    head.msgbody_attr.u16val = 0;
+    head.phone_num           = terminal->phone;
+    head.msg_flow_num        = terminal->flow_num++;
+    head.total_packet        = 0;
+    head.packet_seq          = 0;
+    if (JT808FramePackage(packager_, tx_para_, &frame_) != 0)
+        return -1;
+    if (track)
+        terminal->pending[head.msg_flow_num] = PendingRequest {msg_id, Clock::now()};
+    ++sent_by_id_[msg_id];
+    return Write(terminal, frame_);
+}
+
+// The header is packaged once and sent at the start of every fragment, as JT808Client does; the platform answers
+// every fragment with 0x8001 and the reassembled upload with 0x8800.
+int LoadGenerator::SendMultimedia(Terminal* terminal) {
+    auto& upload        = tx_para_.multimedia_upload;
+    upload.media_id     = ++terminal->media_id;
+    upload.media_type   = 0;
+    upload.media_format = 0;
+    upload.media_event  = 1;
+    upload.channel_id   = 1;
+    upload.loaction_report_body.clear();
+    // Basic location information only.
+    ProtocolParameter location {};
+    location.location_info = tx_para_.location_info;
+    packager_.find(kLocationReport)->second(location, &upload.loaction_report_body);
+    upload.media_data.clear();
+    std::vector<uint8_t> header;
+    if (packager_.find(kMultimediaDataUpload)->second(tx_para_, &header) < 0 || header.size() != kMediaHeaderLength)
+        return -1;
+    std::vector<uint8_t> media(config_.multimedia_size);
+    for (size_t i = 0; i < media.size(); ++i)
+        media[i] = static_cast<uint8_t>(i * 31 + terminal->step);
+    size_t const content = kMediaFragmentLength - kMediaHeaderLength;
+    size_t const total   = (media.size() + content - 1) / content;
+    MsgHead      head;
+    head.msg_id                  = kMultimediaDataUpload;
+    head.msgbody_attr.u16val     = 0;
+    head.msgbody_attr.bit.packet = total > 1 ? 1 : 0;
+    head.phone_num               = terminal->phone;
+    head.total_packet            = static_cast<uint16_t>(total);
+    terminal->media_in_flight    = true;
+    terminal->media_start        = Clock::now();
+    std::vector<uint8_t> chunk;
+    std::vector<uint8_t> escaped;
+    for (size_t i = 0; i < total; ++i) {
+        auto const begin = media.begin() + i * content;
+        auto const end   = i + 1 == total ? media.end() : begin + content;
+        chunk.assign(header.begin(), header.end());
+        chunk.insert(chunk.end(), begin, end);
+        escaped.clear();
+        Escape(chunk, &escaped);
+        head.msg_flow_num = terminal->flow_num++;
+        head.packet_seq   = static_cast<uint16_t>(i + 1);
+        if (JT808FramePackageEscapedBody(head, escaped, static_cast<uint16_t>(chunk.size()),
+                                         BccCheckSum(chunk.data(), chunk.size()), &frame_) != 0)
+            return -1;
+        ++sent_by_id_[kMultimediaDataUpload];
+        if (Write(terminal, frame_) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+int LoadGenerator::Write(Terminal* terminal, std::vector<uint8_t> const& frame) {
+    if (terminal->fd < 0)
+        return -1;
+    ++counters_.sent_frames;
+    counters_.sent_bytes += frame.size();
+    size_t sent = 0;
+    if (terminal->tx.empty()) {
+        while (sent < frame.size()) {
+            ssize_t ret = send(terminal->fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+            if (ret > 0) {
+                sent += ret;
+                continue;
+            }
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            Disconnect(terminal);
+            return -1;
+        }
+        if (sent == frame.size())
+            return 0;
+        // Socket buffer is full, wait for EPOLLOUT.
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events   = EPOLLIN | EPOLLOUT;
+        event.data.u32 = static_cast<uint32_t>(terminal - terminals_.data());
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, terminal->fd, &event);
+    }
+    terminal->tx.insert(terminal->tx.end(), frame.begin() + sent, frame.end());
+    return 0;
+}
+
+void LoadGenerator::ExpireRequests(Clock::time_point const& now) {
+    auto const deadline = now - std::chrono::seconds(kResponseTimeoutSeconds);
+    for (auto& terminal : terminals_) {
+        for (auto it = terminal.pending.begin(); it != terminal.pending.end();) {
+            if (it->second.sent < deadline) {
+                ++counters_.timeouts;
+                it = terminal.pending.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        if (terminal.media_in_flight && terminal.media_start < deadline) {
+            ++counters_.timeouts;
+            terminal.media_in_flight = false;
+        }
+    }
+}
+
+void LoadGenerator::PrintProgress(Clock::time_point const& now) {
+    double const seconds = std::chrono::duration<double>(now - last_report_).count();
+    double const elapsed = std::chrono::duration<double>(now - start_).count();
+    fprintf(report_,
+            "[%6.1fs] online %zu/%d  tx %.0f msg/s %.1f KiB/s  rx %.0f msg/s %.1f KiB/s  nack %llu  timeout %llu  "
+            "disconnect %llu\n",
+            elapsed, online_, config_.terminals, (counters_.sent_frames - last_counters_.sent_frames) / seconds,
+            (counters_.sent_bytes - last_counters_.sent_bytes) / seconds / 1024.0,
+            (counters_.recv_frames - last_counters_.recv_frames) / seconds,
+            (counters_.recv_bytes - last_counters_.recv_bytes) / seconds / 1024.0,
+            static_cast<unsigned long long>(counters_.nacks), static_cast<unsigned long long>(counters_.timeouts),
+            static_cast<unsigned long long>(counters_.disconnects));
+    fflush(report_);
+    last_counters_ = counters_;
+    last_report_   = now;
+}
+
+void LoadGenerator::PrintSummary(void) {
+    double const seconds = std::chrono::duration<double>(Clock::now() - start_).count();
+    fprintf(report_, "\nSummary: %d terminals, %zu online, %.1fs\n", config_.terminals, online_, seconds);
+    fprintf(report_, "  sent      %llu frames (%.0f frames/s), %llu bytes (%.1f KiB/s)\n",
+            static_cast<unsigned long long>(counters_.sent_frames), counters_.sent_frames / seconds,
+            static_cast<unsigned long long>(counters_.sent_bytes), counters_.sent_bytes / seconds / 1024.0);
+    fprintf(report_, "  received  %llu frames (%.0f frames/s), %llu bytes (%.1f KiB/s)\n",
+            static_cast<unsigned long long>(counters_.recv_frames), counters_.recv_frames / seconds,
+            static_cast<unsigned long long>(counters_.recv_bytes), counters_.recv_bytes / seconds / 1024.0);
+    for (auto const& item : sent_by_id_)
+        fprintf(report_, "  0x%04X    %llu frames\n", item.first, static_cast<unsigned long long>(item.second));
+    fprintf(report_,
+            "  errors    parse %llu, nack %llu, timeout %llu, connect/handshake %llu, disconnect %llu\n",
+            static_cast<unsigned long long>(counters_.parse_failures), static_cast<unsigned long long>(counters_.nacks),
+            static_cast<unsigned long long>(counters_.timeouts),
+            static_cast<unsigned long long>(counters_.connect_failures),
+            static_cast<unsigned long long>(counters_.disconnects));
+    fprintf(report_, "Latency:\n");
+    handshake_latency_.Print(report_, "connect+register+auth");
+    char name[32] = {0};
+    for (auto const& item : response_latency_) {
+        snprintf(name, sizeof(name), "0x%04X", item.first);
+        item.second.Print(report_, name);
+    }
+    fflush(report_);
+}
+
+void Usage(char const* name) {
+    printf("Usage: %s [-a ip] [-p port] [-n terminals] [-t seconds] [-r connects per second]\n"
+           "       [-l location interval ms] [-b heartbeat s] [-B batch s] [-m multimedia s] [-M multimedia bytes] "
+           "[-s] [-w capture file] [-e metrics port]\n",
+           name);
+}
+
+} // namespace
+
+} // namespace libjt808
+
+int main(int argc, char** argv) {
+    libjt808::Config config;
+    int              opt = 0;
+    while ((opt = getopt(argc, argv, "a:p:n:t:r:l:b:B:m:M:sw:e:h")) != -1) {
+        switch (opt) {
+            case 'a': config.ip = optarg; break;
+            case 'p': config.port = atoi(optarg); break;
+            case 'n': config.terminals = atoi(optarg); break;
+            case 't': config.duration = atoi(optarg); break;
+            case 'r': config.connect_rate = atoi(optarg); break;
+            case 'l': config.location_interval = atoi(optarg); break;
+            case 'b': config.heartbeat_interval = atoi(optarg); break;
+            case 'B': config.batch_interval = atoi(optarg); break;
+            case 'm': config.multimedia_interval = atoi(optarg); break;
+            case 'M': config.multimedia_size = atoi(optarg); break;
+            case 's': config.in_process_server = true; break;
+            case 'w': config.capture_path = optarg; break;
+            case 'e': config.metrics_port = atoi(optarg); break;
+            default: libjt808::Usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (config.terminals <= 0 || config.connect_rate <= 0 || config.location_interval <= 0 ||
+        config.heartbeat_interval <= 0 || config.multimedia_size <= 0) {
+        libjt808::Usage(argv[0]);
+        return 1;
+    }
+    signal(SIGINT, libjt808::SignalHandler);
+    signal(SIGPIPE, SIG_IGN);
+    // Every terminal needs a descriptor, twice as many with the in-process server.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    FILE*                                  report = stdout;
+    std::unique_ptr<libjt808::JT808Server> server;
+    std::atomic<uint64_t>                  media_uploads(0);
+    std::atomic<uint64_t>                  media_size_errors(0);
+    if (config.in_process_server) {
+        // The server prints every message it handles, keep that off the report.
+        report = fdopen(dup(STDOUT_FILENO), "w");
+        if (report == nullptr || freopen("/dev/null", "w", stdout) == nullptr)
+            return 1;
+        server.reset(new libjt808::JT808Server());
+        server->Init();
+        server->SetServerAccessPoint(config.ip, config.port);
+        server->set_max_connection_num(1024);
+        server->SetRepeatedHeaderLength(libjt808::kMultimediaDataUpload, libjt808::kMediaHeaderLength);
+        server->OnMultimediaDataUploaded([&config, &media_uploads, &media_size_errors](
+                                             libjt808::MultiMediaDataUpload const& media) {
+            ++media_uploads;
+            if (media.media_data.size() != static_cast<size_t>(config.multimedia_size))
+                ++media_size_errors;
+        });
+        if (server->InitServer() != 0) {
+            fprintf(report, "Start server failed!!!\n");
+            return 1;
+        }
+        if (!config.capture_path.empty() && server->StartCapture(config.capture_path) != 0) {
+            fprintf(report, "Start capture failed!!!\n");
+            return 1;
+        }
+        if (config.metrics_port > 0 && server->StartMetricsExporter(config.ip, config.metrics_port) != 0) {
+            fprintf(report, "Start metrics exporter failed!!!\n");
+            return 1;
+        }
+        server->Run();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    {
+        libjt808::LoadGenerator generator(config, report);
+        generator.Run();
+    }
+    if (server != nullptr) {
+        server->StopMetricsExporter();
+        server->StopCapture();
+        if (!config.capture_path.empty())
+            fprintf(report, "Captured %llu records, dropped %llu\n",
+                    static_cast<unsigned long long>(server->capture_tap().records()),
+                    static_cast<unsigned long long>(server->capture_tap().dropped()));
+        server->Stop();
+        fprintf(report, "Multimedia uploads received %llu, wrong size %llu\n",
+                static_cast<unsigned long long>(media_uploads.load()),
+                static_cast<unsigned long long>(media_size_errors.load()));
+        if (media_size_errors.load() > 0) {
+            fprintf(report, "Multimedia uploads corrupted!!!\n");
+            return 1;
+        }
+    }
+    return 0;
+}
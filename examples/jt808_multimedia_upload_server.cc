@@ -38,6 +38,8 @@ int main(int argc, char **argv) {
   libjt808::JT808Server server;
   server.Init();
   server.SetServerAccessPoint("127.0.0.1", 8888);
+  // JT808Client repeats the 36 bytes multimedia header in every fragment.
+  server.SetRepeatedHeaderLength(libjt808::kMultimediaDataUpload, 36);
   server.OnMultimediaDataUploaded([] (
       libjt808::MultiMediaDataUpload const& media) -> void {
         printf("Recv %d bytes media data\n", media.media_data.size());
@@ -47,6 +49,8 @@ int main(int argc, char **argv) {
           ofs.close();
         }}); 
   if (server.InitServer() == 0) {
+    // Write the files on a handler worker instead of the service thread.
+    server.StartHandlerPool(2);
     server.Run();
     std::string cmd;
     std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -80,10 +80,10 @@ void LocaltionReportPackage(libjt808::Packager const& packager) {
     parameter.location_info.altitude  = 54;
     parameter.location_info.speed     = 8;
     parameter.location_info.bearing   = 0;
-    parameter.location_info.time      = "200702145429";
-    parameter.location_extension.insert(std::pair<uint8_t, std::vector<uint8_t>>(0x31, std::vector<uint8_t> {11}));
-    parameter.location_extension.insert(std::pair<uint8_t, std::vector<uint8_t>>(0xE0, std::vector<uint8_t> {1}));
-    parameter.location_extension.insert(std::pair<uint8_t, std::vector<uint8_t>>(0xEE, std::vector<uint8_t> {2}));
+    parameter.location_info.time.Assign("200702145429");
+    parameter.location_extension.Set(0x31, {11});
+    parameter.location_extension.Set(0xE0, {1});
+    parameter.location_extension.Set(0xEE, {2});
     if (libjt808::JT808FramePackage(packager, parameter, &raw_msg) == 0) {
         printf("raw msg: ");
         for (auto& uch : raw_msg)
@@ -72,7 +72,7 @@ void PlatformLocationReportParseTest(void) {
         printf("atitude: %d\n", basic_info.altitude);
         printf("speed: %d\n", basic_info.speed * 10);
         printf("bearing: %d\n", basic_info.bearing);
-        printf("time: %s\n", basic_info.time.c_str());
+        printf("time: %s\n", basic_info.time.ToString().c_str());
         auto it = extension_info.find(0x31);
         if (it != extension_info.end())
             printf("satellites number: %d\n", it->second[0]);
@@ -0,0 +1,778 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  jt808_replay.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 13:46:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+// Capture replay.
+// Replays the terminal side of a capture recorded by JT808Server::StartCapture() against a server, one TCP connection
+// per captured connection, on a single epoll loop. Frames keep their recorded spacing divided by the speed factor,
+// speed 0 sends every frame as soon as the connection is authenticated. Prints the achieved throughput every second
+// and a summary at the end.
+//
+// The authentication code is issued anew by the server, so the handshake is replayed live: the captured (or, for
+// connections captured mid-stream, a generated) 0x0100 is sent, then 0x0102 with the code from the 0x8100 response,
+// and the remaining frames once the platform accepted the authentication.
+//
+// Usage:
+//     jt808_replay -f capture file [-a ip] [-p port] [-x speed] [-c copies] [-s]
+//     -c replays the capture several times at once, every copy with its own phone numbers.
+//     -s starts a JT808Server in the same process.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jt808/capture.h"
+#include "jt808/packager.h"
+#include "jt808/parser.h"
+#include "jt808/server.h"
+#include "jt808/util.h"
+
+namespace libjt808 {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint8_t kManufacturerId[] = {'S', 'K', 'O', 'E', 'M'};
+
+constexpr uint8_t kTerminalModel[] = {'S', 'K', '9', '1', '5', '1'};
+
+// Connections are closed this long after their last frame, so the last responses are still counted.
+constexpr int kLingerMilliseconds = 1000;
+
+// Handshakes without a response after this long fail the connection.
+constexpr int kHandshakeTimeoutSeconds = 10;
+
+volatile sig_atomic_t g_stop = 0;
+
+void SignalHandler(int) {
+    g_stop = 1;
+}
+
+struct Config {
+    std::string path;
+    std::string ip                = "127.0.0.1";
+    int         port              = 8888;
+    double      speed             = 1.0; // 0 means as fast as possible.
+    int         copies            = 1;
+    bool        in_process_server = false;
+};
+
+// One frame sent by the terminal.
+struct ReplayFrame {
+    uint64_t             offset_us; // Time since the start of the capture.
+    uint16_t             msg_id;
+    std::vector<uint8_t> data; // Escaped frame.
+};
+
+// Terminal side of one captured connection.
+struct Session {
+    uint64_t                 start_us; // Connection time since the start of the capture.
+    std::string              phone;
+    std::vector<ReplayFrame> frames;
+};
+
+struct CaptureSummary {
+    uint64_t records        = 0;
+    uint64_t received_bytes = 0;
+    uint64_t sent_bytes     = 0;
+    uint64_t invalid_frames = 0;
+    uint64_t duration_us    = 0;
+    bool     corrupted      = false;
+};
+
+// Split the received bytes of every connection into frames.
+int LoadCapture(std::string const& path, std::vector<Session>* sessions, CaptureSummary* summary) {
+    CaptureReader reader;
+    if (reader.Open(path) != 0)
+        return -1;
+    CaptureRecord                            record;
+    uint64_t                                 base = 0;
+    std::map<uint32_t, size_t>               open;    // Connection ID - session index.
+    std::map<uint32_t, std::vector<uint8_t>> streams; // Connection ID - bytes not yet forming a frame.
+    std::vector<std::vector<uint8_t>>        frames;
+    std::vector<uint8_t>                     decoded;
+    MsgHead                                  head;
+    while (reader.Next(&record) == 0) {
+        if (summary->records++ == 0)
+            base = record.timestamp_us;
+        uint64_t const offset = record.timestamp_us > base ? record.timestamp_us - base : 0;
+        summary->duration_us  = offset;
+        switch (record.type) {
+            case kCaptureConnected:
+                open[record.conn_id] = sessions->size();
+                sessions->push_back(Session {offset, std::string(), std::vector<ReplayFrame>()});
+                streams[record.conn_id].clear();
+                break;
+            case kCaptureDisconnected:
+                open.erase(record.conn_id);
+                streams.erase(record.conn_id);
+                break;
+            case kCaptureSent:
+                summary->sent_bytes += record.data.size();
+                break;
+            case kCaptureReceived: {
+                summary->received_bytes += record.data.size();
+                // Connection opened before the capture started.
+                if (open.find(record.conn_id) == open.end()) {
+                    open[record.conn_id] = sessions->size();
+                    sessions->push_back(Session {offset, std::string(), std::vector<ReplayFrame>()});
+                }
+                auto& session = (*sessions)[open[record.conn_id]];
+                auto& stream  = streams[record.conn_id];
+                stream.insert(stream.end(), record.data.begin(), record.data.end());
+                frames.clear();
+                JT808FrameExtract(&stream, &frames);
+                for (auto& frame : frames) {
+                    if (JT808FrameDecode(frame, &decoded, &head) != 0) {
+                        ++summary->invalid_frames;
+                        continue;
+                    }
+                    if (session.phone.empty())
+                        session.phone = head.phone_num;
+                    session.frames.push_back(ReplayFrame {offset, head.msg_id, std::vector<uint8_t>()});
+                    session.frames.back().data.swap(frame);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    summary->corrupted = reader.corrupted();
+    sessions->erase(std::remove_if(sessions->begin(), sessions->end(),
+                                   [](Session const& session) { return session.frames.empty(); }),
+                    sessions->end());
+    return 0;
+}
+
+// Phone number of a copy, copy 0 keeps the captured number.
+std::string CopyPhone(std::string const& phone, int const& copy) {
+    if (copy == 0)
+        return phone;
+    uint64_t value = 0;
+    for (auto const& c : phone) {
+        if (c >= '0' && c <= '9')
+            value = value * 10 + (c - '0');
+    }
+    value = (value + static_cast<uint64_t>(copy) * 1000000000ULL) % 1000000000000ULL;
+    char buf[16] = {0};
+    snprintf(buf, sizeof(buf), "%012llu", static_cast<unsigned long long>(value));
+    return buf;
+}
+
+// Re-package a frame with another phone number, the checksum follows.
+int RewritePhone(std::vector<uint8_t> const& frame, std::string const& phone, std::vector<uint8_t>* out) {
+    std::vector<uint8_t> decoded;
+    MsgHead              head;
+    if (JT808FrameDecode(frame, &decoded, &head) != 0)
+        return -1;
+    size_t const header_len = head.msgbody_attr.bit.packet ? 17 : 13; // Including the leading flag.
+    if (decoded.size() < header_len + 2)
+        return -1;
+    std::vector<uint8_t> body(decoded.begin() + header_len, decoded.end() - 2);
+    std::vector<uint8_t> escaped;
+    Escape(body, &escaped);
+    head.phone_num = phone;
+    return JT808FramePackageEscapedBody(head, escaped, static_cast<uint16_t>(body.size()),
+                                        BccCheckSum(body.data(), body.size()), out);
+}
+
+enum ConnectionState {
+    kWaiting = 0x0,
+    kConnecting,
+    kRegistering,
+    kAuthenticating,
+    kOnline,
+    kFinished,
+};
+
+enum TimerType {
+    kTimerConnect = 0x0,
+    kTimerSend,
+    kTimerClose,
+};
+
+struct TimerEvent {
+    Clock::time_point when;
+    uint32_t          index;
+    TimerType         type;
+
+    bool operator>(TimerEvent const& other) const {
+        return when > other.when;
+    }
+};
+
+struct Connection {
+    int                  fd       = -1;
+    ConnectionState      state    = kWaiting;
+    size_t               session  = 0;
+    int                  copy     = 0;
+    std::string          phone;
+    size_t               next     = 0; // Next frame to send.
+    uint16_t             flow_num = 0; // Flow number of the generated handshake messages.
+    std::vector<uint8_t> rx;
+    std::vector<uint8_t> tx;
+    Clock::time_point    deadline; // Handshake deadline.
+};
+
+struct Counters {
+    uint64_t sent_frames        = 0;
+    uint64_t sent_bytes         = 0;
+    uint64_t recv_frames        = 0;
+    uint64_t recv_bytes         = 0;
+    uint64_t parse_failures     = 0;
+    uint64_t nacks              = 0; // General responses with a result other than success.
+    uint64_t handshakes         = 0;
+    uint64_t handshake_failures = 0;
+    uint64_t disconnects        = 0;
+    uint64_t skipped_frames     = 0; // Captured 0x0100/0x0102 after the handshake.
+};
+
+class Replayer {
+public:
+    Replayer(Config const& config, std::vector<Session> const& sessions, FILE* report)
+        : config_(config), sessions_(sessions), report_(report), epoll_fd_(-1), finished_(0) {
+        JT808FramePackagerInit(&packager_);
+        JT808FrameParserInit(&parser_);
+    }
+
+    ~Replayer() {
+        for (auto& connection : connections_) {
+            if (connection.fd >= 0)
+                close(connection.fd);
+        }
+        if (epoll_fd_ >= 0)
+            close(epoll_fd_);
+    }
+
+    int Run(void);
+
+private:
+    void Schedule(uint32_t const& index, TimerType const& type, Clock::time_point const& when) {
+        timers_.push(TimerEvent {when, index, type});
+    }
+
+    // Replay time of a capture offset.
+    Clock::time_point At(uint64_t const& offset_us) const {
+        if (config_.speed <= 0)
+            return start_;
+        return start_ + std::chrono::microseconds(static_cast<int64_t>(offset_us / config_.speed));
+    }
+
+    void Connect(uint32_t const& index);
+    void Finish(Connection* connection, bool const& failed);
+    void OnConnected(uint32_t const& index);
+    void OnReadable(uint32_t const& index);
+    void OnWritable(uint32_t const& index);
+    void OnFrame(uint32_t const& index, std::vector<uint8_t> const& frame);
+    void SendDue(uint32_t const& index);
+    int SendHandshake(Connection* connection, uint16_t const& msg_id);
+    int Write(Connection* connection, std::vector<uint8_t> const& frame);
+    void ExpireHandshakes(Clock::time_point const& now);
+    void PrintProgress(Clock::time_point const& now);
+    void PrintSummary(void);
+
+    Config                                                                            config_;
+    std::vector<Session> const&                                                       sessions_;
+    FILE*                                                                             report_;
+    int                                                                               epoll_fd_;
+    size_t                                                                            finished_;
+    Packager                                                                          packager_;
+    Parser                                                                            parser_;
+    ProtocolParameter                                                                 tx_para_ {};
+    ProtocolParameter                                                                 rx_para_ {};
+    std::vector<Connection>                                                           connections_;
+    std::priority_queue<TimerEvent, std::vector<TimerEvent>, std::greater<TimerEvent>> timers_;
+    std::vector<std::vector<uint8_t>>                                                 frames_;
+    std::vector<uint8_t>                                                              frame_;
+    Counters                                                                          counters_;
+    Counters                                                                          last_counters_;
+    std::map<uint16_t, uint64_t>                                                      sent_by_id_;
+    Clock::time_point                                                                 start_;
+    Clock::time_point                                                                 last_report_;
+};
+
+int Replayer::Run(void) {
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ < 0) {
+        printf("%s[%d]: Create epoll failed!!!\n", __FUNCTION__, __LINE__);
+        return -1;
+    }
+    connections_.resize(sessions_.size() * config_.copies);
+    start_       = Clock::now();
+    last_report_ = start_;
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        auto& connection   = connections_[i];
+        connection.session = i % sessions_.size();
+        connection.copy    = static_cast<int>(i / sessions_.size());
+        connection.phone   = CopyPhone(sessions_[connection.session].phone, connection.copy);
+        Schedule(static_cast<uint32_t>(i), kTimerConnect, At(sessions_[connection.session].start_us));
+    }
+    std::vector<struct epoll_event> events(1024);
+    while (!g_stop && finished_ < connections_.size()) {
+        auto now     = Clock::now();
+        int  timeout = 100;
+        if (!timers_.empty()) {
+            auto const wait = std::chrono::duration_cast<std::chrono::milliseconds>(timers_.top().when - now).count();
+            timeout         = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(wait, timeout)));
+        }
+        int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout);
+        if (n < 0 && errno != EINTR)
+            break;
+        for (int i = 0; i < n; ++i) {
+            uint32_t const index = events[i].data.u32;
+            if (connections_[index].state == kConnecting) {
+                OnConnected(index);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                OnReadable(index);
+            if ((events[i].events & EPOLLOUT) && connections_[index].fd >= 0)
+                OnWritable(index);
+        }
+        now = Clock::now();
+        while (!timers_.empty() && timers_.top().when <= now) {
+            auto const event = timers_.top();
+            timers_.pop();
+            auto& connection = connections_[event.index];
+            switch (event.type) {
+                case kTimerConnect: Connect(event.index); break;
+                case kTimerSend: SendDue(event.index); break;
+                case kTimerClose: Finish(&connection, false); break;
+                default: break;
+            }
+        }
+        if (now - last_report_ >= std::chrono::seconds(1)) {
+            ExpireHandshakes(now);
+            PrintProgress(now);
+        }
+    }
+    PrintSummary();
+    return 0;
+}
+
+void Replayer::Connect(uint32_t const& index) {
+    auto& connection = connections_[index];
+    int   fd         = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        Finish(&connection, true);
+        return;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(static_cast<uint16_t>(config_.port));
+    addr.sin_addr.s_addr = inet_addr(config_.ip.c_str());
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        Finish(&connection, true);
+        return;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN | EPOLLOUT;
+    event.data.u32 = index;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        close(fd);
+        Finish(&connection, true);
+        return;
+    }
+    connection.fd       = fd;
+    connection.state    = kConnecting;
+    connection.deadline = Clock::now() + std::chrono::seconds(kHandshakeTimeoutSeconds);
+}
+
+void Replayer::Finish(Connection* connection, bool const& failed) {
+    if (connection->state == kFinished)
+        return;
+    if (failed) {
+        if (connection->state == kOnline)
+            ++counters_.disconnects;
+        else
+            ++counters_.handshake_failures;
+    }
+    if (connection->fd >= 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+        close(connection->fd);
+    }
+    connection->fd    = -1;
+    connection->state = kFinished;
+    connection->rx.clear();
+    connection->tx.clear();
+    ++finished_;
+}
+
+void Replayer::OnConnected(uint32_t const& index) {
+    auto&     connection = connections_[index];
+    int       error      = 0;
+    socklen_t len        = sizeof(error);
+    if (getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+        Finish(&connection, true);
+        return;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.u32 = index;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+    connection.state   = kRegistering;
+    auto const& frames = sessions_[connection.session].frames;
+    if (frames.front().msg_id == kTerminalRegister) {
+        connection.next = 1;
+        if (RewritePhone(frames.front().data, connection.phone, &frame_) != 0) {
+            Finish(&connection, true);
+            return;
+        }
+        ++sent_by_id_[kTerminalRegister];
+        Write(&connection, frame_);
+        return;
+    }
+    SendHandshake(&connection, kTerminalRegister);
+}
+
+void Replayer::OnReadable(uint32_t const& index) {
+    auto&   connection = connections_[index];
+    uint8_t buffer[4096];
+    while (connection.fd >= 0) {
+        ssize_t ret = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (ret > 0) {
+            counters_.recv_bytes += ret;
+            connection.rx.insert(connection.rx.end(), buffer, buffer + ret);
+            frames_.clear();
+            JT808FrameExtract(&connection.rx, &frames_);
+            for (auto const& frame : frames_) {
+                OnFrame(index, frame);
+                if (connection.fd < 0)
+                    return;
+            }
+            continue;
+        }
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (ret < 0 && errno == EINTR)
+            continue;
+        Finish(&connection, true);
+        return;
+    }
+}
+
+void Replayer::OnWritable(uint32_t const& index) {
+    auto& connection = connections_[index];
+    while (!connection.tx.empty()) {
+        ssize_t ret = send(connection.fd, connection.tx.data(), connection.tx.size(), MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            if (errno == EINTR)
+                continue;
+            Finish(&connection, true);
+            return;
+        }
+        connection.tx.erase(connection.tx.begin(), connection.tx.begin() + ret);
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.u32 = index;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+    // Frames held back by the full socket buffer.
+    if (connection.state == kOnline)
+        SendDue(index);
+}
+
+void Replayer::OnFrame(uint32_t const& index, std::vector<uint8_t> const& frame) {
+    auto& connection = connections_[index];
+    ++counters_.recv_frames;
+    if (JT808FrameParse(parser_, frame, &rx_para_) != 0) {
+        ++counters_.parse_failures;
+        return;
+    }
+    auto const& parse = rx_para_.parse;
+    if (parse.msg_head.msg_id == kTerminalRegisterResponse && connection.state == kRegistering) {
+        if (parse.respone_result != kRegisterSuccess) {
+            Finish(&connection, true);
+            return;
+        }
+        connection.state                   = kAuthenticating;
+        tx_para_.parse.authentication_code = parse.authentication_code;
+        SendHandshake(&connection, kTerminalAuthentication);
+        return;
+    }
+    if (parse.msg_head.msg_id != kPlatformGeneralResponse)
+        return;
+    if (connection.state == kAuthenticating && parse.respone_msg_id == kTerminalAuthentication) {
+        if (parse.respone_result != kSuccess) {
+            Finish(&connection, true);
+            return;
+        }
+        ++counters_.handshakes;
+        connection.state = kOnline;
+        SendDue(index);
+        return;
+    }
+    if (parse.respone_result != kSuccess)
+        ++counters_.nacks;
+}
+
+// Send the frames whose replay time has come, then wait for the next one.
+void Replayer::SendDue(uint32_t const& index) {
+    auto& connection = connections_[index];
+    if (connection.state != kOnline)
+        return;
+    auto const& frames = sessions_[connection.session].frames;
+    auto const  now    = Clock::now();
+    // Keep at most one socket buffer of frames queued, the rest follows on EPOLLOUT.
+    while (connection.next < frames.size() && connection.tx.empty()) {
+        auto const& frame = frames[connection.next];
+        auto const  when  = At(frame.offset_us);
+        if (when > now) {
+            Schedule(index, kTimerSend, when);
+            return;
+        }
+        ++connection.next;
+        // The handshake was already replayed live.
+        if (frame.msg_id == kTerminalRegister || frame.msg_id == kTerminalAuthentication) {
+            ++counters_.skipped_frames;
+            continue;
+        }
+        if (connection.copy == 0) {
+            frame_ = frame.data;
+        }
+        else if (RewritePhone(frame.data, connection.phone, &frame_) != 0) {
+            continue;
+        }
+        ++sent_by_id_[frame.msg_id];
+        if (Write(&connection, frame_) < 0)
+            return;
+    }
+    if (connection.next >= frames.size())
+        Schedule(index, kTimerClose, now + std::chrono::milliseconds(kLingerMilliseconds));
+}
+
+int Replayer::SendHandshake(Connection* connection, uint16_t const& msg_id) {
+    auto& head               = tx_para_.msg_head;
+    head.msg_id              = msg_id;
+    head.msgbody_attr.u16val = 0;
+    head.phone_num           = connection->phone;
+    head.msg_flow_num        = connection->flow_num++;
+    head.total_packet        = 0;
+    head.packet_seq          = 0;
+    if (msg_id == kTerminalRegister) {
+        auto& info       = tx_para_.register_info;
+        info.province_id = 0x002c;
+        info.city_id     = 0x012c;
+        info.manufacturer_id.assign(kManufacturerId, kManufacturerId + sizeof(kManufacturerId));
+        info.terminal_model.assign(kTerminalModel, kTerminalModel + sizeof(kTerminalModel));
+        info.terminal_id.assign(connection->phone.end() - std::min<size_t>(7, connection->phone.size()),
+                                connection->phone.end());
+        info.car_plate_color = kVin;
+        info.car_plate_num.clear();
+    }
+    if (JT808FramePackage(packager_, tx_para_, &frame_) != 0) {
+        Finish(connection, true);
+        return -1;
+    }
+    ++sent_by_id_[msg_id];
+    return Write(connection, frame_);
+}
+
+int Replayer::Write(Connection* connection, std::vector<uint8_t> const& frame) {
+    if (connection->fd < 0)
+        return -1;
+    ++counters_.sent_frames;
+    counters_.sent_bytes += frame.size();
+    size_t sent = 0;
+    if (connection->tx.empty()) {
+        while (sent < frame.size()) {
+            ssize_t ret = send(connection->fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+            if (ret > 0) {
+                sent += ret;
+                continue;
+            }
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            Finish(connection, true);
+            return -1;
+        }
+        if (sent == frame.size())
+            return 0;
+        // Socket buffer is full, wait for EPOLLOUT.
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events   = EPOLLIN | EPOLLOUT;
+        event.data.u32 = static_cast<uint32_t>(connection - connections_.data());
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection->fd, &event);
+    }
+    connection->tx.insert(connection->tx.end(), frame.begin() + sent, frame.end());
+    return 0;
+}
+
+void Replayer::ExpireHandshakes(Clock::time_point const& now) {
+    for (auto& connection : connections_) {
+        if ((connection.state == kConnecting || connection.state == kRegistering ||
+             connection.state == kAuthenticating) &&
+            connection.deadline < now)
+            Finish(&connection, true);
+    }
+}
+
+void Replayer::PrintProgress(Clock::time_point const& now) {
+    double const seconds = std::chrono::duration<double>(now - last_report_).count();
+    double const elapsed = std::chrono::duration<double>(now - start_).count();
+    fprintf(report_,
+            "[%6.1fs] done %zu/%zu  tx %.0f msg/s %.1f KiB/s  rx %.0f msg/s %.1f KiB/s  nack %llu  "
+            "handshake failure %llu\n",
+            elapsed, finished_, connections_.size(), (counters_.sent_frames - last_counters_.sent_frames) / seconds,
+            (counters_.sent_bytes - last_counters_.sent_bytes) / seconds / 1024.0,
+            (counters_.recv_frames - last_counters_.recv_frames) / seconds,
+            (counters_.recv_bytes - last_counters_.recv_bytes) / seconds / 1024.0,
+            static_cast<unsigned long long>(counters_.nacks),
+            static_cast<unsigned long long>(counters_.handshake_failures));
+    fflush(report_);
+    last_counters_ = counters_;
+    last_report_   = now;
+}
+
+void Replayer::PrintSummary(void) {
+    double const seconds = std::chrono::duration<double>(Clock::now() - start_).count();
+    fprintf(report_, "\nSummary: %zu connections (%zu captured x %d), %llu authenticated, %.1fs\n",
+            connections_.size(), sessions_.size(), config_.copies,
+            static_cast<unsigned long long>(counters_.handshakes), seconds);
+    fprintf(report_, "  sent      %llu frames (%.0f frames/s), %llu bytes (%.1f KiB/s)\n",
+            static_cast<unsigned long long>(counters_.sent_frames), counters_.sent_frames / seconds,
+            static_cast<unsigned long long>(counters_.sent_bytes), counters_.sent_bytes / seconds / 1024.0);
+    fprintf(report_, "  received  %llu frames (%.0f frames/s), %llu bytes (%.1f KiB/s)\n",
+            static_cast<unsigned long long>(counters_.recv_frames), counters_.recv_frames / seconds,
+            static_cast<unsigned long long>(counters_.recv_bytes), counters_.recv_bytes / seconds / 1024.0);
+    for (auto const& item : sent_by_id_)
+        fprintf(report_, "  0x%04X    %llu frames\n", item.first, static_cast<unsigned long long>(item.second));
+    fprintf(report_, "  errors    parse %llu, nack %llu, handshake %llu, disconnect %llu, skipped %llu\n",
+            static_cast<unsigned long long>(counters_.parse_failures), static_cast<unsigned long long>(counters_.nacks),
+            static_cast<unsigned long long>(counters_.handshake_failures),
+            static_cast<unsigned long long>(counters_.disconnects),
+            static_cast<unsigned long long>(counters_.skipped_frames));
+    fflush(report_);
+}
+
+void Usage(char const* name) {
+    printf("Usage: %s -f capture file [-a ip] [-p port] [-x speed, 0 = max] [-c copies] [-s]\n", name);
+}
+
+} // namespace
+
+} // namespace libjt808
+
+int main(int argc, char** argv) {
+    libjt808::Config config;
+    int              opt = 0;
+    while ((opt = getopt(argc, argv, "f:a:p:x:c:sh")) != -1) {
+        switch (opt) {
+            case 'f': config.path = optarg; break;
+            case 'a': config.ip = optarg; break;
+            case 'p': config.port = atoi(optarg); break;
+            case 'x': config.speed = atof(optarg); break;
+            case 'c': config.copies = atoi(optarg); break;
+            case 's': config.in_process_server = true; break;
+            default: libjt808::Usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (config.path.empty() || config.copies <= 0 || config.speed < 0) {
+        libjt808::Usage(argv[0]);
+        return 1;
+    }
+    std::vector<libjt808::Session> sessions;
+    libjt808::CaptureSummary       summary;
+    if (libjt808::LoadCapture(config.path, &sessions, &summary) != 0) {
+        printf("Open capture %s failed!!!\n", config.path.c_str());
+        return 1;
+    }
+    printf("Capture: %llu records, %.1fs, %zu connections, %llu bytes received, %llu bytes sent%s\n",
+           static_cast<unsigned long long>(summary.records), summary.duration_us / 1e6, sessions.size(),
+           static_cast<unsigned long long>(summary.received_bytes),
+           static_cast<unsigned long long>(summary.sent_bytes), summary.corrupted ? ", truncated" : "");
+    if (sessions.empty())
+        return 0;
+    signal(SIGINT, libjt808::SignalHandler);
+    signal(SIGPIPE, SIG_IGN);
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    FILE*                                  report = stdout;
+    std::unique_ptr<libjt808::JT808Server> server;
+    if (config.in_process_server) {
+        // The server prints every message it handles, keep that off the report.
+        fflush(stdout);
+        report = fdopen(dup(STDOUT_FILENO), "w");
+        if (report == nullptr || freopen("/dev/null", "w", stdout) == nullptr)
+            return 1;
+        server.reset(new libjt808::JT808Server());
+        server->Init();
+        server->SetServerAccessPoint(config.ip, config.port);
+        server->set_max_connection_num(1024);
+        if (server->InitServer() != 0) {
+            fprintf(report, "Start server failed!!!\n");
+            return 1;
+        }
+        server->Run();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    {
+        libjt808::Replayer replayer(config, sessions, report);
+        replayer.Run();
+    }
+    if (server != nullptr)
+        server->Stop();
+    return 0;
+}
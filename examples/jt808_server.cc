@@ -30,6 +30,7 @@
 #include <iostream>
 #include <thread>
 
+#include "jt808/log.h"
 #include "jt808/server.h"
 
 namespace {
@@ -39,10 +40,14 @@ constexpr uint8_t kManufacturerId[] = {'J', 'T', '8', '0', '8'};
 } // namespace
 
 int main(int argc, char** argv) {
+    // Show every location report.
+    libjt808::Logger::Instance().set_level(libjt808::kLogDebug);
     libjt808::JT808Server server;
     server.Init();
     server.SetServerAccessPoint("127.0.0.1", 8888);
     if (server.InitServer() == 0) {
+        // Prometheus text format, e.g. curl http://127.0.0.1:9808/metrics.
+        server.StartMetricsExporter("127.0.0.1", 9808);
         server.Run();
         std::string cmd;
         std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -54,7 +59,22 @@ int main(int argc, char** argv) {
                 std::vector<uint8_t> m_id(kManufacturerId, kManufacturerId + sizeof(kManufacturerId));
                 server.UpgradeRequestByPhoneNumber("13395279527", 52, m_id, "1.0.0", "./upgrade_send.bin");
             }
+            else if (cmd == "capture") {
+                // capture <path>: record the traffic for jt808_replay.
+                std::string path;
+                std::cin >> path;
+                if (server.StartCapture(path) != 0)
+                    printf("Start capture failed!!!\n");
+            }
+            else if (cmd == "stopcapture") {
+                server.StopCapture();
+                printf("Captured %llu records, dropped %llu\n",
+                       static_cast<unsigned long long>(server.capture_tap().records()),
+                       static_cast<unsigned long long>(server.capture_tap().dropped()));
+            }
         }
+        server.StopCapture();
+        server.StopMetricsExporter();
         server.Stop();
     }
     return 0;
@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  area_index.h
+// @Version :  1.0
+// @Time    :  2026/10/19 19:41:12
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_AREA_INDEX_H_
+#define JT808_AREA_INDEX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace libjt808 {
+
+// Bounding box of an area, signed microdegrees, inclusive.
+struct AreaBox {
+    int32_t min_lat;
+    int32_t max_lat;
+    int32_t min_lon;
+    int32_t max_lon;
+
+    bool Contains(int32_t const& lat, int32_t const& lon) const {
+        return lat >= min_lat && lat <= max_lat && lon >= min_lon && lon <= max_lon;
+    }
+};
+
+// Spatial index of area bounding boxes, used to find the candidate areas of a point without testing every area.
+// A hierarchy of uniform grids, the cells of each level are 4 times wider than the level below. A box is stored in
+// the finest level where it spans at most 2x2 cells, so a query looks up one cell per non-empty level whatever the
+// number and the sizes of the areas. Boxes are inserted and erased one by one.
+class AreaGridIndex {
+public:
+    // Number of grid levels, the top level cell is wider than half the globe.
+    static constexpr int kLevels = 8;
+
+    // Args:
+    //     cell_size:  Width of the finest cells in microdegrees, about the size of the smallest areas.
+    explicit AreaGridIndex(int32_t const& cell_size = 10000);
+
+    ~AreaGridIndex() {
+    }
+
+    // Insert a box, replacing the box previously inserted with the same key.
+    void Insert(uint32_t const& key, AreaBox const& box);
+
+    // Returns the number of boxes erased, 0 or 1.
+    size_t Erase(uint32_t const& key);
+
+    void Clear(void);
+
+    size_t size(void) const {
+        return items_.size();
+    }
+
+    bool empty(void) const {
+        return items_.empty();
+    }
+
+    // Find the boxes containing a point.
+    // Args:
+    //     lat:  Latitude, signed microdegrees.
+    //     lon:  Longitude, signed microdegrees.
+    //     keys:  The keys of the boxes are appended, in no particular order.
+    // Returns:
+    //     Number of keys appended.
+    size_t Query(int32_t const& lat, int32_t const& lon, std::vector<uint32_t>* keys) const;
+
+    // Call visitor(key) for every box containing a point, without allocating.
+    template <typename Visitor>
+    void Visit(int32_t const& lat, int32_t const& lon, Visitor const& visitor) const {
+        for (int level = 0; level < kLevels; ++level) {
+            if (level_count_[level] == 0)
+                continue;
+            auto const cell = cells_.find(CellKey(level, CellOf(lat, level), CellOf(lon, level)));
+            if (cell == cells_.end())
+                continue;
+            for (auto const& entry : cell->second) {
+                if (entry.box.Contains(lat, lon))
+                    visitor(entry.key);
+            }
+        }
+    }
+
+private:
+    struct Item {
+        AreaBox box;
+        int     level;
+    };
+
+    // Boxes are copied into the cells so a query reads no other memory.
+    struct CellEntry {
+        uint32_t key;
+        AreaBox  box;
+    };
+
+    // Cell coordinates of a point at a level.
+    int64_t CellOf(int32_t const& value, int const& level) const;
+    static uint64_t CellKey(int const& level, int64_t const& row, int64_t const& column);
+
+    int32_t                                              cell_size_;
+    size_t                                               level_count_[kLevels]; // Boxes stored in each level.
+    std::unordered_map<uint32_t, Item>                   items_;
+    std::unordered_map<uint64_t, std::vector<CellEntry>> cells_;
+};
+
+} // namespace libjt808
+
+#endif // JT808_AREA_INDEX_H_
@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  basic_data_flow.h
+// @Version :  1.0
+// @Time    :  2026/10/19 18:32:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_BASIC_DATA_FLOW_H_
+#define JT808_BASIC_DATA_FLOW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "jt808/location_columns.h"
+#include "jt808/location_report.h"
+#include "jt808/util.h"
+
+namespace libjt808 {
+
+// Decoded basic data flow additional information (0xEA).
+// A field is only meaningful if its sub-item was present, see has(). Numeric sub-items shorter than their field are
+// accepted (big endian, zero extended); longer ones and unknown IDs are skipped. Sub-items without a fixed layout
+// are kept as raw bytes pointing into the decoded 0xEA value.
+struct BasicDataFlow {
+    uint64_t present;                   // Bit n set if the sub-item with BasicDataFlowID n was decoded.
+    uint32_t total_mileage;             // kTotalMileage.
+    uint32_t total_fuel_consumption;    // kTotalFuelConsumption.
+    uint32_t total_engine_running_time; // kTotalEngineRunningTime, seconds.
+    uint32_t total_flameout_time;       // kTotalFlameoutTime.
+    uint32_t total_idle_time;           // kTotalIdleTime.
+    uint32_t carbon_emissions;          // kCarbonEmissions, g.
+    uint16_t external_voltage;          // kExternalVoltage, 0.1V.
+    uint16_t build_in_batt_voltage;     // kBuildInBattVoltage, 0.1V.
+    uint16_t gps_location_accuracy;     // kGPSLocationAccuracy, 0.01.
+    uint8_t  csq;                       // kCSQ.
+    uint8_t  obd_type;                  // kOBDType.
+    uint8_t  gps_satellite_number;      // kGPSSatelliteNumber.
+    uint8_t  gps_avg_snr;               // kGPSAvgSNR, db.
+    uint8_t  ignition_type;             // kIgnitionType.
+    ByteSpan accelerometer_data;        // kAccelerometerData.
+    ByteSpan vehicle_status;            // kVehicleStatus.
+    ByteSpan model_id;                  // kModelID.
+    ByteSpan drive_cycle;               // kDriveCycle.
+
+    bool has(BasicDataFlowID const& id) const {
+        return id < 64 && ((present >> id) & 1) != 0;
+    }
+};
+
+// Decode the value of a 0xEA item, sub-items are ID(WORD)+length(BYTE)+value.
+// Args:
+//     flow:  Value of the 0xEA item.
+//     out:  Decoded fields, the raw fields point into flow.
+// Returns:
+//     Returns 0 on success, -1 if a sub-item runs past the end; the sub-items before it are kept.
+int JT808BasicDataFlowDecode(ByteSpan const& flow, BasicDataFlow* out);
+
+// Decode the 0xEA item of every point of the columns, points without one get no field present.
+// Args:
+//     columns:  Decoded batch location reports, see JT808BatchLocationDecode().
+//     out:  One entry per point, resized to columns.size(); the raw fields point into columns.extension_pool.
+// Returns:
+//     Returns the number of points whose 0xEA item was decoded, -1 on failure.
+int JT808BasicDataFlowDecodeColumns(LocationColumns const& columns, std::vector<BasicDataFlow>* out);
+
+} // namespace libjt808
+
+#endif // JT808_BASIC_DATA_FLOW_H_
@@ -31,6 +31,7 @@
 #define JT808_BCD_H_
 
 #include <stdint.h>
+#include <string.h>
 
 #include <string>
 #include <vector>
@@ -46,6 +47,48 @@ int      StringToBcd(std::string const& in, std::vector<uint8_t>* out);
 int      BcdToString(std::vector<uint8_t> const& in, std::string* out);
 int      BcdToStringFillZero(std::vector<uint8_t> const& in, std::string* out);
 
+// Convert a "YYMMDDhhmmss" BCD time (6 bytes, GMT+8, years 2000-2099) to seconds since the Unix epoch.
+// Returns:
+//     Returns 0 on success, -1 on an invalid digit or field, a day past the end of its month included.
+int BcdTimeToEpoch(uint8_t const* bcd, int64_t* epoch);
+
+// Convert seconds since the Unix epoch to a "YYMMDDhhmmss" BCD time (6 bytes, GMT+8).
+// Returns:
+//     Returns 0 on success, -1 if the time is outside the years 2000-2099.
+int EpochToBcdTime(int64_t const& epoch, uint8_t* bcd);
+
+// "YYMMDDhhmmss" time kept in its 6 byte BCD wire form (GMT+8, all times in this standard use this time zone).
+// Parsing and packaging copy the bytes as they are, the string form is only built on request.
+struct BcdTimestamp {
+    uint8_t bcd[6];
+
+    // Args:
+    //     str:  "YYMMDDhhmmss", 12 decimal digits.
+    // Returns:
+    //     Returns 0 on success, -1 on failure, the time is left unchanged.
+    int Assign(std::string const& str);
+
+    std::string ToString(void) const;
+
+    // Returns:
+    //     Returns 0 on success, -1 if the time is not a valid date of the years 2000-2099.
+    int ToEpoch(int64_t* epoch) const {
+        return BcdTimeToEpoch(bcd, epoch);
+    }
+
+    int FromEpoch(int64_t const& epoch) {
+        return EpochToBcdTime(epoch, bcd);
+    }
+
+    bool operator==(BcdTimestamp const& other) const {
+        return memcmp(bcd, other.bcd, sizeof(bcd)) == 0;
+    }
+
+    bool operator!=(BcdTimestamp const& other) const {
+        return !(*this == other);
+    }
+};
+
 } // namespace libjt808
 
 #endif // JT808_BCD_H_
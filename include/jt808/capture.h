@@ -0,0 +1,210 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  capture.h
+// @Version :  1.0
+// @Time    :  2026/10/19 13:18:40
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_CAPTURE_H_
+#define JT808_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jt808/ring_buffer.h"
+
+namespace libjt808 {
+
+//
+// Capture file format, all integers are little endian.
+//
+// File header, 16 bytes:
+//     magic "JT808CAP" (8), version (2), reserved (6).
+// Record, 16 bytes followed by the raw bytes:
+//     time in microseconds since the epoch (8), connection ID (4), type (1), data length (3).
+//
+// Connection IDs are the server's socket descriptors, so they are reused: a connection starts with its
+// kCaptureConnected record and ends with kCaptureDisconnected or the next kCaptureConnected of the same ID.
+//
+constexpr uint16_t kCaptureVersion = 0x0001;
+
+// Record header length.
+constexpr size_t kCaptureRecordHeaderLength = 16;
+
+// Maximum data length of one record.
+constexpr size_t kCaptureMaxDataLength = 0xFFFFFF;
+
+// Capture record type.
+enum CaptureRecordType {
+    kCaptureReceived = 0x0, // Bytes received from the terminal, as returned by one recv().
+    kCaptureSent,           // Bytes sent to the terminal, one complete frame.
+    kCaptureConnected,      // Connection accepted, no data.
+    kCaptureDisconnected,   // Connection closed, no data.
+};
+
+struct CaptureRecord {
+    uint64_t             timestamp_us; // Microseconds since the epoch.
+    uint32_t             conn_id;      // Connection ID.
+    uint8_t              type;         // See CaptureRecordType.
+    std::vector<uint8_t> data;         // Raw bytes.
+};
+
+// Microseconds since the epoch.
+uint64_t CaptureTimestamp(void);
+
+// Sequential capture file writer.
+class CaptureWriter {
+public:
+    CaptureWriter() {
+    }
+
+    ~CaptureWriter() {
+        Close();
+    }
+
+    // Create the file and write the file header.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int Open(std::string const& path);
+
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int Write(CaptureRecord const& record);
+
+    void Flush(void);
+    void Close(void);
+
+    bool is_open(void) const {
+        return ofs_.is_open();
+    }
+
+private:
+    std::ofstream ofs_;
+};
+
+// Sequential capture file reader.
+class CaptureReader {
+public:
+    CaptureReader() : corrupted_(false) {
+    }
+
+    ~CaptureReader() {
+    }
+
+    // Open the file and check the file header.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int Open(std::string const& path);
+
+    // Read the next record.
+    // Returns:
+    //     Returns 0 on success, -1 at the end of the file or on a truncated record, see corrupted().
+    int Next(CaptureRecord* record);
+
+    // Whether the last Next() stopped on a truncated record.
+    bool corrupted(void) const {
+        return corrupted_;
+    }
+
+private:
+    std::ifstream ifs_;
+    bool          corrupted_;
+};
+
+// Traffic tap of the server.
+// Record() is called by the I/O threads and only copies the bytes into a lock-free ring buffer, a background thread
+// writes the ring buffer to the capture file. A full ring buffer drops the record instead of blocking the I/O thread,
+// see dropped().
+class CaptureTap {
+public:
+    CaptureTap() : running_(false), producers_(0), records_(0), dropped_(0) {
+    }
+
+    ~CaptureTap() {
+        Stop();
+    }
+
+    // Start capturing to a new file.
+    // Args:
+    //     path:  Capture file path.
+    //     capacity:  Number of records the ring buffer holds.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int Start(std::string const& path, size_t const& capacity = 65536);
+
+    // Stop capturing, the queued records are written before the file is closed.
+    void Stop(void);
+
+    bool is_running(void) const {
+        return running_.load(std::memory_order_relaxed);
+    }
+
+    // Record the traffic of a connection, does nothing when the tap is not running.
+    // Args:
+    //     conn_id:  Connection ID.
+    //     type:  See CaptureRecordType.
+    //     data:  Raw bytes, may be nullptr if len is 0.
+    //     len:  Number of bytes.
+    void Record(uint32_t const& conn_id, uint8_t const& type, void const* data, size_t const& len) {
+        if (!running_.load(std::memory_order_relaxed))
+            return;
+        Push(conn_id, type, data, len);
+    }
+
+    // Number of records written.
+    uint64_t records(void) const {
+        return records_.load(std::memory_order_relaxed);
+    }
+
+    // Number of records dropped because the ring buffer was full.
+    uint64_t dropped(void) const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void Push(uint32_t const& conn_id, uint8_t const& type, void const* data, size_t const& len);
+    void WriterHandler(void);
+
+    std::mutex                                 mutex_; // Serializes Start() and Stop().
+    std::atomic_bool                           running_;
+    std::atomic<int>                           producers_; // Threads inside Push().
+    std::atomic<uint64_t>                      records_;
+    std::atomic<uint64_t>                      dropped_;
+    std::unique_ptr<RingBuffer<CaptureRecord>> ring_;
+    CaptureWriter                              writer_;
+    std::thread                                writer_thread_;
+};
+
+} // namespace libjt808
+
+#endif // JT808_CAPTURE_H_
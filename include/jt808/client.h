@@ -40,16 +40,22 @@
 #endif
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <string>
 #include <thread>
-#include <list>
 #include <mutex>
 
+#include "jt808/geofence.h"
+#include "jt808/location_journal.h"
+#include "jt808/outbound_queue.h"
 #include "jt808/packager.h"
 #include "jt808/parser.h"
 #include "jt808/protocol_parameter.h"
+#include "jt808/reassembler.h"
 #include "jt808/terminal_parameter.h"
+#include "jt808/upgrade_receiver.h"
 
 namespace libjt808 {
 
@@ -152,6 +158,58 @@ public:
         return service_is_running_;
     }
 
+    //
+    // Event driven mode, Linux only.
+    //
+    // Instead of ConnectRemote(), JT808ConnectionAuthentication() and Run(), the client can be driven by an event
+    // loop of the application, so one thread hosts many clients; the client creates no thread and never blocks.
+    //     1. ConnectRemoteNonBlocking() starts the connection. Watch socket_fd() for reading, and for writing while
+    //        want_write() is true.
+    //     2. Call HandleReadable() and HandleWritable() when the socket is ready, and HandleTimer() at the latest
+    //        after the milliseconds it returned. Call HandleTimer() too after generating messages from outside, e.g.
+    //        GenerateLocationReportMsgNow().
+    //     3. Registration and authentication run by themselves, is_authenticated() is true once they pass. Location
+    //        reports, heartbeats and the platform commands are then handled as with Run().
+    //     4. Once a call returns -1 the connection failed or timed out, stop watching socket_fd() and call Stop().
+    //        With the blind spot journal enabled, keep calling HandleTimer() while disconnected as well.
+    // All calls on a client, including the setters, must come from the loop thread.
+    //
+    // Start a non-blocking connection to the remote server.
+    // Returns:
+    //     Returns 0 if the connection is in progress or established, -1 on failure.
+    int ConnectRemoteNonBlocking(void);
+
+    // Socket of the connection, -1 if there is none.
+    decltype(socket(0, 0, 0)) socket_fd(void) const {
+        return is_connected_.load() || async_state_ == kAsyncConnecting ? client_ : -1;
+    }
+
+    // Whether the socket needs watching for writing: the connection is in progress or messages are waiting.
+    bool want_write(void) const {
+        return async_state_ == kAsyncConnecting || send_offset_ < send_buffer_.size() || !outbound_.empty();
+    }
+
+    bool is_authenticated(void) const {
+        return is_authenticated_.load();
+    }
+
+    // Receive and handle the available data.
+    // Returns:
+    //     Returns 0 on success, -1 if the connection failed.
+    int HandleReadable(void);
+
+    // Complete the connection, or send the waiting messages.
+    // Returns:
+    //     Returns 0 on success, -1 if the connection failed.
+    int HandleWritable(void);
+
+    // Generate the location reports and heartbeats that are due and send the waiting messages.
+    // Returns:
+    //     Milliseconds until the next call, -1 if the connection failed or registration or authentication timed out.
+    //     While disconnected it journals the location reports (see EnableBlindSpotJournal()) and returns the delay to
+    //     the next one, -1 if the journal is not enabled.
+    int HandleTimer(void);
+
     //
     // External access to set the current general message body parsing and packaging functions,
     // used for overriding or adding command support.
@@ -218,6 +276,7 @@ public:
     void SetInOutAreaAlarmBit(uint8_t const& in) {
         parameter_.location_info.alarm.bit.in_out_area = in;
         location_report_immediately_flag_ |= kAlarmOccurred;
+        outbound_.Notify(); // Report now rather than at the next interval.
     }
 
     // Set the in/out area alarm location extension item.
@@ -226,19 +285,14 @@ public:
     // Returns:
     //     None.
     void SetInOutAreaAlarmExtension(std::vector<uint8_t> const& item) {
-        auto const& it = parameter_.location_extension.find(kAccessAreaAlarm);
-        if (it != parameter_.location_extension.end()) {
-            it->second.assign(item.begin(), item.end());
-        }
-        else {
-            parameter_.location_extension.insert(std::make_pair(kAccessAreaAlarm, item));
-        }
+        parameter_.location_extension.Set(kAccessAreaAlarm, item);
     }
 
     // Set status bit.
     void SetStatusBit(uint32_t const& status) {
         parameter_.location_info.status.value = status;
         location_report_immediately_flag_ |= kStateChanged;
+        outbound_.Notify();
     }
 
     // Get status bit.
@@ -272,15 +326,14 @@ public:
         parameter_.location_info.altitude  = static_cast<uint16_t>(altitude);
         parameter_.location_info.speed     = static_cast<uint16_t>(speed * 10);
         parameter_.location_info.bearing   = static_cast<uint16_t>(bearing);
-        parameter_.location_info.time.assign(timestamp.begin(), timestamp.end());
+        parameter_.location_info.time.Assign(timestamp);
     }
 
     // Get location information extensions.
     int GetLocationExtension(LocationExtensions* items) {
         if (items == nullptr)
             return -1;
-        items->clear();
-        items->insert(parameter_.location_extension.begin(), parameter_.location_extension.end());
+        *items = parameter_.location_extension;
         return 0;
     }
 
@@ -311,8 +364,30 @@ public:
 
     // Immediately generate a location reporting message.
     // Only called when external control of location reporting is enabled.
+    // While not authenticated, the report goes to the blind spot journal if it is enabled.
     void GenerateLocationReportMsgNow(void);
 
+    // Enable store and forward of the location reports made while the link is down, Linux only.
+    // The reports generated by GenerateLocationReportMsgNow() while the client is not authenticated are appended to
+    // a memory mapped journal. The report interval keeps running during the outage for reports with a position fix:
+    // from a thread started by the next ConnectRemote() until the journal is disabled, or from HandleTimer() in the
+    // event driven mode. With msg_generate_outside set, keep calling GenerateLocationReportMsgNow() instead. Once
+    // authenticated, the journal is uploaded as 0x0704 batch location reports with data type 1 (blind spot), one
+    // batch in flight; a batch larger than a packet is sent as a fragmented message and leaves the journal when its
+    // last packet is answered with success. A refused batch is sent again after 30 seconds, and dropped after it was
+    // refused 5 times.
+    // Args:
+    //     path:  Journal file, the reports left from a previous run are uploaded too.
+    //     capacity:  Bytes of the journal, the oldest reports are overwritten when it is full.
+    //     batch_size:  Maximum number of reports in one 0x0704 message.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int EnableBlindSpotJournal(std::string const& path, size_t const& capacity = 4 * 1024 * 1024,
+                               uint16_t const& batch_size = 200);
+
+    // Stop journaling and its thread, the reports left in the journal file are uploaded after it is enabled again.
+    void DisableBlindSpotJournal(void);
+
     //
     // Terminal parameter related.
     //
@@ -362,6 +437,7 @@ public:
     //
     // Upgrade related.
     //
+    // Report the upgrade result (0x0108) of the last received upgrade package.
     void UpgradeResultReport(uint8_t const& result);
     // Callback function for issuing upgrade packages.
     // Args:
@@ -377,6 +453,41 @@ public:
         upgrade_callback_ = callback;
     }
 
+    // Callback function for each upgrade package chunk, called as the fragments arrive.
+    // Fragments may arrive out of order or more than once across reconnections, each chunk is reported only once.
+    // Args:
+    //     type:  Upgrade type.
+    //     offset:  Offset of the chunk in the upgrade package.
+    //     data:  Chunk data.
+    //     size:  Chunk size.
+    //     total_len:  Total length of the upgrade package.
+    // Returns:
+    //     Returns 0 if the chunk has been stored, the fragment is rejected otherwise.
+    using UpgradeChunkCallback = std::function<int(uint8_t const& type, uint32_t const& offset, uint8_t const* data,
+                                                   uint32_t const& size, uint32_t const& total_len)>;
+
+    // Set the callback function for upgrade package chunks.
+    // Once set, upgrade packages are no longer buffered in memory and the OnUpgraded() callback is not called.
+    // A successful upgrade result is reported when all chunks are stored, unless auto_report is false, then the
+    // application calls UpgradeResultReport() after checking the image.
+    void OnUpgradeChunk(UpgradeChunkCallback const& callback, bool const& auto_report = true) {
+        upgrade_chunk_callback_ = callback;
+        upgrade_auto_report_    = auto_report;
+    }
+
+    // Maximum number of recently sent fragments kept to answer 0x8003 fill packet requests, 256 by default.
+    void SetRetransmitCacheCapacity(size_t const& capacity) {
+        std::unique_lock<std::mutex> lock(msg_generate_mutex_);
+        retransmit_cache_.set_capacity(capacity);
+    }
+
+    // Get the fragment tracking state of the upgrade in progress.
+    // Save it together with the partially written image to resume the upgrade after a restart, the state is kept
+    // across reconnections automatically. Only access it while the service is stopped or from the chunk callback.
+    UpgradeReceiver& upgrade_receiver(void) {
+        return upgrade_receiver_;
+    }
+
     //
     // Area route related.
     //
@@ -412,7 +523,10 @@ public:
     //     Returns -1 if the area ID already exists, otherwise returns 0.
     int AddPolygonArea(PolygonArea const& area) {
         auto const& id = area.area_id;
-        return (polygon_areas_.insert(std::make_pair(id, area)).second - 1);
+        if (!polygon_areas_.insert(std::make_pair(id, area)).second)
+            return -1;
+        area_index_.Insert(area);
+        return 0;
     }
 
     // Add a new polygon area.
@@ -430,7 +544,7 @@ public:
                        std::string const& end_time, uint16_t const& max_speed, uint8_t const& overspeed_time,
                        std::vector<LocationPoint> const& vertices) {
         PolygonArea area = {id, AreaAttribute {attr}, begin_time, end_time, max_speed, overspeed_time, vertices};
-        return (polygon_areas_.insert(std::make_pair(id, area)).second - 1);
+        return AddPolygonArea(area);
     }
 
     // Update a polygon area information.
@@ -448,8 +562,8 @@ public:
     void UpdatePolygonArea(uint32_t const& id, uint16_t const& attr, std::string const& begin_time,
                            std::string const& end_time, uint16_t const& max_speed, uint8_t const& overspeed_time,
                            std::vector<LocationPoint> const& vertices) {
-        PolygonArea area   = {id, AreaAttribute {attr}, begin_time, end_time, max_speed, overspeed_time, vertices};
-        polygon_areas_[id] = area;
+        PolygonArea area = {id, AreaAttribute {attr}, begin_time, end_time, max_speed, overspeed_time, vertices};
+        UpdatePolygonAreaByArea(area);
     }
 
     // Update the specified polygon area.
@@ -459,6 +573,8 @@ public:
     //     None.
     void UpdatePolygonAreaByArea(PolygonArea const& area) {
         polygon_areas_[area.area_id] = area;
+        if (area_index_.Insert(area) != 0)
+            area_index_.Erase(kGeofencePolygon, area.area_id);
     }
 
     // Update the specified polygon areas.
@@ -468,7 +584,7 @@ public:
     //     None.
     void UpdatePolygonAreaByAreas(PolygonAreaSet const& areas) {
         for (auto const& item : areas) {
-            polygon_areas_[item.first] = item.second;
+            UpdatePolygonAreaByArea(item.second);
         }
     }
 
@@ -481,6 +597,7 @@ public:
         auto const& it = polygon_areas_.find(id);
         if (it != polygon_areas_.end())
             polygon_areas_.erase(it);
+        area_index_.Erase(kGeofencePolygon, id);
     }
 
     // Delete the specified polygon area by ID.
@@ -506,8 +623,18 @@ public:
     //     None.
     void DeleteAllPolygonArea(void) {
         polygon_areas_.clear();
+        area_index_.Clear(kGeofencePolygon);
     }
 
+    // Get the polygon areas containing a point, only the areas whose bounding box holds the point are tested.
+    // Args:
+    //     latitude:  Degrees, negative in the southern hemisphere.
+    //     longitude:  Degrees, negative in the western hemisphere.
+    //     ids:  Area IDs are appended.
+    // Returns:
+    //     Number of area IDs appended.
+    size_t GetPolygonAreasAt(double const& latitude, double const& longitude, std::vector<uint32_t>* ids) const;
+
     // Polygon area callback function.
     using PolygonAreaCallback = std::function<void(void /* Parameters to be determined. */)>;
 
@@ -516,6 +643,77 @@ public:
         polygon_area_callback_ = callback;
     }
 
+    // Get the current circular area information set.
+    CircularAreaSet const& circular_areas(void) const {
+        return circular_areas_;
+    }
+
+    // Get the current rectangle area information set.
+    RectangleAreaSet const& rectangle_areas(void) const {
+        return rectangle_areas_;
+    }
+
+    // Get the current route information set.
+    RouteSet const& routes(void) const {
+        return routes_;
+    }
+
+    // Set circular areas as the platform does with 0x8600.
+    // Args:
+    //     setting_type:  See AreaSettingType.
+    //     areas:  Circular areas.
+    // Returns:
+    //     Returns 0 on success, -1 if the setting type is unknown.
+    int UpdateCircularAreas(uint8_t const& setting_type, CircularAreaSet const& areas);
+
+    // Delete circular areas by ID, all of them when the ID set is empty.
+    void DeleteCircularAreaByIDs(std::vector<uint32_t> const& ids);
+
+    // Set rectangle areas as the platform does with 0x8602.
+    // Args:
+    //     setting_type:  See AreaSettingType.
+    //     areas:  Rectangle areas.
+    // Returns:
+    //     Returns 0 on success, -1 if the setting type is unknown.
+    int UpdateRectangleAreas(uint8_t const& setting_type, RectangleAreaSet const& areas);
+
+    // Delete rectangle areas by ID, all of them when the ID set is empty.
+    void DeleteRectangleAreaByIDs(std::vector<uint32_t> const& ids);
+
+    // Add or replace a route.
+    // Args:
+    //     route:  Route, at least 2 inflection points.
+    // Returns:
+    //     Returns 0 on success, -1 if the route has less than 2 inflection points.
+    int UpdateRoute(Route const& route) {
+        if (area_index_.Insert(route) != 0)
+            return -1;
+        routes_[route.route_id] = route;
+        return 0;
+    }
+
+    // Delete routes by ID, all of them when the ID set is empty.
+    void DeleteRouteByIDs(std::vector<uint32_t> const& ids);
+
+    // Get the areas and routes containing a point, only the entries whose bounding box holds the point are tested.
+    // Time windows are not checked.
+    // Args:
+    //     latitude:  Degrees, negative in the southern hemisphere.
+    //     longitude:  Degrees, negative in the western hemisphere.
+    //     areas:  Area type and ID pairs are appended.
+    // Returns:
+    //     Number of pairs appended.
+    size_t GetAreasAt(double const& latitude, double const& longitude,
+                      std::vector<std::pair<GeofenceAreaType, uint32_t>>* areas) const;
+
+    // Circular area, rectangle area and route callback function, called with the message ID.
+    using AreaRouteCallback = std::function<void(uint16_t const& msg_id)>;
+
+    // Set the callback function when the platform sets or deletes circular areas, rectangle areas or routes.
+    void OnAreaRouteUpdated(AreaRouteCallback const& callback) {
+        area_route_callback_ = callback;
+    }
+
     //
     // Multimedia data upload.
     //
@@ -547,14 +745,58 @@ private:
     int PackagingMessage(uint32_t const& msg_id, std::vector<uint8_t>* out);
     // Generate a message and store it in the general message list.
     int PackagingGeneralMessage(uint32_t const& msg_id);
+    // Generate the frames of a message body, fragmented if it exceeds one packet.
+    int PackagingFragmentedMessage(uint16_t const& msg_id, std::vector<uint8_t> const& body,
+                                   std::vector<std::vector<uint8_t>>* frames, uint16_t* last_flow_num);
+    // Queue the next batch of the blind spot journal once the previous one was answered.
+    void UploadBlindSpotBatch(std::chrono::steady_clock::time_point const& now);
+    // Remove the uploaded batch from the blind spot journal on the answer to its last packet.
+    void OnBlindSpotBatchResponse(uint16_t const& flow_num, uint8_t const& result);
+    // Journal a location report when the interval since begin_tp elapsed while not authenticated.
+    // Returns the milliseconds until the next one, -1 if nothing is journaled by interval.
+    int64_t RecordBlindSpotReport(std::chrono::steady_clock::time_point const& now,
+                                  std::chrono::steady_clock::time_point* begin_tp);
+    // Start the thread journaling the location reports while disconnected, threaded mode.
+    void StartBlindSpotRecording(void);
+    // Stop the journaling thread and wait for it.
+    void StopBlindSpotRecording(void);
+    // Thread handler function for journaling the location reports while disconnected.
+    void BlindSpotRecordHandler(void);
     // Send a message.
     int SendMessage(std::vector<uint8_t> const& msg);
+    // Apply a circular or rectangle area setting to the area set and the index.
+    template <typename T>
+    int UpdateAreas(GeofenceAreaType const& type, uint8_t const& setting_type, std::map<uint32_t, T> const& areas,
+                    std::map<uint32_t, T>* current);
+    // Delete areas or routes of a type by ID, all of them when the ID set is empty.
+    template <typename T>
+    void DeleteAreas(GeofenceAreaType const& type, std::vector<uint32_t> const& ids, std::map<uint32_t, T>* current);
     // Main thread handler function.
     void ThreadHandler(void);
     // Thread handler function for sending messages to the server.
     void SendHandler(std::atomic_bool* const running);
     // Thread handler function for receiving messages from the server.
     void ReceiveHandler(std::atomic_bool* const running);
+    // Handle a complete frame received from the server.
+    void HandleMessage(std::vector<uint8_t> const& frame);
+
+    // Connection progress of the event driven mode.
+    enum AsyncState : uint8_t {
+        kAsyncIdle = 0x0,
+        kAsyncConnecting,
+        kAsyncRegistering,
+        kAsyncAuthenticating,
+        kAsyncOnline,
+    };
+
+    // Send the registration message once connected, event driven mode.
+    int StartRegistration(void);
+    // Handle a frame received in the event driven mode.
+    int HandleAsyncFrame(std::vector<uint8_t> const& frame);
+    // Move the waiting messages to the socket until it is full, event driven mode.
+    int FlushMessages(void);
+    // Close the connection and clear the state of the event driven mode.
+    void ResetAsyncState(void);
 
     std::atomic_bool          manual_deal_;        // Manual processing flag.
     std::mutex                msg_generate_mutex_; // Message generation mutex to ensure unique message serial numbers.
@@ -573,13 +815,44 @@ private:
     std::atomic_bool jt808_connection_handling_; // Flag indicating JT808 connection authentication is in progress.
     TerminalParameterCallback terminal_parameter_callback_; // Callback function for modifying terminal parameters.
     UpgradeCallback           upgrade_callback_;            // Callback function for issuing terminal upgrade packages.
+    UpgradeChunkCallback      upgrade_chunk_callback_;      // Callback function for upgrade package chunks.
+    bool                      upgrade_auto_report_;         // Report the upgrade result when all chunks are stored.
+    UpgradeReceiver           upgrade_receiver_;            // Fragment tracking of the upgrade in progress.
+    FragmentRetransmitCache   retransmit_cache_;            // Recently sent fragments, for 0x8003 fill packet requests.
+    FragmentReassembler       reassembler_;                 // Fragmented downlink messages being reassembled.
     PolygonAreaCallback       polygon_area_callback_;       // Callback function for modifying polygon area information.
+    AreaRouteCallback         area_route_callback_;         // Callback function for modifying areas and routes.
     Packager                  packager_;                    // General JT808 protocol packager.
     Parser                    parser_;                      // General JT808 protocol parser.
-    std::list<std::vector<uint8_t>> location_report_msg_;   // Location reporting message list.
-    std::list<std::vector<uint8_t>> general_msg_;           // Message list excluding location reporting messages.
+    OutboundQueue                   outbound_;              // Encoded messages waiting to be sent, by priority.
     PolygonAreaSet                  polygon_areas_;         // Polygon area information set.
+    CircularAreaSet                 circular_areas_;        // Circular area information set.
+    RectangleAreaSet                rectangle_areas_;       // Rectangle area information set.
+    RouteSet                        routes_;                // Route information set.
+    GeofenceAreas                   area_index_;            // Areas and routes prepared for point lookups.
     ProtocolParameter               parameter_;             // JT808 protocol parameters.
+    // Event driven mode.
+    AsyncState                            async_state_;        // Connection progress.
+    std::vector<uint8_t>                  recv_buffer_;        // Received bytes of an incomplete frame.
+    std::vector<std::vector<uint8_t>>     frames_;             // Frames extracted from recv_buffer_.
+    std::vector<uint8_t>                  send_buffer_;        // Messages being sent.
+    size_t                                send_offset_;        // Bytes of send_buffer_ accepted by the socket.
+    std::chrono::steady_clock::time_point async_deadline_;     // Timeout of connecting, registering or authenticating.
+    std::chrono::steady_clock::time_point report_begin_tp_;    // Last location report.
+    std::chrono::steady_clock::time_point heartbeat_begin_tp_; // Last message sent, for the heartbeat.
+    bool                                  first_report_;       // No location report sent since authentication.
+    // Blind spot store and forward.
+    std::mutex                            journal_mutex_;         // Guards the journal and the batch in flight.
+    LocationJournal                       journal_;               // Reports made while not authenticated.
+    uint16_t                              blind_spot_batch_size_; // Maximum reports per 0x0704 message.
+    bool                                  blind_spot_in_flight_;  // A batch waits for its answer.
+    uint16_t                              blind_spot_flow_num_;   // Flow number of the last packet of the batch.
+    uint64_t                              blind_spot_next_;       // Journal position after the batch.
+    std::chrono::steady_clock::time_point blind_spot_sent_tp_;    // When the batch was queued.
+    uint8_t                               blind_spot_refusals_;   // Failure answers to the batch at the journal head.
+    std::thread                           blind_spot_thread_;     // Journals the reports while disconnected.
+    bool                                  blind_spot_recording_;  // Keeps blind_spot_thread_ running.
+    std::condition_variable               blind_spot_cv_;         // Wakes blind_spot_thread_ to stop.
 
     friend class JT808CustomClient; // Allow the custom server to access private members.
 };
@@ -0,0 +1,140 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  firmware_cache.h
+// @Version :  1.0
+// @Time    :  2026/10/19 09:12:40
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_FIRMWARE_CACHE_H_
+#define JT808_FIRMWARE_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "jt808/protocol_parameter.h"
+
+namespace libjt808 {
+
+// One 0x8108 fragment, message body only.
+// The per-session header fields (phone number, flow number, packet sequence) are added when the frame is sent.
+struct FirmwareFragment {
+    uint16_t             body_len;     // Message body length before escaping.
+    uint8_t              body_bcc;     // XOR checksum of the unescaped message body.
+    std::vector<uint8_t> escaped_body; // Escaped message body.
+};
+
+// Upgrade image pre-sliced into 0x8108 fragments.
+// Images are immutable once created and shared by reference between upgrade sessions.
+struct FirmwareImage {
+    std::string                   path;            // Upgrade file path.
+    uint8_t                       upgrade_type;    // Upgrade type.
+    std::vector<uint8_t>          manufacturer_id; // Manufacturer ID, fixed 5 bytes.
+    std::string                   version_id;      // Upgrade version number.
+    uint32_t                      total_len;       // Total length of the upgrade package.
+    std::vector<FirmwareFragment> fragments;       // Fragments in packet sequence order.
+};
+
+using FirmwareImagePtr = std::shared_ptr<FirmwareImage const>;
+
+// Slice an upgrade package into escaped 0x8108 fragments.
+// Every fragment carries the upgrade type, manufacturer ID, version number and total length followed by its share of
+// the upgrade data, the same layout JT808FramePackage() produces for kTerminalUpgrade.
+// Args:
+//     data:  Upgrade package content.
+//     len:  Upgrade package size.
+//     image:  Image to fill, upgrade_type/manufacturer_id/version_id must be set by the caller.
+// Returns:
+//     Returns 0 on success, -1 on failure.
+int SliceFirmwareImage(uint8_t const* data, size_t const& len, FirmwareImage* image);
+
+// Generate the complete frame of one fragment for a terminal.
+// Args:
+//     msg_head:  Terminal message header, phone number and flow number are taken from it.
+//     image:  Upgrade image.
+//     index:  Fragment index, starting from 0.
+//     out:  Complete escaped frame.
+// Returns:
+//     Returns 0 on success, -1 on failure.
+int PackageFirmwareFragment(MsgHead const& msg_head, FirmwareImage const& image, size_t const& index,
+                            std::vector<uint8_t>* out);
+
+// Upgrade image cache.
+// Each upgrade file is mapped into memory and sliced only once, later requests for the same file, upgrade type,
+// manufacturer ID and version share the cached fragments. A cached image is reloaded if the file has been modified.
+//
+// Example:
+//     FirmwareImageCache cache;
+//     auto image = cache.Load("./upgrade.bin", kTerminal, {'S', 'K', 'O', 'E', 'M'}, "1.0.1");
+//     if (image != nullptr) {
+//       std::vector<uint8_t> frame;
+//       for (size_t i = 0; i < image->fragments.size(); ++i) {
+//         PackageFirmwareFragment(msg_head, *image, i, &frame);
+//         // Send frame.
+//       }
+//     }
+class FirmwareImageCache {
+public:
+    FirmwareImageCache() {
+    }
+
+    ~FirmwareImageCache() {
+    }
+
+    // Get the cached image, the upgrade file is loaded and sliced on first use.
+    // Returns:
+    //     The shared image, nullptr if the file can not be read.
+    FirmwareImagePtr Load(std::string const& path, uint8_t const& upgrade_type,
+                          std::vector<uint8_t> const& manufacturer_id, std::string const& version_id);
+
+    // Remove all cached images of the upgrade file.
+    // Sessions still holding an image keep it alive until they finish.
+    void Evict(std::string const& path);
+
+    // Remove all cached images.
+    void Clear(void);
+
+    // Number of cached images.
+    size_t size(void) const;
+
+private:
+    struct Entry {
+        int64_t          mtime; // Modification time of the file when it was loaded.
+        int64_t          size;  // File size when it was loaded.
+        FirmwareImagePtr image;
+    };
+
+    mutable std::mutex           mutex_;
+    std::map<std::string, Entry> images_; // Key: path, upgrade type, manufacturer ID and version.
+};
+
+} // namespace libjt808
+
+#endif // JT808_FIRMWARE_CACHE_H_
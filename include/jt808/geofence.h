@@ -0,0 +1,325 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  geofence.h
+// @Version :  1.0
+// @Time    :  2026/10/19 19:05:37
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_GEOFENCE_H_
+#define JT808_GEOFENCE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jt808/area_index.h"
+#include "jt808/area_route.h"
+#include "jt808/message_view.h"
+#include "jt808/point_in_polygon.h"
+
+namespace libjt808 {
+
+// Area types, the values are those of the location type of the overspeed and in/out area alarm items.
+enum GeofenceAreaType : uint8_t {
+    kGeofenceCircle = 0x1, // CircularArea, 0x8600.
+    kGeofenceRectangle,    // RectangleArea, 0x8602.
+    kGeofencePolygon,      // PolygonArea, 0x8604.
+    kGeofenceRoute,        // Route, 0x8606.
+};
+
+// Geofence event type.
+enum GeofenceEventType {
+    kGeofenceEnter = 0x0,    // The terminal entered the area.
+    kGeofenceExit,           // The terminal left the area, or deviated from the route.
+    kGeofenceOverspeed,      // The terminal exceeded max_speed inside the area for overspeed_time seconds.
+    kGeofenceDriveTimeShort, // The terminal left a road section sooner than its minimum driving time.
+    kGeofenceDriveTimeLong,  // The terminal left a road section later than its maximum driving time.
+};
+
+// Event of one terminal and one area.
+struct GeofenceEvent {
+    GeofenceEventType type;
+    GeofenceAreaType  area_type;
+    uint32_t          area_id;        // Area or route ID.
+    uint16_t          area_attribute; // See AreaAttribute, or RouteAttribute for routes.
+    uint32_t          section_id;     // Road section of a route, 0 for areas.
+    uint32_t          drive_time;     // Seconds on the road section, for the driving time events.
+    uint32_t          inside_time;    // Seconds from entering to leaving the area, for exit events.
+    uint32_t          latitude;       // Degrees multiplied by 10^6, as reported.
+    uint32_t          longitude;      // Degrees multiplied by 10^6, as reported.
+    uint16_t          speed;          // 1/10 km/h.
+    int64_t           time;           // Seconds since the Unix epoch of the report.
+};
+
+// Areas and routes prepared for point tests, with one spatial index over the bounding boxes of the areas and of every
+// road section of the routes, so long routes only test the sections near the point.
+// Circles and road sections are tested on a local flat projection, accurate for sizes up to tens of kilometres.
+// Areas are kept in slots, a slot keeps its index until the area is erased and erased slots are reused. IDs are
+// separate for each area type, as in JT808.
+class GeofenceAreas {
+public:
+    // Road section of a route, from one inflection point to the next.
+    struct RouteSection {
+        uint32_t section_id;
+        uint32_t segment;        // Geometry, see Segment.
+        uint16_t max_speed;      // km/h, 0 if the section has no speed limit.
+        uint8_t  overspeed_time; // Seconds.
+        bool     drive_time;     // Whether the driving time thresholds apply.
+        uint16_t max_drive_time; // Seconds.
+        uint16_t min_drive_time; // Seconds.
+    };
+
+    struct Area {
+        GeofenceAreaType          type;
+        uint32_t                  area_id;
+        uint16_t                  attribute;      // AreaAttribute, or RouteAttribute for routes.
+        int64_t                   start_time;     // Seconds since the Unix epoch, -1 if not limited by time.
+        int64_t                   stop_time;      // Seconds since the Unix epoch, -1 if not limited by time.
+        bool                      daily;          // The times are seconds of the day (GMT+8), the date was 000000.
+        uint16_t                  max_speed;      // km/h, 0 if the area has no speed limit; see sections for routes.
+        uint8_t                   overspeed_time; // Seconds.
+        AreaBox                   box;            // Microdegrees, negative in the southern and western hemispheres.
+        int32_t                   center_lat;     // Circles.
+        int32_t                   center_lon;     // Circles.
+        double                    radius;         // Circles, meters.
+        PolygonEdges              edges;          // Polygons.
+        std::vector<RouteSection> sections;       // Routes.
+    };
+
+    // An area containing a point.
+    struct Hit {
+        uint32_t slot;
+        uint32_t section;  // Index in Area::sections for routes, 0 for areas.
+        double   distance; // Meters from the route, 0 for areas.
+    };
+
+    GeofenceAreas() {
+    }
+
+    ~GeofenceAreas() {
+    }
+
+    // Add an area or replace the area of the same type and ID in its slot.
+    // The by-time window is applied when both times are complete "YYMMDDhhmmss" dates, or both are daily times with
+    // the date 000000 (GMT+8, may span midnight); otherwise the area is always active.
+    // Returns:
+    //     Returns 0 on success, -1 if the area is degenerate: a polygon with less than 3 vertices or a route with
+    //     less than 2 inflection points.
+    int Insert(CircularArea const& area);
+    int Insert(RectangleArea const& area);
+    int Insert(PolygonArea const& area);
+    int Insert(Route const& route);
+
+    // Returns the number of areas erased, 0 or 1.
+    size_t Erase(GeofenceAreaType const& type, uint32_t const& area_id);
+
+    // Erase the areas of one type.
+    void Clear(GeofenceAreaType const& type);
+
+    void Clear(void);
+
+    // Number of areas.
+    size_t size(void) const {
+        return slot_of_.size();
+    }
+
+    // Number of slots, the slots of the areas are below it.
+    size_t slot_count(void) const {
+        return areas_.size();
+    }
+
+    // Area of a slot below slot_count(), erased slots have the type 0.
+    Area const& area(uint32_t const& slot) const {
+        return areas_[slot];
+    }
+
+    // Returns 0 and the slot of the area, -1 if there is no such area.
+    int FindSlot(GeofenceAreaType const& type, uint32_t const& area_id, uint32_t* slot) const;
+
+    // Find the areas containing a point, and the routes whose corridor holds it with the nearest road section.
+    // Args:
+    //     lat:  Latitude, signed microdegrees.
+    //     lon:  Longitude, signed microdegrees.
+    //     hits:  The areas are appended, in no particular order.
+    // Returns:
+    //     Number of areas appended.
+    size_t Query(int32_t const& lat, int32_t const& lon, std::vector<Hit>* hits) const;
+
+private:
+    // Straight road section with its half width, projected to meters around its first point.
+    struct Segment {
+        uint32_t slot;
+        uint32_t section;
+        int32_t  lat;
+        int32_t  lon;
+        double   lon_scale;  // Meters per microdegree of longitude.
+        double   dx;         // Meters to the second point, eastwards.
+        double   dy;         // Meters to the second point, northwards.
+        double   half_width; // Meters.
+    };
+
+    // Index keys of the road sections have this bit set, the other bits are the segment number.
+    static constexpr uint32_t kSegmentKey = 0x80000000;
+
+    static uint64_t AreaKey(GeofenceAreaType const& type, uint32_t const& area_id) {
+        return (static_cast<uint64_t>(type) << 32) | area_id;
+    }
+
+    // Slot of the area, a new or a reused one if the area does not exist, with its old geometry removed.
+    Area& PrepareSlot(GeofenceAreaType const& type, uint32_t const& area_id, uint32_t* slot);
+    void  RemoveGeometry(uint32_t const& slot);
+    // Squared distance in meters from the point to the segment.
+    static double SegmentDistance2(Segment const& segment, int32_t const& lat, int32_t const& lon);
+
+    std::vector<Area>                      areas_;
+    std::vector<uint32_t>                  free_slots_;
+    std::vector<Segment>                   segments_;
+    std::vector<uint32_t>                  free_segments_;
+    std::unordered_map<uint64_t, uint32_t> slot_of_; // Type and area ID to slot.
+    AreaGridIndex                          index_;   // Keyed by slot, or by segment for the road sections.
+};
+
+using GeofenceAreasPtr = std::shared_ptr<GeofenceAreas const>;
+
+// Prepare polygon areas for the geofence engine, areas with less than 3 vertices are skipped.
+GeofenceAreasPtr GeofenceCompile(PolygonAreaSet const& areas);
+
+// Point in area test on microdegrees, routes excluded. See PolygonEdgesContains() for polygons.
+bool GeofenceContains(GeofenceAreas::Area const& area, int32_t const& lat, int32_t const& lon);
+
+// Whether an area applies at a time, in seconds since the Unix epoch. A daily window may span midnight.
+bool GeofenceInTimeWindow(GeofenceAreas::Area const& area, int64_t const& time);
+
+// Platform side geofence engine.
+// Every location report of a terminal is tested against the areas and routes assigned to it. Entering and leaving an
+// area or a route, speeding inside it and the driving time of the road sections are reported as events, so the
+// platform does not depend on the terminals' own alarms. A terminal starts outside all areas, its first report
+// inside an area is an enter event. The driving time of a road section is checked when the terminal moves on to
+// another section of the route. Areas with by_time set only apply inside their time window, a terminal inside an
+// area when its window closes leaves it.
+// The state of a terminal is kept only for the areas it is in, so it is updated from each report alone and its size
+// does not depend on the number of areas assigned.
+// Only the areas whose bounding box holds the point are tested, see AreaGridIndex. Areas are assigned from any
+// thread; Evaluate() is called by the I/O thread and allocates nothing once the terminal's state exists.
+class GeofenceEngine {
+public:
+    GeofenceEngine() : hysteresis_(1) {
+    }
+
+    ~GeofenceEngine() {
+    }
+
+    // Assign areas to terminals, replacing their previous areas and state.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int SetAreas(std::string const& phone, GeofenceAreasPtr const& areas);
+    int SetAreas(std::vector<std::string> const& phones, PolygonAreaSet const& areas);
+
+    // Add or replace one area of a terminal, call it along with sending 0x8600, 0x8602, 0x8604 or 0x8606 to the
+    // terminal. Areas shared with other terminals are copied first. The terminal stays inside a replaced area until
+    // a report outside of it.
+    // Returns:
+    //     Returns 0 on success, -1 if the area is degenerate.
+    int UpdateArea(std::string const& phone, CircularArea const& area);
+    int UpdateArea(std::string const& phone, RectangleArea const& area);
+    int UpdateArea(std::string const& phone, PolygonArea const& area);
+    int UpdateArea(std::string const& phone, Route const& route);
+
+    // Delete areas of one type of a terminal, all of them if ids is empty, call it along with sending 0x8601,
+    // 0x8603, 0x8605 or 0x8607 to the terminal. No exit event is reported for the deleted areas.
+    void DeleteAreas(std::string const& phone, GeofenceAreaType const& type, std::vector<uint32_t> const& ids);
+
+    // Stop checking a terminal.
+    void RemoveTerminal(std::string const& phone);
+
+    void Clear(void);
+
+    // Number of terminals with assigned areas.
+    size_t size(void) const;
+
+    // Set the number of consecutive reports inside, or outside, an area needed to enter, or leave, it.
+    // The default 1 reports every crossing at once. Larger values suppress the enter and exit pairs of a terminal
+    // drifting along a boundary, at the cost of reporting each crossing that many reports later; the entry time and
+    // inside_time still count from the first of those reports.
+    void SetHysteresis(uint8_t const& reports) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        hysteresis_ = reports > 0 ? reports : 1;
+    }
+
+    // Test one location report.
+    // Args:
+    //     phone:  Terminal phone number.
+    //     report:  Location report body.
+    //     events:  Events of the report are appended.
+    // Returns:
+    //     Number of events appended, -1 if the report is invalid.
+    int Evaluate(std::string const& phone, LocationReportView const& report, std::vector<GeofenceEvent>* events);
+
+private:
+    enum AreaStateFlag : uint8_t {
+        kStateInside            = 0x1,
+        kStateHit               = 0x2, // Inside according to the report being evaluated.
+        kStateOverspeedReported = 0x4,
+    };
+
+    // State of a terminal in an area it is in, or is entering. Times are seconds since the Unix epoch.
+    struct AreaState {
+        uint32_t slot;
+        uint32_t entered;         // Time of the first report inside.
+        uint32_t left;            // Time of the first report outside while leaving.
+        uint32_t section_since;   // Time of the first report on the road section.
+        uint32_t overspeed_since; // Time of the first report above the limit, 0 if not speeding.
+        uint16_t section;         // Road section of a route the terminal is on.
+        uint8_t  flags;           // See AreaStateFlag.
+        uint8_t  pending;         // Consecutive reports towards entering, or leaving, see SetHysteresis().
+    };
+
+    struct Terminal {
+        GeofenceAreasPtr               areas;
+        std::shared_ptr<GeofenceAreas> owned;  // Same as areas once they have been updated for this terminal only.
+        std::vector<AreaState>         states; // Unordered.
+    };
+
+    // Areas of a terminal that can be updated, copied from the shared areas on first use.
+    static GeofenceAreas* MutableAreas(Terminal* terminal);
+    static AreaState*     FindState(std::vector<AreaState>* states, uint32_t const& slot);
+
+    template <typename T>
+    int UpdateAreaOf(std::string const& phone, T const& area);
+
+    mutable std::mutex                        mutex_;
+    std::unordered_map<std::string, Terminal> terminals_;
+    std::vector<GeofenceAreas::Hit>           hits_; // Areas containing the report being evaluated.
+    uint8_t                                   hysteresis_;
+};
+
+} // namespace libjt808
+
+#endif // JT808_GEOFENCE_H_
@@ -0,0 +1,118 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  handler_pool.h
+// @Version :  1.0
+// @Time    :  2026/10/19 15:48:03
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_HANDLER_POOL_H_
+#define JT808_HANDLER_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "jt808/ring_buffer.h"
+
+namespace libjt808 {
+
+// Worker threads running the application handlers of the server off the I/O thread.
+// Each worker owns a lock-free queue; a session is always hashed to the same worker, so the tasks of one session run
+// in submission order while different sessions run in parallel.
+class HandlerPool {
+public:
+    using Task = std::function<void(void)>;
+
+    HandlerPool() : running_(false), executed_(0) {
+    }
+
+    ~HandlerPool() {
+        Stop();
+    }
+
+    HandlerPool(HandlerPool const&)            = delete;
+    HandlerPool& operator=(HandlerPool const&) = delete;
+
+    // Start the workers.
+    // Args:
+    //     threads:  Number of worker threads.
+    //     capacity:  Number of tasks each worker queue holds.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int Start(size_t const& threads, size_t const& capacity = 1024);
+
+    // Stop the workers after the queued tasks have run.
+    void Stop(void);
+
+    bool is_running(void) const {
+        return running_.load(std::memory_order_relaxed);
+    }
+
+    // Queue a task of a session without blocking, the pool must be running.
+    // Returns:
+    //     Returns false if the worker queue of the session is full, the task is left untouched.
+    bool TrySubmit(uint64_t const& session, Task&& task) {
+        return workers_[WorkerIndex(session)]->queue.TryPush(std::move(task));
+    }
+
+    // Queue a task of a session, waiting while the worker queue is full; the pool must be running.
+    void Submit(uint64_t const& session, Task&& task);
+
+    // Number of tasks run so far.
+    uint64_t executed(void) const {
+        return executed_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Worker {
+        explicit Worker(size_t const& capacity) : queue(capacity) {
+        }
+
+        RingBuffer<Task> queue;
+        std::thread      thread;
+    };
+
+    size_t WorkerIndex(uint64_t const& session) const {
+        // Fibonacci hashing spreads consecutive socket descriptors over the workers.
+        return static_cast<size_t>((session * 0x9E3779B97F4A7C15ULL) >> 32) % workers_.size();
+    }
+
+    void WorkerHandler(Worker* worker);
+
+    std::mutex                           mutex_; // Serializes Start() and Stop().
+    std::atomic_bool                     running_;
+    std::atomic<uint64_t>                executed_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+} // namespace libjt808
+
+#endif // JT808_HANDLER_POOL_H_
@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_columns.h
+// @Version :  1.0
+// @Time    :  2026/10/19 17:06:12
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_LOCATION_COLUMNS_H_
+#define JT808_LOCATION_COLUMNS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "jt808/message_view.h"
+#include "jt808/util.h"
+
+namespace libjt808 {
+
+// Location points in columnar form (structure of arrays), one entry per point in every column.
+// Decoding reuses the capacity of the columns, so a long-lived instance decodes batches without allocating once it
+// has grown to the largest batch.
+struct LocationColumns {
+    std::vector<uint32_t> alarm;     // Alarm words, see AlarmBit.
+    std::vector<uint32_t> status;    // Status words, see StatusBit.
+    std::vector<uint32_t> latitude;  // Degrees multiplied by 10^6.
+    std::vector<uint32_t> longitude; // Degrees multiplied by 10^6.
+    std::vector<uint16_t> altitude;  // Meters.
+    std::vector<uint16_t> speed;     // 1/10 km/h.
+    std::vector<uint16_t> bearing;
+    std::vector<int64_t>  timestamp; // Seconds since the Unix epoch, -1 if the BCD time is invalid.
+    // Additional information items of point i are extension_pool[extension_offset[i], extension_offset[i + 1]) in
+    // wire format (ID, length, value), see extensions().
+    std::vector<uint32_t> extension_offset; // size() + 1 entries once a point is added.
+    std::vector<uint8_t>  extension_pool;
+
+    size_t size(void) const {
+        return latitude.size();
+    }
+
+    bool empty(void) const {
+        return latitude.empty();
+    }
+
+    // Remove all points, the capacity is kept.
+    void clear(void);
+
+    void reserve(size_t const& points, size_t const& extension_bytes);
+
+    // Additional information items of a point, iterate them with LocationExtensionCursor.
+    ByteSpan extensions(size_t const& index) const {
+        return ByteSpan(extension_pool.data() + extension_offset[index],
+                        extension_offset[index + 1] - extension_offset[index]);
+    }
+};
+
+// Append one location report body to the columns.
+// Returns:
+//     Returns 0 on success, -1 if the body is shorter than the location basic information.
+int JT808LocationColumnsAppend(LocationReportView const& report, LocationColumns* columns);
+
+// Append the points of a 0x0704 batch location report body to the columns.
+// The body is checked before anything is appended, a malformed batch leaves the columns untouched.
+// Args:
+//     body:  Message body, see BatchLocationReportView::body().
+//     columns:  Destination, not cleared so several batches can be accumulated.
+//     data_type:  Optional, 0: normal batch data, 1: blind spot report data.
+// Returns:
+//     Returns 0 on success, -1 on failure.
+int JT808BatchLocationDecode(ByteSpan const& body, LocationColumns* columns, uint8_t* data_type = nullptr);
+
+} // namespace libjt808
+
+#endif // JT808_LOCATION_COLUMNS_H_
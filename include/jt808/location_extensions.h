@@ -0,0 +1,289 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_extensions.h
+// @Version :  1.0
+// @Time    :  2026/10/19 17:48:20
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_LOCATION_EXTENSIONS_H_
+#define JT808_LOCATION_EXTENSIONS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <initializer_list>
+#include <type_traits>
+#include <vector>
+
+#include "jt808/util.h"
+
+namespace libjt808 {
+
+// Array of trivially copyable elements kept inline up to N elements, moved to the heap beyond that.
+// Clearing keeps the heap storage, so a reused buffer stops allocating once it has grown to its working size.
+template <typename T, size_t N>
+class SmallBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "SmallBuffer only holds trivially copyable elements");
+
+public:
+    SmallBuffer() : size_(0) {
+    }
+
+    T* data(void) {
+        return heap_.empty() ? inline_ : heap_.data();
+    }
+
+    T const* data(void) const {
+        return heap_.empty() ? inline_ : heap_.data();
+    }
+
+    size_t size(void) const {
+        return size_;
+    }
+
+    void clear(void) {
+        size_ = 0;
+    }
+
+    // Insert count elements before pos, src may be nullptr to leave them uninitialized.
+    T* Insert(size_t const& pos, T const* src, size_t const& count) {
+        Reserve(size_ + count);
+        T* const p = data();
+        memmove(p + pos + count, p + pos, (size_ - pos) * sizeof(T));
+        if (src != nullptr)
+            memcpy(p + pos, src, count * sizeof(T));
+        size_ += count;
+        return p + pos;
+    }
+
+    void Erase(size_t const& pos, size_t const& count) {
+        T* const p = data();
+        memmove(p + pos, p + pos + count, (size_ - pos - count) * sizeof(T));
+        size_ -= count;
+    }
+
+private:
+    void Reserve(size_t const& capacity) {
+        size_t const current = heap_.empty() ? N : heap_.size();
+        if (capacity <= current)
+            return;
+        size_t const grown = capacity > 2 * current ? capacity : 2 * current;
+        if (heap_.empty()) {
+            heap_.resize(grown);
+            memcpy(heap_.data(), inline_, size_ * sizeof(T));
+        }
+        else {
+            heap_.resize(grown);
+        }
+    }
+
+    T              inline_[N];
+    std::vector<T> heap_; // Whole capacity once the elements moved out of inline_.
+    size_t         size_;
+};
+
+// Value bytes of one additional information item, valid until the owning LocationExtensions is modified.
+class ExtensionValue {
+public:
+    ExtensionValue() : data_(nullptr), size_(0) {
+    }
+
+    ExtensionValue(uint8_t const* data, size_t const& size) : data_(data), size_(size) {
+    }
+
+    uint8_t const* data(void) const {
+        return data_;
+    }
+
+    size_t size(void) const {
+        return size_;
+    }
+
+    bool empty(void) const {
+        return size_ == 0;
+    }
+
+    uint8_t const* begin(void) const {
+        return data_;
+    }
+
+    uint8_t const* end(void) const {
+        return data_ + size_;
+    }
+
+    uint8_t const& operator[](size_t const& i) const {
+        return data_[i];
+    }
+
+    operator ByteSpan(void) const {
+        return ByteSpan(data_, size_);
+    }
+
+private:
+    uint8_t const* data_;
+    size_t         size_;
+};
+
+// Location additional information items, key: item ID, value: item bytes.
+// Items are kept sorted by ID in a flat array over one byte pool, both inline for the usual handful of items, so
+// parsing a report does not allocate per item and lookups stay in one cache line or two. Iteration yields items in
+// ID order with first/second members like std::map, which is also the packaging order.
+class LocationExtensions {
+public:
+    struct value_type {
+        uint8_t        first;
+        ExtensionValue second;
+    };
+
+    class const_iterator {
+    public:
+        const_iterator(LocationExtensions const* owner, size_t const& index) : owner_(owner), index_(index) {
+        }
+
+        value_type const& operator*(void) const {
+            item_ = owner_->At(index_);
+            return item_;
+        }
+
+        value_type const* operator->(void) const {
+            item_ = owner_->At(index_);
+            return &item_;
+        }
+
+        const_iterator& operator++(void) {
+            ++index_;
+            return *this;
+        }
+
+        bool operator==(const_iterator const& other) const {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const_iterator const& other) const {
+            return index_ != other.index_;
+        }
+
+    private:
+        LocationExtensions const* owner_;
+        size_t                    index_;
+        mutable value_type        item_;
+    };
+
+    using iterator = const_iterator;
+
+    const_iterator begin(void) const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end(void) const {
+        return const_iterator(this, entries_.size());
+    }
+
+    size_t size(void) const {
+        return entries_.size();
+    }
+
+    bool empty(void) const {
+        return entries_.size() == 0;
+    }
+
+    void clear(void) {
+        entries_.clear();
+        pool_.clear();
+    }
+
+    const_iterator find(uint8_t const& id) const {
+        size_t const index = LowerBound(id);
+        if (index < entries_.size() && entries_.data()[index].id == id)
+            return const_iterator(this, index);
+        return end();
+    }
+
+    // First item whose ID is not less than id.
+    const_iterator lower_bound(uint8_t const& id) const {
+        return const_iterator(this, LowerBound(id));
+    }
+
+    size_t count(uint8_t const& id) const {
+        return find(id) != end() ? 1 : 0;
+    }
+
+    // Returns:
+    //     Returns 0 on success, -1 if the item is not present.
+    int Get(uint8_t const& id, ExtensionValue* value) const;
+
+    // Decode a BYTE/WORD/DWORD item on demand.
+    // Returns:
+    //     Returns 0 on success, -1 if the item is not present or has another length.
+    int GetU8(uint8_t const& id, uint8_t* value) const;
+    int GetU16(uint8_t const& id, uint16_t* value) const;
+    int GetU32(uint8_t const& id, uint32_t* value) const;
+
+    // Replace the items with the additional information of a location report body, in wire format.
+    // The chain is checked and indexed in one pass and the values copied in one block, no item is decoded.
+    // Returns:
+    //     Returns 0 on success, -1 if an item runs past the end, the items are then cleared.
+    int AssignWire(ByteSpan const& items);
+
+    // Add an item or replace the value of an existing one.
+    // Returns:
+    //     Returns 0 on success, -1 if the value is longer than 255 bytes.
+    int Set(uint8_t const& id, uint8_t const* data, size_t const& len);
+
+    int Set(uint8_t const& id, std::vector<uint8_t> const& value) {
+        return Set(id, value.data(), value.size());
+    }
+
+    int Set(uint8_t const& id, std::initializer_list<uint8_t> value) {
+        return Set(id, value.begin(), value.size());
+    }
+
+    // Returns:
+    //     Returns the number of items removed, 0 or 1.
+    size_t erase(uint8_t const& id);
+
+private:
+    struct Entry {
+        uint8_t  id;
+        uint8_t  len;
+        uint16_t offset; // Into the pool, values are stored in ID order.
+    };
+
+    // Index of the first entry whose ID is not less than id.
+    size_t LowerBound(uint8_t const& id) const;
+
+    value_type At(size_t const& index) const {
+        Entry const& entry = entries_.data()[index];
+        return value_type {entry.id, ExtensionValue(pool_.data() + entry.offset, entry.len)};
+    }
+
+    SmallBuffer<Entry, 12>   entries_;
+    SmallBuffer<uint8_t, 64> pool_;
+};
+
+} // namespace libjt808
+
+#endif // JT808_LOCATION_EXTENSIONS_H_
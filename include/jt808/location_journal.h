@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_journal.h
+// @Version :  1.0
+// @Time    :  2026/10/19 22:41:17
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_LOCATION_JOURNAL_H_
+#define JT808_LOCATION_JOURNAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace libjt808 {
+
+// Persistent ring of location report bodies (0x0200), the blind spot store of the terminal.
+// The records live in a memory mapped file, so they survive a restart of the process; each one is kept as
+// length(WORD, big endian)+body, the layout of a 0x0704 location item, and a batch is read with plain copies.
+// Records never wrap around the end of the file, a full journal overwrites its oldest records. Positions are
+// logical byte offsets that only grow, a reader peeks a batch and consumes it by position once it was delivered.
+// Not thread safe. Linux only, Open() fails elsewhere.
+class LocationJournal {
+public:
+    LocationJournal();
+    ~LocationJournal();
+
+    LocationJournal(LocationJournal const&)            = delete;
+    LocationJournal& operator=(LocationJournal const&) = delete;
+
+    // Open the journal file, creating it if needed.
+    // The records of an existing journal are kept, one of a different capacity is cleared.
+    // Args:
+    //     path:  Journal file.
+    //     capacity:  Bytes available for the records.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int Open(std::string const& path, size_t const& capacity);
+
+    // Unmap the journal, the records stay in the file.
+    void Close(void);
+
+    bool is_open(void) const {
+        return base_ != nullptr;
+    }
+
+    bool empty(void) const;
+
+    // Append a location report body, dropping the oldest records if there is no room.
+    // Returns:
+    //     Returns 0 on success, -1 if the journal is not open or the body does not fit.
+    int Append(uint8_t const* body, size_t const& len);
+
+    // Copy the oldest records as 0x0704 location items, without removing them.
+    // Args:
+    //     max_count:  Maximum number of records.
+    //     max_bytes:  Maximum bytes copied, at least one record is copied.
+    //     items:  The records are appended.
+    //     next:  Position after the last record copied, for Consume().
+    // Returns:
+    //     Returns the number of records copied.
+    size_t Peek(size_t const& max_count, size_t const& max_bytes, std::vector<uint8_t>* items, uint64_t* next) const;
+
+    // Remove the records before a position returned by Peek(), the ones already overwritten are skipped.
+    void Consume(uint64_t const& next);
+
+    // Write the journal back to the file.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int Sync(void);
+
+private:
+    struct Header;
+
+    Header* header(void) const {
+        return reinterpret_cast<Header*>(base_);
+    }
+    uint8_t* records(void) const;
+
+    // Position of the record at pos, after the padding at the end of the ring.
+    uint64_t SkipPadding(uint64_t const& pos) const;
+    // Remove the oldest record.
+    void DropOldest(void);
+    // Check the records after a restart, a partially written tail is cut off.
+    bool Recover(void);
+    void Reset(void);
+
+    uint8_t* base_;     // Mapped file: header, then the records.
+    size_t   map_size_; // Bytes mapped.
+    size_t   capacity_; // Bytes of the records.
+};
+
+} // namespace libjt808
+
+#endif // JT808_LOCATION_JOURNAL_H_
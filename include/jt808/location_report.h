@@ -36,6 +36,9 @@
 #include <string>
 #include <vector>
 
+#include "jt808/bcd.h"
+#include "jt808/location_extensions.h"
+
 namespace libjt808 {
 
 // Alarm bits
@@ -166,7 +169,7 @@ struct LocationBasicInformation {
     // Bearing 0-359, true north is 0, clockwise
     uint16_t bearing;
     // Time, "YYMMDDhhmmss" (GMT+8 time, all times in this standard use this time zone).
-    std::string time;
+    BcdTimestamp time;
 };
 
 // Extended vehicle signal status bits
@@ -271,9 +274,6 @@ enum BasicDataFlowID {
     kCarbonEmissions        = 0x0021, ///< Carbon emissions, g
 };
 
-// Definition of location information additional items storage: key: itemid, value: itemvalue.
-using LocationExtensions = std::map<uint8_t, std::vector<uint8_t>>;
-
 // Overspeed alarm additional information location type, BYTE.
 enum kOverSpeedAlarmLocationType {
     // No specific location.
@@ -335,6 +335,7 @@ int SetOverSpeedAlarmBody(uint8_t const& location_type, uint32_t const& area_rou
 
 // Get overspeed alarm additional information message body.
 int GetOverSpeedAlarmBody(std::vector<uint8_t> const& out, uint8_t* location_type, uint32_t* area_route_id);
+int GetOverSpeedAlarmBody(ByteSpan const& out, uint8_t* location_type, uint32_t* area_route_id);
 
 // Set access area/route alarm additional information message body.
 int SetAccessAreaAlarmBody(uint8_t const& location_type, uint32_t const& area_route_id, uint8_t const& direction,
@@ -343,6 +344,16 @@ int SetAccessAreaAlarmBody(uint8_t const& location_type, uint32_t const& area_ro
 // Get access area/route alarm additional information message body.
 int GetAccessAreaAlarmBody(std::vector<uint8_t> const& out, uint8_t* location_type, uint32_t* area_route_id,
                            uint8_t* direction);
+int GetAccessAreaAlarmBody(ByteSpan const& out, uint8_t* location_type, uint32_t* area_route_id, uint8_t* direction);
+
+// Find one sub-item of the basic data flow additional information (0xEA), sub-items are ID(WORD)+length(BYTE)+value.
+// Args:
+//     flow:  Value of the 0xEA item.
+//     id:  See BasicDataFlowID.
+//     value:  Sub-item value, points into flow.
+// Returns:
+//     Returns 0 on success, -1 if the sub-item is not present or the sub-items are malformed.
+int GetBasicDataFlowItem(ByteSpan const& flow, uint16_t const& id, ByteSpan* value);
 
 } // namespace libjt808
 
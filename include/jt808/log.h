@@ -0,0 +1,328 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  log.h
+// @Version :  1.0
+// @Time    :  2026/10/19 15:02:17
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_LOG_H_
+#define JT808_LOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "jt808/ring_buffer.h"
+
+namespace libjt808 {
+
+// Log level.
+enum LogLevel {
+    kLogDebug = 0x0,
+    kLogInfo,
+    kLogWarn,
+    kLogError,
+    kLogOff, // Disable logging.
+};
+
+// Maximum number of arguments of one log record, the extra arguments are ignored.
+constexpr size_t kLogMaxArgs = 12;
+
+// Bytes of one log record reserved for string and byte arguments, longer ones are truncated.
+constexpr size_t kLogTextCapacity = 256;
+
+// Byte argument, written as space separated hex bytes by "%s".
+struct LogBytes {
+    LogBytes(void const* bytes, size_t const& length) : data(bytes), size(length) {
+    }
+
+    void const* data;
+    size_t      size;
+};
+
+enum LogArgType {
+    kLogArgSigned = 0x0,
+    kLogArgUnsigned,
+    kLogArgDouble,
+    kLogArgPointer,
+    kLogArgString, // Copied into LogRecord::text.
+    kLogArgBytes,  // Copied into LogRecord::text.
+};
+
+struct LogArg {
+    uint8_t type; // See LogArgType.
+    union {
+        int64_t     i;
+        uint64_t    u;
+        double      d;
+        void const* p;
+        struct {
+            uint16_t offset;
+            uint16_t length;
+        } text;
+    };
+};
+
+// A log message with its arguments captured by value, formatted later by the writer thread.
+struct LogRecord {
+    uint64_t    timestamp_us; // Microseconds since the epoch.
+    char const* file;         // Must be a string literal, as __FILE__.
+    char const* format;       // Must be a string literal.
+    int         line;
+    uint8_t     level;
+    uint8_t     arg_count;
+    uint16_t    text_length;
+    uint32_t    suppressed; // Messages of the same site dropped by the rate limit before this one.
+    LogArg      args[kLogMaxArgs];
+    char        text[kLogTextCapacity];
+};
+
+// Capture one argument.
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type LogCaptureArg(
+    LogRecord* record, T const& value) {
+    auto& arg = record->args[record->arg_count++];
+    arg.type  = kLogArgSigned;
+    arg.i     = value;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type LogCaptureArg(
+    LogRecord* record, T const& value) {
+    auto& arg = record->args[record->arg_count++];
+    arg.type  = kLogArgUnsigned;
+    arg.u     = value;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_enum<T>::value>::type LogCaptureArg(LogRecord* record, T const& value) {
+    auto& arg = record->args[record->arg_count++];
+    arg.type  = kLogArgSigned;
+    arg.i     = static_cast<int64_t>(value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type LogCaptureArg(LogRecord* record,
+                                                                                     T const&   value) {
+    auto& arg = record->args[record->arg_count++];
+    arg.type  = kLogArgDouble;
+    arg.d     = value;
+}
+
+inline void LogCaptureText(LogRecord* record, uint8_t const& type, void const* data, size_t const& len) {
+    auto&        arg    = record->args[record->arg_count++];
+    size_t const room   = kLogTextCapacity - record->text_length;
+    size_t const length = len < room ? len : room;
+    if (length > 0)
+        memcpy(record->text + record->text_length, data, length);
+    arg.type        = type;
+    arg.text.offset = record->text_length;
+    arg.text.length = static_cast<uint16_t>(length);
+    record->text_length += static_cast<uint16_t>(length);
+}
+
+inline void LogCaptureArg(LogRecord* record, char const* value) {
+    if (value == nullptr)
+        value = "(null)";
+    LogCaptureText(record, kLogArgString, value, strlen(value));
+}
+
+inline void LogCaptureArg(LogRecord* record, std::string const& value) {
+    LogCaptureText(record, kLogArgString, value.data(), value.size());
+}
+
+inline void LogCaptureArg(LogRecord* record, LogBytes const& value) {
+    LogCaptureText(record, kLogArgBytes, value.data, value.size);
+}
+
+inline void LogCaptureArg(LogRecord* record, void const* value) {
+    auto& arg = record->args[record->arg_count++];
+    arg.type  = kLogArgPointer;
+    arg.p     = value;
+}
+
+inline void LogCaptureArgs(LogRecord* /* record */) {
+}
+
+template <typename T, typename... Args>
+inline void LogCaptureArgs(LogRecord* record, T const& first, Args const&... rest) {
+    if (record->arg_count < kLogMaxArgs)
+        LogCaptureArg(record, first);
+    LogCaptureArgs(record, rest...);
+}
+
+// Render a record as one line, with a trailing newline.
+void LogFormatRecord(LogRecord const& record, std::string* out);
+
+// Per call site rate limit, allows at most per_second messages in each second.
+// Constant initialized, so a function local static costs no initialization guard.
+class LogRateLimiter {
+public:
+    constexpr explicit LogRateLimiter(uint32_t const per_second)
+        : per_second_(per_second), window_(-1), count_(0), suppressed_(0) {
+    }
+
+    // Args:
+    //     suppressed:  Number of messages dropped since the last allowed one, set when the message is allowed.
+    // Returns:
+    //     Returns true if the message may be logged.
+    bool Allow(uint32_t* suppressed) {
+        int64_t const now = std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::steady_clock::now().time_since_epoch())
+                                .count();
+        int64_t window = window_.load(std::memory_order_relaxed);
+        if (now != window && window_.compare_exchange_strong(window, now, std::memory_order_relaxed))
+            count_.store(0, std::memory_order_relaxed);
+        if (count_.fetch_add(1, std::memory_order_relaxed) < per_second_) {
+            *suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+private:
+    uint32_t const        per_second_;
+    std::atomic<int64_t>  window_; // Second of the current window.
+    std::atomic<uint32_t> count_;  // Messages seen in the current window.
+    std::atomic<uint32_t> suppressed_;
+};
+
+// Asynchronous logger.
+// Log() only captures the format string and the argument values into a lock-free ring buffer, a background thread
+// formats and writes them. A full ring buffer drops the record instead of blocking the caller, see dropped().
+class Logger {
+public:
+    // Process wide logger, the writer thread starts on first use.
+    static Logger& Instance(void);
+
+    Logger(Logger const&)            = delete;
+    Logger& operator=(Logger const&) = delete;
+
+    bool IsEnabled(LogLevel const& level) const {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    LogLevel level(void) const {
+        return static_cast<LogLevel>(level_.load(std::memory_order_relaxed));
+    }
+
+    void set_level(LogLevel const& level) {
+        level_.store(level, std::memory_order_relaxed);
+    }
+
+    // Write to a file instead of stdout.
+    // Args:
+    //     path:  Log file path, appended to; an empty path restores stdout.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int SetOutput(std::string const& path);
+
+    // Args:
+    //     suppressed:  Messages of the same site dropped by a rate limit, see LogRateLimiter.
+    //     format:  printf style format, must be a string literal; length modifiers are ignored since the
+    //              arguments keep their own type.
+    template <typename... Args>
+    void Log(LogLevel const& level, char const* file, int const& line, uint32_t const& suppressed,
+             char const* format, Args const&... args) {
+        LogRecord record;
+        record.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch())
+                                  .count();
+        record.file        = file;
+        record.format      = format;
+        record.line        = line;
+        record.level       = static_cast<uint8_t>(level);
+        record.arg_count   = 0;
+        record.text_length = 0;
+        record.suppressed  = suppressed;
+        LogCaptureArgs(&record, args...);
+        Push(&record);
+    }
+
+    // Wait until the records logged so far are written.
+    void Flush(void);
+
+    // Number of records dropped because the ring buffer was full.
+    uint64_t dropped(void) const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    Logger();
+    ~Logger();
+
+    void Push(LogRecord* record);
+    void WriterHandler(void);
+
+    std::atomic<int>                       level_;
+    std::atomic_bool                       running_;
+    std::atomic<uint64_t>                  pushed_;
+    std::atomic<uint64_t>                  written_;
+    std::atomic<uint64_t>                  dropped_;
+    std::unique_ptr<RingBuffer<LogRecord>> ring_;
+    std::mutex                             output_mutex_; // Guards output_.
+    FILE*                                  output_;
+    std::thread                            writer_thread_;
+};
+
+} // namespace libjt808
+
+// Log a message if the level is enabled, e.g. JT808_LOG(libjt808::kLogInfo, "Accepted %s:%d", ip, port).
+// The arguments are not evaluated when the level is disabled.
+#define JT808_LOG(level, format, ...)                                                                \
+    do {                                                                                             \
+        if (::libjt808::Logger::Instance().IsEnabled(level))                                         \
+            ::libjt808::Logger::Instance().Log(level, __FILE__, __LINE__, 0, format, ##__VA_ARGS__); \
+    } while (0)
+
+// Log at most per_second messages of this call site in each second, the number of dropped ones is appended to the
+// next message written.
+#define JT808_LOG_RATE_LIMITED(level, per_second, format, ...)                                              \
+    do {                                                                                                    \
+        if (::libjt808::Logger::Instance().IsEnabled(level)) {                                              \
+            static ::libjt808::LogRateLimiter jt808_log_limiter(per_second);                                \
+            uint32_t                          jt808_log_suppressed = 0;                                     \
+            if (jt808_log_limiter.Allow(&jt808_log_suppressed))                                             \
+                ::libjt808::Logger::Instance().Log(level, __FILE__, __LINE__, jt808_log_suppressed, format, \
+                                                   ##__VA_ARGS__);                                          \
+        }                                                                                                   \
+    } while (0)
+
+#define JT808_LOG_DEBUG(format, ...) JT808_LOG(::libjt808::kLogDebug, format, ##__VA_ARGS__)
+#define JT808_LOG_INFO(format, ...)  JT808_LOG(::libjt808::kLogInfo, format, ##__VA_ARGS__)
+#define JT808_LOG_WARN(format, ...)  JT808_LOG(::libjt808::kLogWarn, format, ##__VA_ARGS__)
+#define JT808_LOG_ERROR(format, ...) JT808_LOG(::libjt808::kLogError, format, ##__VA_ARGS__)
+
+#endif // JT808_LOG_H_
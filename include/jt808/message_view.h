@@ -0,0 +1,283 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  message_view.h
+// @Version :  1.0
+// @Time    :  2026/10/19 16:27:45
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_MESSAGE_VIEW_H_
+#define JT808_MESSAGE_VIEW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "jt808/location_report.h"
+#include "jt808/util.h"
+
+namespace libjt808 {
+
+//
+// Read-only views of uplink message bodies.
+// A view only points into the decoded frame, nothing is copied or allocated; it is valid until the callback it was
+// passed to returns, copy out whatever must be kept.
+//
+
+// Length of the location basic information.
+constexpr size_t kLocationBasicLength = 28;
+
+// Location additional information items, iterated in wire order.
+class LocationExtensionCursor {
+public:
+    explicit LocationExtensionCursor(ByteSpan const& items) : items_(items), pos_(0) {
+    }
+
+    // Args:
+    //     id:  Additional information ID.
+    //     value:  Additional information bytes.
+    // Returns:
+    //     Returns false at the end of the items or on an item running past the body.
+    bool Next(uint8_t* id, ByteSpan* value) {
+        if (pos_ + 2 > items_.size)
+            return false;
+        size_t const len = items_[pos_ + 1];
+        if (pos_ + 2 + len > items_.size)
+            return false;
+        *id    = items_[pos_];
+        *value = ByteSpan(items_.data + pos_ + 2, len);
+        pos_ += 2 + len;
+        return true;
+    }
+
+private:
+    ByteSpan items_;
+    size_t   pos_;
+};
+
+// Location report body, 0x0200 and each item of 0x0704.
+class LocationReportView {
+public:
+    LocationReportView() {
+    }
+
+    explicit LocationReportView(ByteSpan const& body) : body_(body) {
+    }
+
+    // Whether the body holds the location basic information.
+    bool valid(void) const {
+        return body_.size >= kLocationBasicLength;
+    }
+
+    AlarmBit alarm(void) const {
+        AlarmBit alarm;
+        alarm.value = LoadBigEndian32(body_.data);
+        return alarm;
+    }
+
+    StatusBit status(void) const {
+        StatusBit status;
+        status.value = LoadBigEndian32(body_.data + 4);
+        return status;
+    }
+
+    // Degrees multiplied by 10^6.
+    uint32_t latitude(void) const {
+        return LoadBigEndian32(body_.data + 8);
+    }
+
+    // Degrees multiplied by 10^6.
+    uint32_t longitude(void) const {
+        return LoadBigEndian32(body_.data + 12);
+    }
+
+    // Meters.
+    uint16_t altitude(void) const {
+        return LoadBigEndian16(body_.data + 16);
+    }
+
+    // 1/10 km/h.
+    uint16_t speed(void) const {
+        return LoadBigEndian16(body_.data + 18);
+    }
+
+    uint16_t bearing(void) const {
+        return LoadBigEndian16(body_.data + 20);
+    }
+
+    // "YYMMDDhhmmss" as 6 BCD bytes, GMT+8.
+    ByteSpan time(void) const {
+        return ByteSpan(body_.data + 22, 6);
+    }
+
+    LocationExtensionCursor extensions(void) const {
+        return LocationExtensionCursor(body_.subspan(kLocationBasicLength, body_.size));
+    }
+
+    // Find one additional information item.
+    // Returns:
+    //     Returns 0 on success, -1 if the item is not present.
+    int FindExtension(uint8_t const& id, ByteSpan* value) const {
+        auto    cursor = extensions();
+        uint8_t item_id;
+        while (cursor.Next(&item_id, value)) {
+            if (item_id == id)
+                return 0;
+        }
+        return -1;
+    }
+
+    ByteSpan body(void) const {
+        return body_;
+    }
+
+private:
+    ByteSpan body_;
+};
+
+// 0x0704 batch location report.
+class BatchLocationReportView {
+public:
+    explicit BatchLocationReportView(ByteSpan const& body) : body_(body) {
+    }
+
+    // Whether the body holds the item count and data type.
+    bool valid(void) const {
+        return body_.size >= 3;
+    }
+
+    // Number of items announced by the terminal.
+    uint16_t count(void) const {
+        return LoadBigEndian16(body_.data);
+    }
+
+    // 0: normal batch data, 1: blind spot report data.
+    uint8_t data_type(void) const {
+        return body_[2];
+    }
+
+    // Location report items, iterated in wire order.
+    class Cursor {
+    public:
+        explicit Cursor(ByteSpan const& items) : items_(items), pos_(0) {
+        }
+
+        // Returns:
+        //     Returns false at the end of the items or on an item running past the body.
+        bool Next(LocationReportView* report) {
+            if (pos_ + 2 > items_.size)
+                return false;
+            size_t const len = LoadBigEndian16(items_.data + pos_);
+            if (pos_ + 2 + len > items_.size)
+                return false;
+            *report = LocationReportView(ByteSpan(items_.data + pos_ + 2, len));
+            pos_ += 2 + len;
+            return true;
+        }
+
+    private:
+        ByteSpan items_;
+        size_t   pos_;
+    };
+
+    Cursor reports(void) const {
+        return Cursor(body_.subspan(3, body_.size));
+    }
+
+    ByteSpan body(void) const {
+        return body_;
+    }
+
+private:
+    ByteSpan body_;
+};
+
+// 0x0705 CAN bus data upload.
+class CANBroadcastView {
+public:
+    // Length of one CAN item: CAN ID (4) and CAN data (8).
+    static constexpr size_t kItemLength = 12;
+
+    explicit CANBroadcastView(ByteSpan const& body) : body_(body) {
+    }
+
+    // Whether the body holds the item count and receive time.
+    bool valid(void) const {
+        return body_.size >= 7;
+    }
+
+    // Number of items announced by the terminal.
+    uint16_t count(void) const {
+        return LoadBigEndian16(body_.data);
+    }
+
+    // Receive time of the first item, "hhmmssmsms" as 5 BCD bytes.
+    ByteSpan receive_time(void) const {
+        return ByteSpan(body_.data + 2, 5);
+    }
+
+    // Number of complete items in the body.
+    size_t size(void) const {
+        return (body_.size - 7) / kItemLength;
+    }
+
+    // CAN ID, bit 31 channel, bit 30 frame type, bit 29 collection mode, bits 28-0 bus ID.
+    uint32_t can_id(size_t const& index) const {
+        return LoadBigEndian32(body_.data + 7 + index * kItemLength);
+    }
+
+    ByteSpan can_data(size_t const& index) const {
+        return ByteSpan(body_.data + 7 + index * kItemLength + 4, 8);
+    }
+
+private:
+    ByteSpan body_;
+};
+
+// 0x0108 terminal upgrade result report.
+class UpgradeResultView {
+public:
+    explicit UpgradeResultView(ByteSpan const& body) : body_(body) {
+    }
+
+    bool valid(void) const {
+        return body_.size >= 2;
+    }
+
+    // See kTerminalUpgradeType.
+    uint8_t upgrade_type(void) const {
+        return body_[0];
+    }
+
+    // See kTerminalUpgradeResultType.
+    uint8_t upgrade_result(void) const {
+        return body_[1];
+    }
+
+private:
+    ByteSpan body_;
+};
+
+} // namespace libjt808
+
+#endif // JT808_MESSAGE_VIEW_H_
@@ -0,0 +1,278 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  metrics.h
+// @Version :  1.0
+// @Time    :  2026/10/19 14:21:36
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_METRICS_H_
+#define JT808_METRICS_H_
+
+#if defined(__linux__)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <winsock2.h>
+#include <windows.h>
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jt808/parser.h"
+
+namespace libjt808 {
+
+// Number of shards of every metric. Each thread writes its own shard, so the hot path is one uncontended relaxed
+// atomic add on a cache line no other thread writes.
+constexpr size_t kMetricShards = 16;
+
+// Shard of the calling thread, threads are assigned round-robin on first use.
+inline size_t MetricShardIndex(void) {
+    static std::atomic<size_t> next_shard(0);
+    // Constant initialized, so the access needs no thread_local init guard.
+    static thread_local size_t shard = kMetricShards;
+    if (shard == kMetricShards)
+        shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return shard;
+}
+
+// Fixed-size array of sharded counters.
+class CounterArray {
+public:
+    explicit CounterArray(size_t const& size);
+    ~CounterArray() {
+    }
+
+    CounterArray(CounterArray const&)            = delete;
+    CounterArray& operator=(CounterArray const&) = delete;
+
+    size_t size(void) const {
+        return size_;
+    }
+
+    void Add(size_t const& index, uint64_t const& value = 1) {
+        base_[MetricShardIndex() * stride_ + index].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    // Sum of all shards.
+    uint64_t Value(size_t const& index) const;
+
+private:
+    size_t                                   size_;
+    size_t                                   stride_; // Counters per shard, rounded up to whole cache lines.
+    std::unique_ptr<std::atomic<uint64_t>[]> storage_;
+    std::atomic<uint64_t>*                   base_;   // First counter of shard 0, cache line aligned.
+};
+
+// Point-in-time copy of a MetricHistogram.
+struct HistogramSnapshot {
+    std::vector<uint64_t> buckets;
+    uint64_t              count;
+    uint64_t              sum;
+
+    // Upper bound of the bucket holding the percentile (0 - 100).
+    uint64_t Percentile(double const& percent) const;
+};
+
+// HDR-style log-linear histogram, 16 sub-buckets per power of two so the relative error stays below 6.25% over the
+// whole range. Values are unit-less, the server records microseconds; values above 2^36 land in the last bucket.
+class MetricHistogram {
+public:
+    static constexpr size_t kSubBuckets  = 16;
+    static constexpr size_t kBucketCount = 33 * kSubBuckets;
+
+    MetricHistogram() : counters_(kBucketCount + 1) {
+    }
+
+    void Record(uint64_t const& value) {
+        counters_.Add(BucketIndex(value));
+        counters_.Add(kBucketCount, value); // Sum.
+    }
+
+    void Snapshot(HistogramSnapshot* snapshot) const;
+
+    static size_t BucketIndex(uint64_t const& value) {
+        if (value < kSubBuckets)
+            return static_cast<size_t>(value);
+        int const    shift = 63 - __builtin_clzll(value) - 4;
+        size_t const index = static_cast<size_t>((shift + 1) * kSubBuckets + ((value >> shift) & 0xF));
+        return index < kBucketCount ? index : kBucketCount - 1;
+    }
+
+    // Largest value of the bucket.
+    static uint64_t BucketUpperBound(size_t const& index) {
+        if (index < kSubBuckets)
+            return index;
+        size_t const shift = index / kSubBuckets - 1;
+        return ((kSubBuckets + index % kSubBuckets) << shift) + (1ULL << shift) - 1;
+    }
+
+private:
+    CounterArray counters_; // Buckets followed by the sum.
+};
+
+// Counters of one message ID.
+struct MessageMetrics {
+    uint64_t frames_in;
+    uint64_t frames_out;
+};
+
+// Point-in-time copy of the server metrics.
+struct MetricsSnapshot {
+    std::map<uint16_t, MessageMetrics> messages;       // Message ID (key) - frame counters (value).
+    MessageMetrics                     other_messages; // Message IDs beyond the per-ID table.
+    uint64_t                           bytes_in;
+    uint64_t                           bytes_out;
+    uint64_t                           parse_failures[kParseErrorReasonCount]; // Indexed by ParseErrorReason.
+    uint64_t                           sessions_opened;
+    uint64_t                           sessions_closed;
+    int64_t                            active_sessions;
+    uint64_t                           handshake_failures;
+    HistogramSnapshot                  handshake_latency_us; // Accept to authentication success.
+    HistogramSnapshot                  ack_latency_us;       // Platform command to terminal general response.
+};
+
+// Metrics registry of the server.
+// All On*() functions are lock-free and safe to call from any thread.
+class JT808Metrics {
+public:
+    JT808Metrics();
+    ~JT808Metrics() {
+    }
+
+    void OnFrameReceived(uint16_t const& msg_id) {
+        counters_.Add(MessageSlot(msg_id) * 2);
+    }
+
+    void OnFrameSent(uint16_t const& msg_id, size_t const& bytes) {
+        counters_.Add(MessageSlot(msg_id) * 2 + 1);
+        counters_.Add(kBytesOut, bytes);
+    }
+
+    void OnBytesReceived(size_t const& bytes) {
+        counters_.Add(kBytesIn, bytes);
+    }
+
+    void OnParseFailure(ParseErrorReason const& reason) {
+        counters_.Add(kParseFailures + (reason < kParseErrorReasonCount ? reason : kParseInvalidFrame));
+    }
+
+    void OnSessionOpened(void) {
+        counters_.Add(kSessionsOpened);
+    }
+
+    void OnSessionClosed(void) {
+        counters_.Add(kSessionsClosed);
+    }
+
+    void OnHandshake(uint64_t const& latency_us) {
+        handshake_latency_.Record(latency_us);
+    }
+
+    void OnHandshakeFailure(void) {
+        counters_.Add(kHandshakeFailures);
+    }
+
+    void OnAck(uint64_t const& latency_us) {
+        ack_latency_.Record(latency_us);
+    }
+
+    // Pull API.
+    void Snapshot(MetricsSnapshot* snapshot) const;
+
+private:
+    // Message IDs get a table slot on first use, slot 0 collects the IDs beyond the table.
+    static constexpr size_t kMessageSlots = 256;
+
+    // Scalar counters follow the per-message counters (frames in, frames out of every slot).
+    enum {
+        kBytesIn = kMessageSlots * 2,
+        kBytesOut,
+        kSessionsOpened,
+        kSessionsClosed,
+        kHandshakeFailures,
+        kParseFailures,
+        kCounterCount = kParseFailures + kParseErrorReasonCount,
+    };
+
+    size_t MessageSlot(uint16_t const& msg_id) {
+        uint8_t const slot = slots_[msg_id].load(std::memory_order_relaxed);
+        return slot != 0 ? slot : AssignMessageSlot(msg_id);
+    }
+
+    size_t AssignMessageSlot(uint16_t const& msg_id);
+
+    std::unique_ptr<std::atomic<uint8_t>[]> slots_;     // Message ID (index) - slot (value), 0 if not assigned.
+    std::atomic<size_t>                     next_slot_;
+    CounterArray                            counters_;
+    MetricHistogram                         handshake_latency_;
+    MetricHistogram                         ack_latency_;
+};
+
+// Format a snapshot in the Prometheus text exposition format (version 0.0.4).
+void FormatPrometheusText(MetricsSnapshot const& snapshot, std::string* out);
+
+// Minimal HTTP endpoint serving the Prometheus text of a metrics registry, one request per connection.
+class MetricsExporter {
+public:
+    MetricsExporter() : listen_(-1), is_running_(false), metrics_(nullptr) {
+    }
+
+    ~MetricsExporter() {
+        Stop();
+    }
+
+    // Start serving on ip:port.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int Start(JT808Metrics const* metrics, std::string const& ip, int const& port);
+
+    void Stop(void);
+
+    bool is_running(void) const {
+        return is_running_;
+    }
+
+private:
+    void ServeHandler(void);
+
+    decltype(socket(0, 0, 0)) listen_;
+    std::atomic_bool          is_running_;
+    JT808Metrics const*       metrics_;
+    std::thread               thread_;
+};
+
+} // namespace libjt808
+
+#endif // JT808_METRICS_H_
@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  outbound_queue.h
+// @Version :  1.0
+// @Time    :  2026/10/19 21:06:42
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_OUTBOUND_QUEUE_H_
+#define JT808_OUTBOUND_QUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "jt808/ring_buffer.h"
+
+namespace libjt808 {
+
+// Priority of an outbound message, the lower values are sent first.
+enum OutboundPriority : uint8_t {
+    kOutboundResponse = 0, // Responses, registration, authentication and heartbeats.
+    kOutboundReport,       // Location reports.
+    kOutboundBulk,         // Multimedia data and other bulk uploads.
+    kOutboundPriorityCount,
+};
+
+// Bounded lock-free multi-producer single-consumer queue of encoded frames with priorities.
+// Any thread may push; one thread pops, always taking the highest priority frame queued. Only location reports are
+// dropped, a full report ring gives up its oldest one; responses and bulk frames beyond their ring capacity wait in a
+// locked overflow list, in order. The consumer blocks in Wait() on an eventfd that producers only signal while it is
+// waiting, so a push normally costs no system call.
+class OutboundQueue {
+public:
+    OutboundQueue();
+    ~OutboundQueue();
+
+    OutboundQueue(OutboundQueue const&)            = delete;
+    OutboundQueue& operator=(OutboundQueue const&) = delete;
+
+    // Queue a frame, any thread.
+    // Returns:
+    //     Returns false if an older location report was dropped to make room.
+    bool Push(OutboundPriority const& priority, std::vector<uint8_t>&& frame);
+
+    // Take the highest priority frame, consumer thread only.
+    // Returns:
+    //     Returns false if the queue is empty.
+    bool Pop(std::vector<uint8_t>* frame);
+
+    // Wait until a frame is queued, consumer thread only.
+    // Args:
+    //     timeout_msec:  Maximum waiting time, ms.
+    // Returns:
+    //     Returns true if the queue is not empty.
+    bool Wait(int const& timeout_msec);
+
+    // Wake the consumer blocked in Wait(), for changes it checks besides the queue; any thread.
+    void Notify(void);
+
+    // Discard the queued frames, consumer thread only.
+    void Clear(void);
+
+    // Approximate while producers are pushing.
+    size_t size(void) const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    bool empty(void) const {
+        return size() == 0;
+    }
+
+    // Location reports dropped since construction.
+    uint64_t dropped(void) const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    using FrameRing = RingBuffer<std::vector<uint8_t>>;
+
+    std::unique_ptr<FrameRing>       rings_[kOutboundPriorityCount];
+    std::mutex                       overflow_mutex_;
+    std::deque<std::vector<uint8_t>> overflow_[kOutboundPriorityCount];      // Frames a full ring could not take.
+    std::atomic<size_t>              overflow_size_[kOutboundPriorityCount]; // Lets the lock-free path skip the lists.
+    std::atomic<size_t>              size_;                                  // Frames queued.
+    std::atomic<uint64_t>            dropped_;                               // Location reports dropped.
+    std::atomic_bool                 waiting_;                               // Consumer blocked in Wait().
+    int                              event_fd_; // -1 where eventfd is not available, Wait() then polls.
+};
+
+} // namespace libjt808
+
+#endif // JT808_OUTBOUND_QUEUE_H_
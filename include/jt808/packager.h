@@ -62,6 +62,20 @@ bool JT808FramePackagerOverride(Packager* packager, uint16_t const& msg_id, Pack
 // Packaging command.
 int JT808FramePackage(Packager const& packager, ProtocolParameter const& para, std::vector<uint8_t>* out);
 
+// Packaging command for a message body that has already been escaped.
+// The message header is generated from msg_head, the checksum is derived from the header and the precomputed XOR
+// checksum of the unescaped body, so shared message bodies only have to be escaped once.
+// Args:
+//     msg_head:  Message header, msglen is replaced by body_len.
+//     escaped_body:  Escaped message body.
+//     body_len:  Message body length before escaping.
+//     body_bcc:  XOR checksum of the unescaped message body.
+//     out:  Complete escaped frame.
+// Returns:
+//     Returns 0 on success, -1 on failure.
+int JT808FramePackageEscapedBody(MsgHead const& msg_head, std::vector<uint8_t> const& escaped_body,
+                                 uint16_t const& body_len, uint8_t const& body_bcc, std::vector<uint8_t>* out);
+
 } // namespace libjt808
 
 #endif // JT808_PACKAGER_H_
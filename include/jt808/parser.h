@@ -48,6 +48,17 @@ using ParseHandler = std::function<int(std::vector<uint8_t> const& in, ProtocolP
 // Parser definition, map<key, value>, key: message ID, value: message body parsing handler.
 using Parser = std::map<uint16_t, ParseHandler>;
 
+// Reason of a frame parse failure.
+enum ParseErrorReason {
+    kParseSuccess = 0x0,  // No error.
+    kParseInvalidFrame,   // Bad escape sequence or frame shorter than a message header.
+    kParseChecksumError,  // XOR checksum mismatch.
+    kParseHeaderError,    // Message header cannot be parsed.
+    kParseUnknownMsgId,   // No parse handler for the message ID.
+    kParseBodyError,      // Message body rejected by its parse handler.
+    kParseErrorReasonCount,
+};
+
 // Parser initialization command, provides parsing functionality for some commands.
 int JT808FrameParserInit(Parser* parser);
 
@@ -79,6 +90,65 @@ bool JT808FrameParserOverride(Parser* parser, uint16_t const& msg_id, ParseHandl
  */
 int JT808FrameParse(Parser const& parser, std::vector<uint8_t> const& in, ProtocolParameter* para);
 
+// Same as above, the failure reason is stored in reason (may be nullptr).
+int JT808FrameParse(Parser const& parser, std::vector<uint8_t> const& in, ProtocolParameter* para,
+                    ParseErrorReason* reason);
+
+/**
+ * @brief Decodes a JT808 frame without parsing its message body.
+ *
+ * Performs reverse escape, XOR checksum check and message header parsing, used to inspect the header (for example
+ * the packet bit) before the message body is parsed with JT808DecodedFrameParse().
+ *
+ * @param in The escaped frame.
+ * @param out The unescaped frame, including both flags and the checksum.
+ * @param msg_head The parsed message header.
+ * @return int Returns 0 on success, -1 on failure.
+ */
+int JT808FrameDecode(std::vector<uint8_t> const& in, std::vector<uint8_t>* out, MsgHead* msg_head);
+int JT808FrameDecode(std::vector<uint8_t> const& in, std::vector<uint8_t>* out, MsgHead* msg_head,
+                     ParseErrorReason* reason);
+
+/**
+ * @brief Parses the message body of a frame decoded by JT808FrameDecode().
+ *
+ * @param parser The parser containing message ID to function mappings.
+ * @param decoded The unescaped frame.
+ * @param msg_head The message header returned by JT808FrameDecode().
+ * @param para The protocol parameter structure pointer to store parsed data.
+ * @return int Returns 0 on success, -1 on failure.
+ */
+int JT808DecodedFrameParse(Parser const& parser, std::vector<uint8_t> const& decoded, MsgHead const& msg_head,
+                           ProtocolParameter* para);
+int JT808DecodedFrameParse(Parser const& parser, std::vector<uint8_t> const& decoded, MsgHead const& msg_head,
+                           ProtocolParameter* para, ParseErrorReason* reason);
+
+/**
+ * @brief Parses a complete message body, used for messages reassembled from fragments.
+ *
+ * The message body may be longer than the 1023 bytes of a single frame.
+ *
+ * @param parser The parser containing message ID to function mappings.
+ * @param msg_head The message header, the packet bit must be cleared.
+ * @param body The complete message body.
+ * @param para The protocol parameter structure pointer to store parsed data.
+ * @return int Returns 0 on success, -1 on failure.
+ */
+int JT808MessageParse(Parser const& parser, MsgHead const& msg_head, std::vector<uint8_t> const& body,
+                      ProtocolParameter* para);
+
+/**
+ * @brief Extracts complete frames from a TCP byte stream.
+ *
+ * Frames are delimited by the 0x7E flag. Bytes before the first flag are discarded, complete frames are moved to
+ * frames, and an incomplete trailing frame is left in buffer to be completed by the next receive.
+ *
+ * @param buffer Received bytes, consumed bytes are removed.
+ * @param frames Extracted frames including both flags.
+ * @return int Number of frames extracted, -1 on failure.
+ */
+int JT808FrameExtract(std::vector<uint8_t>* buffer, std::vector<std::vector<uint8_t>>* frames);
+
 } // namespace libjt808
 
 #endif // JT808_PARSER_H_
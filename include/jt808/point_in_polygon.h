@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  point_in_polygon.h
+// @Version :  1.0
+// @Time    :  2026/10/19 20:16:48
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_POINT_IN_POLYGON_H_
+#define JT808_POINT_IN_POLYGON_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "jt808/area_index.h"
+
+namespace libjt808 {
+
+// Edges of a polygon prepared for crossing number tests.
+// Structure of arrays in signed microdegrees, the unit of the location report. Each edge is stored from its lower to
+// its higher latitude end and horizontal edges are dropped, so the test is the same for every edge. The arrays are
+// padded to a multiple of 8 with edges no point crosses, the vector kernels need no tail loop.
+// Coordinates must be within [-90, 90] and [-180, 180] degrees, differences then fit in 32 bits and products in 64.
+struct PolygonEdges {
+    std::vector<int32_t> lat_lo; // Latitude of the lower end.
+    std::vector<int32_t> lat_hi; // Latitude of the higher end.
+    std::vector<int32_t> lon_lo; // Longitude of the lower end.
+    std::vector<int32_t> dlon;   // Longitude of the higher end minus lon_lo.
+    std::vector<int32_t> dlat;   // lat_hi minus lat_lo, positive.
+    size_t               count;  // Number of edges before the padding.
+    AreaBox              box;
+
+    PolygonEdges() : count(0), box() {
+    }
+
+    bool empty(void) const {
+        return count == 0;
+    }
+
+    void clear(void);
+};
+
+// Build the edges of a closed polygon, the last vertex is joined to the first.
+// Args:
+//     lat:  Vertex latitudes, signed microdegrees.
+//     lon:  Vertex longitudes, signed microdegrees.
+//     count:  Number of vertices.
+//     edges:  Built edges.
+// Returns:
+//     Returns 0 on success, -1 if the polygon has less than 3 vertices.
+int PolygonEdgesBuild(int32_t const* lat, int32_t const* lon, size_t const& count, PolygonEdges* edges);
+
+// Crossing number test of a point, exact integer arithmetic: a point is inside if a ray from it towards increasing
+// longitude crosses an odd number of edges. Points outside the bounding box are rejected first.
+bool PolygonEdgesContains(PolygonEdges const& edges, int32_t const& lat, int32_t const& lon);
+
+// Test many points against one polygon, the vector kernels test 8 (AVX2) or 4 (SSE4.2) points per edge.
+// Args:
+//     edges:  Polygon edges.
+//     lat:  Point latitudes, signed microdegrees.
+//     lon:  Point longitudes, signed microdegrees.
+//     count:  Number of points.
+//     inside:  1 for the points inside the polygon, 0 for the others.
+// Returns:
+//     Number of points inside the polygon.
+size_t PolygonEdgesContainsBatch(PolygonEdges const& edges, int32_t const* lat, int32_t const* lon,
+                                 size_t const& count, uint8_t* inside);
+
+// Point in polygon kernels, the best one supported by the CPU is selected on first use.
+enum PolygonKernel {
+    kPolygonKernelScalar = 0x0,
+    kPolygonKernelSse42,
+    kPolygonKernelAvx2,
+};
+
+// Get the kernel in use.
+PolygonKernel GetPolygonKernel(void);
+
+// Select the kernel, for benchmarks and comparisons.
+// Returns:
+//     Returns 0 on success, -1 if the CPU or the compiler does not support it.
+int SetPolygonKernel(PolygonKernel const& kernel);
+
+} // namespace libjt808
+
+#endif // JT808_POINT_IN_POLYGON_H_
@@ -64,8 +64,14 @@ enum SupportedCommands {
     kGetLocationInformation         = 0x8201, // Get location information.
     kGetLocationInformationResponse = 0x0201, // Get location information response.
     kLocationTrackingControl        = 0x8202, // Location tracking control.
+    kSetCircularArea                = 0x8600, // Set circular area.
+    kDeleteCircularArea             = 0x8601, // Delete circular area.
+    kSetRectangleArea               = 0x8602, // Set rectangle area.
+    kDeleteRectangleArea            = 0x8603, // Delete rectangle area.
     kSetPolygonArea                 = 0x8604, // Set polygon area.
     kDeletePolygonArea              = 0x8605, // Delete polygon area.
+    kSetRoute                       = 0x8606, // Set route.
+    kDeleteRoute                    = 0x8607, // Delete route.
     kMultimediaDataUpload           = 0x0801, // Multimedia data upload.
     kMultimediaDataUploadResponse   = 0x8800, // Multimedia data upload response.
 
@@ -133,6 +139,9 @@ enum MsgBodyPos {
     MSGBODY_PACKET_POS   = 17, // Starting position of long message body content.
 };
 
+// Maximum message body length of a single JT808 frame (10 bits of the message body attribute).
+constexpr uint16_t kMaxMsgBodyLength = 1023;
+
 // Escape related flags.
 enum ProtocolEscapeFlag {
     PROTOCOL_SIGN          = 0x7E, // Flag bit.
@@ -354,6 +363,20 @@ struct ProtocolParameter {
     PolygonArea polygon_area;
     // Set of polygon area IDs to be deleted.
     std::vector<uint32_t> polygon_area_id;
+    // Setting type of the circular or rectangle areas, see AreaSettingType.
+    uint8_t area_setting_type;
+    // Circular areas.
+    CircularAreaSet circular_areas;
+    // Set of circular area IDs to be deleted, all of them if empty.
+    std::vector<uint32_t> circular_area_id;
+    // Rectangle areas.
+    RectangleAreaSet rectangle_areas;
+    // Set of rectangle area IDs to be deleted, all of them if empty.
+    std::vector<uint32_t> rectangle_area_id;
+    // Route.
+    Route route;
+    // Set of route IDs to be deleted, all of them if empty.
+    std::vector<uint32_t> route_id;
     // Upgrade information.
     UpgradeInfo upgrade_info;
     // Fill packet information.
@@ -398,6 +421,20 @@ struct ProtocolParameter {
         PolygonArea polygon_area;
         // Parsed set of polygon area IDs to be deleted.
         std::vector<uint32_t> polygon_area_id;
+        // Parsed setting type of the circular or rectangle areas.
+        uint8_t area_setting_type;
+        // Parsed circular areas.
+        CircularAreaSet circular_areas;
+        // Parsed set of circular area IDs to be deleted.
+        std::vector<uint32_t> circular_area_id;
+        // Parsed rectangle areas.
+        RectangleAreaSet rectangle_areas;
+        // Parsed set of rectangle area IDs to be deleted.
+        std::vector<uint32_t> rectangle_area_id;
+        // Parsed route.
+        Route route;
+        // Parsed set of route IDs to be deleted.
+        std::vector<uint32_t> route_id;
         // Parsed upgrade information.
         UpgradeInfo upgrade_info;
         // Parsed fill packet information.
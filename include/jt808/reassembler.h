@@ -0,0 +1,274 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  reassembler.h
+// @Version :  1.0
+// @Time    :  2026/10/19 12:21:36
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_REASSEMBLER_H_
+#define JT808_REASSEMBLER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "jt808/protocol_parameter.h"
+
+namespace libjt808 {
+
+// Maximum number of packet IDs in one 0x8003 request, the count field is one byte.
+constexpr uint16_t kMaxFillPacketIds = 255;
+
+// Message flow number of the first packet of a fragmented message.
+// The fragments of a message are sent with consecutive flow numbers.
+inline uint16_t FirstPacketFlowNum(MsgHead const& msg_head) {
+    return static_cast<uint16_t>(msg_head.msg_flow_num - (msg_head.packet_seq - 1));
+}
+
+// Fill packet request generated for an incomplete message.
+struct FillPacketRequest {
+    uint16_t   msg_id;      // Message ID of the incomplete message.
+    FillPacket fill_packet; // First packet flow number and missing packet IDs.
+};
+
+// Pool of fragment buffers shared by the reassemblers of all sessions.
+// Every buffer holds one fragment body (at most kMaxMsgBodyLength bytes) and is accounted at full size, the pool
+// refuses buffers beyond max_bytes so the total reassembly memory is bounded. Released buffers are kept for reuse.
+// Thread safe.
+class FragmentBufferPool {
+public:
+    explicit FragmentBufferPool(size_t const& max_bytes = 64 * 1024 * 1024, size_t const& max_free_buffers = 1024)
+        : max_bytes_(max_bytes)
+        , max_free_buffers_(max_free_buffers)
+        , used_bytes_(0) {
+    }
+
+    ~FragmentBufferPool() {
+    }
+
+    FragmentBufferPool(FragmentBufferPool const&)            = delete;
+    FragmentBufferPool& operator=(FragmentBufferPool const&) = delete;
+
+    void set_max_bytes(size_t const& max_bytes) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        max_bytes_ = max_bytes;
+    }
+
+    // Get an empty buffer.
+    // Returns:
+    //     Returns 0 on success, -1 if the memory cap is reached.
+    int Acquire(std::vector<uint8_t>* buffer);
+
+    // Return a buffer to the pool.
+    void Release(std::vector<uint8_t>* buffer);
+
+    // Memory held by the buffers in use.
+    size_t used_bytes(void) const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return used_bytes_;
+    }
+
+private:
+    mutable std::mutex                mutex_;
+    size_t                            max_bytes_;
+    size_t                            max_free_buffers_;
+    size_t                            used_bytes_;
+    std::vector<std::vector<uint8_t>> free_buffers_;
+};
+
+// Reassembly limits of one session.
+struct ReassemblerLimits {
+    uint32_t timeout_ms;        // Idle time before a fill packet request is generated.
+    uint32_t max_fill_requests; // Unanswered fill packet requests before an incomplete message is dropped.
+    uint32_t max_age_ms;        // Incomplete messages older than this are dropped, 0 means no limit.
+    uint32_t max_message_bytes; // Maximum size of one reassembled message.
+    uint32_t max_session_bytes; // Maximum buffered fragment bytes of the session.
+    uint32_t max_messages;      // Maximum number of incomplete messages of the session.
+};
+
+// Reassembly of fragmented messages (message body attribute packet bit set) of one session.
+// Fragments are keyed by message ID and first packet flow number, so several messages can be in flight. Fragment
+// bodies may have different sizes, each is kept in its own pooled buffer and appended in packet sequence order.
+// Some messages repeat a header in every fragment (the 0x8108 upgrade header, the 0x0801 multimedia header as sent by
+// JT808Client), the repeated part is only kept from the first fragment, see SetRepeatedHeaderLength(). Only 0x8108
+// is set by default, standard terminals send the 0x0801 header in the first fragment alone.
+// Incomplete messages idle for longer than the timeout generate 0x8003 fill packet requests listing the missing
+// packet IDs, and are dropped once max_fill_requests requests went unanswered or max_age_ms has elapsed. Messages
+// whose size exceeds max_message_bytes are refused, and the oldest incomplete message is evicted when the session
+// exceeds max_session_bytes or max_messages.
+//
+// Example:
+//     FragmentReassembler reassembler(&pool);
+//     MsgHead head;
+//     std::vector<uint8_t> body;
+//     int ret = reassembler.AddFragment(msg_head, fragment_body, std::chrono::steady_clock::now(), &head, &body);
+//     if (ret == FragmentReassembler::kMessageComplete)
+//       JT808MessageParse(parser, head, body, &para);
+class FragmentReassembler {
+public:
+    // Result of AddFragment().
+    enum AddResult {
+        kFragmentStored = 0, // Fragment stored, the message is not complete yet.
+        kFragmentDuplicate,  // Fragment already received.
+        kMessageComplete,    // Last missing fragment, the reassembled message is returned.
+    };
+
+    // Length of the header repeated in a fragment body, -1 if the body is invalid.
+    using HeaderLengthFunction = std::function<int(std::vector<uint8_t> const& body)>;
+
+    // Args:
+    //     pool:  Shared buffer pool, nullptr to allocate the buffers without a global memory cap.
+    explicit FragmentReassembler(FragmentBufferPool* pool = nullptr);
+    ~FragmentReassembler() {
+        Clear();
+    }
+
+    FragmentReassembler(FragmentReassembler const&)            = delete;
+    FragmentReassembler& operator=(FragmentReassembler const&) = delete;
+
+    void set_limits(ReassemblerLimits const& limits) {
+        limits_ = limits;
+    }
+
+    ReassemblerLimits const& limits(void) const {
+        return limits_;
+    }
+
+    // Idle time before a fill packet request is generated.
+    void set_timeout_ms(uint32_t const& timeout_ms) {
+        limits_.timeout_ms = timeout_ms;
+    }
+
+    // Unanswered fill packet requests before an incomplete message is dropped.
+    void set_max_fill_requests(uint32_t const& max_fill_requests) {
+        limits_.max_fill_requests = max_fill_requests;
+    }
+
+    // Length of the message body header repeated in every fragment of the message, 0 by default.
+    void SetRepeatedHeaderLength(uint16_t const& msg_id, uint16_t const& length);
+    void SetRepeatedHeaderLength(uint16_t const& msg_id, HeaderLengthFunction const& function);
+
+    // Add one fragment.
+    // Args:
+    //     msg_head:  Parsed header of the fragment.
+    //     body:  Message body of the fragment.
+    //     now:  Current time.
+    //     head:  Header of the reassembled message, packet bit cleared and flow number of the first packet.
+    //     message:  Reassembled message body.
+    // Returns:
+    //     AddResult, -1 if the fragment is invalid or refused by the memory limits.
+    int AddFragment(MsgHead const& msg_head, std::vector<uint8_t> const& body,
+                    std::chrono::steady_clock::time_point const& now, MsgHead* head, std::vector<uint8_t>* message);
+
+    // Collect fill packet requests for the incomplete messages idle for longer than the timeout.
+    // Abandoned incomplete messages are dropped.
+    void CollectFillRequests(std::chrono::steady_clock::time_point const& now,
+                             std::vector<FillPacketRequest>* requests);
+
+    // Drop all incomplete messages.
+    void Clear(void);
+
+    // Number of incomplete messages.
+    size_t size(void) const {
+        return messages_.size();
+    }
+
+    // Buffered fragment bytes.
+    size_t bytes(void) const {
+        return bytes_;
+    }
+
+private:
+    struct Message {
+        MsgHead                                  head;  // Header of the first fragment received.
+        size_t                                   bytes; // Buffered bytes of the message.
+        uint32_t                                 fill_requests;
+        std::chrono::steady_clock::time_point    created;
+        std::chrono::steady_clock::time_point    last_active;
+        std::map<uint16_t, std::vector<uint8_t>> fragments; // Packet sequence number (key) - Fragment body (value).
+    };
+
+    // Release the buffers of a message and remove it.
+    std::map<uint32_t, Message>::iterator Drop(std::map<uint32_t, Message>::iterator const& it);
+    // Drop the oldest incomplete message except the given one.
+    bool DropOldest(uint32_t const& keep);
+
+    FragmentBufferPool*                      pool_;
+    ReassemblerLimits                        limits_;
+    size_t                                   bytes_;                  // Buffered fragment bytes.
+    std::map<uint16_t, HeaderLengthFunction> repeated_header_length_; // Message ID (key).
+    std::map<uint32_t, Message>              messages_; // Message ID << 16 | first packet flow number (key).
+};
+
+// Bounded cache of the fragments recently sent, used to answer 0x8003 fill packet requests.
+// The oldest fragments are discarded first.
+class FragmentRetransmitCache {
+public:
+    FragmentRetransmitCache()
+        : capacity_(256) {
+    }
+
+    ~FragmentRetransmitCache() {
+    }
+
+    // Maximum number of cached fragments.
+    void set_capacity(size_t const& capacity) {
+        capacity_ = capacity;
+        while (fragments_.size() > capacity_)
+            fragments_.pop_front();
+    }
+
+    // Cache a fragment frame.
+    void Store(MsgHead const& msg_head, std::vector<uint8_t> const& frame);
+
+    // Find the frames of the requested fragments.
+    // Returns:
+    //     Number of frames found.
+    int Find(FillPacket const& fill_packet, std::vector<std::vector<uint8_t>>* frames) const;
+
+    void Clear(void) {
+        fragments_.clear();
+    }
+
+private:
+    struct Fragment {
+        uint16_t             first_flow_num;
+        uint16_t             packet_seq;
+        std::vector<uint8_t> frame;
+    };
+
+    size_t               capacity_;
+    std::deque<Fragment> fragments_;
+};
+
+} // namespace libjt808
+
+#endif // JT808_REASSEMBLER_H_
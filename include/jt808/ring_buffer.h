@@ -0,0 +1,144 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  ring_buffer.h
+// @Version :  1.0
+// @Time    :  2026/10/19 13:10:24
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_RING_BUFFER_H_
+#define JT808_RING_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace libjt808 {
+
+// Bounded lock-free multi-producer multi-consumer queue.
+// Every slot carries a sequence number that tells producers and consumers whose turn it is, so a push or pop costs one
+// CAS on the shared position and never blocks; a full queue makes TryPush() fail instead of waiting.
+template <typename T>
+class RingBuffer {
+public:
+    // The capacity is rounded up to a power of two.
+    explicit RingBuffer(size_t const& capacity) : mask_(RoundUp(capacity) - 1), cells_(new Cell[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+        dequeue_pos_.store(0, std::memory_order_relaxed);
+    }
+
+    ~RingBuffer() {
+    }
+
+    RingBuffer(RingBuffer const&)            = delete;
+    RingBuffer& operator=(RingBuffer const&) = delete;
+
+    size_t capacity(void) const {
+        return mask_ + 1;
+    }
+
+    // Returns:
+    //     Returns false if the queue is full, the value is left untouched.
+    bool TryPush(T&& value) {
+        Cell*  cell = nullptr;
+        size_t pos  = enqueue_pos_.load(std::memory_order_relaxed);
+        while (1) {
+            cell               = &cells_[pos & mask_];
+            size_t const   seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t const dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0) {
+                return false;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns:
+    //     Returns false if the queue is empty.
+    bool TryPop(T* value) {
+        Cell*  cell = nullptr;
+        size_t pos  = dequeue_pos_.load(std::memory_order_relaxed);
+        while (1) {
+            cell               = &cells_[pos & mask_];
+            size_t const   seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t const dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0) {
+                return false;
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        *value = std::move(cell->data);
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr size_t kCacheLineSize = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T                   data;
+    };
+
+    static size_t RoundUp(size_t const& capacity) {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        return size;
+    }
+
+    // Producers and consumers spin on different cache lines.
+    char                    pad0_[kCacheLineSize];
+    size_t const            mask_;
+    std::unique_ptr<Cell[]> cells_;
+    char                    pad1_[kCacheLineSize];
+    std::atomic<size_t>     enqueue_pos_;
+    char                    pad2_[kCacheLineSize];
+    std::atomic<size_t>     dequeue_pos_;
+    char                    pad3_[kCacheLineSize];
+};
+
+} // namespace libjt808
+
+#endif // JT808_RING_BUFFER_H_
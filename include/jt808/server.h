@@ -40,16 +40,29 @@
 #endif
 
 #include <atomic>
+#include <chrono>
 #include <functional>
+#include <deque>
+#include <list>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 #include <map>
-
+#include <memory>
+
+#include "capture.h"
+#include "firmware_cache.h"
+#include "geofence.h"
+#include "handler_pool.h"
+#include "message_view.h"
+#include "metrics.h"
 #include "packager.h"
 #include "parser.h"
 #include "protocol_parameter.h"
+#include "reassembler.h"
 #include "terminal_parameter.h"
+#include "upgrade_campaign.h"
 
 namespace libjt808 {
 
@@ -92,6 +105,11 @@ public:
         port_ = port;
     }
 
+    // Set the listen backlog, must be used after calling Init().
+    void set_max_connection_num(int const& num) {
+        max_connection_num_ = num;
+    }
+
     // Initialize server.
     int InitServer(void);
 
@@ -157,7 +175,8 @@ public:
      * @brief Sends an upgrade request to the client.
      *
      * This method sends an upgrade request to the client using the specified socket, upgrade type, manufacturer ID,
-     * version ID, and upgrade file path.
+     * version ID, and upgrade file path. The upgrade file is loaded through the firmware image cache, so repeated
+     * requests for the same file share one sliced copy.
      *
      * @param socket The client's socket.
      * @param upgrade_type The type of upgrade.
@@ -169,6 +188,15 @@ public:
     int UpgradeRequest(decltype(socket(0, 0, 0)) const& socket, int const& upgrade_type,
                        std::vector<uint8_t> const& manufacturer_id, std::string const& version_id, char const* path);
 
+    /**
+     * @brief Sends a cached upgrade image to the client.
+     *
+     * @param socket The client's socket.
+     * @param image The upgrade image, see FirmwareImageCache::Load().
+     * @return Returns 0 on success, -1 on failure.
+     */
+    int UpgradeRequest(decltype(socket(0, 0, 0)) const& socket, FirmwareImagePtr const& image);
+
     /**
      * @brief Sends an upgrade request to the client identified by phone number.
      *
@@ -185,12 +213,205 @@ public:
     int UpgradeRequestByPhoneNumber(std::string const& phone, int const& upgrade_type,
                                     std::vector<uint8_t> const& manufacturer_id, std::string const& version_id,
                                     char const* path) {
-        for (auto const& item : clients_) {
-            if (item.second.msg_head.phone_num == phone) {
-                return UpgradeRequest(item.first, upgrade_type, manufacturer_id, version_id, path);
-            }
+        decltype(socket(0, 0, 0)) socket;
+        {
+            std::unique_lock<std::mutex> lock(clients_mutex_);
+            auto                         it = phone_sockets_.find(phone);
+            if (it == phone_sockets_.end())
+                return -1;
+            socket = it->second;
         }
-        return -1;
+        return UpgradeRequest(socket, upgrade_type, manufacturer_id, version_id, path);
+    }
+
+    // Get the firmware image cache shared by all upgrade requests.
+    FirmwareImageCache& firmware_cache(void) {
+        return firmware_cache_;
+    }
+
+    /**
+     * @brief Starts an upgrade campaign for a set of terminals.
+     *
+     * The transfers run asynchronously inside the main service thread, limited by the scheduler configuration (global
+     * bandwidth cap, number of concurrent transfers, timeouts and retries). Terminals that are not connected when
+     * their turn comes are marked offline.
+     *
+     * @param phones The terminal phone numbers.
+     * @param image The upgrade image, see FirmwareImageCache::Load().
+     * @return Campaign ID on success, -1 on failure.
+     */
+    int StartUpgradeCampaign(std::vector<std::string> const& phones, FirmwareImagePtr const& image) {
+        return upgrade_scheduler_.CreateCampaign(phones, image);
+    }
+
+    int StartUpgradeCampaign(std::vector<std::string> const& phones, int const& upgrade_type,
+                             std::vector<uint8_t> const& manufacturer_id, std::string const& version_id,
+                             char const* path) {
+        if (path == nullptr)
+            return -1;
+        auto image = firmware_cache_.Load(path, static_cast<uint8_t>(upgrade_type), manufacturer_id, version_id);
+        return upgrade_scheduler_.CreateCampaign(phones, image);
+    }
+
+    // Cancel the unfinished transfers of an upgrade campaign.
+    int CancelUpgradeCampaign(int const& campaign_id) {
+        return upgrade_scheduler_.CancelCampaign(campaign_id);
+    }
+
+    // Get the per-terminal progress of an upgrade campaign, including the 0x0108 upgrade results.
+    int GetUpgradeCampaignProgress(int const& campaign_id, std::vector<UpgradeProgress>* progress) const {
+        return upgrade_scheduler_.GetCampaignProgress(campaign_id, progress);
+    }
+
+    // Get the upgrade campaign scheduler, used to set limits and the finished callback.
+    UpgradeCampaignScheduler& upgrade_scheduler(void) {
+        return upgrade_scheduler_;
+    }
+
+    //
+    // Fragmented message reassembly.
+    //
+    // Set the reassembly limits of each client, applied to new connections.
+    void set_reassembler_limits(ReassemblerLimits const& limits) {
+        reassembler_limits_ = limits;
+    }
+
+    // Length of a message body header the clients repeat in every fragment, cut from all fragments but the first,
+    // applied to new connections. Standard terminals send no repeated header, JT808Client repeats the 36 bytes
+    // 0x0801 multimedia header. A length of 0 keeps the fragments whole.
+    void SetRepeatedHeaderLength(uint16_t const& msg_id, uint16_t const& length) {
+        if (length == 0)
+            repeated_header_length_.erase(msg_id);
+        else
+            repeated_header_length_[msg_id] = length;
+    }
+
+    // Get the fragment buffer pool, used to set the global reassembly memory cap.
+    FragmentBufferPool& fragment_pool(void) {
+        return fragment_pool_;
+    }
+
+    //
+    // Traffic capture.
+    //
+    // Record the bytes received and sent on every connection to a capture file, see capture.h.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int StartCapture(std::string const& path) {
+        return capture_tap_.Start(path);
+    }
+
+    void StopCapture(void) {
+        capture_tap_.Stop();
+    }
+
+    // Get the capture tap, used to read the record and drop counters.
+    CaptureTap& capture_tap(void) {
+        return capture_tap_;
+    }
+
+    //
+    // Metrics.
+    //
+    // Get the metrics registry, see JT808Metrics::Snapshot() for the pull API.
+    JT808Metrics const& metrics(void) const {
+        return metrics_;
+    }
+
+    // Serve the metrics in the Prometheus text format on ip:port, e.g. "127.0.0.1", 9808.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int StartMetricsExporter(std::string const& ip, int const& port) {
+        return metrics_exporter_.Start(&metrics_, ip, port);
+    }
+
+    void StopMetricsExporter(void) {
+        metrics_exporter_.Stop();
+    }
+
+    //
+    // Handler worker pool.
+    //
+    // Run the application callbacks on worker threads instead of the main service thread, so a slow callback does
+    // not stall the other connections. The callbacks of one terminal keep their order. A terminal with max_pending
+    // callbacks waiting is not read until its worker catches up, which pushes back on the terminal through TCP.
+    // Must be used before calling Run().
+    // Args:
+    //     threads:  Number of worker threads.
+    //     max_pending:  Callbacks of one terminal queued or running before its connection is paused.
+    // Returns:
+    //     Returns 0 on success, -1 on failure.
+    int StartHandlerPool(size_t const& threads, size_t const& max_pending = 64) {
+        if (max_pending == 0)
+            return -1;
+        handler_max_pending_ = max_pending;
+        return handler_pool_.Start(threads);
+    }
+
+    // Get the handler worker pool.
+    HandlerPool const& handler_pool(void) const {
+        return handler_pool_;
+    }
+
+    //
+    // Uplink message callbacks.
+    //
+    // The typed callbacks get a view into the received frame instead of a parsed ProtocolParameter, registering one
+    // takes its message off the generic parse path; the server still sends the platform general response. They run
+    // on the main service thread and the view is only valid during the call, copy what must be kept and hand slow
+    // work to the handler pool. Must be used before calling Run().
+    //
+    using LocationReportCallback      = std::function<void(MsgHead const&, LocationReportView const&)>;
+    using BatchLocationReportCallback = std::function<void(MsgHead const&, BatchLocationReportView const&)>;
+    using CANBroadcastCallback        = std::function<void(MsgHead const&, CANBroadcastView const&)>;
+    using HeartbeatCallback           = std::function<void(MsgHead const&)>;
+    using UpgradeResultCallback       = std::function<void(MsgHead const&, UpgradeResultView const&)>;
+    using MessageCallback             = std::function<void(MsgHead const&, ByteSpan const&)>;
+
+    // 0x0200 location report.
+    void OnLocationReport(LocationReportCallback const& callback) {
+        location_report_callback_ = callback;
+    }
+
+    // 0x0704 batch location report.
+    void OnBatchLocationReport(BatchLocationReportCallback const& callback) {
+        batch_location_report_callback_ = callback;
+    }
+
+    // 0x0705 CAN bus data upload.
+    void OnCANBroadcast(CANBroadcastCallback const& callback) {
+        can_broadcast_callback_ = callback;
+    }
+
+    // 0x0002 terminal heartbeat.
+    void OnHeartbeat(HeartbeatCallback const& callback) {
+        heartbeat_callback_ = callback;
+    }
+
+    // 0x0108 terminal upgrade result report, the upgrade scheduler is still updated.
+    void OnUpgradeResult(UpgradeResultCallback const& callback) {
+        upgrade_result_callback_ = callback;
+    }
+
+    // Raw message body of any other uplink message, called before the message is parsed as usual.
+    void OnMessage(uint16_t const& msg_id, MessageCallback const& callback) {
+        message_callbacks_[msg_id] = callback;
+    }
+
+    //
+    // Geofence.
+    //
+    using GeofenceEventCallback = std::function<void(std::string const& phone, GeofenceEvent const&)>;
+
+    // Get the geofence engine, used to assign polygon areas to terminals, see GeofenceEngine::SetAreas().
+    GeofenceEngine& geofence(void) {
+        return geofence_;
+    }
+
+    // Every 0x0200 of a terminal with assigned areas is tested while a callback is set, the events are passed to the
+    // callback on the handler pool if it is running. Must be used before calling Run().
+    void OnGeofenceEvent(GeofenceEventCallback const& callback) {
+        geofence_event_callback_ = callback;
     }
 
     //
@@ -228,6 +449,48 @@ private:
     void WaitHandler(void);
     // Main service thread handler.
     void ServiceHandler(void);
+    // Move the authenticated clients into the main service thread.
+    void AdoptPendingClients(void);
+    // Handle one parsed message of a client.
+    // Returns:
+    //     Returns 0 on success, -1 if the connection should be closed.
+    int HandleMessage(decltype(socket(0, 0, 0)) const& socket, ProtocolParameter* para);
+    // Pass a message body to the typed callbacks.
+    // Returns:
+    //     Returns 1 if a typed callback consumed the message, 0 if it still needs the generic parse, -1 if the
+    //     connection should be closed.
+    int HandleMessageView(decltype(socket(0, 0, 0)) const& socket, MsgHead const& msg_head, ByteSpan const& body,
+                          ProtocolParameter* para);
+    // Handle one decoded frame of a client, fragments are reassembled before the message is handled.
+    // Returns:
+    //     Returns 0 on success, -1 if the connection should be closed.
+    int HandleFrame(decltype(socket(0, 0, 0)) const& socket, std::vector<uint8_t> const& frame,
+                    ProtocolParameter* para);
+    // Test a location report against the terminal's geofence areas and pass the events to the callback.
+    void EvaluateGeofence(decltype(socket(0, 0, 0)) const& socket, MsgHead const& msg_head,
+                          LocationReportView const& report);
+    // Send 0x8003 fill packet requests for the incomplete fragmented messages.
+    void RequestMissingFragments(void);
+    // Send one upgrade campaign fragment, used by the upgrade scheduler.
+    int SendUpgradeFragment(std::string const& phone, FirmwareImage const& image, size_t const& index,
+                            uint16_t* flow_num);
+    // Remember the send time of a platform command for the ack latency.
+    void TrackAck(decltype(socket(0, 0, 0)) const& socket, uint16_t const& flow_num);
+    // Record the ack latency of the command acknowledged by a terminal general response.
+    void OnAck(decltype(socket(0, 0, 0)) const& socket, uint16_t const& flow_num);
+    // Run an application callback of a client, on the handler pool if it is running.
+    void Dispatch(decltype(socket(0, 0, 0)) const& socket, HandlerPool::Task&& task);
+    // Queue the callbacks the handler pool had no room for.
+    // Returns:
+    //     Returns true if the client may be read, false while its callbacks are behind.
+    bool ResumeHandlerQueue(decltype(socket(0, 0, 0)) const& socket);
+    // Hand the remaining callbacks of a closed client to the handler pool.
+    void ReleaseHandlerQueue(decltype(socket(0, 0, 0)) const& socket);
+    // Close a client connection and remove its state.
+    // Returns:
+    //     Iterator following the removed client.
+    std::map<decltype(socket(0, 0, 0)), ProtocolParameter>::iterator CloseClient(
+        std::map<decltype(socket(0, 0, 0)), ProtocolParameter>::iterator const& it);
 
     decltype(socket(0, 0, 0))    listen_;   // Listening socket.
     std::atomic_bool             is_ready_; // Server socket status.
@@ -235,6 +498,14 @@ private:
     int                          port_;     // Server port.
     int                          max_connection_num_;
     MultimediaDataUploadCallback multimedia_data_upload_callback_;
+    LocationReportCallback       location_report_callback_;
+    BatchLocationReportCallback  batch_location_report_callback_;
+    CANBroadcastCallback         can_broadcast_callback_;
+    HeartbeatCallback            heartbeat_callback_;
+    UpgradeResultCallback        upgrade_result_callback_;
+    GeofenceEventCallback        geofence_event_callback_;
+    FirmwareImageCache           firmware_cache_;     // Upgrade images shared by all upgrade requests.
+    UpgradeCampaignScheduler     upgrade_scheduler_;  // Upgrade campaigns, driven by the main service thread.
     std::thread                  waiting_thread_;     // Wait for client connection thread.
     std::atomic_bool             waiting_is_running_; // Wait for client connection thread running flag.
     std::thread                  service_thread_;     // Main service thread.
@@ -242,10 +513,54 @@ private:
     Packager                     packager_;           // General JT808 protocol packager.
     Parser                       parser_;             // General JT808 protocol parser.
 
+    // Message ID (key) - Raw message body callback (value).
+    std::map<uint16_t, MessageCallback> message_callbacks_;
     // Client's socket (key) - Client's protocol parameters (value).
     std::map<decltype(socket(0, 0, 0)), ProtocolParameter> clients_;
     // Clients in upgrade status.
     std::map<decltype(socket(0, 0, 0)), int> is_upgrading_clients_;
+    // Client's socket (key) - Received bytes not yet forming a complete frame (value).
+    std::map<decltype(socket(0, 0, 0)), std::vector<uint8_t>> receive_buffers_;
+    // Terminal phone number (key) - Client's socket (value).
+    std::map<std::string, decltype(socket(0, 0, 0))> phone_sockets_;
+    // Authenticated clients waiting to be moved into the main service thread.
+    std::list<std::pair<decltype(socket(0, 0, 0)), ProtocolParameter>> pending_clients_;
+    // Protects pending_clients_ and phone_sockets_.
+    std::mutex clients_mutex_;
+    // Fragment buffers shared by all clients, caps the total reassembly memory.
+    FragmentBufferPool fragment_pool_;
+    // Reassembly limits of each client.
+    ReassemblerLimits reassembler_limits_;
+    // Message ID (key) - Length of the header repeated in every fragment (value).
+    std::map<uint16_t, uint16_t> repeated_header_length_;
+    // Client's socket (key) - Fragmented messages being reassembled (value).
+    std::map<decltype(socket(0, 0, 0)), FragmentReassembler> reassemblers_;
+    // Traffic capture of all connections.
+    CaptureTap capture_tap_;
+    // Frame, session and latency metrics.
+    JT808Metrics    metrics_;
+    MetricsExporter metrics_exporter_;
+    // Client's socket (key) - Send time of the platform commands waiting for the terminal general response, by flow
+    // number (value).
+    std::map<decltype(socket(0, 0, 0)), std::map<uint16_t, std::chrono::steady_clock::time_point>> pending_acks_;
+    // Protects pending_acks_, commands may be sent from any thread.
+    std::mutex pending_acks_mutex_;
+
+    // Polygon areas of the terminals and their in/out state.
+    GeofenceEngine geofence_;
+    // Events of the location report being handled, reused.
+    std::vector<GeofenceEvent> geofence_events_;
+
+    // Callbacks of one client handed to the handler pool.
+    struct HandlerQueue {
+        std::shared_ptr<std::atomic<size_t>> pending; // Queued or running callbacks, including the backlog.
+        std::deque<HandlerPool::Task>        backlog; // Callbacks the worker queue had no room for, in order.
+    };
+    // Runs the application callbacks, see StartHandlerPool().
+    HandlerPool handler_pool_;
+    size_t      handler_max_pending_;
+    // Client's socket (key) - Callbacks handed to the handler pool (value).
+    std::map<decltype(socket(0, 0, 0)), HandlerQueue> handler_queues_;
 
     friend class JT808CustomServer; // Allow the custom server to access private members.
 };
@@ -0,0 +1,196 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  upgrade_campaign.h
+// @Version :  1.0
+// @Time    :  2026/10/19 10:02:17
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_UPGRADE_CAMPAIGN_H_
+#define JT808_UPGRADE_CAMPAIGN_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "jt808/firmware_cache.h"
+
+namespace libjt808 {
+
+// Upgrade state of one terminal in a campaign.
+enum UpgradeTerminalState {
+    kUpgradePending = 0x0,    // Waiting for a free transfer slot.
+    kUpgradeTransferring,     // Fragments are being sent.
+    kUpgradeWaitingResult,    // All fragments acknowledged, waiting for the 0x0108 result report.
+    kUpgradeSucceeded,        // Terminal reported a successful upgrade.
+    kUpgradeFailed,           // Terminal rejected a fragment, reported a failure or timed out.
+    kUpgradeOffline,          // Terminal was not connected or disconnected during the transfer.
+    kUpgradeCanceled,         // Campaign was canceled.
+};
+
+// Upgrade progress of one terminal.
+struct UpgradeProgress {
+    std::string          phone;           // Terminal phone number.
+    UpgradeTerminalState state;           // Current state.
+    uint16_t             acked_fragments; // Number of fragments acknowledged by the terminal.
+    uint16_t             total_fragments; // Total number of fragments.
+    uint32_t             bytes_sent;      // Bytes sent including retransmissions.
+    uint32_t             retries;         // Number of fragment retransmissions.
+    uint8_t              upgrade_result;  // Result of the 0x0108 report, see kTerminalUpgradeResultType.
+};
+
+// Scheduler limits, shared by all campaigns.
+struct UpgradeSchedulerConfig {
+    uint64_t max_bytes_per_second;     // Global bandwidth cap in bytes per second, 0 means unlimited.
+    uint32_t max_concurrent_transfers; // Maximum number of terminals transferring at the same time.
+    uint32_t ack_timeout_ms;           // Fragment acknowledge timeout.
+    uint32_t max_retries;              // Retransmissions of one fragment before the terminal is failed.
+    uint32_t result_timeout_ms;        // Timeout waiting for the 0x0108 result report.
+};
+
+// Asynchronous fleet-wide upgrade scheduler.
+// Campaigns are created from any thread, the transfers themselves are driven by the I/O thread through Poll() and the
+// On*() notifications, so no thread is needed per terminal. Each terminal is served stop-and-wait (the next fragment
+// is sent after the previous one is acknowledged), the fleet is served concurrently up to max_concurrent_transfers,
+// and the total send rate is limited by a token bucket of max_bytes_per_second. The bucket holds one second of
+// burst; with a cap below the size of one frame, a frame is sent whenever the bucket is full and the average rate
+// still matches the cap.
+class UpgradeCampaignScheduler {
+public:
+    // Send one fragment to the terminal.
+    // Args:
+    //     phone:  Terminal phone number.
+    //     image:  Upgrade image.
+    //     index:  Fragment index.
+    //     flow_num:  Flow number used for the fragment, to match the terminal general response. Set only when the
+    //                fragment was sent.
+    // Returns:
+    //     Number of bytes sent, 0 if the fragment was deferred without sending anything (it is tried again on a
+    //     later Poll() without using a retry), -1 if the terminal is not connected or sending failed.
+    using FragmentSender = std::function<int(std::string const& phone, FirmwareImage const& image, size_t const& index,
+                                             uint16_t* flow_num)>;
+
+    // Called on the I/O thread when a terminal reaches a final state.
+    using FinishedCallback = std::function<void(int const& campaign_id, UpgradeProgress const& progress)>;
+
+    UpgradeCampaignScheduler();
+    ~UpgradeCampaignScheduler() {
+    }
+
+    // Scheduler limits.
+    void set_config(UpgradeSchedulerConfig const& config) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        config_ = config;
+    }
+
+    UpgradeSchedulerConfig config(void) const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return config_;
+    }
+
+    void OnFinished(FinishedCallback const& callback) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_callback_ = callback;
+    }
+
+    // Create a campaign.
+    // Returns:
+    //     Campaign ID (> 0), -1 on failure.
+    int CreateCampaign(std::vector<std::string> const& phones, FirmwareImagePtr const& image);
+
+    // Cancel all unfinished transfers of the campaign.
+    // Returns:
+    //     Returns 0 on success, -1 if the campaign does not exist.
+    int CancelCampaign(int const& campaign_id);
+
+    // Remove a campaign and its progress records.
+    void RemoveCampaign(int const& campaign_id);
+
+    // Get the progress of every terminal of the campaign.
+    // Returns:
+    //     Returns 0 on success, -1 if the campaign does not exist.
+    int GetCampaignProgress(int const& campaign_id, std::vector<UpgradeProgress>* progress) const;
+
+    // Whether every terminal of the campaign has reached a final state.
+    bool IsCampaignFinished(int const& campaign_id) const;
+
+    // Whether the terminal has an active transfer.
+    bool IsUpgrading(std::string const& phone) const;
+
+    //
+    // Driven by the I/O thread.
+    //
+    // Start transfers, send fragments within the bandwidth budget and handle timeouts.
+    void Poll(std::chrono::steady_clock::time_point const& now, FragmentSender const& sender);
+
+    // Terminal general response (0x0001) to a 0x8108 fragment.
+    void OnFragmentAck(std::string const& phone, uint16_t const& flow_num, uint8_t const& result);
+
+    // Terminal upgrade result report (0x0108).
+    void OnUpgradeResult(std::string const& phone, uint8_t const& result);
+
+    // Terminal connection closed.
+    void OnTerminalOffline(std::string const& phone);
+
+private:
+    struct Transfer {
+        int                                   campaign_id;
+        UpgradeProgress                       progress;
+        size_t                                next_fragment;    // Fragment to send next.
+        uint32_t                              fragment_retries; // Retransmissions of the current fragment.
+        bool                                  waiting_ack;      // A fragment is in flight.
+        uint16_t                              flow_num;         // Flow number of the fragment in flight.
+        std::chrono::steady_clock::time_point deadline;         // Acknowledge or result report deadline.
+    };
+
+    struct Campaign {
+        FirmwareImagePtr      image;
+        std::vector<Transfer> transfers;
+    };
+
+    // Move a transfer to a final state, returns the record for the finished callback.
+    void Finish(Transfer* transfer, UpgradeTerminalState const& state, std::vector<std::pair<int, UpgradeProgress>>* done);
+    // Notify finished transfers outside the lock.
+    void NotifyFinished(std::vector<std::pair<int, UpgradeProgress>> const& done);
+
+    mutable std::mutex                    mutex_;
+    UpgradeSchedulerConfig                config_;
+    FinishedCallback                      finished_callback_;
+    int                                   next_campaign_id_;
+    std::map<int, Campaign>               campaigns_;
+    std::deque<std::pair<int, size_t>>    pending_; // Waiting transfers, campaign ID and transfer index.
+    std::map<std::string, Transfer*>      active_;  // Terminals transferring or waiting for the result report.
+    double                                tokens_;  // Token bucket, bytes.
+    std::chrono::steady_clock::time_point last_refill_;
+};
+
+} // namespace libjt808
+
+#endif // JT808_UPGRADE_CAMPAIGN_H_
@@ -0,0 +1,136 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  upgrade_receiver.h
+// @Version :  1.0
+// @Time    :  2026/10/19 11:08:52
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#ifndef JT808_UPGRADE_RECEIVER_H_
+#define JT808_UPGRADE_RECEIVER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "jt808/protocol_parameter.h"
+
+namespace libjt808 {
+
+// Terminal-side tracking of an upgrade package received as 0x8108 fragments.
+// Only a bitmap of the received fragments is kept, the upgrade data itself is handed to the application chunk by
+// chunk. The state survives reconnections: fragments of the same upgrade (type, version and total length) that have
+// already been received are recognized as duplicates, a different upgrade restarts the tracking.
+// Save()/Restore() allow the application to keep the state across restarts, next to the partially written image.
+class UpgradeReceiver {
+public:
+    // Result of Accept().
+    enum AcceptResult {
+        kNewFragment = 0,   // New fragment, data must be written at the returned offset.
+        kDuplicateFragment, // Fragment already received.
+    };
+
+    UpgradeReceiver() {
+        Reset();
+    }
+
+    ~UpgradeReceiver() {
+    }
+
+    // Clear the tracking state.
+    void Reset(void);
+
+    // Track one fragment.
+    // Args:
+    //     info:  Parsed upgrade information of the fragment.
+    //     total_packet:  Total number of fragments, 1 if the message is not fragmented.
+    //     packet_seq:  Fragment sequence number, starting from 1.
+    //     offset:  Offset of the fragment data in the upgrade package.
+    // Returns:
+    //     kNewFragment or kDuplicateFragment, -1 if the fragment is invalid.
+    int Accept(UpgradeInfo const& info, uint16_t const& total_packet, uint16_t const& packet_seq, uint32_t* offset);
+
+    // Mark a fragment as received, called after the application has stored its data.
+    void MarkReceived(uint16_t const& packet_seq, uint32_t const& size);
+
+    // Whether all fragments have been received.
+    bool complete(void) const {
+        return total_packet_ > 0 && received_packets_ == total_packet_;
+    }
+
+    // Sequence numbers of the fragments not received yet.
+    void GetMissingPackets(std::vector<uint16_t>* packet_ids) const;
+
+    uint8_t upgrade_type(void) const {
+        return upgrade_type_;
+    }
+
+    std::string const& version_id(void) const {
+        return version_id_;
+    }
+
+    uint32_t total_len(void) const {
+        return total_len_;
+    }
+
+    uint16_t total_packet(void) const {
+        return total_packet_;
+    }
+
+    uint16_t received_packets(void) const {
+        return received_packets_;
+    }
+
+    uint32_t received_bytes(void) const {
+        return received_bytes_;
+    }
+
+    // Serialize the tracking state.
+    void Save(std::vector<uint8_t>* out) const;
+
+    // Restore a state produced by Save().
+    // Returns:
+    //     Returns 0 on success, -1 if the data is invalid.
+    int Restore(std::vector<uint8_t> const& in);
+
+private:
+    bool IsReceived(uint16_t const& packet_seq) const {
+        return (bitmap_[(packet_seq - 1) >> 3] >> ((packet_seq - 1) & 0x7)) & 0x1;
+    }
+
+    uint8_t              upgrade_type_;
+    std::string          version_id_;
+    uint32_t             total_len_;
+    uint16_t             total_packet_;
+    uint32_t             fragment_size_; // Data size of every fragment except the last one, 0 if unknown yet.
+    uint16_t             received_packets_;
+    uint32_t             received_bytes_;
+    std::vector<uint8_t> bitmap_;        // One bit per fragment, bit (seq - 1).
+};
+
+} // namespace libjt808
+
+#endif // JT808_UPGRADE_RECEIVER_H_
@@ -63,6 +63,36 @@ constexpr uint32_t EndianSwap32(uint32_t const& u32val) {
           ((u32val&0xFF000000)>>24));
 }
 
+// 只读字节区间, 不持有数据.
+struct ByteSpan {
+  uint8_t const* data;
+  size_t size;
+
+  ByteSpan() : data(nullptr), size(0) {}
+  ByteSpan(uint8_t const* ptr, size_t const& len) : data(ptr), size(len) {}
+
+  bool empty(void) const { return size == 0; }
+  uint8_t const* begin(void) const { return data; }
+  uint8_t const* end(void) const { return data + size; }
+  uint8_t const& operator[](size_t const& i) const { return data[i]; }
+  // 子区间, 超出范围的部分被截断.
+  ByteSpan subspan(size_t const& offset, size_t const& len) const {
+    if (offset >= size) return ByteSpan(data + size, 0);
+    return ByteSpan(data + offset, len < size - offset ? len : size - offset);
+  }
+};
+
+// 读取大端16位整型.
+inline uint16_t LoadBigEndian16(uint8_t const* p) {
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+// 读取大端32位整型.
+inline uint32_t LoadBigEndian32(uint8_t const* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
 // 转义函数.
 int Escape(std::vector<uint8_t> const& in,
            std::vector<uint8_t>* out);
@@ -0,0 +1,108 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  area_index.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 19:41:12
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/area_index.h"
+
+namespace libjt808 {
+
+AreaGridIndex::AreaGridIndex(int32_t const& cell_size)
+    : cell_size_(cell_size > 0 ? cell_size : 10000), level_count_() {
+}
+
+int64_t AreaGridIndex::CellOf(int32_t const& value, int const& level) const {
+    int64_t const size = static_cast<int64_t>(cell_size_) << (2 * level);
+    // Round towards negative infinity so the cells around 0 have the same width as the others.
+    return value >= 0 ? value / size : -((size - 1 - value) / size);
+}
+
+uint64_t AreaGridIndex::CellKey(int const& level, int64_t const& row, int64_t const& column) {
+    return (static_cast<uint64_t>(level) << 56) | ((static_cast<uint64_t>(row) & 0xFFFFFFF) << 28) |
+           (static_cast<uint64_t>(column) & 0xFFFFFFF);
+}
+
+void AreaGridIndex::Insert(uint32_t const& key, AreaBox const& box) {
+    Erase(key);
+    int level = 0;
+    while (level < kLevels - 1 && (CellOf(box.max_lat, level) - CellOf(box.min_lat, level) > 1 ||
+                                   CellOf(box.max_lon, level) - CellOf(box.min_lon, level) > 1)) {
+        ++level;
+    }
+    CellEntry const entry = {key, box};
+    for (int64_t row = CellOf(box.min_lat, level); row <= CellOf(box.max_lat, level); ++row) {
+        for (int64_t column = CellOf(box.min_lon, level); column <= CellOf(box.max_lon, level); ++column)
+            cells_[CellKey(level, row, column)].push_back(entry);
+    }
+    items_[key] = Item {box, level};
+    ++level_count_[level];
+}
+
+size_t AreaGridIndex::Erase(uint32_t const& key) {
+    auto const it = items_.find(key);
+    if (it == items_.end())
+        return 0;
+    AreaBox const& box   = it->second.box;
+    int const      level = it->second.level;
+    for (int64_t row = CellOf(box.min_lat, level); row <= CellOf(box.max_lat, level); ++row) {
+        for (int64_t column = CellOf(box.min_lon, level); column <= CellOf(box.max_lon, level); ++column) {
+            auto const cell = cells_.find(CellKey(level, row, column));
+            if (cell == cells_.end())
+                continue;
+            auto& entries = cell->second;
+            for (size_t i = 0; i < entries.size(); ++i) {
+                if (entries[i].key == key) {
+                    entries[i] = entries.back();
+                    entries.pop_back();
+                    break;
+                }
+            }
+            if (entries.empty())
+                cells_.erase(cell);
+        }
+    }
+    --level_count_[level];
+    items_.erase(it);
+    return 1;
+}
+
+void AreaGridIndex::Clear(void) {
+    items_.clear();
+    cells_.clear();
+    for (auto& count : level_count_)
+        count = 0;
+}
+
+size_t AreaGridIndex::Query(int32_t const& lat, int32_t const& lon, std::vector<uint32_t>* keys) const {
+    if (keys == nullptr)
+        return 0;
+    size_t const first = keys->size();
+    Visit(lat, lon, [keys](uint32_t const& key) { keys->push_back(key); });
+    return keys->size() - first;
+}
+
+} // namespace libjt808
@@ -0,0 +1,162 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  basic_data_flow.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 18:32:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/basic_data_flow.h"
+
+#include <string.h>
+
+#include "jt808/message_view.h"
+
+namespace libjt808 {
+
+namespace {
+
+// Width in bytes of a numeric field, kFieldRaw for the fields kept as bytes.
+enum FieldKind : uint8_t {
+    kFieldRaw = 0,
+    kFieldU8  = 1,
+    kFieldU16 = 2,
+    kFieldU32 = 4,
+};
+
+struct FieldSpec {
+    uint16_t  id;
+    FieldKind kind;
+    uint16_t  offset; // Of the field in BasicDataFlow.
+};
+
+constexpr FieldSpec kFieldSpecs[] = {
+    {kTotalMileage, kFieldU32, offsetof(BasicDataFlow, total_mileage)},
+    {kTotalFuelConsumption, kFieldU32, offsetof(BasicDataFlow, total_fuel_consumption)},
+    {kTotalEngineRunningTime, kFieldU32, offsetof(BasicDataFlow, total_engine_running_time)},
+    {kTotalFlameoutTime, kFieldU32, offsetof(BasicDataFlow, total_flameout_time)},
+    {kTotalIdleTime, kFieldU32, offsetof(BasicDataFlow, total_idle_time)},
+    {kAccelerometerData, kFieldRaw, offsetof(BasicDataFlow, accelerometer_data)},
+    {kVehicleStatus, kFieldRaw, offsetof(BasicDataFlow, vehicle_status)},
+    {kExternalVoltage, kFieldU16, offsetof(BasicDataFlow, external_voltage)},
+    {kBuildInBattVoltage, kFieldU16, offsetof(BasicDataFlow, build_in_batt_voltage)},
+    {kCSQ, kFieldU8, offsetof(BasicDataFlow, csq)},
+    {kModelID, kFieldRaw, offsetof(BasicDataFlow, model_id)},
+    {kOBDType, kFieldU8, offsetof(BasicDataFlow, obd_type)},
+    {kDriveCycle, kFieldRaw, offsetof(BasicDataFlow, drive_cycle)},
+    {kGPSSatelliteNumber, kFieldU8, offsetof(BasicDataFlow, gps_satellite_number)},
+    {kGPSLocationAccuracy, kFieldU16, offsetof(BasicDataFlow, gps_location_accuracy)},
+    {kGPSAvgSNR, kFieldU8, offsetof(BasicDataFlow, gps_avg_snr)},
+    {kIgnitionType, kFieldU8, offsetof(BasicDataFlow, ignition_type)},
+    {kCarbonEmissions, kFieldU32, offsetof(BasicDataFlow, carbon_emissions)},
+};
+
+// Sub-item IDs above this are not decoded, the presence bits hold 64 IDs.
+constexpr uint16_t kMaxFieldId = 63;
+
+// Field spec of each sub-item ID, nullptr for the IDs without a field.
+struct FieldTable {
+    FieldSpec const* by_id[kMaxFieldId + 1];
+
+    FieldTable() : by_id() {
+        for (auto const& spec : kFieldSpecs)
+            by_id[spec.id] = &spec;
+    }
+};
+
+FieldTable const& GetFieldTable(void) {
+    static FieldTable const table;
+    return table;
+}
+
+} // namespace
+
+int JT808BasicDataFlowDecode(ByteSpan const& flow, BasicDataFlow* out) {
+    if (out == nullptr)
+        return -1;
+    *out = BasicDataFlow();
+    auto const&    table = GetFieldTable();
+    uint8_t* const base  = reinterpret_cast<uint8_t*>(out);
+    size_t         pos   = 0;
+    while (pos + 3 <= flow.size) {
+        uint16_t const id  = LoadBigEndian16(flow.data + pos);
+        size_t const   len = flow[pos + 2];
+        if (pos + 3 + len > flow.size)
+            return -1;
+        uint8_t const* value = flow.data + pos + 3;
+        pos += 3 + len;
+        if (id > kMaxFieldId || table.by_id[id] == nullptr)
+            continue;
+        FieldSpec const& spec = *table.by_id[id];
+        if (spec.kind == kFieldRaw) {
+            ByteSpan const raw(value, len);
+            memcpy(base + spec.offset, &raw, sizeof(raw));
+        }
+        else {
+            if (len == 0 || len > spec.kind)
+                continue;
+            uint32_t number = 0;
+            for (size_t i = 0; i < len; ++i)
+                number = (number << 8) | value[i];
+            if (spec.kind == kFieldU8) {
+                uint8_t const field = static_cast<uint8_t>(number);
+                memcpy(base + spec.offset, &field, sizeof(field));
+            }
+            else if (spec.kind == kFieldU16) {
+                uint16_t const field = static_cast<uint16_t>(number);
+                memcpy(base + spec.offset, &field, sizeof(field));
+            }
+            else {
+                memcpy(base + spec.offset, &number, sizeof(number));
+            }
+        }
+        out->present |= uint64_t(1) << id;
+    }
+    return 0;
+}
+
+int JT808BasicDataFlowDecodeColumns(LocationColumns const& columns, std::vector<BasicDataFlow>* out) {
+    if (out == nullptr)
+        return -1;
+    out->resize(columns.size());
+    int decoded = 0;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        auto&    flow   = (*out)[i];
+        auto     cursor = LocationExtensionCursor(columns.extensions(i));
+        uint8_t  id;
+        ByteSpan value;
+        bool     found = false;
+        while (!found && cursor.Next(&id, &value))
+            found = id == kBasicDataFlow;
+        if (!found) {
+            flow = BasicDataFlow();
+            continue;
+        }
+        if (JT808BasicDataFlowDecode(value, &flow) == 0)
+            ++decoded;
+    }
+    return decoded;
+}
+
+} // namespace libjt808
@@ -137,4 +137,103 @@ int BcdToStringFillZero(std::vector<uint8_t> const& in, std::string* out) {
     return 0;
 }
 
+namespace {
+
+// Days before the first day of each month (1-12) of a common year, 13 closes December. The tail lets a month masked
+// to 4 bits index the table and the next entry before it is checked.
+constexpr int kDaysBeforeMonth[17] = {0, 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365, 365, 365, 365};
+
+// 2000-01-01 and 2100-01-01 as days since the Unix epoch.
+constexpr int64_t kDaysTo2000 = 10957;
+constexpr int64_t kDaysTo2100 = 47482;
+
+constexpr int64_t kGmt8Offset = 8 * 3600;
+
+} // namespace
+
+int BcdTimeToEpoch(uint8_t const* bcd, int64_t* epoch) {
+    if (bcd == nullptr || epoch == nullptr)
+        return -1;
+    // A digit above 9 carries into bit 4 once 6 is added, the carries of all 12 digits are collected and the range
+    // checks folded in, so the only branch is the final one.
+    uint32_t bad = 0;
+    uint32_t field[6];
+    for (int i = 0; i < 6; ++i) {
+        uint32_t const hi = bcd[i] >> 4;
+        uint32_t const lo = bcd[i] & 0x0F;
+        bad |= ((hi + 6) | (lo + 6)) & 0x10;
+        field[i] = hi * 10 + lo;
+    }
+    uint32_t const yy  = field[0];
+    uint32_t const mon = field[1];
+    uint32_t const day = field[2];
+    // Every 4th year of 2000-2099 is a leap year; an invalid month only reads a wrong length, it is bad already.
+    uint32_t const leap_year  = (yy & 3) == 0;
+    uint32_t const m          = mon & 0x0F;
+    uint32_t const month_days = kDaysBeforeMonth[m + 1] - kDaysBeforeMonth[m] + (leap_year & (mon == 2));
+    bad |= (mon - 1 > 11) | (day - 1 >= month_days) | (field[3] > 23) | (field[4] > 59) | (field[5] > 60);
+    if (bad != 0)
+        return -1;
+    // (yy + 31) / 4 counts the leap years of 1970 up to the year before.
+    uint32_t const leap = leap_year & (mon > 2);
+    int64_t const  days = (yy + 30) * 365 + (yy + 31) / 4 + kDaysBeforeMonth[mon] + leap + day - 1;
+    *epoch = days * 86400 + field[3] * 3600 + field[4] * 60 + field[5] - kGmt8Offset;
+    return 0;
+}
+
+int EpochToBcdTime(int64_t const& epoch, uint8_t* bcd) {
+    if (bcd == nullptr)
+        return -1;
+    int64_t const local = epoch + kGmt8Offset;
+    int64_t const days  = local >= 0 ? local / 86400 : (local - 86399) / 86400;
+    if (days < kDaysTo2000 || days >= kDaysTo2100)
+        return -1;
+    int const seconds = static_cast<int>(local - days * 86400);
+    // 4 year cycles of 1461 days, the first year of each cycle is the leap year.
+    int const cycle = static_cast<int>(days - kDaysTo2000) / 1461;
+    int       doy   = static_cast<int>(days - kDaysTo2000) % 1461;
+    int       yy    = cycle * 4;
+    if (doy >= 366) {
+        yy  += 1 + (doy - 366) / 365;
+        doy  = (doy - 366) % 365;
+    }
+    int const leap = (yy & 3) == 0 ? 1 : 0;
+    int       mon  = 12;
+    while (mon > 1 && doy < kDaysBeforeMonth[mon] + (mon > 2 ? leap : 0))
+        --mon;
+    int const day = doy - kDaysBeforeMonth[mon] - (mon > 2 ? leap : 0) + 1;
+    bcd[0] = HexToBcd(static_cast<uint8_t>(yy));
+    bcd[1] = HexToBcd(static_cast<uint8_t>(mon));
+    bcd[2] = HexToBcd(static_cast<uint8_t>(day));
+    bcd[3] = HexToBcd(static_cast<uint8_t>(seconds / 3600));
+    bcd[4] = HexToBcd(static_cast<uint8_t>(seconds / 60 % 60));
+    bcd[5] = HexToBcd(static_cast<uint8_t>(seconds % 60));
+    return 0;
+}
+
+int BcdTimestamp::Assign(std::string const& str) {
+    if (str.size() != 2 * sizeof(bcd))
+        return -1;
+    uint8_t packed[sizeof(bcd)];
+    for (size_t i = 0; i < sizeof(bcd); ++i) {
+        uint8_t const hi = static_cast<uint8_t>(str[2 * i] - '0');
+        uint8_t const lo = static_cast<uint8_t>(str[2 * i + 1] - '0');
+        if (hi > 9 || lo > 9)
+            return -1;
+        packed[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    memcpy(bcd, packed, sizeof(bcd));
+    return 0;
+}
+
+std::string BcdTimestamp::ToString(void) const {
+    static char const kDigits[] = "0123456789ABCDEF";
+    char              str[2 * sizeof(bcd)];
+    for (size_t i = 0; i < sizeof(bcd); ++i) {
+        str[2 * i]     = kDigits[bcd[i] >> 4];
+        str[2 * i + 1] = kDigits[bcd[i] & 0x0F];
+    }
+    return std::string(str, sizeof(str));
+}
+
 } // namespace libjt808
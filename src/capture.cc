@@ -0,0 +1,227 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  capture.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 13:18:40
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/capture.h"
+
+#include <string.h>
+
+#include <chrono>
+
+namespace libjt808 {
+
+namespace {
+
+constexpr char kCaptureMagic[8] = {'J', 'T', '8', '0', '8', 'C', 'A', 'P'};
+
+constexpr size_t kCaptureFileHeaderLength = 16;
+
+// Flush the file after this many records written without a pause.
+constexpr uint64_t kFlushInterval = 4096;
+
+void PutLittleEndian(uint64_t const& value, size_t const& len, uint8_t* out) {
+    for (size_t i = 0; i < len; ++i)
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint64_t GetLittleEndian(uint8_t const* in, size_t const& len) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < len; ++i)
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+} // namespace
+
+uint64_t CaptureTimestamp(void) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+int CaptureWriter::Open(std::string const& path) {
+    Close();
+    ofs_.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!ofs_.is_open())
+        return -1;
+    uint8_t header[kCaptureFileHeaderLength] = {0};
+    memcpy(header, kCaptureMagic, sizeof(kCaptureMagic));
+    PutLittleEndian(kCaptureVersion, 2, header + 8);
+    ofs_.write(reinterpret_cast<char const*>(header), sizeof(header));
+    if (!ofs_.good()) {
+        ofs_.close();
+        return -1;
+    }
+    return 0;
+}
+
+int CaptureWriter::Write(CaptureRecord const& record) {
+    if (!ofs_.is_open() || record.data.size() > kCaptureMaxDataLength)
+        return -1;
+    uint8_t header[kCaptureRecordHeaderLength];
+    PutLittleEndian(record.timestamp_us, 8, header);
+    PutLittleEndian(record.conn_id, 4, header + 8);
+    header[12] = record.type;
+    PutLittleEndian(record.data.size(), 3, header + 13);
+    ofs_.write(reinterpret_cast<char const*>(header), sizeof(header));
+    if (!record.data.empty())
+        ofs_.write(reinterpret_cast<char const*>(record.data.data()), record.data.size());
+    return ofs_.good() ? 0 : -1;
+}
+
+void CaptureWriter::Flush(void) {
+    if (ofs_.is_open())
+        ofs_.flush();
+}
+
+void CaptureWriter::Close(void) {
+    if (ofs_.is_open())
+        ofs_.close();
+}
+
+int CaptureReader::Open(std::string const& path) {
+    if (ifs_.is_open())
+        ifs_.close();
+    corrupted_ = false;
+    ifs_.open(path, std::ios::binary | std::ios::in);
+    if (!ifs_.is_open())
+        return -1;
+    uint8_t header[kCaptureFileHeaderLength];
+    ifs_.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (ifs_.gcount() != static_cast<std::streamsize>(sizeof(header)) ||
+        memcmp(header, kCaptureMagic, sizeof(kCaptureMagic)) != 0 ||
+        GetLittleEndian(header + 8, 2) != kCaptureVersion) {
+        ifs_.close();
+        return -1;
+    }
+    return 0;
+}
+
+int CaptureReader::Next(CaptureRecord* record) {
+    if (record == nullptr || !ifs_.is_open())
+        return -1;
+    uint8_t header[kCaptureRecordHeaderLength];
+    ifs_.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (ifs_.gcount() != static_cast<std::streamsize>(sizeof(header))) {
+        // A capture cut off by a crash ends with a partial record.
+        corrupted_ = ifs_.gcount() != 0;
+        return -1;
+    }
+    record->timestamp_us = GetLittleEndian(header, 8);
+    record->conn_id      = static_cast<uint32_t>(GetLittleEndian(header + 8, 4));
+    record->type         = header[12];
+    record->data.resize(GetLittleEndian(header + 13, 3));
+    if (!record->data.empty()) {
+        ifs_.read(reinterpret_cast<char*>(record->data.data()), record->data.size());
+        if (ifs_.gcount() != static_cast<std::streamsize>(record->data.size())) {
+            corrupted_ = true;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int CaptureTap::Start(std::string const& path, size_t const& capacity) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (running_.load())
+        return -1;
+    if (writer_.Open(path) < 0)
+        return -1;
+    // No producer is inside Push() once the tap is stopped, so the ring buffer can be replaced.
+    if (ring_ == nullptr || ring_->capacity() < capacity)
+        ring_.reset(new RingBuffer<CaptureRecord>(capacity));
+    records_.store(0);
+    dropped_.store(0);
+    running_.store(true);
+    writer_thread_ = std::thread(&CaptureTap::WriterHandler, this);
+    return 0;
+}
+
+void CaptureTap::Stop(void) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_.load())
+        return;
+    running_.store(false);
+    // Wait for the producers that saw the tap running, the writer drains what they pushed.
+    while (producers_.load() != 0)
+        std::this_thread::yield();
+    if (writer_thread_.joinable())
+        writer_thread_.join();
+    writer_.Close();
+}
+
+void CaptureTap::Push(uint32_t const& conn_id, uint8_t const& type, void const* data, size_t const& len) {
+    producers_.fetch_add(1);
+    // Re-check after announcing ourselves, Stop() may have finished waiting in between.
+    if (running_.load()) {
+        CaptureRecord record;
+        record.timestamp_us = CaptureTimestamp();
+        record.conn_id      = conn_id;
+        record.type         = type;
+        if (len > 0 && data != nullptr) {
+            auto const bytes = static_cast<uint8_t const*>(data);
+            record.data.assign(bytes, bytes + (len > kCaptureMaxDataLength ? kCaptureMaxDataLength : len));
+        }
+        if (!ring_->TryPush(std::move(record)))
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    producers_.fetch_sub(1);
+}
+
+// Drain the ring buffer into the file until the tap is stopped and empty.
+void CaptureTap::WriterHandler(void) {
+    CaptureRecord record;
+    uint64_t      unflushed = 0;
+    while (1) {
+        if (ring_->TryPop(&record)) {
+            writer_.Write(record);
+            records_.fetch_add(1, std::memory_order_relaxed);
+            if (++unflushed >= kFlushInterval) {
+                writer_.Flush();
+                unflushed = 0;
+            }
+            continue;
+        }
+        if (!running_.load() && producers_.load() == 0) {
+            // Producers may have pushed between the last pop and the check.
+            if (!ring_->TryPop(&record))
+                break;
+            writer_.Write(record);
+            records_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (unflushed > 0) {
+            writer_.Flush();
+            unflushed = 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    writer_.Flush();
+}
+
+} // namespace libjt808
@@ -29,6 +29,7 @@
 
 #include "jt808/client.h"
 
+#include <errno.h>
 #include <string.h>
 #include <math.h>
 #if defined(__linux__)
@@ -37,10 +38,13 @@
 #include <fcntl.h>
 #endif
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 
+#include "jt808/log.h"
 #include "jt808/socket_util.h"
+#include "jt808/util.h"
 
 namespace libjt808 {
 
@@ -57,12 +61,17 @@ RegisterInfo const kRegisterInfo = {
     "\xD4\xC1\x42\x31\x32\x33\x34\x35", // "粤B12345".
 };
 
+// 盲区补报批次被平台拒绝的最大次数, 超过后视为无法处理的数据并移除.
+constexpr uint8_t kMaxBlindSpotRefusals = 5;
+
 } // namespace
 
 JT808Client::JT808Client() {
+    blind_spot_recording_ = false;
 }
 
 JT808Client::~JT808Client() {
+    StopBlindSpotRecording();
 }
 
 // 对一些必要的参数设定一个默认值, 防止协议命令生成不完整.
@@ -85,12 +94,21 @@ void JT808Client::Init(void) {
     polygon_area_callback_ = [](void) -> void {
         return;
     };
+    upgrade_chunk_callback_ = nullptr;
+    upgrade_auto_report_    = true;
+    upgrade_receiver_.Reset();
+    // 缓存式升级需要容纳整个升级包.
+    auto limits              = reassembler_.limits();
+    limits.max_message_bytes = 32 * 1024 * 1024;
+    limits.max_session_bytes = 32 * 1024 * 1024;
+    reassembler_.set_limits(limits);
+    reassembler_.Clear();
     // 位置上报相关.
     location_report_inteval_              = 10; // 10s位置上报时间间隔.
     location_report_immediately_flag_     = 0;  // 立即上报标志清零.
     parameter_.location_info.alarm.value  = 0;
     parameter_.location_info.status.value = 0;
-    parameter_.location_info.time         = "700101000000"; // 1970-01-01-00-00-00.
+    parameter_.location_info.time.Assign("700101000000"); // 1970-01-01-00-00-00.
     // 通信流程控制.
     is_connected_.store(false);
     is_authenticated_.store(false);
@@ -98,10 +116,21 @@ void JT808Client::Init(void) {
     location_report_msg_generate_outside_.store(false);
     tcp_connection_handling_.store(false);
     jt808_connection_handling_.store(false);
+    async_state_  = kAsyncIdle;
+    send_offset_  = 0;
+    first_report_ = true;
+    // 盲区补报.
+    blind_spot_batch_size_ = 200;
+    blind_spot_in_flight_  = false;
+    blind_spot_flow_num_   = 0;
+    blind_spot_next_       = 0;
+    blind_spot_refusals_   = 0;
 }
 
 // 与远程服务器建立TCP连接, 并设置socket为非阻塞模式.
 int JT808Client::ConnectRemote(void) {
+    // 连接失败期间也需按时间间隔记录盲区位置信息.
+    StartBlindSpotRecording();
     if (tcp_connection_handling_.load())
         return -1;
     if (jt808_connection_handling_.load())
@@ -117,7 +146,7 @@ int JT808Client::ConnectRemote(void) {
     addr.sin_addr.s_addr = inet_addr(ip_.c_str());
     auto tcp_socket      = socket(AF_INET, SOCK_STREAM, 0);
     if (tcp_socket == -1) {
-        printf("%s[%d]: Create socket failed!!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_ERROR("Create socket failed!!!");
         tcp_connection_handling_.store(false);
         return -1;
     }
@@ -132,7 +161,7 @@ int JT808Client::ConnectRemote(void) {
     }
     auto tcp_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (tcp_socket == INVALID_SOCKET) {
-        printf("%s[%d]: Create socket failed!!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_ERROR("Create socket failed!!!");
         WSACleanup();
         tcp_connection_handling_.store(false);
         return -1;
@@ -140,7 +169,7 @@ int JT808Client::ConnectRemote(void) {
     addr.sin_addr.S_un.S_addr = inet_addr(ip_.c_str());
 #endif
     if (Connect(tcp_socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
-        printf("[%s:%d] Connect to remote server failed!!!\n", ip_.c_str(), port_);
+        JT808_LOG_ERROR("[%s:%d] Connect to remote server failed!!!", ip_, port_);
         Close(tcp_socket);
 #if defined(_WIN32)
         WSACleanup();
@@ -156,7 +185,7 @@ int JT808Client::ConnectRemote(void) {
 #elif defined(_WIN32)
     unsigned long ul = 1;
     if (ioctlsocket(tcp_socket, FIONBIO, (unsigned long*)&ul) == SOCKET_ERROR) {
-        printf("[%s:%d] Set socket nonblock failed!!!\n", ip_.c_str(), port_);
+        JT808_LOG_ERROR("[%s:%d] Set socket nonblock failed!!!", ip_, port_);
         Close(tcp_socket);
 #if defined(_WIN32)
         WSACleanup();
@@ -169,7 +198,7 @@ int JT808Client::ConnectRemote(void) {
     client_ = tcp_socket;
     is_connected_.store(true);
     tcp_connection_handling_.store(false);
-    printf("[%s:%d] TCP connected.\n", ip_.c_str(), port_);
+    JT808_LOG_INFO("[%s:%d] TCP connected.", ip_, port_);
     return 0;
 }
 
@@ -261,7 +290,12 @@ int JT808Client::JT808ConnectionAuthentication(void) {
     }
     is_authenticated_.store(true);
     jt808_connection_handling_.store(false);
-    printf("[%s:%d]: JT808 connected.\n", ip_.c_str(), port_);
+    {
+        // 断线前未得到应答的盲区补报批次重新上传.
+        std::unique_lock<std::mutex> lock(journal_mutex_);
+        blind_spot_in_flight_ = false;
+    }
+    JT808_LOG_INFO("[%s:%d] JT808 connected.", ip_, port_);
     return 0;
 }
 
@@ -280,6 +314,10 @@ void JT808Client::Stop(void) {
         return;
     if (jt808_connection_handling_.load())
         return;
+    if (async_state_ != kAsyncIdle) {
+        ResetAsyncState();
+        return;
+    }
     if (client_ > 0) {
         Close(client_);
         client_ = -1;
@@ -296,13 +334,12 @@ void JT808Client::WattingStop(int const& timeout_msec) {
         auto begin_tp = std::chrono::steady_clock::now();
         auto end_tp   = begin_tp;
         while (std::chrono::duration_cast<std::chrono::milliseconds>(end_tp - begin_tp).count() < timeout_msec) {
-            if (general_msg_.empty() && location_report_msg_.empty())
+            if (outbound_.empty())
                 break;
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
             end_tp = std::chrono::steady_clock::now();
         }
-        general_msg_.clear();
-        location_report_msg_.clear();
+        outbound_.Clear();
         service_is_running_.store(false);
         Close(client_);
         client_ = 0;
@@ -316,22 +353,63 @@ void JT808Client::WattingStop(int const& timeout_msec) {
 
 void JT808Client::GenerateLocationReportMsgNow(void) {
     // printf("timestamp: %s\n", parameter_.location_info.time.c_str());
+    // 未鉴权时存入盲区日志, 鉴权后以定位数据批量上传补报.
+    if (!is_authenticated_.load()) {
+        std::unique_lock<std::mutex> lock(journal_mutex_);
+        if (journal_.is_open()) {
+            // 只封装消息体, 不占用消息流水号.
+            std::vector<uint8_t>         body;
+            std::unique_lock<std::mutex> msg_lock(msg_generate_mutex_);
+            auto const                   it = packager_.find(kLocationReport);
+            if (it == packager_.end() || it->second(parameter_, &body) <= 0) {
+                JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Package message failed !!!");
+                return;
+            }
+            msg_lock.unlock();
+            if (journal_.Append(body.data(), body.size()) != 0)
+                JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Blind spot journal append failed !!!");
+            return;
+        }
+    }
     std::vector<uint8_t> msg;
     if (PackagingMessage(kLocationReport, &msg) < 0) {
-        printf("%s[%d]: Package message failed !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Package message failed !!!");
         return;
     }
-    if (location_report_msg_.size() > 10000) {
-        location_report_msg_.pop_front();
+    // 队列满时丢弃最早的位置上报.
+    if (!outbound_.Push(kOutboundReport, std::move(msg))) {
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Outbound queue full, %llu location reports dropped !!!",
+                               static_cast<unsigned long long>(outbound_.dropped()));
     }
-    location_report_msg_.push_back(std::move(msg));
+}
+
+int JT808Client::EnableBlindSpotJournal(std::string const& path, size_t const& capacity, uint16_t const& batch_size) {
+    if (batch_size == 0)
+        return -1;
+    std::unique_lock<std::mutex> lock(journal_mutex_);
+    if (journal_.Open(path, capacity) != 0) {
+        JT808_LOG_ERROR("Open blind spot journal %s failed !!!", path);
+        return -1;
+    }
+    blind_spot_batch_size_ = batch_size;
+    blind_spot_in_flight_  = false;
+    blind_spot_refusals_   = 0;
+    return 0;
+}
+
+void JT808Client::DisableBlindSpotJournal(void) {
+    StopBlindSpotRecording();
+    std::unique_lock<std::mutex> lock(journal_mutex_);
+    journal_.Sync();
+    journal_.Close();
+    blind_spot_in_flight_ = false;
 }
 
 int JT808Client::MultimediaUpload(char const* path, std::vector<uint8_t> const& location_basic) {
     std::ifstream ifs;
     ifs.open(path, std::ios::in | std::ios::binary);
     if (!ifs.is_open()) {
-        printf("%s[%d]: Updrade file open failed !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_ERROR("Updrade file open failed !!!");
         return -1;
     }
     ifs.seekg(0, std::ios::end);
@@ -401,14 +479,14 @@ int JT808Client::MultimediaUpload(char const* path, std::vector<uint8_t> const&
     if (ReceiveAndParseMessage(5) == 0) {
         if (parameter_.parse.msg_head.msg_id == kMultimediaDataUploadResponse) {
             if (parameter_.parse.msg_head.msgbody_attr.bit.msglen == 4) {
-                printf("Completed.\n");
+                JT808_LOG_INFO("Completed.");
             }
             else {
                 // TODO(mengyuming@hotmail.com): 需要重传.
             }
         }
     }
-    printf("Done.\n");
+    JT808_LOG_INFO("Done.");
     manual_deal_.store(false);
     return 0;
 }
@@ -417,16 +495,16 @@ int JT808Client::MultimediaUpload(char const* path, std::vector<uint8_t> const&
 // 并通过socket发送到服务端.
 int JT808Client::PackagingAndSendMessage(uint32_t const& msg_id) {
     if (!is_connected_) {
-        printf("%s[%d]: Invalid connection !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_ERROR("Invalid connection !!!");
         return -1;
     }
     std::vector<uint8_t> msg;
     if (PackagingMessage(msg_id, &msg) < 0) {
-        printf("%s[%d]: Package message failed !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Package message failed !!!");
         return -1;
     }
     if (Send(client_, reinterpret_cast<char*>(msg.data()), msg.size(), 0) <= 0) {
-        printf("%s[%d]: Send message failed !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Send message failed !!!");
         return -1;
     }
     return 0;
@@ -435,7 +513,7 @@ int JT808Client::PackagingAndSendMessage(uint32_t const& msg_id) {
 // 阻塞地从socket连接中接收一次数据, 然后按照JT808协议进行解析.
 int JT808Client::ReceiveAndParseMessage(int const& timeout) {
     if (!is_connected_) {
-        printf("%s[%d]: Invalid connection !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_ERROR("Invalid connection !!!");
         return -1;
     }
     std::vector<uint8_t>    msg;
@@ -450,7 +528,7 @@ int JT808Client::ReceiveAndParseMessage(int const& timeout) {
             break;
         }
         else if (ret == 0) {
-            printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
+            JT808_LOG_RATE_LIMITED(kLogInfo, 10, "Disconnect !!!");
             is_connected_.store(false);
             return -1;
         }
@@ -471,7 +549,7 @@ int JT808Client::ReceiveAndParseMessage(int const& timeout) {
     // printf("\n");
     // 解析消息.
     if (JT808FrameParse(parser_, msg, &parameter_) == -1) {
-        printf("%s[%d]: Parse message failed !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Parse message failed !!!");
         return -1;
     }
     return 0;
@@ -483,9 +561,12 @@ int JT808Client::PackagingMessage(uint32_t const& msg_id, std::vector<uint8_t>*
     std::unique_lock<std::mutex> lock(msg_generate_mutex_);
     parameter_.msg_head.msg_id = msg_id; // 设置消息ID.
     if (JT808FramePackage(packager_, parameter_, out) < 0) {
-        printf("%s[%d]: Package message failed !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Package message failed !!!");
         return -1;
     }
+    // 缓存分包, 用于应答平台的补传分包请求.
+    if (parameter_.msg_head.msgbody_attr.bit.packet == 1 && parameter_.msg_head.total_packet > 1)
+        retransmit_cache_.Store(parameter_.msg_head, *out);
     ++parameter_.msg_head.msg_flow_num; // 每正确生成一条命令, 消息流水号增加1.
     lock.unlock();
     return 0;
@@ -496,13 +577,496 @@ int JT808Client::PackagingGeneralMessage(uint32_t const& msg_id) {
     if (PackagingMessage(msg_id, &msg) != 0) {
         return -1;
     }
-    if (general_msg_.size() > 100) {
-        general_msg_.pop_front();
+    outbound_.Push(kOutboundResponse, std::move(msg));
+    return 0;
+}
+
+// 封装消息体, 超出单包长度时分包, 分包缓存用于应答平台的补传分包请求.
+int JT808Client::PackagingFragmentedMessage(uint16_t const& msg_id, std::vector<uint8_t> const& body,
+                                            std::vector<std::vector<uint8_t>>* frames, uint16_t* last_flow_num) {
+    if (frames == nullptr || last_flow_num == nullptr)
+        return -1;
+    size_t const kMaxPacketBody = 1023; // 消息体长度占10位.
+    size_t const total          = body.empty() ? 1 : (body.size() + kMaxPacketBody - 1) / kMaxPacketBody;
+    if (total > 0xFFFF)
+        return -1;
+    std::unique_lock<std::mutex> lock(msg_generate_mutex_);
+    MsgHead                      head = parameter_.msg_head;
+    head.msg_id                       = msg_id;
+    head.msgbody_attr.bit.packet      = total > 1 ? 1 : 0;
+    head.total_packet                 = static_cast<uint16_t>(total);
+    std::vector<uint8_t> packet;
+    std::vector<uint8_t> escaped;
+    std::vector<uint8_t> frame;
+    for (size_t i = 0; i < total; ++i) {
+        size_t const pos = i * kMaxPacketBody;
+        size_t const len = std::min(kMaxPacketBody, body.size() - pos);
+        packet.assign(body.begin() + pos, body.begin() + pos + len);
+        if (Escape(packet, &escaped) < 0)
+            return -1;
+        // 分包的流水号连续, 平台据此请求补传.
+        head.packet_seq   = static_cast<uint16_t>(i + 1);
+        head.msg_flow_num = parameter_.msg_head.msg_flow_num++;
+        if (JT808FramePackageEscapedBody(head, escaped, static_cast<uint16_t>(packet.size()),
+                                         BccCheckSum(packet.data(), packet.size()), &frame) != 0)
+            return -1;
+        if (total > 1)
+            retransmit_cache_.Store(head, frame);
+        frames->push_back(std::move(frame));
+    }
+    *last_flow_num = head.msg_flow_num;
+    return 0;
+}
+
+// 盲区补报, 每次上传一批位置数据, 平台应答最后一包后再上传下一批; 30s未应答或被拒绝则重新上传.
+void JT808Client::UploadBlindSpotBatch(std::chrono::steady_clock::time_point const& now) {
+    std::unique_lock<std::mutex> lock(journal_mutex_);
+    if (!journal_.is_open() || journal_.empty())
+        return;
+    if (blind_spot_in_flight_ && now - blind_spot_sent_tp_ < std::chrono::seconds(30))
+        return;
+    // 数据项个数(WORD)+位置数据类型(BYTE), 之后是日志中的位置数据项; 一批最多64包.
+    std::vector<uint8_t> body(3, 0);
+    uint64_t             next  = 0;
+    size_t const         count = journal_.Peek(blind_spot_batch_size_, 64 * 1023 - 3, &body, &next);
+    body[0]                    = static_cast<uint8_t>(count >> 8);
+    body[1]                    = static_cast<uint8_t>(count);
+    body[2]                    = 1; // 盲区补报.
+    std::vector<std::vector<uint8_t>> frames;
+    uint16_t                          flow_num = 0;
+    if (PackagingFragmentedMessage(kBatchLocationReport, body, &frames, &flow_num) != 0) {
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Package message failed !!!");
+        return;
+    }
+    for (auto& frame : frames)
+        outbound_.Push(kOutboundBulk, std::move(frame));
+    blind_spot_in_flight_ = true;
+    blind_spot_flow_num_  = flow_num;
+    blind_spot_next_      = next;
+    blind_spot_sent_tp_   = now;
+}
+
+// 未鉴权时按位置上报时间间隔存入盲区日志, 未定位时跳过本次记录.
+int64_t JT808Client::RecordBlindSpotReport(std::chrono::steady_clock::time_point const& now,
+                                           std::chrono::steady_clock::time_point* begin_tp) {
+    if (location_report_msg_generate_outside_ || is_authenticated_.load())
+        return -1;
+    {
+        std::unique_lock<std::mutex> lock(journal_mutex_);
+        if (!journal_.is_open())
+            return -1;
+    }
+    int64_t const report_intv = std::max<int64_t>(location_report_inteval_ * 1000, 1000); // 时间间隔, ms.
+    int64_t const lag         = std::chrono::duration_cast<std::chrono::milliseconds>(now - *begin_tp).count();
+    if (lag < report_intv)
+        return report_intv - lag;
+    *begin_tp = now;
+    if (parameter_.location_info.status.bit.positioning == 1)
+        GenerateLocationReportMsgNow();
+    return report_intv;
+}
+
+void JT808Client::StartBlindSpotRecording(void) {
+    std::unique_lock<std::mutex> lock(journal_mutex_);
+    if (!journal_.is_open() || blind_spot_thread_.joinable())
+        return;
+    blind_spot_recording_ = true;
+    blind_spot_thread_    = std::thread(&JT808Client::BlindSpotRecordHandler, this);
+}
+
+void JT808Client::StopBlindSpotRecording(void) {
+    std::thread thread;
+    {
+        std::unique_lock<std::mutex> lock(journal_mutex_);
+        blind_spot_recording_ = false;
+        thread                = std::move(blind_spot_thread_);
+    }
+    blind_spot_cv_.notify_all();
+    if (thread.joinable())
+        thread.join();
+}
+
+// 断线期间代替发送线程进行位置信息汇报, 存入盲区日志; 在线时每秒检查一次连接状态.
+void JT808Client::BlindSpotRecordHandler(void) {
+    auto                         begin_tp = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(journal_mutex_);
+    while (blind_spot_recording_) {
+        auto const now = std::chrono::steady_clock::now();
+        lock.unlock();
+        int64_t wait_msec = RecordBlindSpotReport(now, &begin_tp);
+        lock.lock();
+        if (wait_msec < 0) {
+            begin_tp  = now; // 断线后满一个时间间隔再记录.
+            wait_msec = 1000;
+        }
+        blind_spot_cv_.wait_for(lock, std::chrono::milliseconds(wait_msec), [this] { return !blind_spot_recording_; });
+    }
+}
+
+void JT808Client::OnBlindSpotBatchResponse(uint16_t const& flow_num, uint8_t const& result) {
+    std::unique_lock<std::mutex> lock(journal_mutex_);
+    if (!blind_spot_in_flight_ || flow_num != blind_spot_flow_num_)
+        return;
+    // 平台暂时拒绝(如分包重组内存不足)时保留在日志中, 超时后重新上传; 多次拒绝后才移除, 避免反复上传.
+    if (result != kSuccess) {
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Blind spot batch refused, result %d !!!", result);
+        if (++blind_spot_refusals_ < kMaxBlindSpotRefusals)
+            return;
+    }
+    journal_.Consume(blind_spot_next_);
+    blind_spot_in_flight_ = false;
+    blind_spot_refusals_  = 0;
+    lock.unlock();
+    outbound_.Notify(); // 唤醒发送线程上传下一批.
+}
+
+// 上报最近一次接收的升级包的升级结果.
+void JT808Client::UpgradeResultReport(uint8_t const& result) {
+    parameter_.upgrade_info.upgrade_type   = upgrade_receiver_.upgrade_type();
+    parameter_.upgrade_info.upgrade_result = result;
+    PackagingGeneralMessage(kTerminalUpgradeResultReport);
+}
+
+// 查找包含指定点的多边形区域, 只检测外接矩形包含该点的区域.
+size_t JT808Client::GetPolygonAreasAt(double const& latitude, double const& longitude,
+                                     std::vector<uint32_t>* ids) const {
+    if (ids == nullptr)
+        return 0;
+    std::vector<std::pair<GeofenceAreaType, uint32_t>> areas;
+    GetAreasAt(latitude, longitude, &areas);
+    size_t const first = ids->size();
+    for (auto const& area : areas) {
+        if (area.first == kGeofencePolygon)
+            ids->push_back(area.second);
+    }
+    return ids->size() - first;
+}
+
+// 查找包含指定点的区域和路线, 只检测外接矩形包含该点的区域和路段.
+size_t JT808Client::GetAreasAt(double const& latitude, double const& longitude,
+                               std::vector<std::pair<GeofenceAreaType, uint32_t>>* areas) const {
+    if (areas == nullptr || fabs(latitude) > 90.0 || fabs(longitude) > 180.0)
+        return 0;
+    std::vector<GeofenceAreas::Hit> hits;
+    area_index_.Query(static_cast<int32_t>(llround(latitude * 1e6)), static_cast<int32_t>(llround(longitude * 1e6)),
+                      &hits);
+    for (auto const& hit : hits) {
+        auto const& area = area_index_.area(hit.slot);
+        areas->push_back(std::make_pair(area.type, area.area_id));
+    }
+    return hits.size();
+}
+
+// 按设置属性更新圆形或矩形区域.
+template <typename T>
+int JT808Client::UpdateAreas(GeofenceAreaType const& type, uint8_t const& setting_type,
+                             std::map<uint32_t, T> const& areas, std::map<uint32_t, T>* current) {
+    if (setting_type > kAreaModify)
+        return -1;
+    if (setting_type == kAreaUpdate) {
+        current->clear();
+        area_index_.Clear(type);
+    }
+    for (auto const& item : areas) {
+        if (setting_type == kAreaModify && current->find(item.first) == current->end())
+            continue;
+        (*current)[item.first] = item.second;
+        area_index_.Insert(item.second);
     }
-    general_msg_.push_back(std::move(msg));
     return 0;
 }
 
+// 删除指定ID的区域或路线, ID集为空时删除该类型的全部区域或路线.
+template <typename T>
+void JT808Client::DeleteAreas(GeofenceAreaType const& type, std::vector<uint32_t> const& ids,
+                              std::map<uint32_t, T>* current) {
+    if (ids.empty()) {
+        current->clear();
+        area_index_.Clear(type);
+        return;
+    }
+    for (auto const& id : ids) {
+        current->erase(id);
+        area_index_.Erase(type, id);
+    }
+}
+
+int JT808Client::UpdateCircularAreas(uint8_t const& setting_type, CircularAreaSet const& areas) {
+    return UpdateAreas(kGeofenceCircle, setting_type, areas, &circular_areas_);
+}
+
+void JT808Client::DeleteCircularAreaByIDs(std::vector<uint32_t> const& ids) {
+    DeleteAreas(kGeofenceCircle, ids, &circular_areas_);
+}
+
+int JT808Client::UpdateRectangleAreas(uint8_t const& setting_type, RectangleAreaSet const& areas) {
+    return UpdateAreas(kGeofenceRectangle, setting_type, areas, &rectangle_areas_);
+}
+
+void JT808Client::DeleteRectangleAreaByIDs(std::vector<uint32_t> const& ids) {
+    DeleteAreas(kGeofenceRectangle, ids, &rectangle_areas_);
+}
+
+void JT808Client::DeleteRouteByIDs(std::vector<uint32_t> const& ids) {
+    DeleteAreas(kGeofenceRoute, ids, &routes_);
+}
+
+// 以非阻塞方式发起TCP连接, 由外部事件循环驱动后续的注册和鉴权.
+int JT808Client::ConnectRemoteNonBlocking(void) {
+#if defined(__linux__)
+    if (is_connected_.load() || async_state_ != kAsyncIdle || tcp_connection_handling_.load())
+        return -1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(static_cast<uint16_t>(port_));
+    addr.sin_addr.s_addr = inet_addr(ip_.c_str());
+    auto tcp_socket      = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (tcp_socket == -1) {
+        JT808_LOG_ERROR("Create socket failed!!!");
+        return -1;
+    }
+    client_ = tcp_socket;
+    recv_buffer_.clear();
+    send_buffer_.clear();
+    send_offset_ = 0;
+    if (Connect(tcp_socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0)
+        return StartRegistration();
+    if (errno != EINPROGRESS) {
+        JT808_LOG_ERROR("[%s:%d] Connect to remote server failed!!!", ip_, port_);
+        Close(tcp_socket);
+        client_ = -1;
+        return -1;
+    }
+    async_state_    = kAsyncConnecting;
+    async_deadline_ = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+// TCP连接建立后发送注册消息.
+int JT808Client::StartRegistration(void) {
+    is_connected_.store(true);
+    async_state_    = kAsyncRegistering;
+    async_deadline_ = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    JT808_LOG_INFO("[%s:%d] TCP connected.", ip_, port_);
+    if (PackagingGeneralMessage(kTerminalRegister) != 0)
+        return -1;
+    return FlushMessages();
+}
+
+int JT808Client::HandleReadable(void) {
+    if (async_state_ == kAsyncConnecting)
+        return 0;
+    if (async_state_ == kAsyncIdle)
+        return -1;
+    char buffer[4096];
+    while (1) {
+        int const ret = Recv(client_, buffer, sizeof(buffer), 0);
+        if (ret > 0) {
+            recv_buffer_.insert(recv_buffer_.end(), buffer, buffer + ret);
+            if (ret < static_cast<int>(sizeof(buffer)))
+                break;
+        }
+        else if (ret == 0) {
+            JT808_LOG_RATE_LIMITED(kLogInfo, 10, "[%s:%d] Disconnect !!!", ip_, port_);
+            return -1;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        else if (errno != EINTR) {
+            JT808_LOG_ERROR("[%s:%d] Remote socket error!!!", ip_, port_);
+            return -1;
+        }
+    }
+    // 处理TCP粘包, 不完整的消息帧留待下次接收.
+    JT808FrameExtract(&recv_buffer_, &frames_);
+    for (auto const& frame : frames_) {
+        if (HandleAsyncFrame(frame) != 0)
+            return -1;
+    }
+    frames_.clear();
+    // 一直没有帧结束标志的数据不是JT808消息.
+    if (recv_buffer_.size() > 64 * 1024) {
+        JT808_LOG_ERROR("[%s:%d] Oversized frame!!!", ip_, port_);
+        return -1;
+    }
+    // 上一批盲区补报得到应答后继续上传.
+    if (async_state_ == kAsyncOnline)
+        UploadBlindSpotBatch(std::chrono::steady_clock::now());
+    return FlushMessages();
+}
+
+int JT808Client::HandleWritable(void) {
+    if (async_state_ == kAsyncIdle)
+        return -1;
+    if (async_state_ != kAsyncConnecting)
+        return FlushMessages();
+#if defined(__linux__)
+    // 非阻塞连接完成, 检查连接结果.
+    int       error = 0;
+    socklen_t len   = sizeof(error);
+    if (getsockopt(client_, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+        JT808_LOG_ERROR("[%s:%d] Connect to remote server failed!!!", ip_, port_);
+        return -1;
+    }
+#endif
+    return StartRegistration();
+}
+
+int JT808Client::HandleTimer(void) {
+    auto const now = std::chrono::steady_clock::now();
+    // 断线期间按位置上报时间间隔存入盲区日志.
+    if (async_state_ == kAsyncIdle)
+        return static_cast<int>(RecordBlindSpotReport(now, &report_begin_tp_));
+    // 连接, 注册和鉴权超时.
+    if (async_state_ != kAsyncOnline) {
+        if (now >= async_deadline_) {
+            JT808_LOG_ERROR("[%s:%d] JT808 connection timeout!!!", ip_, port_);
+            return -1;
+        }
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        int64_t       next        = duration_cast<milliseconds>(async_deadline_ - now).count();
+        int64_t const report_next = RecordBlindSpotReport(now, &report_begin_tp_);
+        if (report_next >= 0)
+            next = std::min(next, report_next);
+        return static_cast<int>(next);
+    }
+    // 丢弃长时间未完成的分包消息.
+    if (reassembler_.size() > 0)
+        reassembler_.CollectFillRequests(now, nullptr);
+    int64_t const report_intv = location_report_inteval_ * 1000; // 时间间隔, ms.
+    int64_t       heartbeat_intv;
+    uint32_t      temp;
+    // 从终端参数中获取心跳包时间间隔, 若未找到或值为0则使用默认60秒(s)心跳.
+    if ((GetTerminalHeartbeatInterval(&temp) == 0) && (temp > 0)) {
+        heartbeat_intv = temp * 1000;
+    }
+    else {
+        heartbeat_intv = 60000; // 60s.
+    }
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    int64_t const report_time_lag    = duration_cast<milliseconds>(now - report_begin_tp_).count();
+    int64_t const heartbeat_time_lag = duration_cast<milliseconds>(now - heartbeat_begin_tp_).count();
+    // 与服务线程相同: 首次位置上报需要等到成功定位后再进行, 在此期间进行心跳包发送.
+    bool const waiting_fix = parameter_.location_info.status.bit.positioning == 0 && first_report_;
+    if (!location_report_msg_generate_outside_ &&
+        (report_time_lag >= report_intv || location_report_immediately_flag_) && !waiting_fix) {
+        first_report_                     = false;
+        location_report_immediately_flag_ = 0;
+        report_begin_tp_                  = now;
+        heartbeat_begin_tp_               = now; // 进行位置汇报后重置心跳检测时间.
+        GenerateLocationReportMsgNow();
+    }
+    else if (heartbeat_time_lag >= heartbeat_intv) {
+        heartbeat_begin_tp_ = now;
+        PackagingGeneralMessage(kTerminalHeartBeat);
+    }
+    UploadBlindSpotBatch(now);
+    if (FlushMessages() != 0)
+        return -1;
+    // 距下次心跳或位置上报的时间, 等待定位时每100ms检查一次.
+    int64_t next = heartbeat_intv - duration_cast<milliseconds>(now - heartbeat_begin_tp_).count();
+    if (!location_report_msg_generate_outside_) {
+        int64_t const report_next =
+            waiting_fix ? 100 : report_intv - duration_cast<milliseconds>(now - report_begin_tp_).count();
+        next = std::min(next, report_next);
+    }
+    if (reassembler_.size() > 0)
+        next = std::min<int64_t>(next, 1000);
+    return static_cast<int>(std::max<int64_t>(next, 0));
+}
+
+// 处理事件驱动模式下接收到的消息帧, 鉴权通过前只处理注册应答和鉴权应答.
+int JT808Client::HandleAsyncFrame(std::vector<uint8_t> const& frame) {
+    if (async_state_ == kAsyncOnline) {
+        HandleMessage(frame);
+        return 0;
+    }
+    if (JT808FrameParse(parser_, frame, &parameter_) != 0)
+        return 0;
+    auto const& parse = parameter_.parse;
+    auto const  now   = std::chrono::steady_clock::now();
+    if (async_state_ == kAsyncRegistering) {
+        if (parse.msg_head.msg_id != kTerminalRegisterResponse)
+            return 0;
+        if (parse.respone_result != kRegisterSuccess) {
+            JT808_LOG_ERROR("[%s:%d] Register failed!!!", ip_, port_);
+            return -1;
+        }
+        async_state_    = kAsyncAuthenticating;
+        async_deadline_ = now + std::chrono::seconds(5);
+        return PackagingGeneralMessage(kTerminalAuthentication);
+    }
+    if (parse.msg_head.msg_id != kPlatformGeneralResponse || parse.respone_msg_id != kTerminalAuthentication)
+        return 0;
+    if (parse.respone_result != kSuccess) {
+        JT808_LOG_ERROR("[%s:%d] Authentication failed!!!", ip_, port_);
+        return -1;
+    }
+    is_authenticated_.store(true);
+    async_state_        = kAsyncOnline;
+    report_begin_tp_    = now;
+    heartbeat_begin_tp_ = now;
+    first_report_       = true;
+    {
+        // 断线前未得到应答的盲区补报批次重新上传.
+        std::unique_lock<std::mutex> lock(journal_mutex_);
+        blind_spot_in_flight_ = false;
+    }
+    JT808_LOG_INFO("[%s:%d] JT808 connected.", ip_, port_);
+    return 0;
+}
+
+// 优先发送应答消息, 直到发送缓冲区满; 未发送的消息仍留在消息列表中.
+int JT808Client::FlushMessages(void) {
+    while (1) {
+        if (send_offset_ == send_buffer_.size()) {
+            send_buffer_.clear();
+            send_offset_ = 0;
+            if (!outbound_.Pop(&send_buffer_))
+                return 0;
+            heartbeat_begin_tp_ = std::chrono::steady_clock::now(); // 重置心跳检测时间.
+        }
+#if defined(__linux__)
+        int const flags = MSG_NOSIGNAL;
+#else
+        int const flags = 0;
+#endif
+        int const ret = Send(client_, reinterpret_cast<char*>(send_buffer_.data() + send_offset_),
+                             static_cast<int>(send_buffer_.size() - send_offset_), flags);
+        if (ret > 0) {
+            send_offset_ += static_cast<size_t>(ret);
+        }
+        else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 0;
+        }
+        else if (ret == 0 || errno != EINTR) {
+            JT808_LOG_RATE_LIMITED(kLogWarn, 10, "[%s:%d] Send data failed !!!", ip_, port_);
+            return -1;
+        }
+    }
+}
+
+void JT808Client::ResetAsyncState(void) {
+    if (client_ >= 0)
+        Close(client_);
+    client_      = -1;
+    async_state_ = kAsyncIdle;
+    recv_buffer_.clear();
+    frames_.clear();
+    send_buffer_.clear();
+    send_offset_ = 0;
+    outbound_.Clear();
+    is_authenticated_.store(false);
+    is_connected_.store(false);
+}
+
 // 服务端通信线程, 解析接收到的命令, 同时自动进行位置信息上报和心跳包的发送.
 void JT808Client::ThreadHandler(void) {
     service_is_running_.store(true);
@@ -523,22 +1087,22 @@ void JT808Client::ThreadHandler(void) {
         }
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
-    // 线程终止.
+    // 线程终止, 唤醒等待消息的发送线程.
     send_running.store(false);
     recv_running.store(false);
+    outbound_.Notify();
     service_is_running_.store(false);
     std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     Stop();
-    printf("[%s:%d] Main service done.\r\n", server_ip.c_str(), server_port);
+    JT808_LOG_INFO("[%s:%d] Main service done.", server_ip, server_port);
 }
 
 void JT808Client::SendHandler(std::atomic_bool* const running) {
     running->store(true);
-    int64_t                 report_intv = location_report_inteval_ * 1000; // 时间间隔, ms.
-    std::unique_ptr<char[]> buffer(new char[4096], std::default_delete<char[]>());
-    auto                    report_begin_tp    = std::chrono::steady_clock::now();
-    auto                    heartbeat_begin_tp = std::chrono::steady_clock::now();
-    auto                    end_tp             = std::chrono::steady_clock::now();
+    int64_t report_intv        = location_report_inteval_ * 1000; // 时间间隔, ms.
+    auto    report_begin_tp    = std::chrono::steady_clock::now();
+    auto    heartbeat_begin_tp = std::chrono::steady_clock::now();
+    auto    end_tp             = std::chrono::steady_clock::now();
     auto report_time_lag = std::chrono::duration_cast<std::chrono::milliseconds>(end_tp - report_begin_tp).count();
     auto heartbeat_time_lag =
         std::chrono::duration_cast<std::chrono::milliseconds>(end_tp - heartbeat_begin_tp).count();
@@ -553,58 +1117,33 @@ void JT808Client::SendHandler(std::atomic_bool* const running) {
     }
     bool first_report = true;
     manual_deal_.store(false);
-    std::string server_ip   = ip_;
-    int         server_port = port_;
+    std::string          server_ip   = ip_;
+    int                  server_port = port_;
+    std::vector<uint8_t> msg;
     while (running->load()) {
-        // if (manual_deal_.load()) {
-        //   std::this_thread::sleep_for(std::chrono::milliseconds(20));
-        //   continue;
-        // }
         end_tp = std::chrono::steady_clock::now();
-        // 优先发送应答消息.
-        if (!general_msg_.empty()) {
-            if (!manual_deal_.load()) {
-                for (auto& msg : general_msg_) {
-                    // printf("JT808 Send[%d]: ", static_cast<int>(msg.size()));
-                    // for (auto const& uch : msg) printf("%02X ", uch);
-                    // printf("\n");
-                    if (Send(client_, reinterpret_cast<char*>(msg.data()), msg.size(), 0) <= 0) {
-                        printf("%s[%d]: Send message failed !!!\n", __FUNCTION__, __LINE__);
-                        service_is_running_.store(false);
-                        return;
-                    }
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // 按优先级发送队列中的消息: 应答消息优先, 其次位置上报, 最后是多媒体等批量数据.
+        // 外部生成的位置上报消息同样经由队列发送.
+        if (!manual_deal_.load() && !outbound_.empty()) {
+            while (outbound_.Pop(&msg)) {
+                // printf("JT808 Send[%d]: ", static_cast<int>(msg.size()));
+                // for (auto const& uch : msg) printf("%02X ", uch);
+                // printf("\n");
+                if (Send(client_, reinterpret_cast<char*>(msg.data()), msg.size(), 0) <= 0) {
+                    JT808_LOG_RATE_LIMITED(kLogWarn, 10, "[%s:%d] Send data failed !!!", server_ip, server_port);
+                    service_is_running_.store(false);
+                    return;
                 }
-                general_msg_.clear();
-            }
-            heartbeat_begin_tp = end_tp; // 重置心跳检测时间.
-        }
-        // 到达时间间隔或有立即上报的标志时进行位置信息汇报.
-        // 外部生成上报消息, 交由内部进行上报.
-        if (!location_report_msg_.empty()) {
-            if (!manual_deal_.load()) {
-                for (auto& msg : location_report_msg_) {
-                    // printf("JT808 Send[%d]: ", static_cast<int>(msg.size()));
-                    // for (auto const& uch : msg) printf("%02X ", uch);
-                    // printf("\n");
-                    if (Send(client_, reinterpret_cast<char*>(msg.data()), msg.size(), 0) <= 0) {
-                        printf("[%s:%d] Send data failed !!!\n", server_ip.c_str(), server_port);
-                        service_is_running_.store(false);
-                        return;
-                    }
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                }
-                location_report_msg_.clear();
-                // report_begin_tp = end_tp;
             }
             heartbeat_begin_tp = end_tp; // 重置心跳检测时间.
         }
+        // 盲区补报, 新的批次在下次循环发送.
+        UploadBlindSpotBatch(end_tp);
         // 上次发送位置上报消息到此时的时间差.
         report_time_lag = std::chrono::duration_cast<std::chrono::milliseconds>(end_tp - report_begin_tp).count();
         // 上次发送心跳包到此时的时间差.
         heartbeat_time_lag = std::chrono::duration_cast<std::chrono::milliseconds>(end_tp - heartbeat_begin_tp).count();
         // 到达时间间隔或有立即上报的标志时进行位置信息汇报.
-        // 外部生成上报消息, 交由内部进行上报.
         if (!location_report_msg_generate_outside_ &&
             (report_time_lag >= report_intv || location_report_immediately_flag_)) {
             // 首次上报需要等到成功定位后再进行, 再此期间可以进行心跳包发送.
@@ -614,7 +1153,7 @@ void JT808Client::SendHandler(std::atomic_bool* const running) {
                         heartbeat_begin_tp = end_tp;
                         PackagingGeneralMessage(kTerminalHeartBeat);
                     }
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    outbound_.Wait(100);
                     continue;
                 }
             }
@@ -630,21 +1169,25 @@ void JT808Client::SendHandler(std::atomic_bool* const running) {
             PackagingGeneralMessage(kTerminalHeartBeat);
         }
         else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            // 休眠到下次位置上报或心跳的时间, 期间有消息入队或立即上报时被唤醒.
+            int64_t wait_msec = heartbeat_intv - heartbeat_time_lag;
+            if (!location_report_msg_generate_outside_)
+                wait_msec = std::min<int64_t>(wait_msec, report_intv - report_time_lag);
+            if (manual_deal_.load())
+                wait_msec = std::min<int64_t>(wait_msec, 20);
+            outbound_.Wait(static_cast<int>(std::max<int64_t>(wait_msec, 1)));
         }
     }
     running->store(false);
-    printf("[%s:%d] Send service done.\r\n", server_ip.c_str(), server_port);
+    JT808_LOG_INFO("[%s:%d] Send service done.", server_ip, server_port);
 }
 
 void JT808Client::ReceiveHandler(std::atomic_bool* const running) {
     running->store(true);
-    int                     ret = -1;
-    std::unique_ptr<char[]> buffer(new char[4096], std::default_delete<char[]>());
-    std::vector<uint8_t>    msg;
-    std::unique_ptr<char[]> upgrade_buffer;
-    int                     total_size      = 0;
-    int                     packet_max_size = 0;
+    int                               ret = -1;
+    std::unique_ptr<char[]>           buffer(new char[4096], std::default_delete<char[]>());
+    std::vector<uint8_t>              received;
+    std::vector<std::vector<uint8_t>> frames;
     manual_deal_.store(false);
     std::string server_ip   = ip_;
     int         server_port = port_;
@@ -654,128 +1197,211 @@ void JT808Client::ReceiveHandler(std::atomic_bool* const running) {
             continue;
         }
         if ((ret = Recv(client_, buffer.get(), 4096, 0)) > 0) {
-            // TODO(mengyuming@hotmail.com): 需要处理TCP粘包.
-            msg.assign(buffer.get(), buffer.get() + ret);
-            // printf("JT808 Recv[%d]: ", static_cast<int>(msg.size()));
-            // for (auto const& uch : msg) printf("%02X ", uch);
-            // printf("\n");
-            if (JT808FrameParse(parser_, msg, &parameter_) == 0) {
-                auto const& msg_id = parameter_.parse.msg_head.msg_id;
-                if (msg_id == kSetTerminalParameters) { // 设置终端参数.
-                    // 更新终端参数.
-                    for (auto const& it : parameter_.parse.terminal_parameters) {
-                        if (parameter_.terminal_parameters.find(it.first) != parameter_.terminal_parameters.end()) {
-                            parameter_.terminal_parameters[it.first] = it.second;
-                        }
-                        else {
-                            parameter_.terminal_parameters.insert(it);
-                        }
-                    }
-                    // 应答成功.
-                    parameter_.respone_result = kSuccess;
-                    PackagingGeneralMessage(kTerminalGeneralResponse);
-                    // 调用回调函数.
-                    terminal_parameter_callback_();
-                }
-                else if (msg_id == kGetTerminalParameters ||
-                         msg_id == kGetSpecificTerminalParameters) { // 查询终端参数.
-                    auto const& ids = parameter_.parse.terminal_parameter_ids;
-                    if (ids.empty()) { // 返回全部参数.
-                        parameter_.terminal_parameter_ids.clear();
-                    }
-                    else { // 返回指定参数.
-                        parameter_.terminal_parameter_ids.assign(ids.begin(), ids.end());
-                    }
-                    PackagingGeneralMessage(kGetTerminalParametersResponse);
-                }
-                else if (msg_id == kSetPolygonArea) { // 设置矩形区域.
-                    UpdatePolygonAreaByArea(parameter_.parse.polygon_area);
-                    // 应答成功.
-                    parameter_.respone_result = kSuccess;
-                    PackagingMessage(kTerminalGeneralResponse, &msg);
-                    general_msg_.push_back(msg);
-                    // 调用回调函数.
-                    polygon_area_callback_();
-                }
-                else if (msg_id == kDeletePolygonArea) { // 删除矩形区域.
-                    DeletePolygonAreaByIDs(parameter_.polygon_area_id);
-                    // 应答成功.
-                    parameter_.respone_result = kSuccess;
-                    PackagingGeneralMessage(kTerminalGeneralResponse);
-                    // 调用回调函数.
-                    polygon_area_callback_();
-                }
-                else if (msg_id == kTerminalUpgrade) { // 下发终端升级包.
-                    // TODO(mengyuming@hotmail.com): 未做分包完整性校验.
-                    auto const& upgrade_info = parameter_.parse.upgrade_info;
-                    auto const& msg_head     = parameter_.parse.msg_head;
-                    auto const& packet_size  = upgrade_info.upgrade_data.size();
-                    // 检查分包.
-                    if (msg_head.msgbody_attr.bit.packet == 1) { // 分包.
-                        // 分配空间.
-                        if (msg_head.packet_seq == 1) { // 第一包.
-                            int max_len = msg_head.msgbody_attr.bit.msglen * msg_head.total_packet;
-                            upgrade_buffer =
-                                std::move(std::unique_ptr<char[]>(new char[max_len], std::default_delete<char[]>()));
-                            // 子包最大的数据长度.
-                            packet_max_size = packet_size;
-                            total_size      = 0;
-                        }
-                        memcpy(&(upgrade_buffer[packet_max_size * (msg_head.packet_seq - 1)]),
-                               upgrade_info.upgrade_data.data(), packet_size);
-                        total_size += packet_size;
-                        parameter_.respone_result = kSuccess;
-                        PackagingGeneralMessage(kTerminalGeneralResponse);
-                        // 等待所有数据传输完成.
-                        if (msg_head.packet_seq == msg_head.total_packet) {
-                            upgrade_callback_(upgrade_info.upgrade_type, upgrade_buffer.get(), total_size);
-                            upgrade_buffer.reset();
-                            // 暂时直接返回升级结果.
-                            parameter_.upgrade_info.upgrade_type   = upgrade_info.upgrade_type;
-                            parameter_.upgrade_info.upgrade_result = kTerminalUpgradeSuccess;
-                            PackagingGeneralMessage(kTerminalUpgradeResultReport);
-                        }
-                    }
-                    else { // 未分包.
-                        parameter_.respone_result = kSuccess;
-                        PackagingGeneralMessage(kTerminalGeneralResponse);
-                        upgrade_callback_(upgrade_info.upgrade_type,
-                                          reinterpret_cast<char const*>(upgrade_info.upgrade_data.data()),
-                                          static_cast<int>(upgrade_info.upgrade_data.size()));
-                        // 暂时直接返回升级结果.
-                        parameter_.upgrade_info.upgrade_type   = upgrade_info.upgrade_type;
-                        parameter_.upgrade_info.upgrade_result = kTerminalUpgradeSuccess;
-                        PackagingGeneralMessage(kTerminalUpgradeResultReport);
-                    }
-                }
-                else if (msg_id == kPlatformGeneralResponse) {
-                    // 接收到平台应答后, 清除进出区域报警标志位.
-                    if ((parameter_.parse.respone_msg_id == kLocationReport) &&
-                        (parameter_.location_info.alarm.bit.in_out_area == 1)) {
-                        parameter_.location_info.alarm.bit.in_out_area = 0;
-                    }
-                }
+            // 处理TCP粘包, 不完整的消息帧留待下次接收.
+            received.insert(received.end(), buffer.get(), buffer.get() + ret);
+            JT808FrameExtract(&received, &frames);
+            for (auto const& frame : frames) {
+                // printf("JT808 Recv[%d]: ", static_cast<int>(frame.size()));
+                // for (auto const& uch : frame) printf("%02X ", uch);
+                // printf("\n");
+                HandleMessage(frame);
             }
+            frames.clear();
+            // 一直没有帧结束标志的数据不是JT808消息.
+            if (received.size() > 64 * 1024)
+                received.clear();
         }
         else if (ret == 0) {
-            printf("[%s:%d] Disconnect !!!\n", server_ip.c_str(), server_port);
+            JT808_LOG_RATE_LIMITED(kLogInfo, 10, "[%s:%d] Disconnect !!!", server_ip, server_port);
             service_is_running_.store(false);
             return;
         }
         else {
             if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+                // 丢弃长时间未完成的分包消息.
+                if (reassembler_.size() > 0)
+                    reassembler_.CollectFillRequests(std::chrono::steady_clock::now(), nullptr);
                 std::this_thread::sleep_for(std::chrono::milliseconds(10));
                 continue;
             }
             else {
-                printf("[%s:%d] Remote socket error!!!\n", server_ip.c_str(), server_port);
+                JT808_LOG_ERROR("[%s:%d] Remote socket error!!!", server_ip, server_port);
                 service_is_running_.store(false);
                 return;
             }
         }
     }
     running->store(false);
-    printf("[%s:%d] Receive service done.\r\n", server_ip.c_str(), server_port);
+    JT808_LOG_INFO("[%s:%d] Receive service done.", server_ip, server_port);
+}
+
+// 解析一条完整的消息帧, 分包消息先重组, 并处理平台下发的命令.
+void JT808Client::HandleMessage(std::vector<uint8_t> const& frame) {
+    // 分包消息(流式接收的升级包除外)先重组, 完整后再解析.
+    bool                 reassembled = false;
+    int                  ret         = -1;
+    std::vector<uint8_t> decoded;
+    std::vector<uint8_t> message;
+    MsgHead              msg_head;
+    MsgHead              head;
+    if (JT808FrameDecode(frame, &decoded, &msg_head) == 0) {
+        if (msg_head.msgbody_attr.bit.packet == 1 && msg_head.total_packet > 0 &&
+            !(msg_head.msg_id == kTerminalUpgrade && upgrade_chunk_callback_ != nullptr)) {
+            std::vector<uint8_t> body(decoded.begin() + MSGBODY_PACKET_POS, decoded.end() - 2);
+            int result = reassembler_.AddFragment(msg_head, body, std::chrono::steady_clock::now(), &head, &message);
+            // 逐包应答.
+            parameter_.parse.msg_head = msg_head;
+            parameter_.respone_result = result < 0 ? kFailure : kSuccess;
+            PackagingGeneralMessage(kTerminalGeneralResponse);
+            if (result == FragmentReassembler::kMessageComplete) {
+                reassembled = true;
+                ret         = JT808MessageParse(parser_, head, message, &parameter_);
+                message.clear();
+            }
+        }
+        else {
+            ret = JT808DecodedFrameParse(parser_, decoded, msg_head, &parameter_);
+        }
+    }
+    if (ret == 0) {
+        auto const& msg_id = parameter_.parse.msg_head.msg_id;
+        if (msg_id == kSetTerminalParameters) { // 设置终端参数.
+            // 更新终端参数.
+            for (auto const& it : parameter_.parse.terminal_parameters) {
+                if (parameter_.terminal_parameters.find(it.first) != parameter_.terminal_parameters.end()) {
+                    parameter_.terminal_parameters[it.first] = it.second;
+                }
+                else {
+                    parameter_.terminal_parameters.insert(it);
+                }
+            }
+            // 应答成功.
+            parameter_.respone_result = kSuccess;
+            PackagingGeneralMessage(kTerminalGeneralResponse);
+            // 调用回调函数.
+            terminal_parameter_callback_();
+        }
+        else if (msg_id == kGetTerminalParameters ||
+                 msg_id == kGetSpecificTerminalParameters) { // 查询终端参数.
+            auto const& ids = parameter_.parse.terminal_parameter_ids;
+            if (ids.empty()) { // 返回全部参数.
+                parameter_.terminal_parameter_ids.clear();
+            }
+            else { // 返回指定参数.
+                parameter_.terminal_parameter_ids.assign(ids.begin(), ids.end());
+            }
+            PackagingGeneralMessage(kGetTerminalParametersResponse);
+        }
+        else if (msg_id == kSetPolygonArea) { // 设置矩形区域.
+            UpdatePolygonAreaByArea(parameter_.parse.polygon_area);
+            // 应答成功.
+            parameter_.respone_result = kSuccess;
+            PackagingGeneralMessage(kTerminalGeneralResponse);
+            // 调用回调函数.
+            polygon_area_callback_();
+        }
+        else if (msg_id == kDeletePolygonArea) { // 删除矩形区域.
+            DeletePolygonAreaByIDs(parameter_.polygon_area_id);
+            // 应答成功.
+            parameter_.respone_result = kSuccess;
+            PackagingGeneralMessage(kTerminalGeneralResponse);
+            // 调用回调函数.
+            polygon_area_callback_();
+        }
+        else if (msg_id == kSetCircularArea || msg_id == kSetRectangleArea || msg_id == kSetRoute) {
+            auto const& parse = parameter_.parse;
+            int         ret   = 0;
+            if (msg_id == kSetCircularArea)
+                ret = UpdateCircularAreas(parse.area_setting_type, parse.circular_areas);
+            else if (msg_id == kSetRectangleArea)
+                ret = UpdateRectangleAreas(parse.area_setting_type, parse.rectangle_areas);
+            else
+                ret = UpdateRoute(parse.route);
+            // 应答.
+            parameter_.respone_result = ret == 0 ? kSuccess : kFailure;
+            PackagingGeneralMessage(kTerminalGeneralResponse);
+            // 调用回调函数.
+            if (ret == 0 && area_route_callback_ != nullptr)
+                area_route_callback_(msg_id);
+        }
+        else if (msg_id == kDeleteCircularArea || msg_id == kDeleteRectangleArea || msg_id == kDeleteRoute) {
+            auto const& parse = parameter_.parse;
+            if (msg_id == kDeleteCircularArea)
+                DeleteCircularAreaByIDs(parse.circular_area_id);
+            else if (msg_id == kDeleteRectangleArea)
+                DeleteRectangleAreaByIDs(parse.rectangle_area_id);
+            else
+                DeleteRouteByIDs(parse.route_id);
+            // 应答成功.
+            parameter_.respone_result = kSuccess;
+            PackagingGeneralMessage(kTerminalGeneralResponse);
+            // 调用回调函数.
+            if (area_route_callback_ != nullptr)
+                area_route_callback_(msg_id);
+        }
+        else if (msg_id == kTerminalUpgrade && upgrade_chunk_callback_ != nullptr) { // 流式接收升级包.
+            auto const& upgrade_info = parameter_.parse.upgrade_info;
+            auto const& msg_head     = parameter_.parse.msg_head;
+            uint16_t    total_packet = 1;
+            uint16_t    packet_seq   = 1;
+            if (msg_head.msgbody_attr.bit.packet == 1) {
+                total_packet = msg_head.total_packet;
+                packet_seq   = msg_head.packet_seq;
+            }
+            uint32_t offset = 0;
+            uint32_t size   = static_cast<uint32_t>(upgrade_info.upgrade_data.size());
+            int      ret    = upgrade_receiver_.Accept(upgrade_info, total_packet, packet_seq, &offset);
+            if (ret == UpgradeReceiver::kNewFragment) {
+                // 写入成功后才标记为已接收, 失败的分包由平台重传.
+                if (upgrade_chunk_callback_(upgrade_info.upgrade_type, offset, upgrade_info.upgrade_data.data(),
+                                            size, upgrade_info.upgrade_data_total_len) == 0) {
+                    upgrade_receiver_.MarkReceived(packet_seq, size);
+                }
+                else {
+                    ret = -1;
+                }
+            }
+            // 重复的分包直接应答成功.
+            parameter_.respone_result = ret < 0 ? kFailure : kSuccess;
+            PackagingGeneralMessage(kTerminalGeneralResponse);
+            if (ret == UpgradeReceiver::kNewFragment && upgrade_receiver_.complete() && upgrade_auto_report_)
+                UpgradeResultReport(kTerminalUpgradeSuccess);
+        }
+        else if (msg_id == kTerminalUpgrade) { // 下发终端升级包, 分包已完成重组.
+            auto const& upgrade_info = parameter_.parse.upgrade_info;
+            // 分包已逐包应答.
+            if (!reassembled) {
+                parameter_.respone_result = kSuccess;
+                PackagingGeneralMessage(kTerminalGeneralResponse);
+            }
+            upgrade_callback_(upgrade_info.upgrade_type,
+                              reinterpret_cast<char const*>(upgrade_info.upgrade_data.data()),
+                              static_cast<int>(upgrade_info.upgrade_data.size()));
+            // 暂时直接返回升级结果.
+            parameter_.upgrade_info.upgrade_type   = upgrade_info.upgrade_type;
+            parameter_.upgrade_info.upgrade_result = kTerminalUpgradeSuccess;
+            PackagingGeneralMessage(kTerminalUpgradeResultReport);
+        }
+        else if (msg_id == kFillPacketRequest) { // 补传分包请求.
+            std::vector<std::vector<uint8_t>> frames;
+            {
+                std::unique_lock<std::mutex> lock(msg_generate_mutex_);
+                retransmit_cache_.Find(parameter_.parse.fill_packet, &frames);
+            }
+            // 按原始流水号重发缓存中的分包, 已被淘汰的分包无法补传; 补传的多为多媒体数据, 排在位置上报之后.
+            for (auto& frame : frames)
+                outbound_.Push(kOutboundBulk, std::move(frame));
+        }
+        else if (msg_id == kPlatformGeneralResponse) {
+            // 接收到平台应答后, 清除进出区域报警标志位.
+            if ((parameter_.parse.respone_msg_id == kLocationReport) &&
+                (parameter_.location_info.alarm.bit.in_out_area == 1)) {
+                parameter_.location_info.alarm.bit.in_out_area = 0;
+            }
+            if (parameter_.parse.respone_msg_id == kBatchLocationReport)
+                OnBlindSpotBatchResponse(parameter_.parse.respone_flow_num, parameter_.parse.respone_result);
+        }
+    }
 }
 
 } // namespace libjt808
@@ -0,0 +1,219 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  firmware_cache.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 09:13:05
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/firmware_cache.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <fstream>
+
+#include "jt808/packager.h"
+#include "jt808/util.h"
+
+namespace libjt808 {
+
+namespace {
+
+// Manufacturer ID length.
+constexpr size_t kManufacturerIdLength = 5;
+
+std::string ImageKey(std::string const& path, uint8_t const& upgrade_type,
+                     std::vector<uint8_t> const& manufacturer_id, std::string const& version_id) {
+    std::string key(path);
+    key.push_back('\0');
+    key.push_back(static_cast<char>(upgrade_type));
+    key.append(manufacturer_id.begin(), manufacturer_id.end());
+    key.push_back('\0');
+    key.append(version_id);
+    return key;
+}
+
+bool StartsWithPath(std::string const& key, std::string const& path) {
+    return key.size() > path.size() && key.compare(0, path.size(), path) == 0 && key[path.size()] == '\0';
+}
+
+// Read the file modification time and size.
+int FileStat(std::string const& path, int64_t* mtime, int64_t* size) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return -1;
+    *mtime = static_cast<int64_t>(st.st_mtime);
+    *size  = static_cast<int64_t>(st.st_size);
+    return 0;
+}
+
+// Map the file into memory and slice it.
+int LoadAndSlice(std::string const& path, FirmwareImage* image) {
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return -1;
+    }
+    size_t length = static_cast<size_t>(st.st_size);
+    void*  addr   = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return -1;
+    madvise(addr, length, MADV_SEQUENTIAL);
+    int ret = SliceFirmwareImage(static_cast<uint8_t const*>(addr), length, image);
+    munmap(addr, length);
+    return ret;
+#else
+    std::ifstream ifs;
+    ifs.open(path, std::ios::in | std::ios::binary);
+    if (!ifs.is_open())
+        return -1;
+    ifs.seekg(0, std::ios::end);
+    size_t length = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+    if (length == 0)
+        return -1;
+    std::unique_ptr<char[]> buffer(new char[length], std::default_delete<char[]>());
+    ifs.read(buffer.get(), length);
+    ifs.close();
+    return SliceFirmwareImage(reinterpret_cast<uint8_t const*>(buffer.get()), length, image);
+#endif
+}
+
+} // namespace
+
+int SliceFirmwareImage(uint8_t const* data, size_t const& len, FirmwareImage* image) {
+    if (data == nullptr || image == nullptr || len == 0 || len > 0xFFFFFFFF)
+        return -1;
+    if (image->version_id.size() > 255)
+        return -1;
+    // Manufacturer ID is fixed 5 bytes, padded with 0x00 if insufficient.
+    image->manufacturer_id.resize(kManufacturerIdLength, 0x00);
+    image->total_len = static_cast<uint32_t>(len);
+    // Fixed part of every fragment: type(1) + manufacturer ID(5) + version length(1) + version + total length(4).
+    std::vector<uint8_t> prefix;
+    prefix.push_back(image->upgrade_type);
+    prefix.insert(prefix.end(), image->manufacturer_id.begin(), image->manufacturer_id.end());
+    prefix.push_back(static_cast<uint8_t>(image->version_id.size()));
+    prefix.insert(prefix.end(), image->version_id.begin(), image->version_id.end());
+    U32ToU8Array u32converter;
+    u32converter.u32val = EndianSwap32(image->total_len);
+    for (int i = 0; i < 4; ++i)
+        prefix.push_back(u32converter.u8array[i]);
+    size_t const max_content = kMaxMsgBodyLength - prefix.size();
+    image->fragments.clear();
+    image->fragments.reserve((len + max_content - 1) / max_content);
+    std::vector<uint8_t> body;
+    for (size_t i = 0; i < len; i += max_content) {
+        size_t chunk = len - i;
+        if (chunk > max_content)
+            chunk = max_content;
+        body.assign(prefix.begin(), prefix.end());
+        body.insert(body.end(), data + i, data + i + chunk);
+        FirmwareFragment fragment;
+        fragment.body_len = static_cast<uint16_t>(body.size());
+        fragment.body_bcc = BccCheckSum(body.data(), body.size());
+        if (Escape(body, &fragment.escaped_body) < 0)
+            return -1;
+        image->fragments.push_back(std::move(fragment));
+    }
+    if (image->fragments.size() > 0xFFFF)
+        return -1;
+    return 0;
+}
+
+int PackageFirmwareFragment(MsgHead const& msg_head, FirmwareImage const& image, size_t const& index,
+                            std::vector<uint8_t>* out) {
+    if (out == nullptr || index >= image.fragments.size())
+        return -1;
+    MsgHead head = msg_head;
+    head.msg_id  = kTerminalUpgrade;
+    if (image.fragments.size() > 1) {
+        head.msgbody_attr.bit.packet = 1;
+        head.total_packet            = static_cast<uint16_t>(image.fragments.size());
+        head.packet_seq              = static_cast<uint16_t>(index + 1);
+    }
+    else {
+        head.msgbody_attr.bit.packet = 0;
+        head.total_packet            = 1;
+        head.packet_seq              = 1;
+    }
+    auto const& fragment = image.fragments[index];
+    return JT808FramePackageEscapedBody(head, fragment.escaped_body, fragment.body_len, fragment.body_bcc, out);
+}
+
+FirmwareImagePtr FirmwareImageCache::Load(std::string const& path, uint8_t const& upgrade_type,
+                                          std::vector<uint8_t> const& manufacturer_id,
+                                          std::string const& version_id) {
+    int64_t mtime = 0;
+    int64_t size  = 0;
+    if (FileStat(path, &mtime, &size) != 0)
+        return nullptr;
+    auto const                   key = ImageKey(path, upgrade_type, manufacturer_id, version_id);
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto                         it = images_.find(key);
+    if (it != images_.end() && it->second.mtime == mtime && it->second.size == size)
+        return it->second.image;
+    std::shared_ptr<FirmwareImage> image(new FirmwareImage());
+    image->path         = path;
+    image->upgrade_type = upgrade_type;
+    image->manufacturer_id.assign(manufacturer_id.begin(), manufacturer_id.end());
+    image->version_id = version_id;
+    if (LoadAndSlice(path, image.get()) != 0)
+        return nullptr;
+    images_[key] = Entry {mtime, size, image};
+    return image;
+}
+
+void FirmwareImageCache::Evict(std::string const& path) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto it = images_.begin(); it != images_.end();) {
+        if (StartsWithPath(it->first, path))
+            it = images_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void FirmwareImageCache::Clear(void) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    images_.clear();
+}
+
+size_t FirmwareImageCache::size(void) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return images_.size();
+}
+
+} // namespace libjt808
@@ -0,0 +1,635 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  geofence.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 19:05:37
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/geofence.h"
+
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "jt808/bcd.h"
+
+namespace libjt808 {
+
+namespace {
+
+// Meters per microdegree of latitude, on a sphere of the mean earth radius.
+constexpr double kMetersPerMicrodegree = 6371008.8 * 3.14159265358979323846 / 180.0 / 1e6;
+
+// Degrees to signed microdegrees.
+int32_t ToMicrodegrees(double const& degree, bool const& negative) {
+    int32_t const value = static_cast<int32_t>(llround(fabs(degree) * 1e6));
+    return negative ? -value : value;
+}
+
+// Meters per microdegree of longitude at a latitude, kept away from 0 near the poles.
+double LongitudeScale(int32_t const& lat) {
+    double const scale = kMetersPerMicrodegree * cos(lat * 1e-6 * 3.14159265358979323846 / 180.0);
+    return scale > 1e-3 ? scale : 1e-3;
+}
+
+int32_t ClampMicrodegrees(double const& value, int32_t const& limit) {
+    return value < -limit ? -limit : (value > limit ? limit : static_cast<int32_t>(value));
+}
+
+// Box of the points within a distance in meters of a box.
+AreaBox ExpandBox(AreaBox const& box, double const& meters, double const& lon_scale) {
+    double const lat = meters / kMetersPerMicrodegree;
+    double const lon = meters / lon_scale;
+    return AreaBox {ClampMicrodegrees(box.min_lat - lat, 90000000), ClampMicrodegrees(box.max_lat + lat, 90000000),
+                    ClampMicrodegrees(box.min_lon - lon, 180000000), ClampMicrodegrees(box.max_lon + lon, 180000000)};
+}
+
+constexpr int64_t kSecondsPerDay = 86400;
+constexpr int64_t kGmt8Offset    = 8 * 3600;
+
+// "YYMMDDhhmmss" to seconds since the Unix epoch, or to seconds of the day with daily set if the date is 000000.
+// Returns -1 if it is neither.
+int64_t AreaTime(std::string const& str, bool* daily) {
+    BcdTimestamp time;
+    int64_t      epoch;
+    if (time.Assign(str) != 0)
+        return -1;
+    *daily = time.bcd[0] == 0 && time.bcd[1] == 0 && time.bcd[2] == 0;
+    if (!*daily)
+        return time.ToEpoch(&epoch) == 0 ? epoch : -1;
+    // Validate the time of the day on an arbitrary date.
+    time.bcd[0] = 0x00;
+    time.bcd[1] = 0x01;
+    time.bcd[2] = 0x01;
+    if (time.ToEpoch(&epoch) != 0)
+        return -1;
+    return (epoch + kGmt8Offset) % kSecondsPerDay;
+}
+
+// Time window of an area, left unlimited unless both times are dates, or both are times of the day.
+void SetTimeWindow(bool const& by_time, std::string const& start_time, std::string const& stop_time,
+                   GeofenceAreas::Area* area) {
+    area->start_time = -1;
+    area->stop_time  = -1;
+    area->daily      = false;
+    if (by_time) {
+        bool          start_daily = false;
+        bool          stop_daily  = false;
+        int64_t const start = AreaTime(start_time, &start_daily);
+        int64_t const stop  = AreaTime(stop_time, &stop_daily);
+        if (start >= 0 && stop >= 0 && start_daily == stop_daily) {
+            area->start_time = start;
+            area->stop_time  = stop;
+            area->daily      = start_daily;
+        }
+    }
+}
+
+// Time window and speed limit of a circular, rectangle or polygon area.
+template <typename T>
+void SetAreaLimits(T const& source, GeofenceAreas::Area* area) {
+    area->attribute = source.area_attribute.value;
+    SetTimeWindow(source.area_attribute.bit.by_time, source.start_time, source.stop_time, area);
+    area->max_speed      = source.area_attribute.bit.speed_limit ? source.max_speed : 0;
+    area->overspeed_time = source.area_attribute.bit.speed_limit ? source.overspeed_time : 0;
+}
+
+} // namespace
+
+GeofenceAreas::Area& GeofenceAreas::PrepareSlot(GeofenceAreaType const& type, uint32_t const& area_id,
+                                                uint32_t* slot) {
+    if (FindSlot(type, area_id, slot) == 0) {
+        RemoveGeometry(*slot);
+    }
+    else if (free_slots_.empty()) {
+        *slot = static_cast<uint32_t>(areas_.size());
+        areas_.emplace_back();
+    }
+    else {
+        *slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    slot_of_[AreaKey(type, area_id)] = *slot;
+    Area& area          = areas_[*slot];
+    area.type           = type;
+    area.area_id        = area_id;
+    area.attribute      = 0;
+    area.start_time     = -1;
+    area.stop_time      = -1;
+    area.daily          = false;
+    area.max_speed      = 0;
+    area.overspeed_time = 0;
+    area.box            = AreaBox();
+    area.center_lat     = 0;
+    area.center_lon     = 0;
+    area.radius         = 0.0;
+    return area;
+}
+
+void GeofenceAreas::RemoveGeometry(uint32_t const& slot) {
+    Area& area = areas_[slot];
+    index_.Erase(slot);
+    for (auto const& section : area.sections) {
+        index_.Erase(kSegmentKey | section.segment);
+        free_segments_.push_back(section.segment);
+    }
+    area.sections.clear();
+    area.edges.clear();
+}
+
+int GeofenceAreas::Insert(CircularArea const& circle) {
+    uint32_t slot;
+    Area&    area = PrepareSlot(kGeofenceCircle, circle.area_id, &slot);
+    SetAreaLimits(circle, &area);
+    area.center_lat      = ToMicrodegrees(circle.center.latitude, circle.area_attribute.bit.sn_latitude);
+    area.center_lon      = ToMicrodegrees(circle.center.longitude, circle.area_attribute.bit.ew_longitude);
+    area.radius          = circle.radius;
+    AreaBox const center = {area.center_lat, area.center_lat, area.center_lon, area.center_lon};
+    area.box             = ExpandBox(center, area.radius, LongitudeScale(area.center_lat));
+    index_.Insert(slot, area.box);
+    return 0;
+}
+
+int GeofenceAreas::Insert(RectangleArea const& rectangle) {
+    uint32_t slot;
+    Area&    area = PrepareSlot(kGeofenceRectangle, rectangle.area_id, &slot);
+    SetAreaLimits(rectangle, &area);
+    bool const    south  = rectangle.area_attribute.bit.sn_latitude;
+    bool const    west   = rectangle.area_attribute.bit.ew_longitude;
+    int32_t const lat[2] = {ToMicrodegrees(rectangle.upper_left.latitude, south),
+                            ToMicrodegrees(rectangle.lower_right.latitude, south)};
+    int32_t const lon[2] = {ToMicrodegrees(rectangle.upper_left.longitude, west),
+                            ToMicrodegrees(rectangle.lower_right.longitude, west)};
+    // Accept the corners in any order.
+    area.box = AreaBox {std::min(lat[0], lat[1]), std::max(lat[0], lat[1]), std::min(lon[0], lon[1]),
+                        std::max(lon[0], lon[1])};
+    index_.Insert(slot, area.box);
+    return 0;
+}
+
+int GeofenceAreas::Insert(PolygonArea const& polygon) {
+    if (polygon.vertices.size() < 3)
+        return -1;
+    std::vector<int32_t> lat;
+    std::vector<int32_t> lon;
+    lat.reserve(polygon.vertices.size());
+    lon.reserve(polygon.vertices.size());
+    for (auto const& vertex : polygon.vertices) {
+        lat.push_back(ToMicrodegrees(vertex.latitude, polygon.area_attribute.bit.sn_latitude));
+        lon.push_back(ToMicrodegrees(vertex.longitude, polygon.area_attribute.bit.ew_longitude));
+    }
+    uint32_t slot;
+    Area&    area = PrepareSlot(kGeofencePolygon, polygon.area_id, &slot);
+    SetAreaLimits(polygon, &area);
+    PolygonEdgesBuild(lat.data(), lon.data(), lat.size(), &area.edges);
+    area.box = area.edges.box;
+    index_.Insert(slot, area.box);
+    return 0;
+}
+
+int GeofenceAreas::Insert(Route const& route) {
+    auto const& points = route.inflection_points;
+    if (points.size() < 2)
+        return -1;
+    uint32_t slot;
+    Area&    area = PrepareSlot(kGeofenceRoute, route.route_id, &slot);
+    area.attribute = route.route_attribute.value;
+    SetTimeWindow(route.route_attribute.bit.by_time, route.start_time, route.stop_time, &area);
+    area.sections.reserve(points.size() - 1);
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        auto const&   from      = points[i];
+        auto const&   to        = points[i + 1];
+        auto const&   attribute = from.section_attribute.bit;
+        int32_t const lat0      = ToMicrodegrees(from.point.latitude, attribute.sn_latitude);
+        int32_t const lon0      = ToMicrodegrees(from.point.longitude, attribute.ew_longitude);
+        int32_t const lat1      = ToMicrodegrees(to.point.latitude, to.section_attribute.bit.sn_latitude);
+        int32_t const lon1      = ToMicrodegrees(to.point.longitude, to.section_attribute.bit.ew_longitude);
+        Segment       segment;
+        segment.slot       = slot;
+        segment.section    = static_cast<uint32_t>(i);
+        segment.lat        = lat0;
+        segment.lon        = lon0;
+        segment.lon_scale  = LongitudeScale(static_cast<int32_t>((static_cast<int64_t>(lat0) + lat1) / 2));
+        segment.dx         = static_cast<double>(static_cast<int64_t>(lon1) - lon0) * segment.lon_scale;
+        segment.dy         = static_cast<double>(static_cast<int64_t>(lat1) - lat0) * kMetersPerMicrodegree;
+        segment.half_width = from.section_width / 2.0;
+        uint32_t number;
+        if (free_segments_.empty()) {
+            number = static_cast<uint32_t>(segments_.size());
+            segments_.push_back(segment);
+        }
+        else {
+            number = free_segments_.back();
+            free_segments_.pop_back();
+            segments_[number] = segment;
+        }
+        AreaBox const ends = {std::min(lat0, lat1), std::max(lat0, lat1), std::min(lon0, lon1), std::max(lon0, lon1)};
+        AreaBox const box  = ExpandBox(ends, segment.half_width, std::min(LongitudeScale(lat0), LongitudeScale(lat1)));
+        index_.Insert(kSegmentKey | number, box);
+        RouteSection section;
+        section.section_id     = from.section_id;
+        section.segment        = number;
+        section.max_speed      = attribute.speed_limit ? from.max_speed : 0;
+        section.overspeed_time = attribute.speed_limit ? from.overspeed_time : 0;
+        section.drive_time     = attribute.drive_time;
+        section.max_drive_time = attribute.drive_time ? from.max_drive_time : 0;
+        section.min_drive_time = attribute.drive_time ? from.min_drive_time : 0;
+        area.sections.push_back(section);
+        if (i == 0) {
+            area.box = box;
+        }
+        else {
+            area.box.min_lat = std::min(area.box.min_lat, box.min_lat);
+            area.box.max_lat = std::max(area.box.max_lat, box.max_lat);
+            area.box.min_lon = std::min(area.box.min_lon, box.min_lon);
+            area.box.max_lon = std::max(area.box.max_lon, box.max_lon);
+        }
+    }
+    return 0;
+}
+
+size_t GeofenceAreas::Erase(GeofenceAreaType const& type, uint32_t const& area_id) {
+    auto const it = slot_of_.find(AreaKey(type, area_id));
+    if (it == slot_of_.end())
+        return 0;
+    uint32_t const slot = it->second;
+    RemoveGeometry(slot);
+    areas_[slot].type = static_cast<GeofenceAreaType>(0);
+    free_slots_.push_back(slot);
+    slot_of_.erase(it);
+    return 1;
+}
+
+void GeofenceAreas::Clear(GeofenceAreaType const& type) {
+    for (auto const& area : areas_) {
+        if (area.type == type)
+            Erase(type, area.area_id);
+    }
+}
+
+void GeofenceAreas::Clear(void) {
+    areas_.clear();
+    free_slots_.clear();
+    segments_.clear();
+    free_segments_.clear();
+    slot_of_.clear();
+    index_.Clear();
+}
+
+int GeofenceAreas::FindSlot(GeofenceAreaType const& type, uint32_t const& area_id, uint32_t* slot) const {
+    auto const it = slot_of_.find(AreaKey(type, area_id));
+    if (slot == nullptr || it == slot_of_.end())
+        return -1;
+    *slot = it->second;
+    return 0;
+}
+
+double GeofenceAreas::SegmentDistance2(Segment const& segment, int32_t const& lat, int32_t const& lon) {
+    double const px     = static_cast<double>(static_cast<int64_t>(lon) - segment.lon) * segment.lon_scale;
+    double const py     = static_cast<double>(static_cast<int64_t>(lat) - segment.lat) * kMetersPerMicrodegree;
+    double const length = segment.dx * segment.dx + segment.dy * segment.dy;
+    double       t      = length > 0.0 ? (px * segment.dx + py * segment.dy) / length : 0.0;
+    t                   = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    double const ex     = px - t * segment.dx;
+    double const ey     = py - t * segment.dy;
+    return ex * ex + ey * ey;
+}
+
+size_t GeofenceAreas::Query(int32_t const& lat, int32_t const& lon, std::vector<Hit>* hits) const {
+    if (hits == nullptr)
+        return 0;
+    size_t const first = hits->size();
+    index_.Visit(lat, lon, [&](uint32_t const& key) {
+        if ((key & kSegmentKey) == 0) {
+            if (GeofenceContains(areas_[key], lat, lon))
+                hits->push_back(Hit {key, 0, 0.0});
+            return;
+        }
+        Segment const& segment  = segments_[key & ~kSegmentKey];
+        double const   distance = SegmentDistance2(segment, lat, lon);
+        if (distance > segment.half_width * segment.half_width)
+            return;
+        // One hit per route, on its nearest road section, the later one at a shared inflection point.
+        for (size_t i = first; i < hits->size(); ++i) {
+            Hit& hit = (*hits)[i];
+            if (hit.slot != segment.slot)
+                continue;
+            double const meters = sqrt(distance);
+            if (meters < hit.distance || (meters == hit.distance && segment.section > hit.section)) {
+                hit.section  = segment.section;
+                hit.distance = meters;
+            }
+            return;
+        }
+        hits->push_back(Hit {segment.slot, segment.section, sqrt(distance)});
+    });
+    return hits->size() - first;
+}
+
+GeofenceAreasPtr GeofenceCompile(PolygonAreaSet const& areas) {
+    auto compiled = std::make_shared<GeofenceAreas>();
+    for (auto const& item : areas)
+        compiled->Insert(item.second);
+    return compiled;
+}
+
+bool GeofenceContains(GeofenceAreas::Area const& area, int32_t const& lat, int32_t const& lon) {
+    switch (area.type) {
+        case kGeofenceCircle: {
+            if (!area.box.Contains(lat, lon))
+                return false;
+            double const dx = static_cast<double>(lon - area.center_lon) * LongitudeScale(area.center_lat);
+            double const dy = static_cast<double>(lat - area.center_lat) * kMetersPerMicrodegree;
+            return dx * dx + dy * dy <= area.radius * area.radius;
+        }
+        case kGeofenceRectangle:
+            return area.box.Contains(lat, lon);
+        case kGeofencePolygon:
+            return PolygonEdgesContains(area.edges, lat, lon);
+        default:
+            return false;
+    }
+}
+
+bool GeofenceInTimeWindow(GeofenceAreas::Area const& area, int64_t const& time) {
+    if (area.start_time < 0)
+        return true;
+    if (!area.daily)
+        return time >= area.start_time && time <= area.stop_time;
+    int64_t const local = ((time + kGmt8Offset) % kSecondsPerDay + kSecondsPerDay) % kSecondsPerDay;
+    if (area.start_time <= area.stop_time)
+        return local >= area.start_time && local <= area.stop_time;
+    return local >= area.start_time || local <= area.stop_time;
+}
+
+int GeofenceEngine::SetAreas(std::string const& phone, GeofenceAreasPtr const& areas) {
+    if (areas == nullptr)
+        return -1;
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& terminal = terminals_[phone];
+    terminal.areas = areas;
+    terminal.owned.reset();
+    terminal.states.clear();
+    return 0;
+}
+
+int GeofenceEngine::SetAreas(std::vector<std::string> const& phones, PolygonAreaSet const& areas) {
+    auto const compiled = GeofenceCompile(areas);
+    for (auto const& phone : phones) {
+        if (SetAreas(phone, compiled) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+GeofenceAreas* GeofenceEngine::MutableAreas(Terminal* terminal) {
+    if (terminal->owned == nullptr) {
+        terminal->owned = terminal->areas != nullptr ? std::make_shared<GeofenceAreas>(*terminal->areas)
+                                                     : std::make_shared<GeofenceAreas>();
+        terminal->areas = terminal->owned;
+    }
+    return terminal->owned.get();
+}
+
+GeofenceEngine::AreaState* GeofenceEngine::FindState(std::vector<AreaState>* states, uint32_t const& slot) {
+    for (auto& state : *states) {
+        if (state.slot == slot)
+            return &state;
+    }
+    return nullptr;
+}
+
+template <typename T>
+int GeofenceEngine::UpdateAreaOf(std::string const& phone, T const& area) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto&                        terminal = terminals_[phone];
+    return MutableAreas(&terminal)->Insert(area);
+}
+
+int GeofenceEngine::UpdateArea(std::string const& phone, CircularArea const& area) {
+    return UpdateAreaOf(phone, area);
+}
+
+int GeofenceEngine::UpdateArea(std::string const& phone, RectangleArea const& area) {
+    return UpdateAreaOf(phone, area);
+}
+
+int GeofenceEngine::UpdateArea(std::string const& phone, PolygonArea const& area) {
+    return UpdateAreaOf(phone, area);
+}
+
+int GeofenceEngine::UpdateArea(std::string const& phone, Route const& route) {
+    return UpdateAreaOf(phone, route);
+}
+
+void GeofenceEngine::DeleteAreas(std::string const& phone, GeofenceAreaType const& type,
+                                 std::vector<uint32_t> const& ids) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto const                   it = terminals_.find(phone);
+    if (it == terminals_.end())
+        return;
+    auto&      terminal = it->second;
+    auto const areas    = MutableAreas(&terminal);
+    auto&      states   = terminal.states;
+    for (size_t i = 0; i < states.size();) {
+        auto const& area = areas->area(states[i].slot);
+        if (area.type == type && (ids.empty() || std::find(ids.begin(), ids.end(), area.area_id) != ids.end())) {
+            states[i] = states.back();
+            states.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+    if (ids.empty()) {
+        areas->Clear(type);
+        return;
+    }
+    for (auto const& id : ids)
+        areas->Erase(type, id);
+}
+
+void GeofenceEngine::RemoveTerminal(std::string const& phone) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    terminals_.erase(phone);
+}
+
+void GeofenceEngine::Clear(void) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    terminals_.clear();
+}
+
+size_t GeofenceEngine::size(void) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return terminals_.size();
+}
+
+int GeofenceEngine::Evaluate(std::string const& phone, LocationReportView const& report,
+                             std::vector<GeofenceEvent>* events) {
+    if (events == nullptr || !report.valid())
+        return -1;
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto                         it = terminals_.find(phone);
+    if (it == terminals_.end())
+        return 0;
+    StatusBit const status = report.status();
+    if (status.bit.positioning == 0)
+        return 0; // The location is not valid.
+    if (report.latitude() > 90000000 || report.longitude() > 180000000)
+        return 0; // Out of range, see PolygonEdges.
+    GeofenceEvent event;
+    event.latitude    = report.latitude();
+    event.longitude   = report.longitude();
+    event.speed       = report.speed();
+    event.drive_time  = 0;
+    event.inside_time = 0;
+    if (BcdTimeToEpoch(report.time().data, &event.time) != 0)
+        event.time = static_cast<int64_t>(::time(nullptr));
+    int32_t const  lat    = status.bit.sn_latitude ? -static_cast<int32_t>(event.latitude) : event.latitude;
+    int32_t const  lon    = status.bit.ew_longitude ? -static_cast<int32_t>(event.longitude) : event.longitude;
+    uint32_t const now    = static_cast<uint32_t>(event.time);
+    auto const&    areas  = *it->second.areas;
+    auto&          states = it->second.states;
+    int            count  = 0;
+    // Fill the area fields of the event.
+    auto const describe = [&](GeofenceAreas::Area const& area, AreaState const& state) {
+        event.area_type      = area.type;
+        event.area_id        = area.area_id;
+        event.area_attribute = area.attribute;
+        event.section_id     = state.section < area.sections.size() ? area.sections[state.section].section_id : 0;
+        event.drive_time     = 0;
+        event.inside_time    = 0;
+    };
+    hits_.clear();
+    areas.Query(lat, lon, &hits_);
+    // Areas outside their time window are ignored; report them in slot order.
+    size_t hit_count = 0;
+    for (size_t i = 0; i < hits_.size(); ++i) {
+        if (GeofenceInTimeWindow(areas.area(hits_[i].slot), event.time))
+            hits_[hit_count++] = hits_[i];
+    }
+    hits_.resize(hit_count);
+    std::sort(hits_.begin(), hits_.end(),
+              [](GeofenceAreas::Hit const& lhs, GeofenceAreas::Hit const& rhs) { return lhs.slot < rhs.slot; });
+    for (auto& state : states)
+        state.flags &= ~kStateHit;
+    for (auto const& hit : hits_) {
+        auto const state = FindState(&states, hit.slot);
+        if (state != nullptr)
+            state->flags |= kStateHit;
+    }
+    // Left areas, and areas no longer being entered.
+    for (size_t i = 0; i < states.size();) {
+        auto& state = states[i];
+        if ((state.flags & kStateHit) != 0) {
+            ++i;
+            continue;
+        }
+        if ((state.flags & kStateInside) != 0) {
+            if (state.pending++ == 0)
+                state.left = now;
+            if (state.pending < hysteresis_) {
+                ++i;
+                continue;
+            }
+            describe(areas.area(state.slot), state);
+            event.type        = kGeofenceExit;
+            event.inside_time = state.left - state.entered;
+            events->push_back(event);
+            ++count;
+        }
+        state = states.back();
+        states.pop_back();
+    }
+    // Entered areas, road sections and speeding.
+    for (auto const& hit : hits_) {
+        auto const& area  = areas.area(hit.slot);
+        auto        state = FindState(&states, hit.slot);
+        if (state == nullptr) {
+            states.push_back(AreaState {hit.slot, now, 0, now, 0, 0, kStateHit, 0});
+            state = &states.back();
+        }
+        if ((state->flags & kStateInside) == 0) {
+            if (++state->pending < hysteresis_)
+                continue;
+            state->flags        |= kStateInside;
+            state->pending       = 0;
+            state->section       = static_cast<uint16_t>(hit.section);
+            state->section_since = state->entered;
+            describe(area, *state);
+            event.type = kGeofenceEnter;
+            events->push_back(event);
+            ++count;
+        }
+        else if (area.type == kGeofenceRoute && state->section != hit.section) {
+            // Moved on to another road section, check the driving time of the previous one.
+            state->pending = 0;
+            if (state->section < area.sections.size()) {
+                auto const&    section = area.sections[state->section];
+                uint32_t const elapsed = now - state->section_since;
+                if (section.drive_time && (elapsed < section.min_drive_time || elapsed > section.max_drive_time)) {
+                    describe(area, *state);
+                    event.type = elapsed < section.min_drive_time ? kGeofenceDriveTimeShort : kGeofenceDriveTimeLong;
+                    event.drive_time = elapsed;
+                    events->push_back(event);
+                    ++count;
+                }
+            }
+            state->section          = static_cast<uint16_t>(hit.section);
+            state->section_since    = now;
+            state->flags           &= ~kStateOverspeedReported;
+            state->overspeed_since  = 0;
+        }
+        else {
+            state->pending = 0;
+        }
+        uint16_t max_speed      = area.max_speed;
+        uint8_t  overspeed_time = area.overspeed_time;
+        if (area.type == kGeofenceRoute) {
+            max_speed      = area.sections[state->section].max_speed;
+            overspeed_time = area.sections[state->section].overspeed_time;
+        }
+        if (max_speed == 0)
+            continue;
+        if (event.speed <= max_speed * 10) {
+            state->flags           &= ~kStateOverspeedReported;
+            state->overspeed_since  = 0;
+            continue;
+        }
+        if (state->overspeed_since == 0)
+            state->overspeed_since = now;
+        if ((state->flags & kStateOverspeedReported) == 0 && now - state->overspeed_since >= overspeed_time) {
+            state->flags |= kStateOverspeedReported;
+            describe(area, *state);
+            event.type = kGeofenceOverspeed;
+            events->push_back(event);
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace libjt808
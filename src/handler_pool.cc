@@ -0,0 +1,94 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  handler_pool.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 15:48:03
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/handler_pool.h"
+
+#include <chrono>
+
+namespace libjt808 {
+
+namespace {
+
+// Number of empty polls a worker spins before it starts sleeping.
+constexpr int kSpinPolls = 64;
+
+} // namespace
+
+int HandlerPool::Start(size_t const& threads, size_t const& capacity) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (running_.load() || threads == 0 || capacity == 0)
+        return -1;
+    workers_.clear();
+    for (size_t i = 0; i < threads; ++i)
+        workers_.emplace_back(new Worker(capacity));
+    running_.store(true);
+    for (auto& worker : workers_)
+        worker->thread = std::thread(&HandlerPool::WorkerHandler, this, worker.get());
+    return 0;
+}
+
+void HandlerPool::Stop(void) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_.load())
+        return;
+    running_.store(false);
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+void HandlerPool::Submit(uint64_t const& session, Task&& task) {
+    auto& queue = workers_[WorkerIndex(session)]->queue;
+    while (!queue.TryPush(std::move(task)))
+        std::this_thread::yield();
+}
+
+// Run the queued tasks until the pool is stopped and the queue is empty.
+void HandlerPool::WorkerHandler(Worker* worker) {
+    Task task;
+    int  idle = 0;
+    while (1) {
+        if (worker->queue.TryPop(&task)) {
+            task();
+            task = nullptr; // Release the captured state now rather than at the next task.
+            executed_.fetch_add(1, std::memory_order_relaxed);
+            idle = 0;
+            continue;
+        }
+        if (!running_.load())
+            break;
+        if (++idle < kSpinPolls)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+}
+
+} // namespace libjt808
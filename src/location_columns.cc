@@ -0,0 +1,118 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_columns.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 17:06:12
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/location_columns.h"
+
+#include "jt808/bcd.h"
+
+namespace libjt808 {
+
+namespace {
+
+// Append a location report body known to hold the basic information.
+void AppendPoint(ByteSpan const& body, LocationColumns* columns) {
+    uint8_t const* p = body.data;
+    columns->alarm.push_back(LoadBigEndian32(p));
+    columns->status.push_back(LoadBigEndian32(p + 4));
+    columns->latitude.push_back(LoadBigEndian32(p + 8));
+    columns->longitude.push_back(LoadBigEndian32(p + 12));
+    columns->altitude.push_back(LoadBigEndian16(p + 16));
+    columns->speed.push_back(LoadBigEndian16(p + 18));
+    columns->bearing.push_back(LoadBigEndian16(p + 20));
+    int64_t epoch = -1;
+    if (BcdTimeToEpoch(p + 22, &epoch) != 0)
+        epoch = -1;
+    columns->timestamp.push_back(epoch);
+    if (columns->extension_offset.empty())
+        columns->extension_offset.push_back(0);
+    columns->extension_pool.insert(columns->extension_pool.end(), p + kLocationBasicLength, body.end());
+    columns->extension_offset.push_back(static_cast<uint32_t>(columns->extension_pool.size()));
+}
+
+} // namespace
+
+void LocationColumns::clear(void) {
+    alarm.clear();
+    status.clear();
+    latitude.clear();
+    longitude.clear();
+    altitude.clear();
+    speed.clear();
+    bearing.clear();
+    timestamp.clear();
+    extension_offset.clear();
+    extension_pool.clear();
+}
+
+void LocationColumns::reserve(size_t const& points, size_t const& extension_bytes) {
+    alarm.reserve(points);
+    status.reserve(points);
+    latitude.reserve(points);
+    longitude.reserve(points);
+    altitude.reserve(points);
+    speed.reserve(points);
+    bearing.reserve(points);
+    timestamp.reserve(points);
+    extension_offset.reserve(points + 1);
+    extension_pool.reserve(extension_bytes);
+}
+
+int JT808LocationColumnsAppend(LocationReportView const& report, LocationColumns* columns) {
+    if (columns == nullptr || !report.valid())
+        return -1;
+    AppendPoint(report.body(), columns);
+    return 0;
+}
+
+int JT808BatchLocationDecode(ByteSpan const& body, LocationColumns* columns, uint8_t* data_type) {
+    BatchLocationReportView const batch(body);
+    if (columns == nullptr || !batch.valid())
+        return -1;
+    // Check every item and size the columns first, so nothing is appended for a malformed batch.
+    uint16_t const     count           = batch.count();
+    size_t             extension_bytes = 0;
+    LocationReportView report;
+    auto               cursor = batch.reports();
+    for (uint16_t i = 0; i < count; ++i) {
+        if (!cursor.Next(&report) || !report.valid())
+            return -1;
+        extension_bytes += report.body().size - kLocationBasicLength;
+    }
+    columns->reserve(columns->size() + count, columns->extension_pool.size() + extension_bytes);
+    cursor = batch.reports();
+    for (uint16_t i = 0; i < count; ++i) {
+        cursor.Next(&report);
+        AppendPoint(report.body(), columns);
+    }
+    if (data_type != nullptr)
+        *data_type = batch.data_type();
+    return 0;
+}
+
+} // namespace libjt808
@@ -0,0 +1,161 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_extensions.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 17:48:20
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/location_extensions.h"
+
+namespace libjt808 {
+
+size_t LocationExtensions::LowerBound(uint8_t const& id) const {
+    Entry const* entries = entries_.data();
+    size_t       count   = entries_.size();
+    // Items usually arrive in ID order, check the end first.
+    if (count == 0 || entries[count - 1].id < id)
+        return count;
+    size_t first = 0;
+    while (count > 0) {
+        size_t const half = count / 2;
+        if (entries[first + half].id < id) {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else {
+            count = half;
+        }
+    }
+    return first;
+}
+
+int LocationExtensions::Get(uint8_t const& id, ExtensionValue* value) const {
+    if (value == nullptr)
+        return -1;
+    size_t const index = LowerBound(id);
+    if (index >= entries_.size() || entries_.data()[index].id != id)
+        return -1;
+    *value = At(index).second;
+    return 0;
+}
+
+int LocationExtensions::GetU8(uint8_t const& id, uint8_t* value) const {
+    ExtensionValue item;
+    if (value == nullptr || Get(id, &item) != 0 || item.size() != 1)
+        return -1;
+    *value = item[0];
+    return 0;
+}
+
+int LocationExtensions::GetU16(uint8_t const& id, uint16_t* value) const {
+    ExtensionValue item;
+    if (value == nullptr || Get(id, &item) != 0 || item.size() != 2)
+        return -1;
+    *value = LoadBigEndian16(item.data());
+    return 0;
+}
+
+int LocationExtensions::GetU32(uint8_t const& id, uint32_t* value) const {
+    ExtensionValue item;
+    if (value == nullptr || Get(id, &item) != 0 || item.size() != 4)
+        return -1;
+    *value = LoadBigEndian32(item.data());
+    return 0;
+}
+
+int LocationExtensions::AssignWire(ByteSpan const& items) {
+    clear();
+    size_t pos    = 0;
+    bool   sorted = true;
+    while (pos + 2 <= items.size) { // Additional information length is at least 1.
+        size_t const len = items[pos + 1];
+        if (pos + 2 + len > items.size) {
+            clear();
+            return -1;
+        }
+        if (entries_.size() > 0 && entries_.data()[entries_.size() - 1].id >= items[pos])
+            sorted = false;
+        // The value offset in the copied block, the ID and length bytes stay in the pool unused.
+        Entry const entry = {items[pos], static_cast<uint8_t>(len), static_cast<uint16_t>(pos + 2)};
+        entries_.Insert(entries_.size(), &entry, 1);
+        pos += 2 + len;
+    }
+    if (sorted) {
+        pool_.Insert(0, items.data, pos);
+        return 0;
+    }
+    // Out of order or repeated IDs, insert the items one by one, a repeated ID keeps its last value.
+    entries_.clear();
+    for (pos = 0; pos + 2 <= items.size; pos += 2 + items[pos + 1])
+        Set(items[pos], items.data + pos + 2, items[pos + 1]);
+    return 0;
+}
+
+int LocationExtensions::Set(uint8_t const& id, uint8_t const* data, size_t const& len) {
+    if (len > 255 || (data == nullptr && len > 0))
+        return -1;
+    size_t const index = LowerBound(id);
+    Entry*       entry = nullptr;
+    int          delta = static_cast<int>(len);
+    if (index < entries_.size() && entries_.data()[index].id == id) {
+        entry = entries_.data() + index;
+        delta -= entry->len;
+        if (delta > 0)
+            pool_.Insert(entry->offset + entry->len, nullptr, static_cast<size_t>(delta));
+        else if (delta < 0)
+            pool_.Erase(entry->offset + len, static_cast<size_t>(-delta));
+    }
+    else {
+        Entry const item = {id, 0, static_cast<uint16_t>(index < entries_.size() ? entries_.data()[index].offset
+                                                                                  : pool_.size())};
+        entry = entries_.Insert(index, &item, 1);
+        pool_.Insert(item.offset, nullptr, len);
+    }
+    entry->len = static_cast<uint8_t>(len);
+    if (len > 0)
+        memcpy(pool_.data() + entry->offset, data, len);
+    // The values behind this one moved.
+    if (delta != 0) {
+        Entry* const entries = entries_.data();
+        for (size_t i = index + 1; i < entries_.size(); ++i)
+            entries[i].offset = static_cast<uint16_t>(entries[i].offset + delta);
+    }
+    return 0;
+}
+
+size_t LocationExtensions::erase(uint8_t const& id) {
+    size_t const index = LowerBound(id);
+    if (index >= entries_.size() || entries_.data()[index].id != id)
+        return 0;
+    Entry const entry = entries_.data()[index];
+    pool_.Erase(entry.offset, entry.len);
+    entries_.Erase(index, 1);
+    Entry* const entries = entries_.data();
+    for (size_t i = index; i < entries_.size(); ++i)
+        entries[i].offset = static_cast<uint16_t>(entries[i].offset - entry.len);
+    return 1;
+}
+
+} // namespace libjt808
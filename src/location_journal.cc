@@ -0,0 +1,243 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  location_journal.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 22:41:17
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+#include "jt808/location_journal.h"
+
+#include <string.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "jt808/util.h"
+
+namespace libjt808 {
+
+namespace {
+
+constexpr uint32_t kJournalMagic   = 0x4A383038; // "J808".
+constexpr uint32_t kJournalVersion = 1;
+
+// The records start after the header, at a cache line.
+constexpr size_t kHeaderSize = 64;
+
+// Length of the unused bytes at the end of the ring, never a record length.
+constexpr uint16_t kPaddingMarker = 0xFFFF;
+
+} // namespace
+
+// Written in place in the file, head and tail are logical positions of the records.
+struct LocationJournal::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity; // Bytes of the records.
+    uint64_t head;     // Oldest record.
+    uint64_t tail;     // After the newest record.
+};
+
+LocationJournal::LocationJournal() : base_(nullptr), map_size_(0), capacity_(0) {
+}
+
+LocationJournal::~LocationJournal() {
+    Close();
+}
+
+int LocationJournal::Open(std::string const& path, size_t const& capacity) {
+    static_assert(sizeof(Header) <= kHeaderSize, "journal header too large");
+    Close();
+#if defined(__linux__)
+    if (capacity < 256)
+        return -1;
+    int const fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return -1;
+    size_t const size = kHeaderSize + capacity;
+    struct stat  st;
+    bool const   fresh = fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != size;
+    if (fresh && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        return -1;
+    }
+    void* const addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return -1;
+    base_     = static_cast<uint8_t*>(addr);
+    map_size_ = size;
+    capacity_ = capacity;
+    if (fresh || !Recover())
+        Reset();
+    return 0;
+#else
+    (void)path;
+    return -1;
+#endif
+}
+
+void LocationJournal::Close(void) {
+    if (base_ == nullptr)
+        return;
+#if defined(__linux__)
+    munmap(base_, map_size_);
+#endif
+    base_     = nullptr;
+    map_size_ = 0;
+    capacity_ = 0;
+}
+
+bool LocationJournal::empty(void) const {
+    return base_ == nullptr || header()->head == header()->tail;
+}
+
+int LocationJournal::Append(uint8_t const* body, size_t const& len) {
+    size_t const need = 2 + len;
+    if (base_ == nullptr || body == nullptr || len == 0 || len >= kPaddingMarker || need > capacity_)
+        return -1;
+    Header* const hdr  = header();
+    size_t        room = 0;
+    size_t        pad  = 0;
+    while (1) {
+        room = capacity_ - hdr->tail % capacity_;
+        pad  = room < need ? room : 0;
+        if (hdr->head == hdr->tail && pad > 0) {
+            // Empty, start over at the beginning of the ring.
+            hdr->head = hdr->tail + pad;
+            hdr->tail = hdr->head;
+            continue;
+        }
+        if (capacity_ - (hdr->tail - hdr->head) >= pad + need)
+            break;
+        DropOldest();
+    }
+    // The tail moves once the record is written, a crash leaves at most a record that Recover() cuts off.
+    uint64_t tail = hdr->tail;
+    if (pad > 0) {
+        if (pad >= 2) {
+            records()[tail % capacity_]     = kPaddingMarker >> 8;
+            records()[tail % capacity_ + 1] = kPaddingMarker & 0xFF;
+        }
+        tail += pad;
+    }
+    uint8_t* const record = records() + tail % capacity_;
+    record[0]             = static_cast<uint8_t>(len >> 8);
+    record[1]             = static_cast<uint8_t>(len);
+    memcpy(record + 2, body, len);
+    hdr->tail = tail + need;
+    return 0;
+}
+
+size_t LocationJournal::Peek(size_t const& max_count, size_t const& max_bytes, std::vector<uint8_t>* items,
+                             uint64_t* next) const {
+    if (base_ == nullptr || items == nullptr)
+        return 0;
+    Header const* const hdr   = header();
+    uint64_t            pos   = hdr->head;
+    size_t              count = 0;
+    size_t              bytes = 0;
+    while (count < max_count && pos < hdr->tail) {
+        uint64_t const       record = SkipPadding(pos);
+        uint8_t const* const data   = records() + record % capacity_;
+        size_t const         len    = 2 + LoadBigEndian16(data);
+        if (count > 0 && bytes + len > max_bytes)
+            break;
+        items->insert(items->end(), data, data + len);
+        pos = record + len;
+        bytes += len;
+        ++count;
+    }
+    if (next != nullptr)
+        *next = pos;
+    return count;
+}
+
+void LocationJournal::Consume(uint64_t const& next) {
+    if (base_ == nullptr)
+        return;
+    Header* const hdr = header();
+    if (next > hdr->head)
+        hdr->head = next < hdr->tail ? next : hdr->tail;
+}
+
+int LocationJournal::Sync(void) {
+    if (base_ == nullptr)
+        return -1;
+#if defined(__linux__)
+    return msync(base_, map_size_, MS_SYNC) == 0 ? 0 : -1;
+#else
+    return -1;
+#endif
+}
+
+uint8_t* LocationJournal::records(void) const {
+    return base_ + kHeaderSize;
+}
+
+uint64_t LocationJournal::SkipPadding(uint64_t const& pos) const {
+    size_t const room = capacity_ - pos % capacity_;
+    if (room < 2 || LoadBigEndian16(records() + pos % capacity_) == kPaddingMarker)
+        return pos + room;
+    return pos;
+}
+
+void LocationJournal::DropOldest(void) {
+    Header* const  hdr = header();
+    uint64_t const pos = SkipPadding(hdr->head);
+    hdr->head          = pos + 2 + LoadBigEndian16(records() + pos % capacity_);
+}
+
+bool LocationJournal::Recover(void) {
+    Header* const hdr = header();
+    if (hdr->magic != kJournalMagic || hdr->version != kJournalVersion || hdr->capacity != capacity_ ||
+        hdr->head > hdr->tail || hdr->tail - hdr->head > capacity_)
+        return false;
+    uint64_t pos = hdr->head;
+    while (pos < hdr->tail) {
+        uint64_t const record = SkipPadding(pos);
+        if (record >= hdr->tail)
+            break;
+        size_t const len = LoadBigEndian16(records() + record % capacity_);
+        if (len == 0 || record % capacity_ + 2 + len > capacity_ || record + 2 + len > hdr->tail)
+            break;
+        pos = record + 2 + len;
+    }
+    hdr->tail = pos;
+    return true;
+}
+
+void LocationJournal::Reset(void) {
+    Header* const hdr = header();
+    hdr->magic        = kJournalMagic;
+    hdr->version      = kJournalVersion;
+    hdr->capacity     = capacity_;
+    hdr->head         = 0;
+    hdr->tail         = 0;
+}
+
+} // namespace libjt808
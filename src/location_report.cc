@@ -55,15 +55,24 @@ int SetOverSpeedAlarmBody(uint8_t const& location_type,
 int GetOverSpeedAlarmBody(std::vector<uint8_t> const& out,
                           uint8_t* location_type,
                           uint32_t* area_route_id) {
+  return GetOverSpeedAlarmBody(ByteSpan(out.data(), out.size()),
+                               location_type, area_route_id);
+}
+
+// 获得超速报警报警附加信息消息体.
+int GetOverSpeedAlarmBody(ByteSpan const& out,
+                          uint8_t* location_type,
+                          uint32_t* area_route_id) {
   if (location_type == nullptr || area_route_id == nullptr) return -1;
-  if (out.size() != 1 || out.size() != 5) return -1;
+  if (out.size != 1 && out.size != 5) return -1;
   *location_type = out[0];
-  if (*location_type != kOverSpeedAlarmNoSpecificLocation) {
-    if (out.size() != 5) return -1;
+  // 无特定位置时没有区域或路段ID.
+  if (*location_type == kOverSpeedAlarmNoSpecificLocation) {
+    *area_route_id = 0;
+    return 0;
   }
-  U32ToU8Array u32converter;
-  memcpy(u32converter.u8array, &(out[1]), 4);
-  *area_route_id = EndianSwap32(u32converter.u32val);
+  if (out.size != 5) return -1;
+  *area_route_id = LoadBigEndian32(out.data + 1);
   return 0;
 }
 
@@ -87,16 +96,42 @@ int GetAccessAreaAlarmBody(std::vector<uint8_t> const& out,
                            uint8_t* location_type,
                            uint32_t* area_route_id,
                            uint8_t* direction) {
+  return GetAccessAreaAlarmBody(ByteSpan(out.data(), out.size()),
+                                location_type, area_route_id, direction);
+}
+
+// 获得进出区域/路线报警附加信息消息体.
+int GetAccessAreaAlarmBody(ByteSpan const& out,
+                           uint8_t* location_type,
+                           uint32_t* area_route_id,
+                           uint8_t* direction) {
   if (location_type == nullptr ||
       area_route_id == nullptr ||
       direction == nullptr ||
-      out.size() != 6) return -1;
+      out.size != 6) return -1;
   *location_type = out[0];
-  U32ToU8Array u32converter;
-  memcpy(u32converter.u8array, &(out[1]), 4);
-  *area_route_id = EndianSwap32(u32converter.u32val);
+  *area_route_id = LoadBigEndian32(out.data + 1);
   *direction = out[5];
   return 0;
 }
 
+// 查找基础数据流附加信息(0xEA)的子项.
+int GetBasicDataFlowItem(ByteSpan const& flow,
+                         uint16_t const& id,
+                         ByteSpan* value) {
+  if (value == nullptr) return -1;
+  size_t pos = 0;
+  // 子项: ID(WORD)+长度(BYTE)+值.
+  while (pos + 3 <= flow.size) {
+    size_t const len = flow[pos + 2];
+    if (pos + 3 + len > flow.size) return -1;
+    if (LoadBigEndian16(flow.data + pos) == id) {
+      *value = ByteSpan(flow.data + pos + 3, len);
+      return 0;
+    }
+    pos += 3 + len;
+  }
+  return -1;
+}
+
 }  // namespace libjt808
@@ -0,0 +1,281 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  log.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 15:02:17
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/log.h"
+
+#include <stdarg.h>
+#include <time.h>
+
+namespace libjt808 {
+
+namespace {
+
+// Number of records the ring buffer holds.
+constexpr size_t kLogCapacity = 4096;
+
+// Longest sleep of the idle writer thread, in milliseconds.
+constexpr int kMaxIdleMs = 50;
+
+char const kLevelTags[] = {'D', 'I', 'W', 'E'};
+
+void AppendFormat(std::string* out, char const* format, ...) __attribute__((format(printf, 2, 3)));
+
+void AppendFormat(std::string* out, char const* format, ...) {
+    char    buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len > 0)
+        out->append(buf, static_cast<size_t>(len) < sizeof(buf) ? len : sizeof(buf) - 1);
+}
+
+// Text of a string or byte argument, bytes are written as "01 02 03".
+void ArgText(LogRecord const& record, LogArg const& arg, std::string* text) {
+    char const* data = record.text + arg.text.offset;
+    if (arg.type == kLogArgString) {
+        text->assign(data, arg.text.length);
+        return;
+    }
+    static char const kHex[] = "0123456789ABCDEF";
+    text->clear();
+    for (uint16_t i = 0; i < arg.text.length; ++i) {
+        uint8_t const uch = static_cast<uint8_t>(data[i]);
+        if (i > 0)
+            text->push_back(' ');
+        text->push_back(kHex[uch >> 4]);
+        text->push_back(kHex[uch & 0xF]);
+    }
+}
+
+// Format one conversion of the format string with the captured argument.
+// Args:
+//     spec:  Flags, width and precision of the conversion, without '%' and length modifiers.
+//     conversion:  Conversion character.
+void AppendArg(LogRecord const& record, LogArg const& arg, std::string const& spec, char const& conversion,
+               std::string* out) {
+    bool const  is_float = strchr("fFeEgGaA", conversion) != nullptr;
+    std::string fmt("%" + spec);
+    std::string text;
+    switch (arg.type) {
+        case kLogArgString:
+        case kLogArgBytes:
+            ArgText(record, arg, &text);
+            fmt += "s";
+            AppendFormat(out, fmt.c_str(), text.c_str());
+            return;
+        case kLogArgPointer:
+            AppendFormat(out, "%p", arg.p);
+            return;
+        case kLogArgDouble:
+            if (is_float) {
+                fmt += conversion;
+                AppendFormat(out, fmt.c_str(), arg.d);
+            }
+            else {
+                AppendFormat(out, "%g", arg.d);
+            }
+            return;
+        default:
+            break;
+    }
+    // Integers, the conversion picks the representation, the captured type the signedness.
+    if (is_float) {
+        fmt += conversion;
+        AppendFormat(out, fmt.c_str(), arg.type == kLogArgSigned ? static_cast<double>(arg.i)
+                                                                 : static_cast<double>(arg.u));
+    }
+    else if (conversion == 'c') {
+        fmt += "c";
+        AppendFormat(out, fmt.c_str(), static_cast<int>(arg.i));
+    }
+    else if (strchr("xXo", conversion) != nullptr) {
+        fmt += "ll";
+        fmt += conversion;
+        AppendFormat(out, fmt.c_str(), static_cast<unsigned long long>(arg.u));
+    }
+    else if (arg.type == kLogArgSigned) {
+        fmt += "lld";
+        AppendFormat(out, fmt.c_str(), static_cast<long long>(arg.i));
+    }
+    else {
+        fmt += "llu";
+        AppendFormat(out, fmt.c_str(), static_cast<unsigned long long>(arg.u));
+    }
+}
+
+} // namespace
+
+void LogFormatRecord(LogRecord const& record, std::string* out) {
+    time_t const sec = static_cast<time_t>(record.timestamp_us / 1000000);
+    struct tm    tm_buf;
+#if defined(_WIN32)
+    localtime_s(&tm_buf, &sec);
+#else
+    localtime_r(&sec, &tm_buf);
+#endif
+    char const* slash = strrchr(record.file, '/');
+    char const* file  = slash != nullptr ? slash + 1 : record.file;
+    char const  level = record.level < sizeof(kLevelTags) ? kLevelTags[record.level] : '?';
+    AppendFormat(out, "%04d-%02d-%02d %02d:%02d:%02d.%06u %c %s:%d] ", tm_buf.tm_year + 1900, tm_buf.tm_mon + 1,
+                 tm_buf.tm_mday, tm_buf.tm_hour, tm_buf.tm_min, tm_buf.tm_sec,
+                 static_cast<unsigned>(record.timestamp_us % 1000000), level, file, record.line);
+    size_t      arg = 0;
+    char const* p   = record.format;
+    while (*p != '\0') {
+        if (*p != '%') {
+            char const* next = strchr(p, '%');
+            size_t      len  = next != nullptr ? static_cast<size_t>(next - p) : strlen(p);
+            out->append(p, len);
+            p += len;
+            continue;
+        }
+        if (p[1] == '%') {
+            out->push_back('%');
+            p += 2;
+            continue;
+        }
+        // %[flags][width][.precision][length]conversion
+        char const* start = ++p;
+        while (*p != '\0' && strchr("-+ #0", *p) != nullptr)
+            ++p;
+        while (*p >= '0' && *p <= '9')
+            ++p;
+        if (*p == '.') {
+            ++p;
+            while (*p >= '0' && *p <= '9')
+                ++p;
+        }
+        std::string const spec(start, p);
+        while (*p != '\0' && strchr("hljztLq", *p) != nullptr)
+            ++p;
+        if (*p == '\0')
+            break;
+        char const conversion = *p++;
+        if (arg < record.arg_count)
+            AppendArg(record, record.args[arg++], spec, conversion, out);
+        else
+            out->append("<?>");
+    }
+    if (record.suppressed > 0)
+        AppendFormat(out, " (%u similar messages suppressed)", static_cast<unsigned>(record.suppressed));
+    out->push_back('\n');
+}
+
+Logger& Logger::Instance(void) {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : level_(kLogInfo),
+      running_(true),
+      pushed_(0),
+      written_(0),
+      dropped_(0),
+      ring_(new RingBuffer<LogRecord>(kLogCapacity)),
+      output_(stdout) {
+    writer_thread_ = std::thread(&Logger::WriterHandler, this);
+}
+
+Logger::~Logger() {
+    running_.store(false);
+    if (writer_thread_.joinable())
+        writer_thread_.join();
+    if (output_ != stdout)
+        fclose(output_);
+}
+
+int Logger::SetOutput(std::string const& path) {
+    FILE* output = stdout;
+    if (!path.empty()) {
+        output = fopen(path.c_str(), "a");
+        if (output == nullptr)
+            return -1;
+    }
+    std::unique_lock<std::mutex> lock(output_mutex_);
+    if (output_ != stdout)
+        fclose(output_);
+    output_ = output;
+    return 0;
+}
+
+void Logger::Flush(void) {
+    uint64_t const pushed = pushed_.load();
+    while (written_.load() < pushed)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::unique_lock<std::mutex> lock(output_mutex_);
+    fflush(output_);
+}
+
+void Logger::Push(LogRecord* record) {
+    if (ring_->TryPush(std::move(*record)))
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+    else
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Format and write the queued records, sleeping longer the longer the queue stays empty.
+void Logger::WriterHandler(void) {
+    LogRecord   record;
+    std::string line;
+    uint64_t    reported_drops = 0;
+    int         idle_ms        = 1;
+    while (1) {
+        size_t batch = 0;
+        {
+            std::unique_lock<std::mutex> lock(output_mutex_);
+            while (batch < 256 && ring_->TryPop(&record)) {
+                line.clear();
+                LogFormatRecord(record, &line);
+                fwrite(line.data(), 1, line.size(), output_);
+                ++batch;
+            }
+            uint64_t const drops = dropped_.load(std::memory_order_relaxed);
+            if (drops != reported_drops) {
+                fprintf(output_, "%llu log records dropped, the writer fell behind\n",
+                        static_cast<unsigned long long>(drops - reported_drops));
+                reported_drops = drops;
+            }
+            if (batch == 0)
+                fflush(output_);
+        }
+        written_.fetch_add(batch, std::memory_order_relaxed);
+        if (batch > 0) {
+            idle_ms = 1;
+            continue;
+        }
+        if (!running_.load())
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(idle_ms));
+        idle_ms = idle_ms * 2 < kMaxIdleMs ? idle_ms * 2 : kMaxIdleMs;
+    }
+}
+
+} // namespace libjt808
@@ -0,0 +1,317 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  metrics.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 14:21:36
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/time.h>
+#endif
+
+#include "jt808/log.h"
+#include "jt808/socket_util.h"
+
+namespace libjt808 {
+
+namespace {
+
+// Counters per cache line.
+constexpr size_t kCountersPerLine = 64 / sizeof(std::atomic<uint64_t>);
+
+// Histogram bucket bounds of the Prometheus export, in seconds.
+constexpr double kLatencyBounds[] = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                                     0.05,   0.1,     0.25,   0.5,   1,      2.5,   5,    10};
+
+char const* const kParseErrorNames[kParseErrorReasonCount] = {
+    "success", "invalid_frame", "checksum", "header", "unknown_msg_id", "body",
+};
+
+void AppendFormat(std::string* out, char const* format, ...) __attribute__((format(printf, 2, 3)));
+
+void AppendFormat(std::string* out, char const* format, ...) {
+    char    buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len > 0)
+        out->append(buf, static_cast<size_t>(len) < sizeof(buf) ? len : sizeof(buf) - 1);
+}
+
+void AppendHeader(std::string* out, char const* name, char const* type, char const* help) {
+    AppendFormat(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void AppendHistogram(std::string* out, char const* name, char const* help, HistogramSnapshot const& histogram) {
+    AppendHeader(out, name, "histogram", help);
+    size_t   index      = 0;
+    uint64_t cumulative = 0;
+    for (auto const& bound : kLatencyBounds) {
+        uint64_t const bound_us = static_cast<uint64_t>(bound * 1e6);
+        while (index < histogram.buckets.size() && MetricHistogram::BucketUpperBound(index) <= bound_us)
+            cumulative += histogram.buckets[index++];
+        AppendFormat(out, "%s_bucket{le=\"%g\"} %llu\n", name, bound, static_cast<unsigned long long>(cumulative));
+    }
+    AppendFormat(out, "%s_bucket{le=\"+Inf\"} %llu\n", name, static_cast<unsigned long long>(histogram.count));
+    AppendFormat(out, "%s_sum %.6f\n", name, histogram.sum / 1e6);
+    AppendFormat(out, "%s_count %llu\n", name, static_cast<unsigned long long>(histogram.count));
+}
+
+} // namespace
+
+constexpr size_t MetricHistogram::kSubBuckets;
+constexpr size_t MetricHistogram::kBucketCount;
+constexpr size_t JT808Metrics::kMessageSlots;
+
+CounterArray::CounterArray(size_t const& size)
+    : size_(size)
+    , stride_((size + kCountersPerLine - 1) / kCountersPerLine * kCountersPerLine)
+    , storage_(new std::atomic<uint64_t>[kMetricShards * stride_ + kCountersPerLine]) {
+    // Align shard 0 to a cache line, the stride keeps the other shards aligned.
+    auto const address = reinterpret_cast<uintptr_t>(storage_.get());
+    auto const offset  = (64 - address % 64) % 64 / sizeof(std::atomic<uint64_t>);
+    base_              = storage_.get() + offset;
+    for (size_t i = 0; i < kMetricShards * stride_ + kCountersPerLine; ++i)
+        storage_[i].store(0, std::memory_order_relaxed);
+}
+
+uint64_t CounterArray::Value(size_t const& index) const {
+    uint64_t value = 0;
+    for (size_t i = 0; i < kMetricShards; ++i)
+        value += base_[i * stride_ + index].load(std::memory_order_relaxed);
+    return value;
+}
+
+uint64_t HistogramSnapshot::Percentile(double const& percent) const {
+    if (count == 0)
+        return 0;
+    uint64_t const rank = static_cast<uint64_t>(count * percent / 100.0 + 0.5);
+    uint64_t       seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank && seen > 0)
+            return MetricHistogram::BucketUpperBound(i);
+    }
+    return MetricHistogram::BucketUpperBound(buckets.size() - 1);
+}
+
+void MetricHistogram::Snapshot(HistogramSnapshot* snapshot) const {
+    if (snapshot == nullptr)
+        return;
+    snapshot->buckets.resize(kBucketCount);
+    snapshot->count = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        snapshot->buckets[i] = counters_.Value(i);
+        snapshot->count += snapshot->buckets[i];
+    }
+    snapshot->sum = counters_.Value(kBucketCount);
+}
+
+JT808Metrics::JT808Metrics()
+    : slots_(new std::atomic<uint8_t>[65536])
+    , next_slot_(1)
+    , counters_(kCounterCount) {
+    for (size_t i = 0; i < 65536; ++i)
+        slots_[i].store(0, std::memory_order_relaxed);
+}
+
+size_t JT808Metrics::AssignMessageSlot(uint16_t const& msg_id) {
+    if (next_slot_.load(std::memory_order_relaxed) >= kMessageSlots)
+        return 0;
+    size_t const slot = next_slot_.fetch_add(1);
+    if (slot >= kMessageSlots)
+        return 0;
+    uint8_t expected = 0;
+    // Another thread assigned the message ID first, the reserved slot stays unused.
+    if (!slots_[msg_id].compare_exchange_strong(expected, static_cast<uint8_t>(slot)))
+        return expected;
+    return slot;
+}
+
+void JT808Metrics::Snapshot(MetricsSnapshot* snapshot) const {
+    if (snapshot == nullptr)
+        return;
+    snapshot->messages.clear();
+    for (size_t msg_id = 0; msg_id < 65536; ++msg_id) {
+        uint8_t const slot = slots_[msg_id].load(std::memory_order_relaxed);
+        if (slot == 0)
+            continue;
+        auto& message      = snapshot->messages[static_cast<uint16_t>(msg_id)];
+        message.frames_in  = counters_.Value(slot * 2);
+        message.frames_out = counters_.Value(slot * 2 + 1);
+    }
+    snapshot->other_messages.frames_in  = counters_.Value(0);
+    snapshot->other_messages.frames_out = counters_.Value(1);
+    snapshot->bytes_in                  = counters_.Value(kBytesIn);
+    snapshot->bytes_out                 = counters_.Value(kBytesOut);
+    for (size_t i = 0; i < kParseErrorReasonCount; ++i)
+        snapshot->parse_failures[i] = counters_.Value(kParseFailures + i);
+    snapshot->sessions_opened    = counters_.Value(kSessionsOpened);
+    snapshot->sessions_closed    = counters_.Value(kSessionsClosed);
+    snapshot->active_sessions    = static_cast<int64_t>(snapshot->sessions_opened - snapshot->sessions_closed);
+    snapshot->handshake_failures = counters_.Value(kHandshakeFailures);
+    handshake_latency_.Snapshot(&snapshot->handshake_latency_us);
+    ack_latency_.Snapshot(&snapshot->ack_latency_us);
+}
+
+void FormatPrometheusText(MetricsSnapshot const& snapshot, std::string* out) {
+    if (out == nullptr)
+        return;
+    out->clear();
+    AppendHeader(out, "jt808_frames_received_total", "counter", "Frames received from terminals by message ID.");
+    for (auto const& item : snapshot.messages) {
+        if (item.second.frames_in == 0)
+            continue;
+        AppendFormat(out, "jt808_frames_received_total{msg_id=\"0x%04X\"} %llu\n", item.first,
+                     static_cast<unsigned long long>(item.second.frames_in));
+    }
+    AppendFormat(out, "jt808_frames_received_total{msg_id=\"other\"} %llu\n",
+                 static_cast<unsigned long long>(snapshot.other_messages.frames_in));
+    AppendHeader(out, "jt808_frames_sent_total", "counter", "Frames sent to terminals by message ID.");
+    for (auto const& item : snapshot.messages) {
+        if (item.second.frames_out == 0)
+            continue;
+        AppendFormat(out, "jt808_frames_sent_total{msg_id=\"0x%04X\"} %llu\n", item.first,
+                     static_cast<unsigned long long>(item.second.frames_out));
+    }
+    AppendFormat(out, "jt808_frames_sent_total{msg_id=\"other\"} %llu\n",
+                 static_cast<unsigned long long>(snapshot.other_messages.frames_out));
+    AppendHeader(out, "jt808_received_bytes_total", "counter", "Bytes received from terminals.");
+    AppendFormat(out, "jt808_received_bytes_total %llu\n", static_cast<unsigned long long>(snapshot.bytes_in));
+    AppendHeader(out, "jt808_sent_bytes_total", "counter", "Bytes sent to terminals.");
+    AppendFormat(out, "jt808_sent_bytes_total %llu\n", static_cast<unsigned long long>(snapshot.bytes_out));
+    AppendHeader(out, "jt808_parse_failures_total", "counter", "Frames that failed to parse by reason.");
+    for (size_t i = kParseInvalidFrame; i < kParseErrorReasonCount; ++i) {
+        AppendFormat(out, "jt808_parse_failures_total{reason=\"%s\"} %llu\n", kParseErrorNames[i],
+                     static_cast<unsigned long long>(snapshot.parse_failures[i]));
+    }
+    AppendHeader(out, "jt808_sessions_opened_total", "counter", "Authenticated terminal sessions.");
+    AppendFormat(out, "jt808_sessions_opened_total %llu\n", static_cast<unsigned long long>(snapshot.sessions_opened));
+    AppendHeader(out, "jt808_active_sessions", "gauge", "Authenticated terminal sessions currently connected.");
+    AppendFormat(out, "jt808_active_sessions %lld\n", static_cast<long long>(snapshot.active_sessions));
+    AppendHeader(out, "jt808_handshake_failures_total", "counter", "Connections that failed register or authentication.");
+    AppendFormat(out, "jt808_handshake_failures_total %llu\n",
+                 static_cast<unsigned long long>(snapshot.handshake_failures));
+    AppendHistogram(out, "jt808_handshake_latency_seconds", "Time from accept to authentication success.",
+                    snapshot.handshake_latency_us);
+    AppendHistogram(out, "jt808_ack_latency_seconds", "Time from a platform command to the terminal general response.",
+                    snapshot.ack_latency_us);
+}
+
+int MetricsExporter::Start(JT808Metrics const* metrics, std::string const& ip, int const& port) {
+    if (metrics == nullptr || is_running_)
+        return -1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(static_cast<uint16_t>(port));
+#if defined(__linux__)
+    addr.sin_addr.s_addr = inet_addr(ip.c_str());
+    listen_              = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_ < 0)
+        return -1;
+    int on = 1;
+    setsockopt(listen_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#elif defined(_WIN32)
+    addr.sin_addr.S_un.S_addr = inet_addr(ip.c_str());
+    listen_                   = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listen_ == INVALID_SOCKET)
+        return -1;
+#endif
+    if (Bind(listen_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1 || Listen(listen_, 16) == -1) {
+        JT808_LOG_ERROR("Bind metrics port %d failed!!!", port);
+        Close(listen_);
+        return -1;
+    }
+    metrics_ = metrics;
+    is_running_.store(true);
+    thread_ = std::thread(&MetricsExporter::ServeHandler, this);
+    return 0;
+}
+
+void MetricsExporter::Stop(void) {
+    if (!is_running_)
+        return;
+    is_running_.store(false);
+    // Wake up the blocking accept().
+#if defined(__linux__)
+    shutdown(listen_, SHUT_RDWR);
+#elif defined(_WIN32)
+    shutdown(listen_, SD_BOTH);
+#endif
+    Close(listen_);
+    if (thread_.joinable())
+        thread_.join();
+}
+
+// Every connection gets the current metrics, whatever the request path.
+void MetricsExporter::ServeHandler(void) {
+    MetricsSnapshot    snapshot;
+    std::string        body;
+    std::string        response;
+    char               request[1024];
+    struct sockaddr_in addr;
+    while (is_running_) {
+        int  len    = sizeof(addr);
+        auto client = Accept(listen_, reinterpret_cast<struct sockaddr*>(&addr), &len);
+        if (client < 0)
+            break;
+        // Do not let a silent client block the exporter.
+#if defined(__linux__)
+        struct timeval timeout = {1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#elif defined(_WIN32)
+        DWORD timeout = 1000;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char const*>(&timeout), sizeof(timeout));
+#endif
+        Recv(client, request, sizeof(request), 0);
+        metrics_->Snapshot(&snapshot);
+        FormatPrometheusText(snapshot, &body);
+        response.clear();
+        AppendFormat(&response,
+                     "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n"
+                     "Connection: close\r\n\r\n",
+                     body.size());
+        response.append(body);
+        size_t sent = 0;
+        while (sent < response.size()) {
+            int ret = Send(client, response.data() + sent, static_cast<int>(response.size() - sent), 0);
+            if (ret <= 0)
+                break;
+            sent += ret;
+        }
+        Close(client);
+    }
+}
+
+} // namespace libjt808
@@ -0,0 +1,158 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  outbound_queue.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 21:06:42
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+#include "jt808/outbound_queue.h"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace libjt808 {
+
+namespace {
+
+// Frames each priority holds; reports may pile up while the link is slow, bulk frames are fill packet answers.
+constexpr size_t kCapacities[kOutboundPriorityCount] = {128, 1024, 256};
+
+// Polling interval of Wait() without eventfd, ms.
+constexpr int kPollMsec = 10;
+
+} // namespace
+
+OutboundQueue::OutboundQueue() : size_(0), dropped_(0), waiting_(false), event_fd_(-1) {
+    for (int i = 0; i < kOutboundPriorityCount; ++i) {
+        rings_[i].reset(new FrameRing(kCapacities[i]));
+        overflow_size_[i].store(0);
+    }
+#if defined(__linux__)
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+OutboundQueue::~OutboundQueue() {
+#if defined(__linux__)
+    if (event_fd_ >= 0)
+        close(event_fd_);
+#endif
+}
+
+bool OutboundQueue::Push(OutboundPriority const& priority, std::vector<uint8_t>&& frame) {
+    auto& ring    = *rings_[priority];
+    bool  dropped = false;
+    if (priority == kOutboundReport) {
+        std::vector<uint8_t> oldest;
+        while (!ring.TryPush(std::move(frame))) {
+            // The ring is multi-consumer safe, so a producer may drop the oldest frame itself.
+            if (ring.TryPop(&oldest)) {
+                size_.fetch_sub(1);
+                dropped_.fetch_add(1);
+                dropped = true;
+            }
+        }
+    }
+    else if (overflow_size_[priority].load() != 0 || !ring.TryPush(std::move(frame))) {
+        // Once a frame overflowed, the later ones follow it until the consumer drained the list, keeping the order.
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        overflow_[priority].push_back(std::move(frame));
+        overflow_size_[priority].fetch_add(1);
+    }
+    // Pairs with Wait(): either the consumer sees the new size, or this sees it waiting.
+    size_.fetch_add(1);
+    if (waiting_.load())
+        Notify();
+    return !dropped;
+}
+
+void OutboundQueue::Notify(void) {
+#if defined(__linux__)
+    if (event_fd_ >= 0) {
+        uint64_t const one = 1;
+        ssize_t const  ret = write(event_fd_, &one, sizeof(one));
+        (void)ret; // The counter is already set if it would overflow.
+    }
+#endif
+}
+
+bool OutboundQueue::Pop(std::vector<uint8_t>* frame) {
+    if (frame == nullptr || empty())
+        return false;
+    for (int i = 0; i < kOutboundPriorityCount; ++i) {
+        if (rings_[i]->TryPop(frame)) {
+            size_.fetch_sub(1);
+            return true;
+        }
+        if (overflow_size_[i].load() != 0) {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            *frame = std::move(overflow_[i].front());
+            overflow_[i].pop_front();
+            overflow_size_[i].fetch_sub(1);
+            size_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OutboundQueue::Wait(int const& timeout_msec) {
+    if (!empty())
+        return true;
+#if defined(__linux__)
+    if (event_fd_ >= 0) {
+        waiting_.store(true);
+        if (empty()) {
+            struct pollfd pfd;
+            pfd.fd      = event_fd_;
+            pfd.events  = POLLIN;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, timeout_msec) > 0) {
+                uint64_t      count;
+                ssize_t const ret = read(event_fd_, &count, sizeof(count));
+                (void)ret;
+            }
+        }
+        waiting_.store(false);
+        return !empty();
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeout_msec, kPollMsec)));
+    return !empty();
+}
+
+void OutboundQueue::Clear(void) {
+    std::vector<uint8_t> frame;
+    while (Pop(&frame)) {
+    }
+}
+
+} // namespace libjt808
@@ -29,6 +29,8 @@
 
 #include "jt808/packager.h"
 
+#include <math.h>
+
 #include "jt808/bcd.h"
 #include "jt808/util.h"
 
@@ -98,6 +100,146 @@ int JT808MsgEscape(std::vector<uint8_t>* out) {
     return 0;
 }
 
+// 转义后追加到输出.
+void JT808AppendEscaped(uint8_t const* in, size_t const& len, std::vector<uint8_t>* out) {
+    for (size_t i = 0; i < len; ++i) {
+        if (in[i] == PROTOCOL_SIGN) {
+            out->push_back(PROTOCOL_ESCAPE);
+            out->push_back(PROTOCOL_ESCAPE_SIGN);
+        }
+        else if (in[i] == PROTOCOL_ESCAPE) {
+            out->push_back(PROTOCOL_ESCAPE);
+            out->push_back(PROTOCOL_ESCAPE_ESCAPE);
+        }
+        else {
+            out->push_back(in[i]);
+        }
+    }
+}
+
+// 封装位置基本信息及位置附加信息项, 0x0200/0x0201/0x0704共用.
+// 返回封装的长度.
+int JT808LocationBodyPackage(LocationBasicInformation const& basic_info, LocationExtensions const& extension_info,
+                             std::vector<uint8_t>* out) {
+    int          msg_len = 28;
+    U32ToU8Array u32converter;
+    // 报警标志.
+    u32converter.u32val = EndianSwap32(basic_info.alarm.value);
+    for (int i = 0; i < 4; ++i)
+        out->push_back(u32converter.u8array[i]);
+    // 状态.
+    u32converter.u32val = EndianSwap32(basic_info.status.value);
+    for (int i = 0; i < 4; ++i)
+        out->push_back(u32converter.u8array[i]);
+    // 纬度.
+    u32converter.u32val = EndianSwap32(basic_info.latitude);
+    for (int i = 0; i < 4; ++i)
+        out->push_back(u32converter.u8array[i]);
+    // 经度.
+    u32converter.u32val = EndianSwap32(basic_info.longitude);
+    for (int i = 0; i < 4; ++i)
+        out->push_back(u32converter.u8array[i]);
+    U16ToU8Array u16converter;
+    // 海拔高程.
+    u16converter.u16val = EndianSwap16(basic_info.altitude);
+    for (int i = 0; i < 2; ++i)
+        out->push_back(u16converter.u8array[i]);
+    // 速度.
+    u16converter.u16val = EndianSwap16(basic_info.speed);
+    for (int i = 0; i < 2; ++i)
+        out->push_back(u16converter.u8array[i]);
+    // 方向.
+    u16converter.u16val = EndianSwap16(basic_info.bearing);
+    for (int i = 0; i < 2; ++i)
+        out->push_back(u16converter.u8array[i]);
+    // UTC时间(BCD-8421码).
+    out->insert(out->end(), basic_info.time.bcd, basic_info.time.bcd + sizeof(basic_info.time.bcd));
+    // 位置附加信息项, 按ID升序排列, 自定义信息项在最后.
+    size_t length = 0;
+    for (auto const& item : extension_info) {
+        if (item.first < kCustomInformationLength) {
+            out->push_back(item.first);
+            out->push_back(item.second.size());
+            out->insert(out->end(), item.second.begin(), item.second.end());
+            msg_len += 2 + item.second.size();
+        }
+        else if (item.first > kCustomInformationLength) {
+            length += 2 + item.second.size();
+        }
+    }
+    // 后续自定义信息长度, 没有自定义信息时不封装.
+    if (length >= 256) {
+        out->push_back(kCustomInformationLength);
+        out->push_back(2);
+        out->push_back(length % 65536 / 256);
+        out->push_back(length % 256);
+        msg_len += 4;
+    }
+    else if (length > 0) {
+        out->push_back(kCustomInformationLength);
+        out->push_back(1);
+        out->push_back(length % 256);
+        msg_len += 3;
+    }
+    for (auto it = extension_info.lower_bound(kCustomInformationLength + 1); it != extension_info.end(); ++it) {
+        out->push_back(it->first);
+        out->push_back(it->second.size());
+        out->insert(out->end(), it->second.begin(), it->second.end());
+    }
+    msg_len += length;
+    return msg_len;
+}
+
+// 封装大端 WORD.
+void PackageU16(uint16_t const& value, std::vector<uint8_t>* out) {
+    out->push_back(static_cast<uint8_t>(value >> 8));
+    out->push_back(static_cast<uint8_t>(value));
+}
+
+// 封装大端 DWORD.
+void PackageU32(uint32_t const& value, std::vector<uint8_t>* out) {
+    out->push_back(static_cast<uint8_t>(value >> 24));
+    out->push_back(static_cast<uint8_t>(value >> 16));
+    out->push_back(static_cast<uint8_t>(value >> 8));
+    out->push_back(static_cast<uint8_t>(value));
+}
+
+// 封装经纬度, 以度为单位的值乘以 10 的 6 次方, 南纬/西经由属性标明.
+void PackageDegree(double const& degree, std::vector<uint8_t>* out) {
+    PackageU32(static_cast<uint32_t>(llround(fabs(degree) * 1e6)), out);
+}
+
+// 封装"YYMMDDhhmmss"格式时间, BCD[6], 不足的部分补0.
+void PackageBcdTime(std::string const& time, std::vector<uint8_t>* out) {
+    std::vector<uint8_t> bcd;
+    StringToBcd(time, &bcd);
+    bcd.resize(6, 0);
+    out->insert(out->end(), bcd.begin(), bcd.end());
+}
+
+// 封装圆形/矩形区域的时间范围与限速, 根据区域属性决定是否存在.
+void PackageAreaLimits(AreaAttribute const& attribute, std::string const& start_time, std::string const& stop_time,
+                       uint16_t const& max_speed, uint8_t const& overspeed_time, std::vector<uint8_t>* out) {
+    if (attribute.bit.by_time) {
+        PackageBcdTime(start_time, out);
+        PackageBcdTime(stop_time, out);
+    }
+    if (attribute.bit.speed_limit) {
+        PackageU16(max_speed, out);
+        out->push_back(overspeed_time);
+    }
+}
+
+// 封装 0x8601/0x8603/0x8607 需要删除的区域或路线ID, 个数为0时删除全部.
+int PackageDeleteIds(std::vector<uint32_t> const& ids, std::vector<uint8_t>* out) {
+    if (out == nullptr || ids.size() > 125)
+        return -1;
+    out->push_back(static_cast<uint8_t>(ids.size()));
+    for (auto const& id : ids)
+        PackageU32(id, out);
+    return static_cast<int>(1 + ids.size() * 4);
+}
+
 } // namespace
 
 // 命令封装器初始化.
@@ -424,82 +566,7 @@ int JT808FramePackagerInit(Packager* packager) {
         kLocationReport, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
             if (out == nullptr)
                 return -1;
-            int          msg_len        = 28;
-            auto&        basic_info     = para.location_info;
-            auto&        extension_info = para.location_extension;
-            U32ToU8Array u32converter;
-            // 报警标志.
-            u32converter.u32val = EndianSwap32(basic_info.alarm.value);
-            for (int i = 0; i < 4; ++i)
-                out->push_back(u32converter.u8array[i]);
-            // 状态.
-            u32converter.u32val = EndianSwap32(basic_info.status.value);
-            for (int i = 0; i < 4; ++i)
-                out->push_back(u32converter.u8array[i]);
-            // 纬度.
-            u32converter.u32val = EndianSwap32(basic_info.latitude);
-            for (int i = 0; i < 4; ++i)
-                out->push_back(u32converter.u8array[i]);
-            // 经度.
-            u32converter.u32val = EndianSwap32(basic_info.longitude);
-            for (int i = 0; i < 4; ++i)
-                out->push_back(u32converter.u8array[i]);
-            U16ToU8Array u16converter;
-            // 海拔高程.
-            u16converter.u16val = EndianSwap16(basic_info.altitude);
-            for (int i = 0; i < 2; ++i)
-                out->push_back(u16converter.u8array[i]);
-            // 速度.
-            u16converter.u16val = EndianSwap16(basic_info.speed);
-            for (int i = 0; i < 2; ++i)
-                out->push_back(u16converter.u8array[i]);
-            // 方向.
-            u16converter.u16val = EndianSwap16(basic_info.bearing);
-            for (int i = 0; i < 2; ++i)
-                out->push_back(u16converter.u8array[i]);
-            std::vector<uint8_t> bcd;
-            // UTC时间(BCD-8421码).
-            StringToBcd(basic_info.time, &bcd);
-            for (auto const& uch : bcd)
-                out->push_back(uch);
-            std::vector<uint8_t> extension_custom;
-            // 位置附加信息项.
-            for (auto const& item : extension_info) {
-                if (item.first <= kCustomInformationLength) {
-                    out->push_back(item.first);
-                    if (item.first == kCustomInformationLength)
-                        continue;
-                    out->push_back(item.second.size());
-                    msg_len += 2 + item.second.size();
-                    for (auto const& uch : item.second)
-                        out->push_back(uch);
-                }
-                else if (item.first > kCustomInformationLength) {
-                    extension_custom.push_back(item.first);
-                    extension_custom.push_back(item.second.size());
-                    for (auto const& uch : item.second)
-                        extension_custom.push_back(uch);
-                }
-            }
-            auto const& length = extension_custom.size();
-            if (length >= 256) {
-                out->push_back(2);
-                out->push_back(length % 65536 / 256);
-                out->push_back(length % 256);
-                msg_len += 4;
-            }
-            else if (length > 0) {
-                out->push_back(1);
-                out->push_back(length % 256);
-                msg_len += 3;
-            }
-            else { // 没有后续自定义信息.
-                out->pop_back();
-            }
-            for (auto const& uch : extension_custom)
-                out->push_back(uch);
-            msg_len += length;
-            return msg_len;
+            return JT808LocationBodyPackage(para.location_info, para.location_extension, out);
         }));
     // 0x8201, 位置信息查询.
     packager->insert(std::pair<uint16_t, PackageHandler>(kGetLocationInformation,
@@ -514,87 +581,13 @@ int JT808FramePackagerInit(Packager* packager) {
         kGetLocationInformationResponse, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
             if (out == nullptr)
                 return -1;
-            int          msg_len = 30;
             U16ToU8Array u16converter;
             // 应答消息流水号.
             u16converter.u16val = EndianSwap16(para.parse.msg_head.msg_flow_num);
             for (int i = 0; i < 2; ++i)
                 out->push_back(u16converter.u8array[i]);
             // 以下为位置信息汇报内容.
-            auto&        basic_info     = para.location_info;
-            auto&        extension_info = para.location_extension;
-            U32ToU8Array u32converter;
-            // 报警标志.
-            u32converter.u32val = EndianSwap32(basic_info.alarm.value);
-            for (int i = 0; i < 4; ++i)
-                out->push_back(u32converter.u8array[i]);
-            // 状态.
-            u32converter.u32val = EndianSwap32(basic_info.status.value);
-            for (int i = 0; i < 4; ++i)
-                out->push_back(u32converter.u8array[i]);
-            // 纬度.
-            u32converter.u32val = EndianSwap32(basic_info.latitude);
-            for (int i = 0; i < 4; ++i)
-                out->push_back(u32converter.u8array[i]);
-            // 经度.
-            u32converter.u32val = EndianSwap32(basic_info.longitude);
-            for (int i = 0; i < 4; ++i)
-                out->push_back(u32converter.u8array[i]);
-            // 海拔高程.
-            u16converter.u16val = EndianSwap16(basic_info.altitude);
-            for (int i = 0; i < 2; ++i)
-                out->push_back(u16converter.u8array[i]);
-            // 速度.
-            u16converter.u16val = EndianSwap16(basic_info.speed);
-            for (int i = 0; i < 2; ++i)
-                out->push_back(u16converter.u8array[i]);
-            // 方向.
-            u16converter.u16val = EndianSwap16(basic_info.bearing);
-            for (int i = 0; i < 2; ++i)
-                out->push_back(u16converter.u8array[i]);
-            std::vector<uint8_t> bcd;
-            // UTC时间(BCD-8421码).
-            StringToBcd(basic_info.time, &bcd);
-            for (auto const& uch : bcd)
-                out->push_back(uch);
-            std::vector<uint8_t> extension_custom;
-            // 位置附加信息项.
-            for (auto const& item : extension_info) {
-                if (item.first <= kCustomInformationLength) {
-                    out->push_back(item.first);
-                    if (item.first == kCustomInformationLength)
-                        continue;
-                    out->push_back(item.second.size());
-                    msg_len += 2 + item.second.size();
-                    for (auto const& uch : item.second)
-                        out->push_back(uch);
-                }
-                else if (item.first > kCustomInformationLength) {
-                    extension_custom.push_back(item.first);
-                    extension_custom.push_back(item.second.size());
-                    for (auto const& uch : item.second)
-                        extension_custom.push_back(uch);
-                }
-            }
-            auto const& length = extension_custom.size();
-            if (length >= 256) {
-                out->push_back(2);
-                out->push_back(length % 65536 / 256);
-                out->push_back(length % 256);
-                msg_len += 4;
-            }
-            else if (length > 0) {
-                out->push_back(1);
-                out->push_back(length % 256);
-                msg_len += 3;
-            }
-            else { // 没有后续自定义信息.
-                out->pop_back();
-            }
-            for (auto const& uch : extension_custom)
-                out->push_back(uch);
-            msg_len += length;
-            return msg_len;
+            return 2 + JT808LocationBodyPackage(para.location_info, para.location_extension, out);
         }));
     // 0x8202, 临时位置跟踪控制.
     packager->insert(std::pair<uint16_t, PackageHandler>(
@@ -614,6 +607,67 @@ int JT808FramePackagerInit(Packager* packager) {
                 out->push_back(u32converter.u8array[i]);
             return msg_len;
         }));
+    // 0x8600, 设置圆形区域.
+    packager->insert(std::pair<uint16_t, PackageHandler>(
+        kSetCircularArea, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
+            if (out == nullptr || para.circular_areas.size() > 255)
+                return -1;
+            size_t const begin = out->size();
+            // 设置属性, 区域总数.
+            out->push_back(para.area_setting_type);
+            out->push_back(static_cast<uint8_t>(para.circular_areas.size()));
+            for (auto const& item : para.circular_areas) {
+                auto const& area = item.second;
+                // 区域ID, 区域属性, 中心点纬度, 中心点经度, 半径.
+                PackageU32(area.area_id, out);
+                PackageU16(area.area_attribute.value, out);
+                PackageDegree(area.center.latitude, out);
+                PackageDegree(area.center.longitude, out);
+                PackageU32(area.radius, out);
+                PackageAreaLimits(area.area_attribute, area.start_time, area.stop_time, area.max_speed,
+                                  area.overspeed_time, out);
+            }
+            // 消息体超过10位消息长度时需分包发送, 此处不支持.
+            if (out->size() - begin > kMaxMsgBodyLength)
+                return -1;
+            return static_cast<int>(out->size() - begin);
+        }));
+    // 0x8601, 删除圆形区域.
+    packager->insert(std::pair<uint16_t, PackageHandler>(
+        kDeleteCircularArea, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
+            return PackageDeleteIds(para.circular_area_id, out);
+        }));
+    // 0x8602, 设置矩形区域.
+    packager->insert(std::pair<uint16_t, PackageHandler>(
+        kSetRectangleArea, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
+            if (out == nullptr || para.rectangle_areas.size() > 255)
+                return -1;
+            size_t const begin = out->size();
+            // 设置属性, 区域总数.
+            out->push_back(para.area_setting_type);
+            out->push_back(static_cast<uint8_t>(para.rectangle_areas.size()));
+            for (auto const& item : para.rectangle_areas) {
+                auto const& area = item.second;
+                // 区域ID, 区域属性, 左上点纬度, 左上点经度, 右下点纬度, 右下点经度.
+                PackageU32(area.area_id, out);
+                PackageU16(area.area_attribute.value, out);
+                PackageDegree(area.upper_left.latitude, out);
+                PackageDegree(area.upper_left.longitude, out);
+                PackageDegree(area.lower_right.latitude, out);
+                PackageDegree(area.lower_right.longitude, out);
+                PackageAreaLimits(area.area_attribute, area.start_time, area.stop_time, area.max_speed,
+                                  area.overspeed_time, out);
+            }
+            // 消息体超过10位消息长度时需分包发送, 此处不支持.
+            if (out->size() - begin > kMaxMsgBodyLength)
+                return -1;
+            return static_cast<int>(out->size() - begin);
+        }));
+    // 0x8603, 删除矩形区域.
+    packager->insert(std::pair<uint16_t, PackageHandler>(
+        kDeleteRectangleArea, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
+            return PackageDeleteIds(para.rectangle_area_id, out);
+        }));
     // 0x8604, 设置多边形区域.
     packager->insert(std::pair<uint16_t, PackageHandler>(
         kSetPolygonArea, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
@@ -668,6 +722,9 @@ int JT808FramePackagerInit(Packager* packager) {
                     out->push_back(u32converter.u8array[3 - i]);
                 msg_len += 8;
             }
+            // 消息体超过10位消息长度时需分包发送, 此处不支持.
+            if (msg_len > kMaxMsgBodyLength)
+                return -1;
             return msg_len;
         }));
     // 0x8605, 删除多边形区域.
@@ -690,6 +747,52 @@ int JT808FramePackagerInit(Packager* packager) {
                                                              }
                                                              return msg_len;
                                                          }));
+    // 0x8606, 设置路线.
+    packager->insert(std::pair<uint16_t, PackageHandler>(
+        kSetRoute, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
+            auto const& route = para.route;
+            if (out == nullptr || route.inflection_points.size() > 0xFFFF)
+                return -1;
+            size_t const begin = out->size();
+            // 路线ID, 路线属性.
+            PackageU32(route.route_id, out);
+            PackageU16(route.route_attribute.value, out);
+            // 起始时间, 结束时间, 在路线属性中相关标志位为1时才启用.
+            if (route.route_attribute.bit.by_time) {
+                PackageBcdTime(route.start_time, out);
+                PackageBcdTime(route.stop_time, out);
+            }
+            // 路线总拐点数.
+            PackageU16(static_cast<uint16_t>(route.inflection_points.size()), out);
+            for (auto const& point : route.inflection_points) {
+                // 拐点ID, 路段ID, 拐点纬度, 拐点经度, 路段宽度, 路段属性.
+                PackageU32(point.inflection_point_id, out);
+                PackageU32(point.section_id, out);
+                PackageDegree(point.point.latitude, out);
+                PackageDegree(point.point.longitude, out);
+                out->push_back(point.section_width);
+                out->push_back(point.section_attribute.value);
+                // 路段行驶过长/不足阈值, 在路段属性中相关标志位为1时才启用.
+                if (point.section_attribute.bit.drive_time) {
+                    PackageU16(point.max_drive_time, out);
+                    PackageU16(point.min_drive_time, out);
+                }
+                // 路段最高速度, 路段超速持续时间, 在路段属性中相关标志位为1时才启用.
+                if (point.section_attribute.bit.speed_limit) {
+                    PackageU16(point.max_speed, out);
+                    out->push_back(point.overspeed_time);
+                }
+            }
+            // 消息体超过10位消息长度时需分包发送, 此处不支持.
+            if (out->size() - begin > kMaxMsgBodyLength)
+                return -1;
+            return static_cast<int>(out->size() - begin);
+        }));
+    // 0x8607, 删除路线.
+    packager->insert(std::pair<uint16_t, PackageHandler>(
+        kDeleteRoute, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
+            return PackageDeleteIds(para.route_id, out);
+        }));
     // 0x0801, 多媒体数据上传.
     packager->insert(std::pair<uint16_t, PackageHandler>(
         kMultimediaDataUpload, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
@@ -733,6 +836,37 @@ int JT808FramePackagerInit(Packager* packager) {
             }
             return msg_len;
         }));
+    // 0x0704, 定位数据批量上传.
+    packager->insert(std::pair<uint16_t, PackageHandler>(
+        kBatchLocationReport, [](ProtocolParameter const& para, std::vector<uint8_t>* out) {
+            if (out == nullptr)
+                return -1;
+            auto const& batch_loc = para.batch_loc;
+            if (batch_loc.loc_info.empty() || batch_loc.loc_info.size() > 0xFFFF)
+                return -1;
+            int          msg_len = 3;
+            U16ToU8Array u16converter;
+            // 数据项个数.
+            u16converter.u16val = EndianSwap16(static_cast<uint16_t>(batch_loc.loc_info.size()));
+            for (int i = 0; i < 2; ++i)
+                out->push_back(u16converter.u8array[i]);
+            // 位置数据类型.
+            out->push_back(batch_loc.data_type);
+            LocationExtensions const empty_extension;
+            for (size_t i = 0; i < batch_loc.loc_info.size(); ++i) {
+                // 位置汇报数据体长度, 封装完成后回填.
+                size_t const len_pos = out->size();
+                out->push_back(0);
+                out->push_back(0);
+                auto const& extension_info = i < batch_loc.loc_ext.size() ? batch_loc.loc_ext[i] : empty_extension;
+                int const   len            = JT808LocationBodyPackage(batch_loc.loc_info[i], extension_info, out);
+                u16converter.u16val        = EndianSwap16(static_cast<uint16_t>(len));
+                (*out)[len_pos]            = u16converter.u8array[0];
+                (*out)[len_pos + 1]        = u16converter.u8array[1];
+                msg_len += 2 + len;
+            }
+            return msg_len;
+        }));
 
     return 0;
 }
@@ -796,4 +930,28 @@ int JT808FramePackage(Packager const& packager, ProtocolParameter const& para, s
     return -1;
 }
 
+// 使用已转义的消息体封装命令.
+int JT808FramePackageEscapedBody(MsgHead const& msg_head, std::vector<uint8_t> const& escaped_body,
+                                 uint16_t const& body_len, uint8_t const& body_bcc, std::vector<uint8_t>* out) {
+    if (out == nullptr)
+        return -1;
+    std::vector<uint8_t> head;
+    // 生成消息头.
+    if (JT808FrameHeadPackage(msg_head, &head) < 0)
+        return -1;
+    // 修正消息长度.
+    if (JT808MsgBodyLengthFix(msg_head, body_len, &head) < 0)
+        return -1;
+    // 校验码, 消息头校验与消息体校验异或.
+    uint8_t bcc = BccCheckSum(&(head[1]), head.size() - 1) ^ body_bcc;
+    out->clear();
+    out->reserve(2 * head.size() + escaped_body.size() + 4);
+    out->push_back(PROTOCOL_SIGN);
+    JT808AppendEscaped(&(head[1]), head.size() - 1, out);
+    out->insert(out->end(), escaped_body.begin(), escaped_body.end());
+    JT808AppendEscaped(&bcc, 1, out);
+    out->push_back(PROTOCOL_SIGN);
+    return 0;
+}
+
 } // namespace libjt808
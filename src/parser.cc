@@ -65,6 +65,133 @@ int JT808FrameHeadParse(std::vector<uint8_t> const& in, MsgHead* msg_head) {
     return 0;
 }
 
+// End of the message body starting at pos, before the checksum and flag. Taken from the frame size rather than the
+// message length, since a reassembled message body may exceed its 10 bits; pos if the frame is too short.
+size_t MessageBodyEnd(std::vector<uint8_t> const& in, size_t const& pos) {
+    return in.size() >= pos + 2 ? in.size() - 2 : pos;
+}
+
+// Parse the location basic information and additional information items of one location report body, shared by
+// 0x0200, 0x0201 and 0x0704.
+int JT808LocationBodyParse(std::vector<uint8_t> const& in, size_t pos, size_t const& len,
+                           LocationBasicInformation* basic_info, LocationExtensions* extension_info) {
+    if (len < 28 || pos + len > in.size())
+        return -1;
+    U32ToU8Array u32converter;
+    // Alarm flag.
+    memcpy(u32converter.u8array, &(in[pos]), 4);
+    basic_info->alarm.value = EndianSwap32(u32converter.u32val);
+    // Status.
+    memcpy(u32converter.u8array, &(in[pos + 4]), 4);
+    basic_info->status.value = EndianSwap32(u32converter.u32val);
+    // Latitude.
+    memcpy(u32converter.u8array, &(in[pos + 8]), 4);
+    basic_info->latitude = EndianSwap32(u32converter.u32val);
+    // Longitude.
+    memcpy(u32converter.u8array, &(in[pos + 12]), 4);
+    basic_info->longitude = EndianSwap32(u32converter.u32val);
+    U16ToU8Array u16converter;
+    // Altitude.
+    memcpy(u16converter.u8array, &(in[pos + 16]), 2);
+    basic_info->altitude = EndianSwap16(u16converter.u16val);
+    // Speed.
+    memcpy(u16converter.u8array, &(in[pos + 18]), 2);
+    basic_info->speed = EndianSwap16(u16converter.u16val);
+    // Bearing.
+    memcpy(u16converter.u8array, &(in[pos + 20]), 2);
+    basic_info->bearing = EndianSwap16(u16converter.u16val);
+    // UTC time (BCD-8421 code).
+    memcpy(basic_info->time.bcd, &(in[pos + 22]), sizeof(basic_info->time.bcd));
+    // Location additional information items, only indexed here, see LocationExtensions::GetU32() and
+    // GetBasicDataFlowItem() to decode them.
+    return extension_info->AssignWire(ByteSpan(in.data() + pos + 28, len - 28));
+}
+
+// Bounds checked reader of a message body, used by the area and route settings whose items vary in length.
+class BodyReader {
+public:
+    // The body of the frame, see MessageBodyEnd().
+    BodyReader(std::vector<uint8_t> const& in, MsgHead const& msg_head) : in_(in) {
+        pos_ = msg_head.msgbody_attr.bit.packet == 1 ? MSGBODY_PACKET_POS : MSGBODY_NOPACKET_POS;
+        end_ = MessageBodyEnd(in, pos_);
+    }
+
+    // Whether the whole body has been read.
+    bool done(void) const {
+        return pos_ == end_;
+    }
+
+    bool U8(uint8_t* value) {
+        if (pos_ + 1 > end_)
+            return false;
+        *value = in_[pos_++];
+        return true;
+    }
+
+    bool U16(uint16_t* value) {
+        if (pos_ + 2 > end_)
+            return false;
+        *value = LoadBigEndian16(in_.data() + pos_);
+        pos_ += 2;
+        return true;
+    }
+
+    bool U32(uint32_t* value) {
+        if (pos_ + 4 > end_)
+            return false;
+        *value = LoadBigEndian32(in_.data() + pos_);
+        pos_ += 4;
+        return true;
+    }
+
+    // Latitude or longitude, degrees multiplied by 10^6.
+    bool Degree(double* value) {
+        uint32_t degree;
+        if (!U32(&degree))
+            return false;
+        *value = degree * 1e-6;
+        return true;
+    }
+
+    // "YYMMDDhhmmss" from BCD[6].
+    bool BcdTime(std::string* value) {
+        if (pos_ + 6 > end_)
+            return false;
+        std::vector<uint8_t> const bcd(in_.begin() + pos_, in_.begin() + pos_ + 6);
+        pos_ += 6;
+        return BcdToStringFillZero(bcd, value) == 0;
+    }
+
+private:
+    std::vector<uint8_t> const& in_;
+    size_t                      pos_;
+    size_t                      end_;
+};
+
+// Time range and speed limit of a circular or rectangle area, present according to the area attribute.
+bool ParseAreaLimits(AreaAttribute const& attribute, BodyReader* reader, std::string* start_time,
+                     std::string* stop_time, uint16_t* max_speed, uint8_t* overspeed_time) {
+    if (attribute.bit.by_time && (!reader->BcdTime(start_time) || !reader->BcdTime(stop_time)))
+        return false;
+    if (attribute.bit.speed_limit && (!reader->U16(max_speed) || !reader->U8(overspeed_time)))
+        return false;
+    return true;
+}
+
+// Area or route IDs to delete of 0x8601, 0x8603 and 0x8607, none means all.
+int ParseDeleteIds(std::vector<uint8_t> const& in, ProtocolParameter* para, std::vector<uint32_t>* ids) {
+    BodyReader reader(in, para->parse.msg_head);
+    uint8_t    count;
+    if (!reader.U8(&count))
+        return -1;
+    ids->resize(count);
+    for (auto& id : *ids) {
+        if (!reader.U32(&id))
+            return -1;
+    }
+    return reader.done() ? 0 : -1;
+}
+
 } // namespace
 
 // Command parser initialization.
@@ -134,7 +261,7 @@ int JT808FrameParserInit(Parser* parser) {
             fill_packet.packet_id.clear();
             uint16_t id = 0;
             for (uint8_t i = 0; i < cnt; ++i) {
-                id = in[pos + i * 2] + in[pos + 1 + i * 2];
+                id = in[pos + i * 2] * 256 + in[pos + 1 + i * 2];
                 fill_packet.packet_id.push_back(id);
             }
             return 0;
@@ -344,12 +471,14 @@ int JT808FrameParserInit(Parser* parser) {
         kTerminalUpgrade, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
             if (para == nullptr)
                 return -1;
-            auto const& msg_len = para->parse.msg_head.msgbody_attr.bit.msglen;
-            uint16_t    pos     = MSGBODY_NOPACKET_POS;
+            uint16_t pos = MSGBODY_NOPACKET_POS;
             if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
                 pos = MSGBODY_PACKET_POS;
-            uint16_t beg          = pos;
-            auto&    upgrade_info = para->parse.upgrade_info;
+            size_t const msg_len = MessageBodyEnd(in, pos) - pos;
+            if (msg_len < 11u || msg_len < 11u + in[pos + 6])
+                return -1;
+            size_t const beg          = pos;
+            auto&        upgrade_info = para->parse.upgrade_info;
             // Upgrade type.
             upgrade_info.upgrade_type = in[pos++];
             // Manufacturer ID.
@@ -368,9 +497,7 @@ int JT808FrameParserInit(Parser* parser) {
                 in[pos] * 65536 * 256 + in[pos + 1] * 65536 + in[pos + 2] * 256 + in[pos + 3];
             // Upgrade data package content.
             pos += 4;
-            uint16_t content_len = msg_len - (pos - beg);
-            if (content_len + 9 + upgrade_info.version_id.size() > msg_len)
-                return -1;
+            size_t const content_len = msg_len - (pos - beg);
             upgrade_info.upgrade_data.assign(in.begin() + pos, in.begin() + pos + content_len);
             return 0;
         }));
@@ -396,54 +523,11 @@ int JT808FrameParserInit(Parser* parser) {
         kLocationReport, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
             if (para == nullptr)
                 return -1;
-            auto const& msg_len = para->parse.msg_head.msgbody_attr.bit.msglen;
-            if (msg_len < 28)
-                return -1;
             uint16_t pos = MSGBODY_NOPACKET_POS;
             if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
                 pos = MSGBODY_PACKET_POS;
-            auto&        basic_info     = para->parse.location_info;
-            auto&        extension_info = para->parse.location_extension;
-            U32ToU8Array u32converter;
-            // Alarm flag.
-            memcpy(u32converter.u8array, &(in[pos]), 4);
-            basic_info.alarm.value = EndianSwap32(u32converter.u32val);
-            // Status.
-            memcpy(u32converter.u8array, &(in[pos + 4]), 4);
-            basic_info.status.value = EndianSwap32(u32converter.u32val);
-            // Latitude.
-            memcpy(u32converter.u8array, &(in[pos + 8]), 4);
-            basic_info.latitude = EndianSwap32(u32converter.u32val);
-            // Longitude.
-            memcpy(u32converter.u8array, &(in[pos + 12]), 4);
-            basic_info.longitude = EndianSwap32(u32converter.u32val);
-            U16ToU8Array u16converter;
-            // Altitude.
-            memcpy(u16converter.u8array, &(in[pos + 16]), 2);
-            basic_info.altitude = EndianSwap16(u16converter.u16val);
-            // Speed.
-            memcpy(u16converter.u8array, &(in[pos + 18]), 2);
-            basic_info.speed = EndianSwap16(u16converter.u16val);
-            // Bearing.
-            memcpy(u16converter.u8array, &(in[pos + 20]), 2);
-            basic_info.bearing = EndianSwap16(u16converter.u16val);
-            // UTC time (BCD-8421 code).
-            std::vector<uint8_t> bcd;
-            bcd.assign(in.begin() + pos + 22, in.begin() + pos + 28);
-            BcdToStringFillZero(bcd, &basic_info.time);
-            if (msg_len > 28) { // Location additional information items.
-                uint8_t end = msg_len + pos;
-                pos += 28;
-                std::vector<uint8_t> item_content;
-                while (pos <= end - 2) { // Additional information length is at least 1.
-                    if (pos + 1 + in[pos + 1] > end)
-                        return -1; // Additional information length exceeds the range.
-                    item_content.assign(in.begin() + pos + 2, in.begin() + pos + 2 + in[pos + 1]);
-                    extension_info[in[pos]] = item_content;
-                    pos += 2 + in[pos + 1];
-                }
-            }
-            return 0;
+            return JT808LocationBodyParse(in, pos, MessageBodyEnd(in, pos) - pos, &para->parse.location_info,
+                                          &para->parse.location_extension);
         }));
 
     // 0x8201, Location information query.
@@ -466,52 +550,13 @@ int JT808FrameParserInit(Parser* parser) {
             uint16_t pos = MSGBODY_NOPACKET_POS;
             if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
                 pos = MSGBODY_PACKET_POS;
+            if (in.size() < pos + 2u)
+                return -1;
             // Response flow number.
-            para->parse.respone_flow_num = in[pos] * 256 + in[pos];
-            pos += 2;
+            para->parse.respone_flow_num = in[pos] * 256 + in[pos + 1];
             // The following is the location information report content.
-            auto&        basic_info     = para->parse.location_info;
-            auto&        extension_info = para->parse.location_extension;
-            U32ToU8Array u32converter;
-            // Alarm flag.
-            memcpy(u32converter.u8array, &(in[pos]), 4);
-            basic_info.alarm.value = EndianSwap32(u32converter.u32val);
-            // Status.
-            memcpy(u32converter.u8array, &(in[pos + 4]), 4);
-            basic_info.status.value = EndianSwap32(u32converter.u32val);
-            // Latitude.
-            memcpy(u32converter.u8array, &(in[pos + 8]), 4);
-            basic_info.latitude = EndianSwap32(u32converter.u32val);
-            // Longitude.
-            memcpy(u32converter.u8array, &(in[pos + 12]), 4);
-            basic_info.longitude = EndianSwap32(u32converter.u32val);
-            U16ToU8Array u16converter;
-            // Altitude.
-            memcpy(u16converter.u8array, &(in[pos + 16]), 2);
-            basic_info.altitude = EndianSwap16(u16converter.u16val);
-            // Speed.
-            memcpy(u16converter.u8array, &(in[pos + 18]), 2);
-            basic_info.speed = EndianSwap16(u16converter.u16val);
-            // Bearing.
-            memcpy(u16converter.u8array, &(in[pos + 20]), 2);
-            basic_info.bearing = EndianSwap16(u16converter.u16val);
-            // UTC time (BCD-8421 code).
-            std::vector<uint8_t> bcd;
-            bcd.assign(in.begin() + pos + 22, in.begin() + pos + 28);
-            BcdToStringFillZero(bcd, &basic_info.time);
-            if (msg_len > 28) { // Location additional information items.
-                uint8_t end = msg_len + pos;
-                pos += 28;
-                std::vector<uint8_t> item_content;
-                while (pos <= end - 2) { // Additional information length is at least 1.
-                    if (pos + 1 + in[pos + 1] > end)
-                        return -1; // Additional information length exceeds the range.
-                    item_content.assign(in.begin() + pos + 2, in.begin() + pos + 2 + in[pos + 1]);
-                    extension_info[in[pos]] = item_content;
-                    pos += 2 + in[pos + 1];
-                }
-            }
-            return 0;
+            return JT808LocationBodyParse(in, pos + 2, msg_len - 2, &para->parse.location_info,
+                                          &para->parse.location_extension);
         }));
 
     // 0x8202, Temporary location tracking control.
@@ -536,6 +581,80 @@ int JT808FrameParserInit(Parser* parser) {
             return 0;
         }));
 
+    // 0x08600, Set circular area.
+    parser->insert(std::pair<uint16_t, ParseHandler>(
+        kSetCircularArea, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+            if (para == nullptr)
+                return -1;
+            BodyReader reader(in, para->parse.msg_head);
+            auto&      areas = para->parse.circular_areas;
+            uint8_t    count;
+            areas.clear();
+            // Setting type and number of areas.
+            if (!reader.U8(&para->parse.area_setting_type) || !reader.U8(&count))
+                return -1;
+            for (uint8_t i = 0; i < count; ++i) {
+                CircularArea area {};
+                // Area ID, attributes, center latitude and longitude, radius.
+                if (!reader.U32(&area.area_id) || !reader.U16(&area.area_attribute.value) ||
+                    !reader.Degree(&area.center.latitude) || !reader.Degree(&area.center.longitude) ||
+                    !reader.U32(&area.radius)) {
+                    return -1;
+                }
+                if (!ParseAreaLimits(area.area_attribute, &reader, &area.start_time, &area.stop_time,
+                                     &area.max_speed, &area.overspeed_time)) {
+                    return -1;
+                }
+                areas[area.area_id] = area;
+            }
+            return reader.done() ? 0 : -1;
+        }));
+
+    // 0x08601, Delete circular area.
+    parser->insert(std::pair<uint16_t, ParseHandler>(
+        kDeleteCircularArea, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+            if (para == nullptr)
+                return -1;
+            return ParseDeleteIds(in, para, &para->parse.circular_area_id);
+        }));
+
+    // 0x08602, Set rectangle area.
+    parser->insert(std::pair<uint16_t, ParseHandler>(
+        kSetRectangleArea, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+            if (para == nullptr)
+                return -1;
+            BodyReader reader(in, para->parse.msg_head);
+            auto&      areas = para->parse.rectangle_areas;
+            uint8_t    count;
+            areas.clear();
+            // Setting type and number of areas.
+            if (!reader.U8(&para->parse.area_setting_type) || !reader.U8(&count))
+                return -1;
+            for (uint8_t i = 0; i < count; ++i) {
+                RectangleArea area {};
+                // Area ID, attributes, upper left and lower right points.
+                if (!reader.U32(&area.area_id) || !reader.U16(&area.area_attribute.value) ||
+                    !reader.Degree(&area.upper_left.latitude) || !reader.Degree(&area.upper_left.longitude) ||
+                    !reader.Degree(&area.lower_right.latitude) || !reader.Degree(&area.lower_right.longitude)) {
+                    return -1;
+                }
+                if (!ParseAreaLimits(area.area_attribute, &reader, &area.start_time, &area.stop_time,
+                                     &area.max_speed, &area.overspeed_time)) {
+                    return -1;
+                }
+                areas[area.area_id] = area;
+            }
+            return reader.done() ? 0 : -1;
+        }));
+
+    // 0x08603, Delete rectangle area.
+    parser->insert(std::pair<uint16_t, ParseHandler>(
+        kDeleteRectangleArea, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+            if (para == nullptr)
+                return -1;
+            return ParseDeleteIds(in, para, &para->parse.rectangle_area_id);
+        }));
+
     // 0x08604, Set polygon area.
     parser->insert(std::pair<uint16_t, ParseHandler>(
         kSetPolygonArea, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
@@ -623,15 +742,68 @@ int JT808FrameParserInit(Parser* parser) {
             return 0;
         }));
 
+    // 0x08606, Set route.
+    parser->insert(std::pair<uint16_t, ParseHandler>(
+        kSetRoute, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+            if (para == nullptr)
+                return -1;
+            BodyReader reader(in, para->parse.msg_head);
+            auto&      route = para->parse.route;
+            uint16_t   count;
+            route = Route();
+            // Route ID and attributes.
+            if (!reader.U32(&route.route_id) || !reader.U16(&route.route_attribute.value))
+                return -1;
+            // Start and end time, only if the relevant flag in route attributes is set to 1.
+            if (route.route_attribute.bit.by_time &&
+                (!reader.BcdTime(&route.start_time) || !reader.BcdTime(&route.stop_time))) {
+                return -1;
+            }
+            // Number of inflection points.
+            if (!reader.U16(&count))
+                return -1;
+            for (uint16_t i = 0; i < count; ++i) {
+                RouteInflectionPoint point {};
+                // Inflection point ID, road section ID, latitude, longitude, road section width and attributes.
+                if (!reader.U32(&point.inflection_point_id) || !reader.U32(&point.section_id) ||
+                    !reader.Degree(&point.point.latitude) || !reader.Degree(&point.point.longitude) ||
+                    !reader.U8(&point.section_width) || !reader.U8(&point.section_attribute.value)) {
+                    return -1;
+                }
+                // Driving time thresholds, only if the relevant flag in road section attributes is set to 1.
+                if (point.section_attribute.bit.drive_time &&
+                    (!reader.U16(&point.max_drive_time) || !reader.U16(&point.min_drive_time))) {
+                    return -1;
+                }
+                // Speed limit, only if the relevant flag in road section attributes is set to 1.
+                if (point.section_attribute.bit.speed_limit &&
+                    (!reader.U16(&point.max_speed) || !reader.U8(&point.overspeed_time))) {
+                    return -1;
+                }
+                route.inflection_points.push_back(point);
+            }
+            return reader.done() ? 0 : -1;
+        }));
+
+    // 0x08607, Delete route.
+    parser->insert(std::pair<uint16_t, ParseHandler>(
+        kDeleteRoute, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+            if (para == nullptr)
+                return -1;
+            return ParseDeleteIds(in, para, &para->parse.route_id);
+        }));
+
     // 0x0801, Multimedia data upload.
     parser->insert(std::pair<uint16_t, ParseHandler>(
         kMultimediaDataUpload, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
             if (para == nullptr)
                 return -1;
-            auto const& msg_len = para->parse.msg_head.msgbody_attr.bit.msglen;
-            uint16_t    pos     = MSGBODY_NOPACKET_POS;
+            uint16_t pos = MSGBODY_NOPACKET_POS;
             if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
                 pos = MSGBODY_PACKET_POS;
+            size_t const msg_len = MessageBodyEnd(in, pos) - pos;
+            if (msg_len < 36u)
+                return -1;
             U32ToU8Array u32converter;
             // Multimedia ID.
             memcpy(u32converter.u8array, in.data() + pos, 4);
@@ -676,6 +848,40 @@ int JT808FrameParserInit(Parser* parser) {
             return 0;
         }));
 
+    // 0x0704, Batch location information report.
+    parser->insert(std::pair<uint16_t, ParseHandler>(
+        kBatchLocationReport, [](std::vector<uint8_t> const& in, ProtocolParameter* para) -> int {
+            if (para == nullptr)
+                return -1;
+            size_t pos = MSGBODY_NOPACKET_POS;
+            if (para->parse.msg_head.msgbody_attr.bit.packet == 1)
+                pos = MSGBODY_PACKET_POS;
+            size_t const end = MessageBodyEnd(in, pos);
+            if (end - pos < 3u)
+                return -1;
+            auto& batch_loc = para->parse.batch_loc;
+            // Number of data items.
+            batch_loc.nbr_of_dat = in[pos] * 256 + in[pos + 1];
+            // Location data type.
+            batch_loc.data_type = in[pos + 2];
+            pos += 3;
+            batch_loc.loc_info.resize(batch_loc.nbr_of_dat);
+            batch_loc.loc_ext.resize(batch_loc.nbr_of_dat);
+            for (uint16_t i = 0; i < batch_loc.nbr_of_dat; ++i) {
+                if (pos + 2 > end)
+                    return -1;
+                // Location report body length.
+                size_t const len = in[pos] * 256 + in[pos + 1];
+                pos += 2;
+                if (pos + len > end)
+                    return -1;
+                if (JT808LocationBodyParse(in, pos, len, &batch_loc.loc_info[i], &batch_loc.loc_ext[i]) != 0)
+                    return -1;
+                pos += len;
+            }
+            return 0;
+        }));
+
     return 0;
 }
 
@@ -718,24 +924,124 @@ bool JT808FrameParserOverride(Parser* parser, uint16_t const& msg_id, ParseHandl
  * @return int Returns 0 on success, -1 on failure.
  */
 int JT808FrameParse(Parser const& parser, std::vector<uint8_t> const& in, ProtocolParameter* para) {
-    if (para == nullptr)
+    return JT808FrameParse(parser, in, para, nullptr);
+}
+
+int JT808FrameParse(Parser const& parser, std::vector<uint8_t> const& in, ProtocolParameter* para,
+                    ParseErrorReason* reason) {
+    if (para == nullptr) {
+        if (reason != nullptr)
+            *reason = kParseInvalidFrame;
         return -1;
+    }
     std::vector<uint8_t> out;
-    // Reverse escape.
-    if (ReverseEscape(in, &out) < 0)
+    MsgHead              msg_head;
+    if (JT808FrameDecode(in, &out, &msg_head, reason) != 0)
         return -1;
-    // XOR checksum check.
-    if (BccCheckSum(&(out[1]), out.size() - 3) != *(out.end() - 2))
+    return JT808DecodedFrameParse(parser, out, msg_head, para, reason);
+}
+
+int JT808FrameDecode(std::vector<uint8_t> const& in, std::vector<uint8_t>* out, MsgHead* msg_head) {
+    return JT808FrameDecode(in, out, msg_head, nullptr);
+}
+
+int JT808FrameDecode(std::vector<uint8_t> const& in, std::vector<uint8_t>* out, MsgHead* msg_head,
+                     ParseErrorReason* reason) {
+    ParseErrorReason error = kParseInvalidFrame;
+    // Reverse escape.
+    if (out != nullptr && msg_head != nullptr && ReverseEscape(in, out) >= 0 && out->size() >= 15) {
+        // XOR checksum check.
+        if (BccCheckSum(&((*out)[1]), out->size() - 3) != *(out->end() - 2))
+            error = kParseChecksumError;
+        // Parse message header.
+        else if (JT808FrameHeadParse(*out, msg_head) != 0)
+            error = kParseHeaderError;
+        else
+            error = kParseSuccess;
+    }
+    if (reason != nullptr)
+        *reason = error;
+    return error == kParseSuccess ? 0 : -1;
+}
+
+int JT808DecodedFrameParse(Parser const& parser, std::vector<uint8_t> const& decoded, MsgHead const& msg_head,
+                           ProtocolParameter* para) {
+    return JT808DecodedFrameParse(parser, decoded, msg_head, para, nullptr);
+}
+
+int JT808DecodedFrameParse(Parser const& parser, std::vector<uint8_t> const& decoded, MsgHead const& msg_head,
+                           ProtocolParameter* para, ParseErrorReason* reason) {
+    ParseErrorReason error = kParseInvalidFrame;
+    if (para != nullptr) {
+        para->parse.msg_head     = msg_head;
+        para->msg_head.phone_num = para->parse.msg_head.phone_num;
+        // Parse message content.
+        auto it = parser.find(para->parse.msg_head.msg_id);
+        if (it == parser.end())
+            error = kParseUnknownMsgId;
+        else
+            error = it->second(decoded, para) == 0 ? kParseSuccess : kParseBodyError;
+    }
+    if (reason != nullptr)
+        *reason = error;
+    return error == kParseSuccess ? 0 : -1;
+}
+
+int JT808MessageParse(Parser const& parser, MsgHead const& msg_head, std::vector<uint8_t> const& body,
+                      ProtocolParameter* para) {
+    if (para == nullptr || msg_head.msgbody_attr.bit.packet == 1)
         return -1;
-    // Parse message header.
-    if (JT808FrameHeadParse(out, &para->parse.msg_head) != 0)
+    // Rebuild an unescaped frame: flag + header + body + checksum + flag.
+    MsgHead head                  = msg_head;
+    head.msgbody_attr.bit.msglen  = body.size() > 1023 ? 1023 : body.size();
+    std::vector<uint8_t> phone_num_bcd;
+    if (StringToBcd(head.phone_num, &phone_num_bcd) != 0)
         return -1;
-    para->msg_head.phone_num = para->parse.msg_head.phone_num;
-    // Parse message content.
-    auto it = parser.find(para->parse.msg_head.msg_id);
-    if (it == parser.end())
+    std::vector<uint8_t> decoded;
+    decoded.reserve(MSGBODY_NOPACKET_POS + body.size() + 2);
+    decoded.push_back(PROTOCOL_SIGN);
+    decoded.push_back(static_cast<uint8_t>(head.msg_id >> 8));
+    decoded.push_back(static_cast<uint8_t>(head.msg_id));
+    decoded.push_back(static_cast<uint8_t>(head.msgbody_attr.u16val >> 8));
+    decoded.push_back(static_cast<uint8_t>(head.msgbody_attr.u16val));
+    decoded.insert(decoded.end(), phone_num_bcd.begin(), phone_num_bcd.end());
+    decoded.push_back(static_cast<uint8_t>(head.msg_flow_num >> 8));
+    decoded.push_back(static_cast<uint8_t>(head.msg_flow_num));
+    decoded.insert(decoded.end(), body.begin(), body.end());
+    decoded.push_back(BccCheckSum(&decoded[1], decoded.size() - 1));
+    decoded.push_back(PROTOCOL_SIGN);
+    return JT808DecodedFrameParse(parser, decoded, head, para);
+}
+
+int JT808FrameExtract(std::vector<uint8_t>* buffer, std::vector<std::vector<uint8_t>>* frames) {
+    if (buffer == nullptr || frames == nullptr)
         return -1;
-    return it->second(out, para);
+    int    cnt   = 0;
+    size_t begin = 0;
+    size_t size  = buffer->size();
+    auto&  in    = *buffer;
+    while (begin < size) {
+        // Frame start flag.
+        while (begin < size && in[begin] != PROTOCOL_SIGN)
+            ++begin;
+        if (begin >= size)
+            break;
+        // Frame end flag.
+        size_t end = begin + 1;
+        while (end < size && in[end] != PROTOCOL_SIGN)
+            ++end;
+        if (end >= size)
+            break;
+        if (end == begin + 1) { // Adjacent flags, the second one starts the next frame.
+            begin = end;
+            continue;
+        }
+        frames->emplace_back(in.begin() + begin, in.begin() + end + 1);
+        ++cnt;
+        begin = end + 1;
+    }
+    in.erase(in.begin(), in.begin() + begin);
+    return cnt;
 }
 
 } // namespace libjt808
@@ -0,0 +1,331 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  point_in_polygon.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 20:16:48
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/point_in_polygon.h"
+
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define JT808_POLYGON_SIMD 1
+#else
+#define JT808_POLYGON_SIMD 0
+#endif
+
+namespace libjt808 {
+
+namespace {
+
+// Edges of the padding, lat_lo > lat_hi so no point is between them.
+constexpr int32_t kPaddingLatLo = INT32_MAX;
+constexpr int32_t kPaddingLatHi = INT32_MIN;
+// Latitude of the points of the padding, below every edge.
+constexpr int32_t kPaddingPointLat = INT32_MIN;
+
+// Whether the ray from the point crosses the edge.
+inline bool Crosses(PolygonEdges const& edges, size_t const& i, int32_t const& lat, int32_t const& lon) {
+    if (lat < edges.lat_lo[i] || lat >= edges.lat_hi[i])
+        return false;
+    int64_t const lhs = static_cast<int64_t>(lon - edges.lon_lo[i]) * edges.dlat[i];
+    int64_t const rhs = static_cast<int64_t>(edges.dlon[i]) * (lat - edges.lat_lo[i]);
+    return lhs < rhs;
+}
+
+bool ContainsScalar(PolygonEdges const& edges, int32_t const& lat, int32_t const& lon) {
+    bool inside = false;
+    for (size_t i = 0; i < edges.count; ++i)
+        inside ^= Crosses(edges, i, lat, lon);
+    return inside;
+}
+
+// Points of a batch inside the bounding box are tested in chunks, padded to a multiple of 8.
+constexpr size_t kBatchChunk = 256;
+
+// Test the points of a chunk, count is a multiple of 8.
+using BatchKernel = void (*)(PolygonEdges const& edges, int32_t const* lat, int32_t const* lon, size_t const& count,
+                             uint8_t* inside);
+
+void ContainsBatchScalar(PolygonEdges const& edges, int32_t const* lat, int32_t const* lon, size_t const& count,
+                         uint8_t* inside) {
+    for (size_t i = 0; i < count; ++i)
+        inside[i] = ContainsScalar(edges, lat[i], lon[i]);
+}
+
+#if JT808_POLYGON_SIMD
+
+// All bits set in the 32-bit lanes of the edge and point pairs whose ray crosses the edge. The 64-bit products are
+// computed separately for the even and the odd lanes.
+__attribute__((target("avx2"))) inline __m256i CrossMaskAvx2(__m256i const& lat, __m256i const& lon,
+                                                             __m256i const& lat_lo, __m256i const& lat_hi,
+                                                             __m256i const& lon_lo, __m256i const& dlon,
+                                                             __m256i const& dlat) {
+    __m256i const between  = _mm256_andnot_si256(_mm256_cmpgt_epi32(lat_lo, lat), _mm256_cmpgt_epi32(lat_hi, lat));
+    __m256i const a        = _mm256_sub_epi32(lon, lon_lo);
+    __m256i const b        = _mm256_sub_epi32(lat, lat_lo);
+    __m256i const lhs_even = _mm256_mul_epi32(a, dlat);
+    __m256i const rhs_even = _mm256_mul_epi32(dlon, b);
+    __m256i const lhs_odd  = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(dlat, 32));
+    __m256i const rhs_odd  = _mm256_mul_epi32(_mm256_srli_epi64(dlon, 32), _mm256_srli_epi64(b, 32));
+    __m256i const less     = _mm256_blend_epi32(_mm256_cmpgt_epi64(rhs_even, lhs_even),
+                                                _mm256_cmpgt_epi64(rhs_odd, lhs_odd), 0xAA);
+    return _mm256_and_si256(between, less);
+}
+
+// One point, 8 edges per step.
+__attribute__((target("avx2"))) bool ContainsAvx2(PolygonEdges const& edges, int32_t const& lat, int32_t const& lon) {
+    __m256i const vlat   = _mm256_set1_epi32(lat);
+    __m256i const vlon   = _mm256_set1_epi32(lon);
+    __m256i       parity = _mm256_setzero_si256();
+    for (size_t i = 0; i < edges.count; i += 8) {
+        __m256i const lat_lo = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(edges.lat_lo.data() + i));
+        __m256i const lat_hi = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(edges.lat_hi.data() + i));
+        __m256i const lon_lo = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(edges.lon_lo.data() + i));
+        __m256i const dlon   = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(edges.dlon.data() + i));
+        __m256i const dlat   = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(edges.dlat.data() + i));
+        parity = _mm256_xor_si256(parity, CrossMaskAvx2(vlat, vlon, lat_lo, lat_hi, lon_lo, dlon, dlat));
+    }
+    return (__builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(parity))) & 1) != 0;
+}
+
+// 8 points per step, every edge is broadcast.
+__attribute__((target("avx2"))) void ContainsBatchAvx2(PolygonEdges const& edges, int32_t const* lat,
+                                                       int32_t const* lon, size_t const& count, uint8_t* inside) {
+    for (size_t i = 0; i < count; i += 8) {
+        __m256i const vlat   = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(lat + i));
+        __m256i const vlon   = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(lon + i));
+        __m256i       parity = _mm256_setzero_si256();
+        for (size_t e = 0; e < edges.count; ++e) {
+            parity = _mm256_xor_si256(parity, CrossMaskAvx2(vlat, vlon, _mm256_set1_epi32(edges.lat_lo[e]),
+                                                            _mm256_set1_epi32(edges.lat_hi[e]),
+                                                            _mm256_set1_epi32(edges.lon_lo[e]),
+                                                            _mm256_set1_epi32(edges.dlon[e]),
+                                                            _mm256_set1_epi32(edges.dlat[e])));
+        }
+        int const mask = _mm256_movemask_ps(_mm256_castsi256_ps(parity));
+        for (int k = 0; k < 8; ++k)
+            inside[i + k] = static_cast<uint8_t>((mask >> k) & 1);
+    }
+}
+
+// Same as CrossMaskAvx2() on 4 lanes.
+__attribute__((target("sse4.2"))) inline __m128i CrossMaskSse42(__m128i const& lat, __m128i const& lon,
+                                                                __m128i const& lat_lo, __m128i const& lat_hi,
+                                                                __m128i const& lon_lo, __m128i const& dlon,
+                                                                __m128i const& dlat) {
+    __m128i const between  = _mm_andnot_si128(_mm_cmpgt_epi32(lat_lo, lat), _mm_cmpgt_epi32(lat_hi, lat));
+    __m128i const a        = _mm_sub_epi32(lon, lon_lo);
+    __m128i const b        = _mm_sub_epi32(lat, lat_lo);
+    __m128i const lhs_even = _mm_mul_epi32(a, dlat);
+    __m128i const rhs_even = _mm_mul_epi32(dlon, b);
+    __m128i const lhs_odd  = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(dlat, 32));
+    __m128i const rhs_odd  = _mm_mul_epi32(_mm_srli_epi64(dlon, 32), _mm_srli_epi64(b, 32));
+    __m128i const less     = _mm_blend_epi16(_mm_cmpgt_epi64(rhs_even, lhs_even), _mm_cmpgt_epi64(rhs_odd, lhs_odd),
+                                             0xCC);
+    return _mm_and_si128(between, less);
+}
+
+__attribute__((target("sse4.2"))) bool ContainsSse42(PolygonEdges const& edges, int32_t const& lat,
+                                                     int32_t const& lon) {
+    __m128i const vlat   = _mm_set1_epi32(lat);
+    __m128i const vlon   = _mm_set1_epi32(lon);
+    __m128i       parity = _mm_setzero_si128();
+    for (size_t i = 0; i < edges.count; i += 4) {
+        __m128i const lat_lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(edges.lat_lo.data() + i));
+        __m128i const lat_hi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(edges.lat_hi.data() + i));
+        __m128i const lon_lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(edges.lon_lo.data() + i));
+        __m128i const dlon   = _mm_loadu_si128(reinterpret_cast<__m128i const*>(edges.dlon.data() + i));
+        __m128i const dlat   = _mm_loadu_si128(reinterpret_cast<__m128i const*>(edges.dlat.data() + i));
+        parity = _mm_xor_si128(parity, CrossMaskSse42(vlat, vlon, lat_lo, lat_hi, lon_lo, dlon, dlat));
+    }
+    return (__builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(parity))) & 1) != 0;
+}
+
+__attribute__((target("sse4.2"))) void ContainsBatchSse42(PolygonEdges const& edges, int32_t const* lat,
+                                                          int32_t const* lon, size_t const& count, uint8_t* inside) {
+    for (size_t i = 0; i < count; i += 4) {
+        __m128i const vlat   = _mm_loadu_si128(reinterpret_cast<__m128i const*>(lat + i));
+        __m128i const vlon   = _mm_loadu_si128(reinterpret_cast<__m128i const*>(lon + i));
+        __m128i       parity = _mm_setzero_si128();
+        for (size_t e = 0; e < edges.count; ++e) {
+            parity = _mm_xor_si128(parity, CrossMaskSse42(vlat, vlon, _mm_set1_epi32(edges.lat_lo[e]),
+                                                          _mm_set1_epi32(edges.lat_hi[e]),
+                                                          _mm_set1_epi32(edges.lon_lo[e]),
+                                                          _mm_set1_epi32(edges.dlon[e]),
+                                                          _mm_set1_epi32(edges.dlat[e])));
+        }
+        int const mask = _mm_movemask_ps(_mm_castsi128_ps(parity));
+        for (int k = 0; k < 4; ++k)
+            inside[i + k] = static_cast<uint8_t>((mask >> k) & 1);
+    }
+}
+
+#endif // JT808_POLYGON_SIMD
+
+bool IsSupported(PolygonKernel const& kernel) {
+#if JT808_POLYGON_SIMD
+    if (kernel == kPolygonKernelAvx2)
+        return __builtin_cpu_supports("avx2");
+    if (kernel == kPolygonKernelSse42)
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    return kernel == kPolygonKernelScalar;
+}
+
+PolygonKernel BestKernel(void) {
+    if (IsSupported(kPolygonKernelAvx2))
+        return kPolygonKernelAvx2;
+    if (IsSupported(kPolygonKernelSse42))
+        return kPolygonKernelSse42;
+    return kPolygonKernelScalar;
+}
+
+std::atomic<int>& CurrentKernel(void) {
+    static std::atomic<int> kernel(BestKernel());
+    return kernel;
+}
+
+} // namespace
+
+void PolygonEdges::clear(void) {
+    lat_lo.clear();
+    lat_hi.clear();
+    lon_lo.clear();
+    dlon.clear();
+    dlat.clear();
+    count = 0;
+    box   = AreaBox();
+}
+
+int PolygonEdgesBuild(int32_t const* lat, int32_t const* lon, size_t const& count, PolygonEdges* edges) {
+    if (lat == nullptr || lon == nullptr || count < 3 || edges == nullptr)
+        return -1;
+    edges->clear();
+    edges->box = AreaBox {lat[0], lat[0], lon[0], lon[0]};
+    for (size_t i = 0, j = count - 1; i < count; j = i++) {
+        edges->box.min_lat = lat[i] < edges->box.min_lat ? lat[i] : edges->box.min_lat;
+        edges->box.max_lat = lat[i] > edges->box.max_lat ? lat[i] : edges->box.max_lat;
+        edges->box.min_lon = lon[i] < edges->box.min_lon ? lon[i] : edges->box.min_lon;
+        edges->box.max_lon = lon[i] > edges->box.max_lon ? lon[i] : edges->box.max_lon;
+        if (lat[i] == lat[j])
+            continue; // Horizontal edges are never crossed.
+        size_t const lo = lat[i] < lat[j] ? i : j;
+        size_t const hi = lat[i] < lat[j] ? j : i;
+        edges->lat_lo.push_back(lat[lo]);
+        edges->lat_hi.push_back(lat[hi]);
+        edges->lon_lo.push_back(lon[lo]);
+        edges->dlon.push_back(lon[hi] - lon[lo]);
+        edges->dlat.push_back(lat[hi] - lat[lo]);
+    }
+    edges->count = edges->lat_lo.size();
+    while (edges->lat_lo.size() % 8 != 0) {
+        edges->lat_lo.push_back(kPaddingLatLo);
+        edges->lat_hi.push_back(kPaddingLatHi);
+        edges->lon_lo.push_back(0);
+        edges->dlon.push_back(0);
+        edges->dlat.push_back(0);
+    }
+    return 0;
+}
+
+bool PolygonEdgesContains(PolygonEdges const& edges, int32_t const& lat, int32_t const& lon) {
+    if (edges.empty() || !edges.box.Contains(lat, lon))
+        return false;
+#if JT808_POLYGON_SIMD
+    switch (CurrentKernel().load(std::memory_order_relaxed)) {
+        case kPolygonKernelAvx2:
+            return ContainsAvx2(edges, lat, lon);
+        case kPolygonKernelSse42:
+            return ContainsSse42(edges, lat, lon);
+        default:
+            break;
+    }
+#endif
+    return ContainsScalar(edges, lat, lon);
+}
+
+size_t PolygonEdgesContainsBatch(PolygonEdges const& edges, int32_t const* lat, int32_t const* lon,
+                                 size_t const& count, uint8_t* inside) {
+    if (lat == nullptr || lon == nullptr || inside == nullptr)
+        return 0;
+    BatchKernel kernel = ContainsBatchScalar;
+#if JT808_POLYGON_SIMD
+    switch (CurrentKernel().load(std::memory_order_relaxed)) {
+        case kPolygonKernelAvx2:
+            kernel = ContainsBatchAvx2;
+            break;
+        case kPolygonKernelSse42:
+            kernel = ContainsBatchSse42;
+            break;
+        default:
+            break;
+    }
+#endif
+    // Only the points inside the bounding box are handed to the kernel, so every lane does useful work.
+    int32_t  chunk_lat[kBatchChunk];
+    int32_t  chunk_lon[kBatchChunk];
+    uint32_t chunk_index[kBatchChunk];
+    uint8_t  chunk_inside[kBatchChunk];
+    size_t   size  = 0;
+    size_t   found = 0;
+    for (size_t i = 0; i < count; ++i) {
+        inside[i] = 0;
+        if (!edges.empty() && edges.box.Contains(lat[i], lon[i])) {
+            chunk_lat[size]     = lat[i];
+            chunk_lon[size]     = lon[i];
+            chunk_index[size++] = static_cast<uint32_t>(i);
+        }
+        if (size == kBatchChunk || (i + 1 == count && size > 0)) {
+            size_t const padded = (size + 7) & ~static_cast<size_t>(7);
+            for (size_t k = size; k < padded; ++k) {
+                chunk_lat[k] = kPaddingPointLat;
+                chunk_lon[k] = 0;
+            }
+            kernel(edges, chunk_lat, chunk_lon, padded, chunk_inside);
+            for (size_t k = 0; k < size; ++k) {
+                inside[chunk_index[k]] = chunk_inside[k];
+                found += chunk_inside[k];
+            }
+            size = 0;
+        }
+    }
+    return found;
+}
+
+PolygonKernel GetPolygonKernel(void) {
+    return static_cast<PolygonKernel>(CurrentKernel().load(std::memory_order_relaxed));
+}
+
+int SetPolygonKernel(PolygonKernel const& kernel) {
+    if (!IsSupported(kernel))
+        return -1;
+    CurrentKernel().store(kernel, std::memory_order_relaxed);
+    return 0;
+}
+
+} // namespace libjt808
@@ -0,0 +1,266 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  reassembler.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 12:22:10
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/reassembler.h"
+
+namespace libjt808 {
+
+int FragmentBufferPool::Acquire(std::vector<uint8_t>* buffer) {
+    if (buffer == nullptr)
+        return -1;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (used_bytes_ + kMaxMsgBodyLength > max_bytes_)
+        return -1;
+    used_bytes_ += kMaxMsgBodyLength;
+    if (!free_buffers_.empty()) {
+        buffer->swap(free_buffers_.back());
+        free_buffers_.pop_back();
+    }
+    lock.unlock();
+    buffer->clear();
+    buffer->reserve(kMaxMsgBodyLength);
+    return 0;
+}
+
+void FragmentBufferPool::Release(std::vector<uint8_t>* buffer) {
+    if (buffer == nullptr || buffer->capacity() == 0)
+        return;
+    buffer->clear();
+    std::unique_lock<std::mutex> lock(mutex_);
+    used_bytes_ -= used_bytes_ >= kMaxMsgBodyLength ? kMaxMsgBodyLength : used_bytes_;
+    if (free_buffers_.size() < max_free_buffers_) {
+        free_buffers_.push_back(std::vector<uint8_t>());
+        free_buffers_.back().swap(*buffer);
+    }
+    else {
+        std::vector<uint8_t>().swap(*buffer);
+    }
+}
+
+FragmentReassembler::FragmentReassembler(FragmentBufferPool* pool)
+    : pool_(pool)
+    , bytes_(0) {
+    limits_.timeout_ms        = 5000;
+    limits_.max_fill_requests = 3;
+    limits_.max_age_ms        = 120000;
+    limits_.max_message_bytes = 4 * 1024 * 1024;
+    limits_.max_session_bytes = 8 * 1024 * 1024;
+    limits_.max_messages      = 8;
+    // 0x8108: upgrade type, manufacturer ID, version length, version and total length.
+    SetRepeatedHeaderLength(kTerminalUpgrade, [](std::vector<uint8_t> const& body) -> int {
+        if (body.size() < 7 || body.size() < 11u + body[6])
+            return -1;
+        return 11 + body[6];
+    });
+}
+
+void FragmentReassembler::SetRepeatedHeaderLength(uint16_t const& msg_id, uint16_t const& length) {
+    SetRepeatedHeaderLength(msg_id, [length](std::vector<uint8_t> const& body) -> int {
+        if (body.size() < length)
+            return -1;
+        return length;
+    });
+}
+
+void FragmentReassembler::SetRepeatedHeaderLength(uint16_t const& msg_id, HeaderLengthFunction const& function) {
+    if (function == nullptr)
+        repeated_header_length_.erase(msg_id);
+    else
+        repeated_header_length_[msg_id] = function;
+}
+
+int FragmentReassembler::AddFragment(MsgHead const& msg_head, std::vector<uint8_t> const& body,
+                                     std::chrono::steady_clock::time_point const& now, MsgHead* head,
+                                     std::vector<uint8_t>* message) {
+    if (head == nullptr || message == nullptr)
+        return -1;
+    if (msg_head.total_packet == 0 || msg_head.packet_seq == 0 || msg_head.packet_seq > msg_head.total_packet)
+        return -1;
+    if (body.empty() || body.size() > kMaxMsgBodyLength)
+        return -1;
+    int header_len = 0;
+    auto iter      = repeated_header_length_.find(msg_head.msg_id);
+    if (iter != repeated_header_length_.end() && (header_len = iter->second(body)) < 0)
+        return -1;
+    uint16_t const first = FirstPacketFlowNum(msg_head);
+    uint32_t const key   = static_cast<uint32_t>(msg_head.msg_id) << 16 | first;
+    auto           it    = messages_.find(key);
+    if (it != messages_.end() && it->second.head.total_packet != msg_head.total_packet) {
+        // Same flow numbers reused by a different message, start again.
+        Drop(it);
+        it = messages_.end();
+    }
+    if (it == messages_.end()) {
+        if (messages_.size() >= limits_.max_messages && !DropOldest(key))
+            return -1;
+        Message msg;
+        msg.head          = msg_head;
+        msg.bytes         = 0;
+        msg.fill_requests = 0;
+        msg.created       = now;
+        it                = messages_.insert(std::make_pair(key, std::move(msg))).first;
+    }
+    auto& msg       = it->second;
+    msg.last_active = now;
+    if (msg.fragments.find(msg_head.packet_seq) != msg.fragments.end())
+        return kFragmentDuplicate;
+    // Only the first fragment keeps the repeated header.
+    size_t const skip = msg_head.packet_seq == 1 ? 0 : header_len;
+    size_t const size = body.size() - skip;
+    if (msg.bytes + size > limits_.max_message_bytes) {
+        Drop(it);
+        return -1;
+    }
+    while (bytes_ + size > limits_.max_session_bytes) {
+        if (!DropOldest(key)) {
+            Drop(it);
+            return -1;
+        }
+    }
+    std::vector<uint8_t> buffer;
+    if (pool_ != nullptr && pool_->Acquire(&buffer) != 0) {
+        // Global memory cap reached, the fragment is requested again later.
+        if (msg.fragments.empty())
+            Drop(it);
+        return -1;
+    }
+    buffer.assign(body.begin() + skip, body.end());
+    msg.fragments[msg_head.packet_seq].swap(buffer);
+    msg.bytes += size;
+    bytes_ += size;
+    if (msg.fragments.size() < msg.head.total_packet)
+        return kFragmentStored;
+    // All fragments received, in packet sequence order.
+    message->clear();
+    message->reserve(msg.bytes);
+    for (auto const& fragment : msg.fragments)
+        message->insert(message->end(), fragment.second.begin(), fragment.second.end());
+    *head                         = msg.head;
+    head->msg_flow_num            = first;
+    head->msgbody_attr.bit.packet = 0;
+    head->total_packet            = 0;
+    head->packet_seq              = 0;
+    Drop(it);
+    return kMessageComplete;
+}
+
+void FragmentReassembler::CollectFillRequests(std::chrono::steady_clock::time_point const& now,
+                                              std::vector<FillPacketRequest>* requests) {
+    for (auto it = messages_.begin(); it != messages_.end();) {
+        auto& msg = it->second;
+        if (limits_.max_age_ms > 0 &&
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - msg.created).count() >= limits_.max_age_ms) {
+            it = Drop(it);
+            continue;
+        }
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(now - msg.last_active).count() <
+            limits_.timeout_ms) {
+            ++it;
+            continue;
+        }
+        if (msg.fill_requests >= limits_.max_fill_requests) {
+            it = Drop(it);
+            continue;
+        }
+        FillPacketRequest request;
+        request.msg_id                                = msg.head.msg_id;
+        request.fill_packet.first_packet_msg_flow_num = static_cast<uint16_t>(it->first & 0xFFFF);
+        uint32_t seq = 1;
+        for (auto const& fragment : msg.fragments) {
+            for (; seq < fragment.first && request.fill_packet.packet_id.size() < kMaxFillPacketIds; ++seq)
+                request.fill_packet.packet_id.push_back(static_cast<uint16_t>(seq));
+            seq = fragment.first + 1;
+        }
+        for (; seq <= msg.head.total_packet && request.fill_packet.packet_id.size() < kMaxFillPacketIds; ++seq)
+            request.fill_packet.packet_id.push_back(static_cast<uint16_t>(seq));
+        if (requests != nullptr)
+            requests->push_back(std::move(request));
+        ++msg.fill_requests;
+        msg.last_active = now;
+        ++it;
+    }
+}
+
+void FragmentReassembler::Clear(void) {
+    for (auto it = messages_.begin(); it != messages_.end();)
+        it = Drop(it);
+}
+
+std::map<uint32_t, FragmentReassembler::Message>::iterator FragmentReassembler::Drop(
+    std::map<uint32_t, Message>::iterator const& it) {
+    for (auto& fragment : it->second.fragments) {
+        bytes_ -= fragment.second.size();
+        if (pool_ != nullptr)
+            pool_->Release(&fragment.second);
+    }
+    return messages_.erase(it);
+}
+
+bool FragmentReassembler::DropOldest(uint32_t const& keep) {
+    auto oldest = messages_.end();
+    for (auto it = messages_.begin(); it != messages_.end(); ++it) {
+        if (it->first != keep && (oldest == messages_.end() || it->second.created < oldest->second.created))
+            oldest = it;
+    }
+    if (oldest == messages_.end())
+        return false;
+    Drop(oldest);
+    return true;
+}
+
+void FragmentRetransmitCache::Store(MsgHead const& msg_head, std::vector<uint8_t> const& frame) {
+    if (capacity_ == 0)
+        return;
+    while (fragments_.size() >= capacity_)
+        fragments_.pop_front();
+    Fragment fragment;
+    fragment.first_flow_num = FirstPacketFlowNum(msg_head);
+    fragment.packet_seq     = msg_head.packet_seq;
+    fragment.frame          = frame;
+    fragments_.push_back(std::move(fragment));
+}
+
+int FragmentRetransmitCache::Find(FillPacket const& fill_packet, std::vector<std::vector<uint8_t>>* frames) const {
+    if (frames == nullptr)
+        return 0;
+    int cnt = 0;
+    for (auto const& id : fill_packet.packet_id) {
+        // Newest first, flow numbers wrap around.
+        for (auto it = fragments_.rbegin(); it != fragments_.rend(); ++it) {
+            if (it->first_flow_num == fill_packet.first_packet_msg_flow_num && it->packet_seq == id) {
+                frames->push_back(it->frame);
+                ++cnt;
+                break;
+            }
+        }
+    }
+    return cnt;
+}
+
+} // namespace libjt808
@@ -42,70 +42,76 @@
 
 #include <algorithm>
 #include <chrono>
-#include <fstream>
+#include <tuple>
+#include <utility>
 
+#include "jt808/log.h"
 #include "jt808/socket_util.h"
 
 namespace libjt808 {
 
 namespace {
 
-// Display location report information.
+// Maximum number of unacknowledged platform commands tracked per client for the ack latency.
+constexpr size_t kMaxPendingAcks = 64;
+
+// Platform commands the terminal answers with a terminal general response.
+bool IsAcknowledgedCommand(uint16_t const& msg_id) {
+    switch (msg_id) {
+        case kPlatformGeneralResponse:
+        case kFillPacketRequest:
+        case kTerminalRegisterResponse:
+        case kGetTerminalParameters:
+        case kGetSpecificTerminalParameters:
+        case kGetLocationInformation:
+        case kMultimediaDataUploadResponse:
+            return false;
+        default:
+            return msg_id >= 0x8000;
+    }
+}
+
+// Log location report information.
 void PrintLocationReportInfo(ProtocolParameter const& para) {
+    if (!Logger::Instance().IsEnabled(kLogDebug))
+        return;
     auto const& basic_info     = para.parse.location_info;
     auto const& extension_info = para.parse.location_extension;
-    printf("Location Report:\n");
-    printf("  inout area alarm bit: %d\n", basic_info.alarm.bit.in_out_area);
-    printf("  position status: %d\n", basic_info.status.bit.positioning);
-    printf("  latitude: %.6lf\n", basic_info.latitude * 1e-6);
-    printf("  longitude: %.6lf\n", basic_info.longitude * 1e-6);
-    printf("  altitude: %d\n", basic_info.altitude);
-    printf("  speed: %f\n", basic_info.speed / 10.0f);
-    printf("  bearing: %d\n", basic_info.bearing);
-    printf("  time: %s\n", basic_info.time.c_str());
-    printf("  location extension:\n");
-    for (auto const& item : extension_info) {
-        printf("    id:%02X, len: %02X, value:", item.first, static_cast<uint8_t>(item.second.size()));
-        for (auto const& uch : item.second)
-            printf(" %02X", uch);
-        printf("\n");
-    }
+    JT808_LOG_DEBUG("Location report: inout area alarm bit: %d, position status: %d, latitude: %.6f, longitude: %.6f, "
+                    "altitude: %d, speed: %.1f, bearing: %d, time: %s",
+                    basic_info.alarm.bit.in_out_area, basic_info.status.bit.positioning, basic_info.latitude * 1e-6,
+                    basic_info.longitude * 1e-6, basic_info.altitude, basic_info.speed / 10.0, basic_info.bearing,
+                    basic_info.time.ToString());
+    for (auto const& item : extension_info)
+        JT808_LOG_DEBUG("  location extension id: %02X, len: %02X, value: %s", item.first, item.second.size(),
+                        LogBytes(item.second.data(), item.second.size()));
     auto it = extension_info.find(libjt808::kAccessAreaAlarm);
     if (it != extension_info.end()) {
         uint8_t  location_type;
         uint32_t area_route_id;
         uint8_t  direction;
-        printf("  in or out area and route information:\n");
-        if (libjt808::GetAccessAreaAlarmBody(it->second, &location_type, &area_route_id, &direction) == 0) {
-            printf("    location type: %d\n", location_type);
-            printf("    id: %04X\n", area_route_id);
-            printf("    direction: %d\n", direction);
-        }
+        if (libjt808::GetAccessAreaAlarmBody(it->second, &location_type, &area_route_id, &direction) == 0)
+            JT808_LOG_DEBUG("  in or out area and route information: location type: %d, id: %04X, direction: %d",
+                            location_type, area_route_id, direction);
     }
 }
 
-// Display terminal parameters.
+// Log terminal parameters.
 void PrintTerminalParameter(ProtocolParameter const& para) {
-    std::string str;
-    printf("Terminal Parameters:\n");
+    if (!Logger::Instance().IsEnabled(kLogInfo))
+        return;
+    JT808_LOG_INFO("Terminal parameters:");
     if (!para.terminal_parameter_ids.empty()) {
         for (auto const& id : para.terminal_parameter_ids) {
             auto const& it = para.parse.terminal_parameters.find(id);
-            if (it != para.parse.terminal_parameters.end()) {
-                printf("  ID:%08X, Length:%d, Value:", it->first, static_cast<int>(it->second.size()));
-                for (auto const& uch : it->second)
-                    printf(" %02X", uch);
-                printf("\n");
-            }
+            if (it != para.parse.terminal_parameters.end())
+                JT808_LOG_INFO("  ID:%08X, Length:%d, Value: %s", it->first, it->second.size(),
+                               LogBytes(it->second.data(), it->second.size()));
         }
     }
     else {
-        for (auto const& item : para.parse.terminal_parameters) {
-            printf("  ID:%08X, Value:", item.first);
-            for (auto const& uch : item.second)
-                printf(" %02X", uch);
-            printf("\n");
-        }
+        for (auto const& item : para.parse.terminal_parameters)
+            JT808_LOG_INFO("  ID:%08X, Value: %s", item.first, LogBytes(item.second.data(), item.second.size()));
     }
 }
 
@@ -120,6 +126,10 @@ void JT808Server::Init(void) {
     // Initialize the command parser and packager.
     JT808FrameParserInit(&parser_);
     JT808FramePackagerInit(&packager_);
+    // Default reassembly limits.
+    reassembler_limits_ = FragmentReassembler().limits();
+    // Callbacks of one client queued before its connection is paused.
+    handler_max_pending_ = 64;
     // Initialize thread running status.
     waiting_is_running_.store(false);
     service_is_running_.store(false);
@@ -135,7 +145,7 @@ int JT808Server::InitServer(void) {
     addr.sin_addr.s_addr = inet_addr(ip_.c_str());
     listen_              = socket(AF_INET, SOCK_STREAM, 0);
     if (listen_ == -1) {
-        printf("%s[%d]: Create socket failed!!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_ERROR("Create socket failed!!!");
         return -1;
     }
 #elif defined(_WIN32)
@@ -145,14 +155,14 @@ int JT808Server::InitServer(void) {
     }
     listen_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (listen_ == INVALID_SOCKET) {
-        printf("%s[%d]: Create socket failed!!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_ERROR("Create socket failed!!!");
         WSACleanup();
         return -1;
     }
     addr.sin_addr.S_un.S_addr = inet_addr(ip_.c_str());
 #endif
     if (Bind(listen_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
-        printf("%s[%d]: Connect to remote server failed!!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_ERROR("Bind %s:%d failed!!!", ip_, port_);
         Close(listen_);
 #if defined(_WIN32)
         WSACleanup();
@@ -181,8 +191,21 @@ void JT808Server::Stop(void) {
         std::this_thread::sleep_for(std::chrono::seconds(3));
         for (auto& socket : clients_) {
             Close(socket.first);
+            metrics_.OnSessionClosed();
         }
         clients_.erase(clients_.begin(), clients_.end());
+        receive_buffers_.clear();
+        reassemblers_.clear();
+        while (!handler_queues_.empty())
+            ReleaseHandlerQueue(handler_queues_.begin()->first);
+        handler_pool_.Stop();
+        {
+            std::unique_lock<std::mutex> lock(clients_mutex_);
+            for (auto& client : pending_clients_)
+                Close(client.first);
+            pending_clients_.clear();
+            phone_sockets_.clear();
+        }
         Close(listen_);
         listen_ = 0;
 #if defined(_WIN32)
@@ -195,63 +218,45 @@ void JT808Server::Stop(void) {
 int JT808Server::UpgradeRequest(decltype(socket(0, 0, 0)) const& socket, int const& upgrade_type,
                                 std::vector<uint8_t> const& manufacturer_id, std::string const& version_id,
                                 char const* path) {
-    std::ifstream ifs;
-    ifs.open(path, std::ios::in | std::ios::binary);
-    if (!ifs.is_open()) {
-        printf("%s[%d]: Updrade file open failed !!!\n", __FUNCTION__, __LINE__);
+    if (path == nullptr)
+        return -1;
+    auto image = firmware_cache_.Load(path, static_cast<uint8_t>(upgrade_type), manufacturer_id, version_id);
+    if (image == nullptr) {
+        JT808_LOG_ERROR("Updrade file open failed !!!");
         return -1;
     }
-    ifs.seekg(0, std::ios::end);
-    size_t length = ifs.tellg();
-    ifs.seekg(0, std::ios::beg);
-    std::unique_ptr<char[]> buffer(new char[length], std::default_delete<char[]>());
-    ifs.read(buffer.get(), length);
-    ifs.close();
+    return UpgradeRequest(socket, image);
+}
+
+int JT808Server::UpgradeRequest(decltype(socket(0, 0, 0)) const& socket, FirmwareImagePtr const& image) {
+    if (image == nullptr || image->fragments.empty())
+        return -1;
+    auto it = clients_.find(socket);
+    if (it == clients_.end())
+        return -1;
     is_upgrading_clients_.insert(std::make_pair(socket, 0));
-    auto& para = clients_[socket];
-    para.upgrade_info.manufacturer_id.assign(manufacturer_id.begin(), manufacturer_id.end());
-    para.upgrade_info.upgrade_type = upgrade_type;
-    para.upgrade_info.version_id   = version_id;
-    uint16_t max_content           = 1023 - 9 - para.upgrade_info.version_id.size();
-    if (length > max_content) {                    // Need to handle packet segmentation.
-        para.msg_head.msgbody_attr.bit.packet = 1; // Perform packet segmentation.
-        para.msg_head.total_packet            = static_cast<uint16_t>(ceil(length * 1.0 / max_content));
-        para.msg_head.packet_seq              = 1;
-        size_t len                            = 0;
-        for (size_t i = 0; i < length; i += max_content) {
-            len = length - i;
-            if (len > max_content)
-                len = max_content;
-            para.upgrade_info.upgrade_data.assign(buffer.get() + i, buffer.get() + i + len);
-            if (PackagingAndSendMessage(socket, kTerminalUpgrade, &para) < 0) {
-                is_upgrading_clients_.erase(socket);
-                return -1;
-            }
-            if (ReceiveAndParseMessage(socket, 5, &para) < 0) {
-                is_upgrading_clients_.erase(socket);
-                return -1;
-            }
-            if (para.parse.msg_head.msg_id != kTerminalGeneralResponse ||
-                para.parse.respone_msg_id != kTerminalUpgrade || para.parse.respone_result != kSuccess) {
-                is_upgrading_clients_.erase(socket);
-                return -1;
-            }
-            ++para.msg_head.packet_seq;
+    auto&                para = it->second;
+    std::vector<uint8_t> msg;
+    for (size_t i = 0; i < image->fragments.size(); ++i) {
+        if (PackageFirmwareFragment(para.msg_head, *image, i, &msg) < 0) {
+            JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Package message failed !!!");
+            is_upgrading_clients_.erase(socket);
+            return -1;
         }
-        para.msg_head.msgbody_attr.bit.packet = 0;
-        para.msg_head.total_packet            = 1;
-    }
-    else {
-        para.upgrade_info.upgrade_data.assign(buffer.get(), buffer.get() + length);
-        if (PackagingAndSendMessage(socket, kTerminalUpgrade, &para) < 0) {
+        ++para.msg_head.msg_flow_num; // Increment message flow number for each successfully generated command.
+        capture_tap_.Record(static_cast<uint32_t>(socket), kCaptureSent, msg.data(), msg.size());
+        if (Send(socket, reinterpret_cast<char*>(msg.data()), msg.size(), 0) <= 0) {
+            JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Send message failed !!!");
             is_upgrading_clients_.erase(socket);
             return -1;
         }
+        metrics_.OnFrameSent(kTerminalUpgrade, msg.size());
         if (ReceiveAndParseMessage(socket, 5, &para) < 0) {
             is_upgrading_clients_.erase(socket);
             return -1;
         }
-        if (para.parse.respone_msg_id != kTerminalUpgrade || para.parse.respone_result != kSuccess) {
+        if (para.parse.msg_head.msg_id != kTerminalGeneralResponse ||
+            para.parse.respone_msg_id != kTerminalUpgrade || para.parse.respone_result != kSuccess) {
             is_upgrading_clients_.erase(socket);
             return -1;
         }
@@ -267,14 +272,19 @@ int JT808Server::PackagingAndSendMessage(decltype(socket(0, 0, 0)) const& socket
     std::vector<uint8_t> msg;
     para->msg_head.msg_id = msg_id; // Set message ID.
     if (JT808FramePackage(packager_, *para, &msg) < 0) {
-        printf("%s[%d]: Package message failed !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Package message failed !!!");
         return -1;
     }
+    uint16_t const flow_num = para->msg_head.msg_flow_num;
     ++para->msg_head.msg_flow_num; // Increment message flow number for each successfully generated command.
+    capture_tap_.Record(static_cast<uint32_t>(socket), kCaptureSent, msg.data(), msg.size());
     if (Send(socket, reinterpret_cast<char*>(msg.data()), msg.size(), 0) <= 0) {
-        printf("%s[%d]: Send message failed !!!\n", __FUNCTION__, __LINE__);
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Send message failed !!!");
         return -2;
     }
+    metrics_.OnFrameSent(static_cast<uint16_t>(msg_id), msg.size());
+    if (IsAcknowledgedCommand(static_cast<uint16_t>(msg_id)))
+        TrackAck(socket, flow_num);
     return 0;
 }
 
@@ -289,10 +299,12 @@ int JT808Server::ReceiveAndParseMessage(decltype(socket(0, 0, 0)) const& socket,
     while (1) {
         if ((ret = Recv(socket, buffer.get(), 4096, 0)) > 0) {
             msg.assign(buffer.get(), buffer.get() + ret);
+            capture_tap_.Record(static_cast<uint32_t>(socket), kCaptureReceived, msg.data(), msg.size());
+            metrics_.OnBytesReceived(msg.size());
             break;
         }
         else if (ret == 0) {
-            printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
+            JT808_LOG_RATE_LIMITED(kLogInfo, 10, "Disconnect !!!");
             return -2;
         }
         else {
@@ -308,10 +320,13 @@ int JT808Server::ReceiveAndParseMessage(decltype(socket(0, 0, 0)) const& socket,
     if (msg.empty())
         return -2;
     // Parse the message.
-    if (JT808FrameParse(parser_, msg, para) == -1) {
-        printf("%s[%d]: Parse message failed !!!\n", __FUNCTION__, __LINE__);
+    ParseErrorReason reason = kParseSuccess;
+    if (JT808FrameParse(parser_, msg, para, &reason) == -1) {
+        metrics_.OnParseFailure(reason);
+        JT808_LOG_RATE_LIMITED(kLogWarn, 10, "Parse message failed !!!");
         return -1;
     }
+    metrics_.OnFrameReceived(para->parse.msg_head.msg_id);
     return 0;
 }
 
@@ -330,12 +345,15 @@ void JT808Server::WaitHandler(void) {
     while (waiting_is_running_) {
         auto socket = Accept(listen_, reinterpret_cast<struct sockaddr*>(&addr), &len);
         if (socket <= 0) {
-            printf("%s[%d]: Invalid socket!!!\n", __FUNCTION__, __LINE__);
+            JT808_LOG_ERROR("Invalid socket!!!");
             break;
         }
+        auto const accepted = std::chrono::steady_clock::now();
+        capture_tap_.Record(static_cast<uint32_t>(socket), kCaptureConnected, nullptr, 0);
         ProtocolParameter para {};
         if (ReceiveAndParseMessage(socket, 3, &para) < 0 || para.parse.msg_head.msg_id != kTerminalRegister) {
             Close(socket);
+            metrics_.OnHandshakeFailure();
             continue;
         }
         // Generate authentication code.
@@ -345,22 +363,26 @@ void JT808Server::WaitHandler(void) {
         para.respone_result = kRegisterSuccess;
         if (PackagingAndSendMessage(socket, kTerminalRegisterResponse, &para) < 0) {
             Close(socket);
+            metrics_.OnHandshakeFailure();
             continue;
         }
         // Wait for the authentication code to be returned.
         if (ReceiveAndParseMessage(socket, 3, &para) < 0) {
             Close(socket);
+            metrics_.OnHandshakeFailure();
             continue;
         }
         // Parse the returned message and compare the authentication code.
         if (para.parse.msg_head.msg_id != kTerminalAuthentication ||
             para.authentication_code != para.parse.authentication_code) {
             Close(socket);
+            metrics_.OnHandshakeFailure();
             continue;
         }
         para.respone_result = kSuccess;
         if (PackagingAndSendMessage(socket, kPlatformGeneralResponse, &para) < 0) {
             Close(socket);
+            metrics_.OnHandshakeFailure();
             continue;
         }
         // printf("Connected\n");
@@ -371,152 +393,459 @@ void JT808Server::WaitHandler(void) {
 #elif defined(_WIN32)
         unsigned long ul = 1;
         if (ioctlsocket(socket, FIONBIO, (unsigned long*)&ul) == SOCKET_ERROR) {
-            printf("%s[%d]: Set socket nonblock failed!!!\n", __FUNCTION__, __LINE__);
+            JT808_LOG_ERROR("Set socket nonblock failed!!!");
             Close(socket);
+            metrics_.OnHandshakeFailure();
             continue;
         }
 #endif
-        clients_.insert(std::make_pair(socket, para));
+        metrics_.OnHandshake(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - accepted).count());
+        std::unique_lock<std::mutex> lock(clients_mutex_);
+        pending_clients_.push_back(std::make_pair(socket, para));
     }
     waiting_is_running_.store(false);
     Stop();
 }
 
-// Main service thread, handles connected client threads.
+// Move the authenticated clients from the waiting thread into the main service thread.
+void JT808Server::AdoptPendingClients(void) {
+    std::unique_lock<std::mutex> lock(clients_mutex_);
+    for (auto& client : pending_clients_) {
+        auto const& phone = client.second.msg_head.phone_num;
+        // A reconnecting terminal replaces its previous connection.
+        auto it = phone_sockets_.find(phone);
+        if (it != phone_sockets_.end() && it->second != client.first) {
+            auto old = clients_.find(it->second);
+            if (old != clients_.end()) {
+                capture_tap_.Record(static_cast<uint32_t>(old->first), kCaptureDisconnected, nullptr, 0);
+                metrics_.OnSessionClosed();
+                Close(old->first);
+                receive_buffers_.erase(old->first);
+                reassemblers_.erase(old->first);
+                ReleaseHandlerQueue(old->first);
+                clients_.erase(old);
+            }
+        }
+        phone_sockets_[phone] = client.first;
+        clients_[client.first] = std::move(client.second);
+        metrics_.OnSessionOpened();
+    }
+    pending_clients_.clear();
+}
+
+std::map<decltype(socket(0, 0, 0)), ProtocolParameter>::iterator JT808Server::CloseClient(
+    std::map<decltype(socket(0, 0, 0)), ProtocolParameter>::iterator const& it) {
+    auto const& phone = it->second.msg_head.phone_num;
+    {
+        std::unique_lock<std::mutex> lock(clients_mutex_);
+        auto                         iter = phone_sockets_.find(phone);
+        if (iter != phone_sockets_.end() && iter->second == it->first)
+            phone_sockets_.erase(iter);
+    }
+    upgrade_scheduler_.OnTerminalOffline(phone);
+    capture_tap_.Record(static_cast<uint32_t>(it->first), kCaptureDisconnected, nullptr, 0);
+    metrics_.OnSessionClosed();
+    {
+        std::unique_lock<std::mutex> lock(pending_acks_mutex_);
+        pending_acks_.erase(it->first);
+    }
+    Close(it->first);
+    receive_buffers_.erase(it->first);
+    reassemblers_.erase(it->first);
+    ReleaseHandlerQueue(it->first);
+    return clients_.erase(it);
+}
+
+void JT808Server::Dispatch(decltype(socket(0, 0, 0)) const& socket, HandlerPool::Task&& task) {
+    if (!handler_pool_.is_running()) {
+        task();
+        return;
+    }
+    auto& queue = handler_queues_[socket];
+    if (queue.pending == nullptr)
+        queue.pending = std::make_shared<std::atomic<size_t>>(0);
+    queue.pending->fetch_add(1);
+    // The worker releases the slot, the queue entry may be gone by then.
+    auto const        pending = queue.pending;
+    HandlerPool::Task wrapped = std::bind(
+        [pending](HandlerPool::Task const& callback) {
+            callback();
+            pending->fetch_sub(1);
+        },
+        std::move(task));
+    if (queue.backlog.empty() && handler_pool_.TrySubmit(socket, std::move(wrapped)))
+        return;
+    queue.backlog.push_back(std::move(wrapped));
+}
+
+bool JT808Server::ResumeHandlerQueue(decltype(socket(0, 0, 0)) const& socket) {
+    auto it = handler_queues_.find(socket);
+    if (it == handler_queues_.end())
+        return true;
+    auto& queue = it->second;
+    while (!queue.backlog.empty() && handler_pool_.TrySubmit(socket, std::move(queue.backlog.front())))
+        queue.backlog.pop_front();
+    return queue.backlog.empty() && queue.pending->load() < handler_max_pending_;
+}
+
+void JT808Server::ReleaseHandlerQueue(decltype(socket(0, 0, 0)) const& socket) {
+    auto it = handler_queues_.find(socket);
+    if (it == handler_queues_.end())
+        return;
+    // Messages already acknowledged to the terminal must still reach the application.
+    for (auto& task : it->second.backlog)
+        handler_pool_.Submit(socket, std::move(task));
+    handler_queues_.erase(it);
+}
+
+int JT808Server::SendUpgradeFragment(std::string const& phone, FirmwareImage const& image, size_t const& index,
+                                     uint16_t* flow_num) {
+    decltype(socket(0, 0, 0)) socket;
+    {
+        std::unique_lock<std::mutex> lock(clients_mutex_);
+        auto                         it = phone_sockets_.find(phone);
+        if (it == phone_sockets_.end())
+            return -1;
+        socket = it->second;
+    }
+    auto it = clients_.find(socket);
+    if (it == clients_.end())
+        return -1;
+    // The blocking upgrade request owns the connection, the fragment is sent later.
+    if (is_upgrading_clients_.find(socket) != is_upgrading_clients_.end())
+        return 0;
+    auto&                para = it->second;
+    std::vector<uint8_t> msg;
+    if (PackageFirmwareFragment(para.msg_head, image, index, &msg) < 0)
+        return -1;
+    int ret = Send(socket, reinterpret_cast<char*>(msg.data()), msg.size(), 0);
+    if (ret <= 0) {
+#if defined(__linux__)
+        // Send buffer full, nothing was sent and the flow number is used again by the next attempt.
+        if (ret < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+            return 0;
+#elif defined(_WIN32)
+        auto wsa_errno = WSAGetLastError();
+        if (ret < 0 && (wsa_errno == WSAEINTR || wsa_errno == WSAEWOULDBLOCK))
+            return 0;
+#endif
+        return -1;
+    }
+    capture_tap_.Record(static_cast<uint32_t>(socket), kCaptureSent, msg.data(), ret);
+    if (static_cast<size_t>(ret) < msg.size()) {
+        // The rest of the frame can not follow another message without corrupting the stream. Closing the client here
+        // would reenter the scheduler, so the connection is shut down and closed by the service loop.
+#if defined(__linux__)
+        shutdown(socket, SHUT_RDWR);
+#elif defined(_WIN32)
+        shutdown(socket, SD_BOTH);
+#endif
+        return -1;
+    }
+    *flow_num = para.msg_head.msg_flow_num;
+    ++para.msg_head.msg_flow_num; // Increment message flow number for each successfully sent command.
+    metrics_.OnFrameSent(kTerminalUpgrade, msg.size());
+    TrackAck(socket, *flow_num);
+    return ret;
+}
+
+void JT808Server::TrackAck(decltype(socket(0, 0, 0)) const& socket, uint16_t const& flow_num) {
+    std::unique_lock<std::mutex> lock(pending_acks_mutex_);
+    auto&                        pending = pending_acks_[socket];
+    // Commands that are never acknowledged must not pile up.
+    if (pending.size() >= kMaxPendingAcks)
+        pending.erase(pending.begin());
+    pending[flow_num] = std::chrono::steady_clock::now();
+}
+
+void JT808Server::OnAck(decltype(socket(0, 0, 0)) const& socket, uint16_t const& flow_num) {
+    std::chrono::steady_clock::time_point sent;
+    {
+        std::unique_lock<std::mutex> lock(pending_acks_mutex_);
+        auto                         it = pending_acks_.find(socket);
+        if (it == pending_acks_.end())
+            return;
+        auto command = it->second.find(flow_num);
+        if (command == it->second.end())
+            return;
+        sent = command->second;
+        it->second.erase(command);
+    }
+    metrics_.OnAck(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sent).count());
+}
+
+// Handle one parsed message.
 // Currently supports displaying location report information and terminal parameter query responses.
 // For all non-response commands, it temporarily responds with a platform general response, with a response result of 0.
+int JT808Server::HandleMessage(decltype(socket(0, 0, 0)) const& socket, ProtocolParameter* para) {
+    static std::vector<uint16_t> const response_cmd = {
+        kResponseCommand, kResponseCommand + sizeof(kResponseCommand) / sizeof(kResponseCommand[0])};
+    para->respone_result = kSuccess;
+    auto const& msg_id   = para->parse.msg_head.msg_id;
+    if (msg_id == kLocationReport) {
+        PrintLocationReportInfo(*para);
+    }
+    else if (msg_id == kGetTerminalParametersResponse) {
+        PrintTerminalParameter(*para);
+    }
+    else if (msg_id == kTerminalGeneralResponse) {
+        OnAck(socket, para->parse.respone_flow_num);
+        if (para->parse.respone_msg_id == kTerminalUpgrade)
+            upgrade_scheduler_.OnFragmentAck(para->msg_head.phone_num, para->parse.respone_flow_num,
+                                             para->parse.respone_result);
+    }
+    else if (msg_id == kTerminalUpgradeResultReport) {
+        upgrade_scheduler_.OnUpgradeResult(para->msg_head.phone_num, para->parse.upgrade_info.upgrade_result);
+    }
+    else if (msg_id == kMultimediaDataUpload) { // Multimedia data upload, fragments are already reassembled.
+        auto& media = para->parse.multimedia_upload;
+        // Temporarily return success directly.
+        auto& resp    = para->multimedia_upload_response;
+        resp.media_id = media.media_id;
+        resp.reload_packet_ids.clear();
+        if (multimedia_data_upload_callback_ != nullptr) {
+            auto const upload = std::make_shared<MultiMediaDataUpload>(std::move(media));
+            Dispatch(socket, [this, upload]() { multimedia_data_upload_callback_(*upload); });
+        }
+        media.media_data.clear();
+        media.loaction_report_body.clear();
+        if (PackagingAndSendMessage(socket, kMultimediaDataUploadResponse, para) < 0)
+            return -1;
+    }
+    // For non-response commands, the default is to use the platform general response.
+    if (find(response_cmd.begin(), response_cmd.end(), msg_id) == response_cmd.end()) {
+        if (PackagingAndSendMessage(socket, kPlatformGeneralResponse, para) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+int JT808Server::HandleMessageView(decltype(socket(0, 0, 0)) const& socket, MsgHead const& msg_head,
+                                   ByteSpan const& body, ProtocolParameter* para) {
+    if (!message_callbacks_.empty()) {
+        auto it = message_callbacks_.find(msg_head.msg_id);
+        if (it != message_callbacks_.end())
+            it->second(msg_head, body);
+    }
+    bool valid = true;
+    switch (msg_head.msg_id) {
+        case kLocationReport: {
+            LocationReportView const view(body);
+            if (geofence_event_callback_ != nullptr && view.valid())
+                EvaluateGeofence(socket, msg_head, view);
+            if (location_report_callback_ == nullptr)
+                return 0;
+            if ((valid = view.valid()))
+                location_report_callback_(msg_head, view);
+            break;
+        }
+        case kBatchLocationReport: {
+            if (batch_location_report_callback_ == nullptr)
+                return 0;
+            BatchLocationReportView const view(body);
+            if ((valid = view.valid()))
+                batch_location_report_callback_(msg_head, view);
+            break;
+        }
+        case kCANBroadcastData: {
+            if (can_broadcast_callback_ == nullptr)
+                return 0;
+            CANBroadcastView const view(body);
+            if ((valid = view.valid()))
+                can_broadcast_callback_(msg_head, view);
+            break;
+        }
+        case kTerminalHeartBeat:
+            if (heartbeat_callback_ == nullptr)
+                return 0;
+            heartbeat_callback_(msg_head);
+            break;
+        case kTerminalUpgradeResultReport:
+            if (upgrade_result_callback_ != nullptr) {
+                UpgradeResultView const view(body);
+                if (view.valid())
+                    upgrade_result_callback_(msg_head, view);
+            }
+            return 0; // The upgrade scheduler needs the parsed result.
+        default:
+            return 0;
+    }
+    if (!valid) {
+        metrics_.OnParseFailure(kParseBodyError);
+        return 1;
+    }
+    para->parse.msg_head     = msg_head;
+    para->msg_head.phone_num = msg_head.phone_num;
+    para->respone_result     = kSuccess;
+    if (PackagingAndSendMessage(socket, kPlatformGeneralResponse, para) < 0)
+        return -1;
+    return 1;
+}
+
+void JT808Server::EvaluateGeofence(decltype(socket(0, 0, 0)) const& socket, MsgHead const& msg_head,
+                                   LocationReportView const& report) {
+    geofence_events_.clear();
+    if (geofence_.Evaluate(msg_head.phone_num, report, &geofence_events_) <= 0)
+        return;
+    for (auto const& event : geofence_events_) {
+        std::string const phone = msg_head.phone_num;
+        Dispatch(socket, [this, phone, event]() { geofence_event_callback_(phone, event); });
+    }
+}
+
+int JT808Server::HandleFrame(decltype(socket(0, 0, 0)) const& socket, std::vector<uint8_t> const& frame,
+                             ProtocolParameter* para) {
+    std::vector<uint8_t> decoded;
+    MsgHead              msg_head;
+    ParseErrorReason     reason = kParseSuccess;
+    if (JT808FrameDecode(frame, &decoded, &msg_head, &reason) != 0) {
+        metrics_.OnParseFailure(reason);
+        return 0;
+    }
+    metrics_.OnFrameReceived(msg_head.msg_id);
+    if (msg_head.msgbody_attr.bit.packet == 0 || msg_head.total_packet == 0) {
+        // Decoded frame: flag, header, body, checksum, flag.
+        size_t const pos = msg_head.msgbody_attr.bit.packet == 1 ? MSGBODY_PACKET_POS : MSGBODY_NOPACKET_POS;
+        size_t const len = msg_head.msgbody_attr.bit.msglen;
+        if (pos + len + 2 <= decoded.size()) {
+            int const ret = HandleMessageView(socket, msg_head, ByteSpan(decoded.data() + pos, len), para);
+            if (ret != 0)
+                return ret < 0 ? -1 : 0;
+        }
+        if (JT808DecodedFrameParse(parser_, decoded, msg_head, para, &reason) != 0) {
+            metrics_.OnParseFailure(reason);
+            return 0;
+        }
+        return HandleMessage(socket, para);
+    }
+    // Fragment, acknowledged on its own and handled once the message is complete.
+    std::vector<uint8_t> body(decoded.begin() + MSGBODY_PACKET_POS, decoded.end() - 2);
+    MsgHead              head;
+    std::vector<uint8_t> message;
+    auto it = reassemblers_.find(socket);
+    if (it == reassemblers_.end()) {
+        it = reassemblers_
+                 .emplace(std::piecewise_construct, std::forward_as_tuple(socket), std::forward_as_tuple(&fragment_pool_))
+                 .first;
+        it->second.set_limits(reassembler_limits_);
+        for (auto const& item : repeated_header_length_)
+            it->second.SetRepeatedHeaderLength(item.first, item.second);
+    }
+    int ret = it->second.AddFragment(msg_head, body, std::chrono::steady_clock::now(), &head, &message);
+    para->parse.msg_head = msg_head;
+    para->respone_result = ret < 0 ? kFailure : kSuccess;
+    if (PackagingAndSendMessage(socket, kPlatformGeneralResponse, para) < 0)
+        return -1;
+    if (ret != FragmentReassembler::kMessageComplete)
+        return 0;
+    ret = HandleMessageView(socket, head, ByteSpan(message.data(), message.size()), para);
+    if (ret != 0)
+        return ret < 0 ? -1 : 0;
+    if (JT808MessageParse(parser_, head, message, para) != 0) {
+        metrics_.OnParseFailure(parser_.find(head.msg_id) == parser_.end() ? kParseUnknownMsgId : kParseBodyError);
+        return 0;
+    }
+    // Keep the fragment count for the handlers.
+    para->parse.msg_head.total_packet = msg_head.total_packet;
+    return HandleMessage(socket, para);
+}
+
+void JT808Server::RequestMissingFragments(void) {
+    auto const                     now = std::chrono::steady_clock::now();
+    std::vector<FillPacketRequest> requests;
+    for (auto it = reassemblers_.begin(); it != reassemblers_.end(); ++it) {
+        if (it->second.size() == 0)
+            continue;
+        requests.clear();
+        it->second.CollectFillRequests(now, &requests);
+        auto client = clients_.find(it->first);
+        if (client == clients_.end())
+            continue;
+        for (auto const& request : requests) {
+            client->second.fill_packet = request.fill_packet;
+            PackagingAndSendMessage(it->first, kFillPacketRequest, &client->second);
+        }
+    }
+}
+
+// Main service thread, handles connected client threads.
+// Received bytes are buffered per client and split into complete frames, so frames split or coalesced by TCP are
+// handled correctly. Upgrade campaigns are driven from here as well.
 // When a client connection is disconnected, the related socket and terminal parameters are removed.
 void JT808Server::ServiceHandler(void) {
     service_is_running_.store(true);
-    int                     ret   = -1;
-    bool                    alive = false;
-    std::unique_ptr<char[]> buffer(new char[4096], std::default_delete<char[]>());
-    std::vector<uint8_t>    msg;
-    std::vector<uint16_t>   response_cmd = {kResponseCommand,
-                                            kResponseCommand + sizeof(kResponseCommand) / sizeof(kResponseCommand[0])};
-    std::unique_ptr<char[]> data_buffer;
-    int                     total_size      = 0;
-    int                     packet_max_size = 0;
+    int                               ret   = -1;
+    bool                              alive = false;
+    std::unique_ptr<char[]>           buffer(new char[4096], std::default_delete<char[]>());
+    std::vector<std::vector<uint8_t>> frames;
+    auto                              sender = [this](std::string const& phone, FirmwareImage const& image,
+                                                      size_t const& index, uint16_t* flow_num) -> int {
+        return SendUpgradeFragment(phone, image, index, flow_num);
+    };
     while (service_is_running_) {
-        for (auto& socket : clients_) {
+        AdoptPendingClients();
+        upgrade_scheduler_.Poll(std::chrono::steady_clock::now(), sender);
+        RequestMissingFragments();
+        for (auto it = clients_.begin(); it != clients_.end();) {
+            auto const socket = it->first;
             // Upgrade requests are not handled here.
-            if (is_upgrading_clients_.find(socket.first) != is_upgrading_clients_.end()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (is_upgrading_clients_.find(socket) != is_upgrading_clients_.end()) {
+                ++it;
+                continue;
+            }
+            // Leave the bytes in the socket while the callbacks of this client are behind.
+            if (handler_pool_.is_running() && !ResumeHandlerQueue(socket)) {
+                ++it;
                 continue;
             }
-            if ((ret = Recv(socket.first, buffer.get(), 4096, 0)) > 0) {
+            if ((ret = Recv(socket, buffer.get(), 4096, 0)) > 0) {
                 if (!alive)
                     alive = true;
-                msg.assign(buffer.get(), buffer.get() + ret);
-                // printf("Recv[%d]: ", ret);
-                // for (auto const& ch : msg) printf("%02X ", ch);
-                // printf("\n");
-                if (JT808FrameParse(parser_, msg, &socket.second) == 0) {
-                    socket.second.respone_result = kSuccess;
-                    auto const& msg_id           = socket.second.parse.msg_head.msg_id;
-                    if (msg_id == kLocationReport) {
-                        PrintLocationReportInfo(socket.second);
-                    }
-                    else if (msg_id == kGetTerminalParametersResponse) {
-                        PrintTerminalParameter(socket.second);
-                    }
-                    else if (msg_id == kMultimediaDataUpload) { // Multimedia data upload.
-                        // TODO: No packet integrity check is performed.
-                        auto&       media       = socket.second.parse.multimedia_upload;
-                        auto const& msg_head    = socket.second.parse.msg_head;
-                        auto const& packet_size = media.media_data.size();
-                        // Check for packet segmentation.
-                        if (msg_head.msgbody_attr.bit.packet == 1) { // Segmented packet.
-                            // Allocate space.
-                            if (msg_head.packet_seq == 1) { // First packet.
-                                int max_len = (1023 - 36) * msg_head.total_packet;
-                                data_buffer = std::move(
-                                    std::unique_ptr<char[]>(new char[max_len], std::default_delete<char[]>()));
-                                // Maximum data length of sub-packet.
-                                packet_max_size = packet_size;
-                                total_size      = 0;
-                            }
-                            memcpy(&(data_buffer[packet_max_size * (msg_head.packet_seq - 1)]), media.media_data.data(),
-                                   packet_size);
-                            total_size += packet_size;
-                            socket.second.respone_result = kSuccess;
-                            if (PackagingAndSendMessage(socket.first, kPlatformGeneralResponse, &socket.second) < 0) {
-                                printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-                                data_buffer.reset();
-                                Close(socket.first);
-                                clients_.erase(socket.first);
-                                break; // When deleting a connection, do not continue traversing, but restart
-                                       // traversing.
-                            }
-                            // Wait for all data to be transmitted.
-                            if (msg_head.packet_seq == msg_head.total_packet) {
-                                media.media_data.clear();
-                                media.media_data.assign(data_buffer.get(), data_buffer.get() + total_size);
-                                multimedia_data_upload_callback_(media);
-                                media.media_data.clear();
-                                media.loaction_report_body.clear();
-                                data_buffer.reset();
-                                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                                // Temporarily return success directly.
-                                auto& resp    = socket.second.multimedia_upload_response;
-                                resp.media_id = media.media_id;
-                                resp.reload_packet_ids.clear();
-                                if (PackagingAndSendMessage(socket.first, kMultimediaDataUploadResponse,
-                                                            &socket.second) < 0) {
-                                    printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-                                    Close(socket.first);
-                                    clients_.erase(socket.first);
-                                    break; // When deleting a connection, do not continue traversing, but restart
-                                           // traversing.
-                                }
-                            }
-                        }
-                        else { // Not segmented.
-                            multimedia_data_upload_callback_(media);
-                            media.media_data.clear();
-                            media.loaction_report_body.clear();
-                            socket.second.multimedia_upload_response.media_id = media.media_id;
-                            if (PackagingAndSendMessage(socket.first, kMultimediaDataUploadResponse, &socket.second) <
-                                0) {
-                                printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-                                Close(socket.first);
-                                clients_.erase(socket.first);
-                                break; // When deleting a connection, do not continue traversing, but restart
-                                       // traversing.
-                            }
-                        }
-                    }
-                    // For non-response commands, the default is to use the platform general response.
-                    if (find(response_cmd.begin(), response_cmd.end(), msg_id) == response_cmd.end()) {
-                        if (PackagingAndSendMessage(socket.first, kPlatformGeneralResponse, &socket.second) < 0) {
-                            printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-                            Close(socket.first);
-                            clients_.erase(socket.first);
-                            break; // When deleting a connection, do not continue traversing, but restart traversing.
-                        }
+                capture_tap_.Record(static_cast<uint32_t>(socket), kCaptureReceived, buffer.get(), ret);
+                metrics_.OnBytesReceived(ret);
+                auto& stream = receive_buffers_[socket];
+                stream.insert(stream.end(), buffer.get(), buffer.get() + ret);
+                frames.clear();
+                JT808FrameExtract(&stream, &frames);
+                // Drop garbage that never forms a frame.
+                if (stream.size() > 64 * 1024)
+                    stream.clear();
+                bool closed = false;
+                for (auto const& frame : frames) {
+                    if (HandleFrame(socket, frame, &it->second) < 0) {
+                        closed = true;
+                        break;
                     }
                 }
+                if (closed) {
+                    JT808_LOG_RATE_LIMITED(kLogInfo, 10, "Disconnect !!!");
+                    it = CloseClient(it);
+                }
+                else {
+                    ++it;
+                }
                 continue;
             }
-            else if (ret <= 0) {
-                if (ret < 0) {
+            if (ret < 0) {
 #if defined(__linux__)
-                    if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
-                        continue;
-                    }
+                if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                    ++it;
+                    continue;
+                }
 #elif defined(_WIN32)
-                    auto wsa_errno = WSAGetLastError();
-                    if (wsa_errno == WSAEINTR || wsa_errno == WSAEWOULDBLOCK)
-                        continue;
-#endif
+                auto wsa_errno = WSAGetLastError();
+                if (wsa_errno == WSAEINTR || wsa_errno == WSAEWOULDBLOCK) {
+                    ++it;
+                    continue;
                 }
-                printf("%s[%d]: Disconnect !!!\n", __FUNCTION__, __LINE__);
-                Close(socket.first);
-                clients_.erase(socket.first);
-                if (!alive)
-                    alive = true;
-                break; // When deleting a connection, do not continue traversing, but restart traversing.
+#endif
             }
+            JT808_LOG_RATE_LIMITED(kLogInfo, 10, "Disconnect !!!");
+            it = CloseClient(it);
+            if (!alive)
+                alive = true;
         }
         if (!alive) {
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
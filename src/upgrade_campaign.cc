@@ -0,0 +1,317 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  upgrade_campaign.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 10:02:43
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/upgrade_campaign.h"
+
+#include <algorithm>
+
+#include "jt808/protocol_parameter.h"
+
+namespace libjt808 {
+
+namespace {
+
+bool IsFinalState(UpgradeTerminalState const& state) {
+    return state == kUpgradeSucceeded || state == kUpgradeFailed || state == kUpgradeOffline ||
+           state == kUpgradeCanceled;
+}
+
+} // namespace
+
+UpgradeCampaignScheduler::UpgradeCampaignScheduler()
+    : next_campaign_id_(1)
+    , tokens_(0.0)
+    , last_refill_(std::chrono::steady_clock::now()) {
+    config_.max_bytes_per_second     = 0;
+    config_.max_concurrent_transfers = 64;
+    config_.ack_timeout_ms           = 5000;
+    config_.max_retries              = 3;
+    config_.result_timeout_ms        = 300000;
+}
+
+int UpgradeCampaignScheduler::CreateCampaign(std::vector<std::string> const& phones, FirmwareImagePtr const& image) {
+    if (image == nullptr || image->fragments.empty() || phones.empty())
+        return -1;
+    std::unique_lock<std::mutex> lock(mutex_);
+    int                          id       = next_campaign_id_++;
+    auto&                        campaign = campaigns_[id];
+    campaign.image                        = image;
+    campaign.transfers.resize(phones.size());
+    for (size_t i = 0; i < phones.size(); ++i) {
+        auto& transfer                     = campaign.transfers[i];
+        transfer.campaign_id               = id;
+        transfer.progress.phone            = phones[i];
+        transfer.progress.state            = kUpgradePending;
+        transfer.progress.acked_fragments  = 0;
+        transfer.progress.total_fragments  = static_cast<uint16_t>(image->fragments.size());
+        transfer.progress.bytes_sent       = 0;
+        transfer.progress.retries          = 0;
+        transfer.progress.upgrade_result   = 0;
+        transfer.next_fragment             = 0;
+        transfer.fragment_retries          = 0;
+        transfer.waiting_ack               = false;
+        transfer.flow_num                  = 0;
+        pending_.push_back(std::make_pair(id, i));
+    }
+    return id;
+}
+
+int UpgradeCampaignScheduler::CancelCampaign(int const& campaign_id) {
+    std::vector<std::pair<int, UpgradeProgress>> done;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto                         it = campaigns_.find(campaign_id);
+        if (it == campaigns_.end())
+            return -1;
+        for (auto& transfer : it->second.transfers) {
+            if (!IsFinalState(transfer.progress.state))
+                Finish(&transfer, kUpgradeCanceled, &done);
+        }
+    }
+    NotifyFinished(done);
+    return 0;
+}
+
+void UpgradeCampaignScheduler::RemoveCampaign(int const& campaign_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto                         it = campaigns_.find(campaign_id);
+    if (it == campaigns_.end())
+        return;
+    for (auto iter = active_.begin(); iter != active_.end();) {
+        if (iter->second->campaign_id == campaign_id)
+            iter = active_.erase(iter);
+        else
+            ++iter;
+    }
+    for (auto iter = pending_.begin(); iter != pending_.end();) {
+        if (iter->first == campaign_id)
+            iter = pending_.erase(iter);
+        else
+            ++iter;
+    }
+    campaigns_.erase(it);
+}
+
+int UpgradeCampaignScheduler::GetCampaignProgress(int const& campaign_id, std::vector<UpgradeProgress>* progress) const {
+    if (progress == nullptr)
+        return -1;
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto                         it = campaigns_.find(campaign_id);
+    if (it == campaigns_.end())
+        return -1;
+    progress->clear();
+    progress->reserve(it->second.transfers.size());
+    for (auto const& transfer : it->second.transfers)
+        progress->push_back(transfer.progress);
+    return 0;
+}
+
+bool UpgradeCampaignScheduler::IsCampaignFinished(int const& campaign_id) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto                         it = campaigns_.find(campaign_id);
+    if (it == campaigns_.end())
+        return true;
+    for (auto const& transfer : it->second.transfers) {
+        if (!IsFinalState(transfer.progress.state))
+            return false;
+    }
+    return true;
+}
+
+bool UpgradeCampaignScheduler::IsUpgrading(std::string const& phone) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return active_.find(phone) != active_.end();
+}
+
+void UpgradeCampaignScheduler::Poll(std::chrono::steady_clock::time_point const& now, FragmentSender const& sender) {
+    std::vector<std::pair<int, UpgradeProgress>> done;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Refill the token bucket, at most one second of burst.
+        if (config_.max_bytes_per_second > 0) {
+            auto   elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - last_refill_).count();
+            double rate    = static_cast<double>(config_.max_bytes_per_second);
+            if (elapsed > 0)
+                tokens_ += rate * elapsed / 1000000.0;
+            if (tokens_ > rate)
+                tokens_ = rate;
+        }
+        last_refill_ = now;
+        // Admit waiting terminals. A terminal already upgrading in another campaign is kept waiting.
+        size_t waiting = pending_.size();
+        while (waiting-- > 0 && active_.size() < config_.max_concurrent_transfers) {
+            auto entry = pending_.front();
+            pending_.pop_front();
+            auto it = campaigns_.find(entry.first);
+            if (it == campaigns_.end())
+                continue;
+            auto& transfer = it->second.transfers[entry.second];
+            if (transfer.progress.state != kUpgradePending)
+                continue;
+            if (active_.find(transfer.progress.phone) != active_.end()) {
+                pending_.push_back(entry);
+                continue;
+            }
+            transfer.progress.state          = kUpgradeTransferring;
+            active_[transfer.progress.phone] = &transfer;
+        }
+        // Timeouts and sending.
+        for (auto it = active_.begin(); it != active_.end();) {
+            Transfer* transfer = it->second;
+            ++it;
+            if (transfer->progress.state == kUpgradeWaitingResult) {
+                if (now >= transfer->deadline)
+                    Finish(transfer, kUpgradeFailed, &done);
+                continue;
+            }
+            // Retransmit the fragment in flight once its ack timed out.
+            bool const retransmit = transfer->waiting_ack;
+            if (retransmit) {
+                if (now < transfer->deadline)
+                    continue;
+                if (transfer->fragment_retries >= config_.max_retries) {
+                    Finish(transfer, kUpgradeFailed, &done);
+                    continue;
+                }
+            }
+            auto const&  image   = *campaigns_[transfer->campaign_id].image;
+            size_t const index   = transfer->next_fragment;
+            auto const&  frag    = image.fragments[index];
+            // Rough frame size for the budget: header + escaped body + checksum + flags.
+            // A frame larger than the burst goes out once the bucket is full, the debt is paid back by the refill.
+            double const cost    = static_cast<double>(frag.escaped_body.size() + 20);
+            double const rate    = static_cast<double>(config_.max_bytes_per_second);
+            if (config_.max_bytes_per_second > 0 && tokens_ < std::min(cost, rate))
+                continue;
+            uint16_t flow_num = 0;
+            int      ret      = sender(transfer->progress.phone, image, index, &flow_num);
+            if (ret < 0) {
+                Finish(transfer, kUpgradeOffline, &done);
+                continue;
+            }
+            // Deferred, nothing was sent: no ack to wait for and no retry used.
+            if (ret == 0)
+                continue;
+            if (retransmit) {
+                ++transfer->fragment_retries;
+                ++transfer->progress.retries;
+            }
+            if (config_.max_bytes_per_second > 0)
+                tokens_ -= ret;
+            transfer->progress.bytes_sent += ret;
+            transfer->waiting_ack = true;
+            transfer->flow_num    = flow_num;
+            transfer->deadline    = now + std::chrono::milliseconds(config_.ack_timeout_ms);
+        }
+    }
+    NotifyFinished(done);
+}
+
+void UpgradeCampaignScheduler::OnFragmentAck(std::string const& phone, uint16_t const& flow_num,
+                                             uint8_t const& result) {
+    std::vector<std::pair<int, UpgradeProgress>> done;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto                         it = active_.find(phone);
+        if (it == active_.end())
+            return;
+        Transfer* transfer = it->second;
+        if (!transfer->waiting_ack || transfer->flow_num != flow_num)
+            return;
+        transfer->waiting_ack = false;
+        if (result != kSuccess) {
+            Finish(transfer, kUpgradeFailed, &done);
+        }
+        else {
+            ++transfer->progress.acked_fragments;
+            ++transfer->next_fragment;
+            transfer->fragment_retries = 0;
+            if (transfer->next_fragment >= transfer->progress.total_fragments) {
+                transfer->progress.state = kUpgradeWaitingResult;
+                transfer->deadline       = std::chrono::steady_clock::now() +
+                                     std::chrono::milliseconds(config_.result_timeout_ms);
+            }
+        }
+    }
+    NotifyFinished(done);
+}
+
+void UpgradeCampaignScheduler::OnUpgradeResult(std::string const& phone, uint8_t const& result) {
+    std::vector<std::pair<int, UpgradeProgress>> done;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto                         it = active_.find(phone);
+        if (it == active_.end())
+            return;
+        Transfer* transfer = it->second;
+        if (transfer->progress.state != kUpgradeWaitingResult)
+            return;
+        transfer->progress.upgrade_result = result;
+        Finish(transfer, result == kTerminalUpgradeSuccess ? kUpgradeSucceeded : kUpgradeFailed, &done);
+    }
+    NotifyFinished(done);
+}
+
+void UpgradeCampaignScheduler::OnTerminalOffline(std::string const& phone) {
+    std::vector<std::pair<int, UpgradeProgress>> done;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto                         it = active_.find(phone);
+        if (it == active_.end())
+            return;
+        Finish(it->second, kUpgradeOffline, &done);
+    }
+    NotifyFinished(done);
+}
+
+void UpgradeCampaignScheduler::Finish(Transfer* transfer, UpgradeTerminalState const& state,
+                                      std::vector<std::pair<int, UpgradeProgress>>* done) {
+    transfer->progress.state = state;
+    transfer->waiting_ack    = false;
+    auto it                  = active_.find(transfer->progress.phone);
+    if (it != active_.end() && it->second == transfer)
+        active_.erase(it);
+    done->push_back(std::make_pair(transfer->campaign_id, transfer->progress));
+}
+
+void UpgradeCampaignScheduler::NotifyFinished(std::vector<std::pair<int, UpgradeProgress>> const& done) {
+    if (done.empty())
+        return;
+    FinishedCallback callback;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        callback = finished_callback_;
+    }
+    if (callback == nullptr)
+        return;
+    for (auto const& item : done)
+        callback(item.first, item.second);
+}
+
+} // namespace libjt808
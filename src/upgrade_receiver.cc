@@ -0,0 +1,182 @@
+// MIT License
+//
+// Copyright (c) 2020 Yuming Meng
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// @File    :  upgrade_receiver.cc
+// @Version :  1.0
+// @Time    :  2026/10/19 11:09:20
+// @Author  :  Meng Yuming
+// @Contact :  mengyuming@hotmail.com
+// @Desc    :  None
+
+#include "jt808/upgrade_receiver.h"
+
+namespace libjt808 {
+
+namespace {
+
+// Version of the Save() layout.
+constexpr uint8_t kUpgradeReceiverStateVersion = 1;
+
+void AppendU16(uint16_t const& val, std::vector<uint8_t>* out) {
+    out->push_back(static_cast<uint8_t>(val >> 8));
+    out->push_back(static_cast<uint8_t>(val));
+}
+
+void AppendU32(uint32_t const& val, std::vector<uint8_t>* out) {
+    out->push_back(static_cast<uint8_t>(val >> 24));
+    out->push_back(static_cast<uint8_t>(val >> 16));
+    out->push_back(static_cast<uint8_t>(val >> 8));
+    out->push_back(static_cast<uint8_t>(val));
+}
+
+uint16_t ReadU16(uint8_t const* in) {
+    return static_cast<uint16_t>(in[0] << 8 | in[1]);
+}
+
+uint32_t ReadU32(uint8_t const* in) {
+    return static_cast<uint32_t>(in[0]) << 24 | static_cast<uint32_t>(in[1]) << 16 |
+           static_cast<uint32_t>(in[2]) << 8 | static_cast<uint32_t>(in[3]);
+}
+
+} // namespace
+
+void UpgradeReceiver::Reset(void) {
+    upgrade_type_     = 0;
+    total_len_        = 0;
+    total_packet_     = 0;
+    fragment_size_    = 0;
+    received_packets_ = 0;
+    received_bytes_   = 0;
+    version_id_.clear();
+    bitmap_.clear();
+}
+
+int UpgradeReceiver::Accept(UpgradeInfo const& info, uint16_t const& total_packet, uint16_t const& packet_seq,
+                            uint32_t* offset) {
+    if (offset == nullptr || total_packet == 0 || packet_seq == 0 || packet_seq > total_packet)
+        return -1;
+    uint32_t const size = static_cast<uint32_t>(info.upgrade_data.size());
+    if (size == 0 || size > info.upgrade_data_total_len)
+        return -1;
+    // A different upgrade restarts the tracking.
+    if (info.upgrade_type != upgrade_type_ || info.version_id != version_id_ ||
+        info.upgrade_data_total_len != total_len_ || total_packet != total_packet_) {
+        Reset();
+        upgrade_type_ = info.upgrade_type;
+        version_id_   = info.version_id;
+        total_len_    = info.upgrade_data_total_len;
+        total_packet_ = total_packet;
+        bitmap_.assign((total_packet + 7) / 8, 0);
+    }
+    if (packet_seq == total_packet) { // Last fragment, aligned to the end of the package.
+        *offset = total_len_ - size;
+        if (total_packet > 1) {
+            uint32_t const expected = *offset / (total_packet - 1);
+            if (*offset % (total_packet - 1) != 0 || (fragment_size_ != 0 && fragment_size_ != expected))
+                return -1;
+            fragment_size_ = expected;
+        }
+        else if (*offset != 0) {
+            return -1;
+        }
+    }
+    else {
+        if (fragment_size_ == 0)
+            fragment_size_ = size;
+        if (size != fragment_size_)
+            return -1;
+        uint64_t const end = static_cast<uint64_t>(packet_seq) * fragment_size_;
+        if (end > total_len_)
+            return -1;
+        *offset = static_cast<uint32_t>(end - size);
+    }
+    return IsReceived(packet_seq) ? kDuplicateFragment : kNewFragment;
+}
+
+void UpgradeReceiver::MarkReceived(uint16_t const& packet_seq, uint32_t const& size) {
+    if (packet_seq == 0 || packet_seq > total_packet_ || IsReceived(packet_seq))
+        return;
+    bitmap_[(packet_seq - 1) >> 3] |= static_cast<uint8_t>(1 << ((packet_seq - 1) & 0x7));
+    ++received_packets_;
+    received_bytes_ += size;
+}
+
+void UpgradeReceiver::GetMissingPackets(std::vector<uint16_t>* packet_ids) const {
+    if (packet_ids == nullptr)
+        return;
+    packet_ids->clear();
+    for (uint32_t seq = 1; seq <= total_packet_; ++seq) {
+        if (!IsReceived(static_cast<uint16_t>(seq)))
+            packet_ids->push_back(static_cast<uint16_t>(seq));
+    }
+}
+
+// Layout: version(1) + type(1) + version id length(1) + version id + total length(4) + total packet(2) +
+// fragment size(4) + received bytes(4) + bitmap.
+void UpgradeReceiver::Save(std::vector<uint8_t>* out) const {
+    if (out == nullptr)
+        return;
+    out->clear();
+    out->push_back(kUpgradeReceiverStateVersion);
+    out->push_back(upgrade_type_);
+    out->push_back(static_cast<uint8_t>(version_id_.size()));
+    out->insert(out->end(), version_id_.begin(), version_id_.end());
+    AppendU32(total_len_, out);
+    AppendU16(total_packet_, out);
+    AppendU32(fragment_size_, out);
+    AppendU32(received_bytes_, out);
+    out->insert(out->end(), bitmap_.begin(), bitmap_.end());
+}
+
+int UpgradeReceiver::Restore(std::vector<uint8_t> const& in) {
+    if (in.size() < 3 || in[0] != kUpgradeReceiverStateVersion)
+        return -1;
+    size_t        pos     = 1;
+    uint8_t const type    = in[pos++];
+    size_t const  ver_len = in[pos++];
+    if (in.size() < pos + ver_len + 14)
+        return -1;
+    std::string version(in.begin() + pos, in.begin() + pos + ver_len);
+    pos += ver_len;
+    uint32_t const total_len     = ReadU32(&in[pos]);
+    uint16_t const total_packet  = ReadU16(&in[pos + 4]);
+    uint32_t const fragment_size = ReadU32(&in[pos + 6]);
+    uint32_t const received      = ReadU32(&in[pos + 10]);
+    pos += 14;
+    if (in.size() - pos != static_cast<size_t>((total_packet + 7) / 8))
+        return -1;
+    Reset();
+    upgrade_type_   = type;
+    version_id_     = std::move(version);
+    total_len_      = total_len;
+    total_packet_   = total_packet;
+    fragment_size_  = fragment_size;
+    received_bytes_ = received;
+    bitmap_.assign(in.begin() + pos, in.end());
+    for (uint32_t seq = 1; seq <= total_packet_; ++seq) {
+        if (IsReceived(static_cast<uint16_t>(seq)))
+            ++received_packets_;
+    }
+    return 0;
+}
+
+} // namespace libjt808